@@ -7,6 +7,8 @@
 //#define NO_MINMAX
 //#include <windows.h>
 
+#include <array>
+#include <cstring>
 #include <iostream>
 
 /*
@@ -330,23 +332,85 @@ struct Header_DXT10
 
 static_assert(sizeof(Header) == 128);
 
+bool dds_parseHeader(const void* data, size_t size, DDSInfo& info)
+{
+	Header header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+
+	// compare the `DDS ` signature
+	if (memcmp(&header, "DDS ", 4) != 0)
+		return false;
+
+	// yes it is stored height then width
+	info.height = header.dwHeight;
+	info.width = header.dwWidth;
+	info.mipmapCount = header.dwMipMapCount;
+	info.dataOffset = sizeof(header);
+
+	// BC4U/BC4S/ATI2/BC55/R8G8_B8G8/G8R8_G8B8/UYVY-packed/YUY2-packed
+	// unsupported
+	if (header.ddspf.dwFourCC[0] != 'D')
+		return false;
+
+	// block size is about physical chunk storage of compressed data in file
+	// (important)
+	switch (header.ddspf.dwFourCC[3])
+	{
+	case '1':  // DXT1
+		info.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		info.blockSize = 8;
+		return true;
+	case '3':  // DXT3
+		info.format = VK_FORMAT_BC3_UNORM_BLOCK;
+		info.blockSize = 16;
+		return true;
+	case '5':  // DXT5
+		info.format = VK_FORMAT_BC5_UNORM_BLOCK;
+		info.blockSize = 16;
+		return true;
+	case '0':  // DX10, its header is between the first one and the pixels
+	{
+		Header_DXT10 header10;
+		if (size < sizeof(header) + sizeof(header10))
+			return false;
+		memcpy(&header10, static_cast<const std::byte*>(data) + sizeof(header),
+		       sizeof(header10));
+		info.dataOffset += sizeof(header10);
+
+		if (header10.dxgiFormat == Format::R32G32B32A32_FLOAT)
+		{
+			info.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			info.blockSize = 16;
+			return true;
+		}
+		if (header10.dxgiFormat == Format::R32G32_FLOAT)
+		{
+			info.format = VK_FORMAT_R32G32_SFLOAT;
+			info.blockSize = 8;
+			return true;
+		}
+		return false;
+	}
+	default: return false;
+	}
+}
+
 cdm::Texture2D texture_loadDDS(const char* path, cdm::TextureFactory& factory,
                                cdm::CommandBufferPool& pool,
                                VkImageLayout outputLayout)
 {
 	// lay out variables to be used
-	Header header;
-	memset(&header, 0xcccc, sizeof(header));
-
-	Header_DXT10 header10;
-	memset(&header10, 0xcccc, sizeof(header10));
+	DDSInfo info;
+	std::array<std::byte, sizeof(Header) + sizeof(Header_DXT10)> headers{};
+	size_t headersSize;
 
 	uint32_t width;
 	uint32_t height;
 	uint32_t mipmapCount;
 
 	uint32_t blockSize;
-	VkFormat format;
 
 	uint32_t w;
 	uint32_t h;
@@ -364,83 +428,27 @@ cdm::Texture2D texture_loadDDS(const char* path, cdm::TextureFactory& factory,
 	long file_size = ftell(f);
 	fseek(f, 0, SEEK_SET);
 
-	// allocate new unsigned char space with 4 (file code) + 124 (header size)
-	// bytes read in 128 bytes from the file
-	fread(&header, 1, sizeof(header), f);
-
-	// compare the `DDS ` signature
-	if (memcmp(&header, "DDS ", 4) != 0)
+	// the DX10 header is only there for the `DX10` fourCC, the bytes read
+	// past the first header are otherwise ignored
+	headersSize = fread(headers.data(), 1, headers.size(), f);
+	if (!dds_parseHeader(headers.data(), headersSize, info))
 		goto exit;
 
-	//*
-
-	// extract height, width, and amount of mipmaps - yes it is stored height
-	// then width
-	height = header.dwHeight;
-	width = header.dwWidth;
-	mipmapCount = header.dwMipMapCount;
+	height = info.height;
+	width = info.width;
+	mipmapCount = info.mipmapCount;
+	blockSize = info.blockSize;
 
 	factory.setWidth(width);
 	factory.setHeight(height);
 	// factory.setMipLevels(mipmapCount);
 	factory.setMipLevels(1);
+	factory.setFormat(info.format);
 
-	size_t bufferSize = file_size - 128;
-
-	// figure out what format to use for what fourCC file type it is
-	// block size is about physical chunk storage of compressed data in file
-	// (important)
-	if (char(header.ddspf.dwFourCC[0]) == 'D')
-	{
-		switch (char(header.ddspf.dwFourCC[3]))
-		{
-		case '1':  // DXT1
-			format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
-			blockSize = 8;
-			break;
-		case '3':  // DXT3
-			format = VK_FORMAT_BC3_UNORM_BLOCK;
-			blockSize = 16;
-			break;
-		case '5':  // DXT5
-			format = VK_FORMAT_BC5_UNORM_BLOCK;
-			blockSize = 16;
-			break;
-		case '0':  // DX10
-		           // unsupported, else will error
-		           // as it adds sizeof(struct DDS_HEADER_DXT10) between pixels
-		           // so, buffer = malloc((file_size - 128) - sizeof(struct
-		           // DDS_HEADER_DXT10));
-			fread(&header10, 1, sizeof(header10), f);
-			if (header10.dxgiFormat == Format::R32G32B32A32_FLOAT)
-			{
-				format = VK_FORMAT_R32G32B32A32_SFLOAT;
-				blockSize = 16;
-			}
-			else if (header10.dxgiFormat == Format::R32G32_FLOAT)
-			{
-				format = VK_FORMAT_R32G32_SFLOAT;
-				blockSize = 8;
-			}
-
-			bufferSize -= sizeof(Header_DXT10);
-			break;
-		default: goto exit;
-		}
-	}
-	else  // BC4U/BC4S/ATI2/BC55/R8G8_B8G8/G8R8_G8B8/UYVY-packed/YUY2-packed
-	      // unsupported
-		goto exit;
-
-	factory.setFormat(format);
-
-	// allocate new unsigned char space with file_size - (file_code +
-	// header_size) magnitude read rest of file
-	buffer.resize(bufferSize);
-	// buffer = (unsigned char*)malloc(file_size - 128);
-	// if(buffer == 0)
-	//	goto exit;
-	fread(buffer.data(), 1, file_size, f);
+	// read the rest of the file
+	buffer.resize(size_t(file_size) - info.dataOffset);
+	fseek(f, long(info.dataOffset), SEEK_SET);
+	fread(buffer.data(), 1, buffer.size(), f);
 
 	// prepare new incomplete texture
 	// glGenTextures(1, &tid);
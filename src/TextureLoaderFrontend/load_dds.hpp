@@ -5,6 +5,24 @@
 #include "Texture2D.hpp"
 #include "TextureFactory.hpp"
 
+#include <cstddef>
+
+/// What `texture_loadDDS` reads from the headers of a DDS file
+struct DDSInfo
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipmapCount = 0;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t blockSize = 0;
+	/// of the pixels, from the start of the file
+	size_t dataOffset = 0;
+};
+
+/// Parses the headers at the start of the `size` bytes of `data`. false if
+/// they are truncated or if the format is not supported
+bool dds_parseHeader(const void* data, size_t size, DDSInfo& info);
+
 cdm::Texture2D texture_loadDDS(
     const char* path, cdm::TextureFactory& factory,
     cdm::CommandBufferPool& pool,
@@ -11,11 +11,11 @@
 
 namespace cdm
 {
-BrdfLut::BrdfLut(RenderWindow& renderWindow, uint32_t resolution,
+BrdfLut::BrdfLut(RenderContext& renderContext, uint32_t resolution,
                  std::string_view filePath)
 
 {
-    auto& vk = renderWindow.device();
+    auto& vk = renderContext.device();
 
     using namespace std::literals;
     namespace fs = std::filesystem;
@@ -66,7 +66,7 @@ BrdfLut::BrdfLut(RenderWindow& renderWindow, uint32_t resolution,
     std::cout << "brdfLut not found in \"" << cacheFilePath
               << "\". Generating it, please wait..." << std::endl;
 
-    BrdfLutGenerator blg(renderWindow, resolution);
+    BrdfLutGenerator blg(renderContext, resolution);
     m_brdfLut = blg.computeBrdfLut();
 
     std::filesystem::create_directory(cacheDirPath);
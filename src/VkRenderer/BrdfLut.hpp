@@ -2,7 +2,7 @@
 
 #include "VulkanDevice.hpp"
 
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Texture2D.hpp"
 
 #include <string_view>
@@ -15,7 +15,7 @@ class BrdfLut final
 
 public:
 	BrdfLut() = default;
-	BrdfLut(RenderWindow& renderWindow, uint32_t resolution = 1024,
+	BrdfLut(RenderContext& renderContext, uint32_t resolution = 1024,
 	        std::string_view filePath = "brdfLut.hdr");
 
 	Texture2D& get() noexcept { return m_brdfLut; }
@@ -3,6 +3,7 @@
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
 #include "TextureFactory.hpp"
+#include "ShaderArchive.hpp"
 #include "StagingBuffer.hpp"
 
 #include <CompilerSpirV/compileSpirV.hpp>
@@ -19,9 +20,9 @@
 
 namespace cdm
 {
-BrdfLutGenerator::BrdfLutGenerator(RenderWindow& renderWindow,
+BrdfLutGenerator::BrdfLutGenerator(RenderContext& renderContext,
                                    uint32_t resolution)
-    : rw(renderWindow),
+    : rw(renderContext),
       m_resolution(resolution)
 {
     auto& vk = rw.get().device();
@@ -99,206 +100,24 @@ BrdfLutGenerator::BrdfLutGenerator(RenderWindow& renderWindow,
 #define Constant(name, value) auto name = writer.declConstant(#name, value);
 
 #pragma region vertexShader
+    m_vertexModule = createShaderModule(vk, "BrdfLutGenerator.vert",
+                                        &vertexShaderBytecode);
+    if (!m_vertexModule)
     {
-        using namespace sdw;
-        VertexWriter writer;
-
-        auto inPosition = writer.declInput<Vec2>("inPosition", 0);
-        auto fragPosition = writer.declOutput<Vec2>("fragPosition", 0);
-
-        auto out = writer.getOut();
-
-        writer.implementMain([&]() {
-            fragPosition = inPosition;
-            out.vtx.position = vec4(inPosition, 0.0_f, 1.0_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_vertexModule = vk.create(createInfo);
-        if (!m_vertexModule)
-        {
-            std::cerr << "error: failed to create vertex shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create vertex shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
 #pragma region fragmentShader
+    m_fragmentModule = createShaderModule(vk, "BrdfLutGenerator.frag",
+                                          &fragmentShaderBytecode);
+    if (!m_fragmentModule)
     {
-        using namespace sdw;
-        FragmentWriter writer;
-
-        auto in = writer.getIn();
-
-        auto fragPosition = writer.declInput<Vec2>("fragPosition", 0);
-        auto fragColor = writer.declOutput<Vec2>("fragColor", 0);
-
-        //*
-        Constant(PI, 3.14159265359_f);
-
-        auto RadicalInverse_VdC = writer.implementFunction<Float>(
-            "RadicalInverse_VdC",
-            [&](const UInt& bits_arg) {
-                Locale(bits, bits_arg);
-
-                bits = (bits << 16_u) | (bits >> 16_u);
-                bits = ((bits & 0x55555555_u) << 1_u) |
-                       ((bits & 0xAAAAAAAA_u) >> 1_u);
-                bits = ((bits & 0x33333333_u) << 2_u) |
-                       ((bits & 0xCCCCCCCC_u) >> 2_u);
-                bits = ((bits & 0x0F0F0F0F_u) << 4_u) |
-                       ((bits & 0xF0F0F0F0_u) >> 4_u);
-                bits = ((bits & 0x00FF00FF_u) << 8_u) |
-                       ((bits & 0xFF00FF00_u) >> 8_u);
-
-                writer.returnStmt(writer.cast<Float>(bits) *
-                                  2.3283064365386963e-10_f);
-            },
-            InUInt{ writer, "bits_arg" });
-
-        auto Hammersley = writer.implementFunction<Vec2>(
-            "Hammersley",
-            [&](const UInt& i, const UInt& N) {
-                writer.returnStmt(
-                    vec2(writer.cast<Float>(i) / writer.cast<Float>(N),
-                         RadicalInverse_VdC(i)));
-            },
-            InUInt{ writer, "i" }, InUInt{ writer, "N" });
-
-        auto ImportanceSampleGGX = writer.implementFunction<Vec3>(
-            "ImportanceSampleGGX",
-            [&](const Vec2& Xi, const Vec3& N, const Float& roughness) {
-                Locale(a, roughness * roughness);
-
-                Locale(phi, 2.0_f * PI * Xi.x());
-                Locale(cosTheta, sqrt((1.0_f - Xi.y()) /
-                                      (1.0_f + (a * a - 1.0_f) * Xi.y())));
-                Locale(sinTheta, sqrt(1.0_f - cosTheta * cosTheta));
-
-                Locale(H, vec3(cos(phi) * sinTheta, sin(phi) * sinTheta,
-                               cosTheta));
-
-                Locale(up, TERNARY(writer, Vec3, abs(N.z()) < 0.999_f,
-                                   vec3(0.0_f, 0.0_f, 1.0_f),
-                                   vec3(1.0_f, 0.0_f, 0.0_f)));
-                Locale(tangent, normalize(cross(up, N)));
-                Locale(bitangent, cross(N, tangent));
-
-                Locale(sampleVec,
-                       tangent * H.x() + bitangent * H.y() + N * H.z());
-                writer.returnStmt(normalize(sampleVec));
-            },
-            InVec2{ writer, "Xi" }, InVec3{ writer, "N" },
-            InFloat{ writer, "roughness" });
-
-        auto GeometrySchlickGGX = writer.implementFunction<Float>(
-            "GeometrySchlickGGX",
-            [&](const Float& NdotV, const Float& roughness) {
-                Locale(a, roughness);
-                Locale(k, (a * a) / 2.0_f);
-
-                Locale(denom, NdotV * (1.0_f - k) + k);
-
-                writer.returnStmt(NdotV / denom);
-            },
-            InFloat{ writer, "NdotV" }, InFloat{ writer, "roughness" });
-
-        auto GeometrySmith = writer.implementFunction<Float>(
-            "GeometrySmith",
-            [&](const Vec3& N, const Vec3& V, const Vec3& L,
-                const Float& roughness) {
-                Locale(NdotV, max(dot(N, V), 0.0_f));
-                Locale(NdotL, max(dot(N, L), 0.0_f));
-                Locale(ggx1, GeometrySchlickGGX(NdotV, roughness));
-                Locale(ggx2, GeometrySchlickGGX(NdotL, roughness));
-
-                writer.returnStmt(ggx1 * ggx2);
-            },
-            InVec3{ writer, "N" }, InVec3{ writer, "V" },
-            InVec3{ writer, "L" }, InFloat{ writer, "roughness" });
-        //*/
-
-        uint32_t m_sampleCount = 2048;
-
-        auto IntegrateBRDF = writer.implementFunction<Vec2>(
-            "IntegrateBRDF",
-            [&](const Float& NdotV, const Float& roughness) {
-                Locale(V, vec3(sqrt(1.0_f - NdotV * NdotV), 0.0_f, NdotV));
-
-                Locale(A, 0.0_f);
-                Locale(B, 0.0_f);
-
-                Locale(N, vec3(0.0_f, 0.0_f, 1.0_f));
-
-                Locale(SAMPLE_COUNT, UInt(m_sampleCount));
-                Locale(SAMPLE_COUNTf, Float(float(m_sampleCount)));
-
-                VEC2(Xi);
-                VEC3(H);
-                VEC3(L);
-                FLOAT(NdotL);
-                FLOAT(NdotH);
-                FLOAT(VdotH);
-                FLOAT(G);
-                FLOAT(G_Vis);
-                FLOAT(Fc);
-
-                FOR(writer, UInt, i, 0_u, i < SAMPLE_COUNT, i++)
-                {
-                    Xi = Hammersley(i, SAMPLE_COUNT);
-                    H = ImportanceSampleGGX(Xi, N, roughness);
-                    L = normalize(2.0_f * dot(V, H) * H - V);
-
-                    NdotL = max(L.z(), 0.0_f);
-                    NdotH = max(H.z(), 0.0_f);
-                    VdotH = max(dot(V, H), 0.0_f);
-
-                    IF(writer, NdotL > 0.0_f)
-                    {
-                        G = GeometrySmith(N, V, L, roughness);
-                        G_Vis = (G * VdotH) / (NdotH * NdotV);
-                        Fc = pow(1.0_f - VdotH, 5.0_f);
-
-                        A += (1.0_f - Fc) * G_Vis;
-                        B += Fc * G_Vis;
-                    }
-                    FI;
-                }
-                ROF;
-
-                A /= SAMPLE_COUNTf;
-                B /= SAMPLE_COUNTf;
-
-                writer.returnStmt(vec2(A, B));
-            },
-            InFloat{ writer, "NdotV" }, InFloat{ writer, "roughness" });
-
-        writer.implementMain([&]() {
-            fragColor = IntegrateBRDF(fragPosition.x() / 2.0_f + 0.5_f,
-                                      fragPosition.y() / 2.0_f + 0.5_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_fragmentModule = vk.create(createInfo);
-        if (!m_fragmentModule)
-        {
-            std::cerr << "error: failed to create fragment shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create fragment shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
@@ -537,6 +356,182 @@ BrdfLutGenerator::BrdfLutGenerator(RenderWindow& renderWindow,
 #pragma endregion
 }
 
+std::vector<uint32_t> BrdfLutGenerator::vertexShaderBytecode()
+{
+    using namespace sdw;
+    VertexWriter writer;
+
+    auto inPosition = writer.declInput<Vec2>("inPosition", 0);
+    auto fragPosition = writer.declOutput<Vec2>("fragPosition", 0);
+
+    auto out = writer.getOut();
+
+    writer.implementMain([&]() {
+        fragPosition = inPosition;
+        out.vtx.position = vec4(inPosition, 0.0_f, 1.0_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
+std::vector<uint32_t> BrdfLutGenerator::fragmentShaderBytecode()
+{
+    using namespace sdw;
+    FragmentWriter writer;
+
+    auto in = writer.getIn();
+
+    auto fragPosition = writer.declInput<Vec2>("fragPosition", 0);
+    auto fragColor = writer.declOutput<Vec2>("fragColor", 0);
+
+    //*
+    Constant(PI, 3.14159265359_f);
+
+    auto RadicalInverse_VdC = writer.implementFunction<Float>(
+        "RadicalInverse_VdC",
+        [&](const UInt& bits_arg) {
+            Locale(bits, bits_arg);
+
+            bits = (bits << 16_u) | (bits >> 16_u);
+            bits = ((bits & 0x55555555_u) << 1_u) |
+                   ((bits & 0xAAAAAAAA_u) >> 1_u);
+            bits = ((bits & 0x33333333_u) << 2_u) |
+                   ((bits & 0xCCCCCCCC_u) >> 2_u);
+            bits = ((bits & 0x0F0F0F0F_u) << 4_u) |
+                   ((bits & 0xF0F0F0F0_u) >> 4_u);
+            bits = ((bits & 0x00FF00FF_u) << 8_u) |
+                   ((bits & 0xFF00FF00_u) >> 8_u);
+
+            writer.returnStmt(writer.cast<Float>(bits) *
+                              2.3283064365386963e-10_f);
+        },
+        InUInt{ writer, "bits_arg" });
+
+    auto Hammersley = writer.implementFunction<Vec2>(
+        "Hammersley",
+        [&](const UInt& i, const UInt& N) {
+            writer.returnStmt(
+                vec2(writer.cast<Float>(i) / writer.cast<Float>(N),
+                     RadicalInverse_VdC(i)));
+        },
+        InUInt{ writer, "i" }, InUInt{ writer, "N" });
+
+    auto ImportanceSampleGGX = writer.implementFunction<Vec3>(
+        "ImportanceSampleGGX",
+        [&](const Vec2& Xi, const Vec3& N, const Float& roughness) {
+            Locale(a, roughness * roughness);
+
+            Locale(phi, 2.0_f * PI * Xi.x());
+            Locale(cosTheta, sqrt((1.0_f - Xi.y()) /
+                                  (1.0_f + (a * a - 1.0_f) * Xi.y())));
+            Locale(sinTheta, sqrt(1.0_f - cosTheta * cosTheta));
+
+            Locale(H, vec3(cos(phi) * sinTheta, sin(phi) * sinTheta,
+                           cosTheta));
+
+            Locale(up, TERNARY(writer, Vec3, abs(N.z()) < 0.999_f,
+                               vec3(0.0_f, 0.0_f, 1.0_f),
+                               vec3(1.0_f, 0.0_f, 0.0_f)));
+            Locale(tangent, normalize(cross(up, N)));
+            Locale(bitangent, cross(N, tangent));
+
+            Locale(sampleVec,
+                   tangent * H.x() + bitangent * H.y() + N * H.z());
+            writer.returnStmt(normalize(sampleVec));
+        },
+        InVec2{ writer, "Xi" }, InVec3{ writer, "N" },
+        InFloat{ writer, "roughness" });
+
+    auto GeometrySchlickGGX = writer.implementFunction<Float>(
+        "GeometrySchlickGGX",
+        [&](const Float& NdotV, const Float& roughness) {
+            Locale(a, roughness);
+            Locale(k, (a * a) / 2.0_f);
+
+            Locale(denom, NdotV * (1.0_f - k) + k);
+
+            writer.returnStmt(NdotV / denom);
+        },
+        InFloat{ writer, "NdotV" }, InFloat{ writer, "roughness" });
+
+    auto GeometrySmith = writer.implementFunction<Float>(
+        "GeometrySmith",
+        [&](const Vec3& N, const Vec3& V, const Vec3& L,
+            const Float& roughness) {
+            Locale(NdotV, max(dot(N, V), 0.0_f));
+            Locale(NdotL, max(dot(N, L), 0.0_f));
+            Locale(ggx1, GeometrySchlickGGX(NdotV, roughness));
+            Locale(ggx2, GeometrySchlickGGX(NdotL, roughness));
+
+            writer.returnStmt(ggx1 * ggx2);
+        },
+        InVec3{ writer, "N" }, InVec3{ writer, "V" },
+        InVec3{ writer, "L" }, InFloat{ writer, "roughness" });
+    //*/
+
+    uint32_t m_sampleCount = 2048;
+
+    auto IntegrateBRDF = writer.implementFunction<Vec2>(
+        "IntegrateBRDF",
+        [&](const Float& NdotV, const Float& roughness) {
+            Locale(V, vec3(sqrt(1.0_f - NdotV * NdotV), 0.0_f, NdotV));
+
+            Locale(A, 0.0_f);
+            Locale(B, 0.0_f);
+
+            Locale(N, vec3(0.0_f, 0.0_f, 1.0_f));
+
+            Locale(SAMPLE_COUNT, UInt(m_sampleCount));
+            Locale(SAMPLE_COUNTf, Float(float(m_sampleCount)));
+
+            VEC2(Xi);
+            VEC3(H);
+            VEC3(L);
+            FLOAT(NdotL);
+            FLOAT(NdotH);
+            FLOAT(VdotH);
+            FLOAT(G);
+            FLOAT(G_Vis);
+            FLOAT(Fc);
+
+            FOR(writer, UInt, i, 0_u, i < SAMPLE_COUNT, i++)
+            {
+                Xi = Hammersley(i, SAMPLE_COUNT);
+                H = ImportanceSampleGGX(Xi, N, roughness);
+                L = normalize(2.0_f * dot(V, H) * H - V);
+
+                NdotL = max(L.z(), 0.0_f);
+                NdotH = max(H.z(), 0.0_f);
+                VdotH = max(dot(V, H), 0.0_f);
+
+                IF(writer, NdotL > 0.0_f)
+                {
+                    G = GeometrySmith(N, V, L, roughness);
+                    G_Vis = (G * VdotH) / (NdotH * NdotV);
+                    Fc = pow(1.0_f - VdotH, 5.0_f);
+
+                    A += (1.0_f - Fc) * G_Vis;
+                    B += Fc * G_Vis;
+                }
+                FI;
+            }
+            ROF;
+
+            A /= SAMPLE_COUNTf;
+            B /= SAMPLE_COUNTf;
+
+            writer.returnStmt(vec2(A, B));
+        },
+        InFloat{ writer, "NdotV" }, InFloat{ writer, "roughness" });
+
+    writer.implementMain([&]() {
+        fragColor = IntegrateBRDF(fragPosition.x() / 2.0_f + 0.5_f,
+                                  fragPosition.y() / 2.0_f + 0.5_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
 BrdfLutGenerator::~BrdfLutGenerator() = default;
 
 Texture2D BrdfLutGenerator::computeBrdfLut()
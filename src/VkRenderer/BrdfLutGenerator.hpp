@@ -3,7 +3,7 @@
 #include "VulkanDevice.hpp"
 
 #include "Buffer.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Texture2D.hpp"
 
 #include <string_view>
@@ -12,7 +12,7 @@ namespace cdm
 {
 class BrdfLutGenerator final
 {
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	UniqueRenderPass m_renderPass;
 
@@ -30,9 +30,12 @@ class BrdfLutGenerator final
 	uint32_t m_resolution;
 
 public:
-	BrdfLutGenerator(RenderWindow& renderWindow, uint32_t resolution);
+	BrdfLutGenerator(RenderContext& renderContext, uint32_t resolution);
 	~BrdfLutGenerator();
 
+	static std::vector<uint32_t> vertexShaderBytecode();
+	static std::vector<uint32_t> fragmentShaderBytecode();
+
 	Texture2D computeBrdfLut();
 };
 }  // namespace cdm
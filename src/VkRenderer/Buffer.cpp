@@ -1,22 +1,41 @@
 #include "Buffer.hpp"
 
-#include "RenderWindow.hpp"
+#include "CpuProfiler.hpp"
+#include "FrameRecorder.hpp"
+#include "RenderContext.hpp"
 
 #include <stdexcept>
 #include <iostream>
 
 namespace cdm
 {
+static MemoryCategory memoryCategoryFromUsage(VkBufferUsageFlags usage)
+{
+    if (usage &
+        (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+        return MemoryCategory::Mesh;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        return MemoryCategory::Uniform;
+    if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+        return MemoryCategory::Staging;
+
+    return MemoryCategory::Other;
+}
+
 Buffer::Buffer(const VulkanDevice& vulkanDevice, VkDeviceSize bufferSize,
                VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage,
                VkMemoryPropertyFlags requiredFlags)
-    : m_vulkanDevice(&vulkanDevice)
+    : m_vulkanDevice(&vulkanDevice),
+      m_memoryCategory(memoryCategoryFromUsage(usage))
 {
     auto& vk = *m_vulkanDevice.get();
 
     vk::BufferCreateInfo info;
     info.size = bufferSize;
     info.usage = usage;
+    // read back when a capture begins
+    if (vk.frameRecorder().tracking())
+        info.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     VmaAllocationCreateInfo allocCreateInfo = {};
@@ -34,6 +53,9 @@ Buffer::Buffer(const VulkanDevice& vulkanDevice, VkDeviceSize bufferSize,
         throw std::runtime_error(std::string("could not create buffer ") +
                                  std::string(vk::result_to_string(res)));
     }
+
+    vk.memoryStats().allocated(m_memoryCategory, m_allocInfo.size);
+    vk.frameRecorder().recordBuffer(m_buffer.get(), info, allocCreateInfo);
 }
 
 Buffer::~Buffer()
@@ -43,8 +65,13 @@ Buffer::~Buffer()
         auto& vk = *m_vulkanDevice.get();
 
         if (m_buffer)
+        {
+            vk.memoryStats().freed(m_memoryCategory, m_allocInfo.size);
+            vk.frameRecorder().recordDestruction(
+                capture::handleId(m_buffer.get()));
             vmaDestroyBuffer(vk.allocator(), m_buffer.get(),
                              m_allocation.get());
+        }
     }
 }
 
@@ -68,11 +95,25 @@ void* Buffer::map()
 void Buffer::unmap()
 {
     auto& vk = *m_vulkanDevice.get();
+
+    // the host writes of the frame are captured when they are done
+    FrameRecorder& frameRecorder = vk.frameRecorder();
+    if (frameRecorder.capturing())
+    {
+        void* data;
+        vmaMapMemory(vk.allocator(), m_allocation.get(), &data);
+        frameRecorder.recordBufferData(m_buffer.get(), data,
+                                       m_allocInfo.size);
+        vmaUnmapMemory(vk.allocator(), m_allocation.get());
+    }
+
     vmaUnmapMemory(vk.allocator(), m_allocation.get());
 }
 
 void Buffer::upload(const void* data, size_t size)
 {
+    CpuProfiler::Zone zone("buffer upload");
+
     /// TODO: check buffer size
     std::memcpy(map(), data, size);
     unmap();
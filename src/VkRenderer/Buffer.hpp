@@ -1,12 +1,13 @@
 #pragma once
 
+#include "Stats.hpp"
 #include "VulkanDevice.hpp"
 
 #include <vector>
 
 namespace cdm
 {
-class RenderWindow;
+class RenderContext;
 
 class Buffer
 {
@@ -16,6 +17,7 @@ class Buffer
 	Movable<VkBuffer> m_buffer;
 
 	VmaAllocationInfo m_allocInfo{};
+	MemoryCategory m_memoryCategory = MemoryCategory::Other;
 
 public:
 	Buffer() = default;
@@ -34,6 +36,8 @@ public:
 	VkDeviceMemory deviceMemory() const { return m_allocInfo.deviceMemory; }
 	const VkBuffer& get() const { return m_buffer.get(); }
 	const VmaAllocation& allocation() const { return m_allocation.get(); }
+	/// Deduced from the usage flags
+	MemoryCategory memoryCategory() const { return m_memoryCategory; }
 
 	void setName(std::string_view name);
 
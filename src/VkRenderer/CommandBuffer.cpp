@@ -1,7 +1,10 @@
 #include "CommandBuffer.hpp"
 #include "CommandPool.hpp"
+#include "DescriptorAllocator.hpp"
+#include "FrameRecorder.hpp"
 
 #include <stdexcept>
+#include <vector>
 
 namespace cdm
 {
@@ -88,6 +91,8 @@ VkResult CommandBuffer::begin()
 
 VkResult CommandBuffer::begin(const vk::CommandBufferBeginInfo& beginInfo)
 {
+    m_stats = RecordingStats{};
+    m_capture = device().frameRecorder().beginCommandBuffer(get());
     return device().BeginCommandBuffer(m_commandBuffer.get(), &beginInfo);
 }
 
@@ -95,13 +100,18 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags usage)
 {
     vk::CommandBufferBeginInfo beginInfo;
     beginInfo.flags = usage;
-    return device().BeginCommandBuffer(m_commandBuffer.get(), &beginInfo);
+    return begin(beginInfo);
 }
 
 CommandBuffer& CommandBuffer::beginQuery(VkQueryPool queryPool, uint32_t query,
                                          VkQueryControlFlags flags)
 {
     device().CmdBeginQuery(m_commandBuffer.get(), queryPool, query, flags);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BeginQuery, queryPool, query,
+                            flags);
+    }
 
     return *this;
 }
@@ -111,6 +121,16 @@ CommandBuffer& CommandBuffer::beginRenderPass(
 {
     device().CmdBeginRenderPass(m_commandBuffer.get(), &renderPassInfo,
                                 contents);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BeginRenderPass,
+                            renderPassInfo.renderPass,
+                            renderPassInfo.framebuffer,
+                            renderPassInfo.renderArea,
+                            capture::array(renderPassInfo.pClearValues,
+                                           renderPassInfo.clearValueCount),
+                            contents);
+    }
 
     return *this;
 }
@@ -121,6 +141,16 @@ CommandBuffer& CommandBuffer::beginRenderPass2(
 {
     device().CmdBeginRenderPass2KHR(m_commandBuffer.get(), &renderPassInfo,
                                     &subpassInfo);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BeginRenderPass,
+                            renderPassInfo.renderPass,
+                            renderPassInfo.framebuffer,
+                            renderPassInfo.renderArea,
+                            capture::array(renderPassInfo.pClearValues,
+                                           renderPassInfo.clearValueCount),
+                            subpassInfo.contents);
+    }
 
     return *this;
 }
@@ -135,6 +165,14 @@ CommandBuffer& CommandBuffer::bindDescriptorSets(
                                    layout, firstSet, descriptorSetCount,
                                    pDescriptorSets, dynamicOffsetCount,
                                    pDynamicOffsets);
+    if (m_capture)
+    {
+        m_capture->writeAll(
+            capture::Command::BindDescriptorSets, pipelineBindPoint, layout,
+            firstSet, capture::array(pDescriptorSets, descriptorSetCount),
+            capture::array(pDynamicOffsets, dynamicOffsetCount));
+    }
+    m_stats.descriptorSetBinds += descriptorSetCount;
 
     return *this;
 }
@@ -165,6 +203,11 @@ CommandBuffer& CommandBuffer::bindIndexBuffer(VkBuffer buffer,
 {
     device().CmdBindIndexBuffer(m_commandBuffer.get(), buffer, offset,
                                 indexType);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BindIndexBuffer, buffer, offset,
+                            indexType);
+    }
 
     return *this;
 }
@@ -174,6 +217,12 @@ CommandBuffer& CommandBuffer::bindPipeline(
 {
     device().CmdBindPipeline(m_commandBuffer.get(), pipelineBindPoint,
                              pipeline);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BindPipeline, pipelineBindPoint,
+                            pipeline);
+    }
+    m_stats.pipelineBinds++;
 
     return *this;
 }
@@ -195,6 +244,12 @@ CommandBuffer& CommandBuffer::bindVertexBuffers(uint32_t firstBinding,
 {
     device().CmdBindVertexBuffers(m_commandBuffer.get(), firstBinding,
                                   bindingCount, pBuffers, pOffsets);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BindVertexBuffers, firstBinding,
+                            capture::array(pBuffers, bindingCount),
+                            capture::array(pOffsets, bindingCount));
+    }
 
     return *this;
 }
@@ -223,6 +278,12 @@ CommandBuffer& CommandBuffer::blitImage(
     device().CmdBlitImage(m_commandBuffer.get(), srcImage, srcImageLayout,
                           dstImage, dstImageLayout, regionCount, pRegions,
                           filter);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::BlitImage, srcImage,
+                            srcImageLayout, dstImage, dstImageLayout,
+                            capture::array(pRegions, regionCount), filter);
+    }
 
     return *this;
 }
@@ -243,6 +304,12 @@ CommandBuffer& CommandBuffer::clearAttachments(
 {
     device().CmdClearAttachments(m_commandBuffer.get(), attachmentCount,
                                  pAttachments, rectCount, pRects);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::ClearAttachments,
+                            capture::array(pAttachments, attachmentCount),
+                            capture::array(pRects, rectCount));
+    }
 
     return *this;
 }
@@ -279,6 +346,12 @@ CommandBuffer& CommandBuffer::clearColorImage(
 {
     device().CmdClearColorImage(m_commandBuffer.get(), image, imageLayout,
                                 pColor, rangeCount, pRanges);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::ClearColorImage, image,
+                            imageLayout, *pColor,
+                            capture::array(pRanges, rangeCount));
+    }
 
     return *this;
 }
@@ -300,6 +373,12 @@ CommandBuffer& CommandBuffer::clearDepthStencilImage(
     device().CmdClearDepthStencilImage(m_commandBuffer.get(), image,
                                        imageLayout, pDepthStencil, rangeCount,
                                        pRanges);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::ClearDepthStencilImage, image,
+                            imageLayout, *pDepthStencil,
+                            capture::array(pRanges, rangeCount));
+    }
 
     return *this;
 }
@@ -321,6 +400,11 @@ CommandBuffer& CommandBuffer::copyBuffer(VkBuffer srcBuffer,
 {
     device().CmdCopyBuffer(m_commandBuffer.get(), srcBuffer, dstBuffer,
                            regionCount, pRegions);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::CopyBuffer, srcBuffer, dstBuffer,
+                            capture::array(pRegions, regionCount));
+    }
 
     return *this;
 }
@@ -355,6 +439,12 @@ CommandBuffer& CommandBuffer::copyBufferToImage(
 {
     device().CmdCopyBufferToImage(m_commandBuffer.get(), srcBuffer, dstImage,
                                   dstImageLayout, regionCount, pRegions);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::CopyBufferToImage, srcBuffer,
+                            dstImage, dstImageLayout,
+                            capture::array(pRegions, regionCount));
+    }
 
     return *this;
 }
@@ -377,6 +467,12 @@ CommandBuffer& CommandBuffer::copyImage(VkImage srcImage,
 {
     device().CmdCopyImage(m_commandBuffer.get(), srcImage, srcImageLayout,
                           dstImage, dstImageLayout, regionCount, pRegions);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::CopyImage, srcImage,
+                            srcImageLayout, dstImage, dstImageLayout,
+                            capture::array(pRegions, regionCount));
+    }
 
     return *this;
 }
@@ -399,6 +495,12 @@ CommandBuffer& CommandBuffer::copyImageToBuffer(
     device().CmdCopyImageToBuffer(m_commandBuffer.get(), srcImage,
                                   srcImageLayout, dstBuffer, regionCount,
                                   pRegions);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::CopyImageToBuffer, srcImage,
+                            srcImageLayout, dstBuffer,
+                            capture::array(pRegions, regionCount));
+    }
 
     return *this;
 }
@@ -420,6 +522,12 @@ CommandBuffer& CommandBuffer::copyQueryPoolResults(
     device().CmdCopyQueryPoolResults(m_commandBuffer.get(), queryPool,
                                      firstQuery, queryCount, dstBuffer,
                                      dstOffset, stride, flags);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::CopyQueryPoolResults, queryPool,
+                            firstQuery, queryCount, dstBuffer, dstOffset,
+                            stride, flags);
+    }
 
     return *this;
 }
@@ -429,6 +537,12 @@ CommandBuffer& CommandBuffer::debugMarkerBegin(
 {
     if (device().CmdDebugMarkerBeginEXT)
         device().CmdDebugMarkerBeginEXT(m_commandBuffer.get(), &markerInfo);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DebugMarkerBegin,
+                            std::string_view(markerInfo.pMarkerName),
+                            markerInfo.color);
+    }
 
     return *this;
 }
@@ -468,6 +582,8 @@ CommandBuffer& CommandBuffer::debugMarkerEnd()
 {
     if (device().CmdDebugMarkerEndEXT)
         device().CmdDebugMarkerEndEXT(m_commandBuffer.get());
+    if (m_capture)
+        m_capture->writeAll(capture::Command::DebugMarkerEnd);
 
     return *this;
 }
@@ -477,6 +593,12 @@ CommandBuffer& CommandBuffer::debugMarkerInsert(
 {
     if (device().CmdDebugMarkerInsertEXT)
         device().CmdDebugMarkerInsertEXT(m_commandBuffer.get(), &markerInfo);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DebugMarkerInsert,
+                            std::string_view(markerInfo.pMarkerName),
+                            markerInfo.color);
+    }
 
     return *this;
 }
@@ -518,6 +640,12 @@ CommandBuffer& CommandBuffer::dispatch(uint32_t groupCountX,
 {
     device().CmdDispatch(m_commandBuffer.get(), groupCountX, groupCountY,
                          groupCountZ);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::Dispatch, groupCountX,
+                            groupCountY, groupCountZ);
+    }
+    m_stats.dispatches++;
 
     return *this;
 }
@@ -529,6 +657,13 @@ CommandBuffer& CommandBuffer::dispatchBase(
     device().CmdDispatchBase(m_commandBuffer.get(), baseGroupX, baseGroupY,
                              baseGroupZ, groupCountX, groupCountY,
                              groupCountZ);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DispatchBase, baseGroupX,
+                            baseGroupY, baseGroupZ, groupCountX, groupCountY,
+                            groupCountZ);
+    }
+    m_stats.dispatches++;
 
     return *this;
 }
@@ -537,6 +672,9 @@ CommandBuffer& CommandBuffer::dispatchIndirect(VkBuffer buffer,
                                                VkDeviceSize offset)
 {
     device().CmdDispatchIndirect(m_commandBuffer.get(), buffer, offset);
+    if (m_capture)
+        m_capture->writeAll(capture::Command::DispatchIndirect, buffer, offset);
+    m_stats.dispatches++;
 
     return *this;
 }
@@ -548,6 +686,13 @@ CommandBuffer& CommandBuffer::draw(uint32_t vertexCount,
 {
     device().CmdDraw(m_commandBuffer.get(), vertexCount, instanceCount,
                      firstVertex, firstInstance);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::Draw, vertexCount, instanceCount,
+                            firstVertex, firstInstance);
+    }
+    m_stats.draws++;
+    m_stats.triangles += uint64_t(vertexCount / 3) * instanceCount;
 
     return *this;
 }
@@ -560,6 +705,14 @@ CommandBuffer& CommandBuffer::drawIndexed(uint32_t indexCount,
 {
     device().CmdDrawIndexed(m_commandBuffer.get(), indexCount, instanceCount,
                             firstIndex, vertexOffset, firstInstance);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DrawIndexed, indexCount,
+                            instanceCount, firstIndex, vertexOffset,
+                            firstInstance);
+    }
+    m_stats.draws++;
+    m_stats.triangles += uint64_t(indexCount / 3) * instanceCount;
 
     return *this;
 }
@@ -571,6 +724,12 @@ CommandBuffer& CommandBuffer::drawIndexedIndirect(VkBuffer buffer,
 {
     device().CmdDrawIndexedIndirect(m_commandBuffer.get(), buffer, offset,
                                     drawCount, stride);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DrawIndexedIndirect, buffer,
+                            offset, drawCount, stride);
+    }
+    m_stats.indirectDraws++;
 
     return *this;
 }
@@ -582,6 +741,13 @@ CommandBuffer& CommandBuffer::drawIndexedIndirectCount(
     device().CmdDrawIndexedIndirectCount(m_commandBuffer.get(), buffer, offset,
                                          countBuffer, countBufferOffset,
                                          maxDrawCount, stride);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DrawIndexedIndirectCount, buffer,
+                            offset, countBuffer, countBufferOffset,
+                            maxDrawCount, stride);
+    }
+    m_stats.indirectDraws++;
 
     return *this;
 }
@@ -592,6 +758,12 @@ CommandBuffer& CommandBuffer::drawIndirect(VkBuffer buffer,
 {
     device().CmdDrawIndirect(m_commandBuffer.get(), buffer, offset, drawCount,
                              stride);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DrawIndirect, buffer, offset,
+                            drawCount, stride);
+    }
+    m_stats.indirectDraws++;
 
     return *this;
 }
@@ -603,6 +775,13 @@ CommandBuffer& CommandBuffer::drawIndirectCount(
     device().CmdDrawIndirectCount(m_commandBuffer.get(), buffer, offset,
                                   countBuffer, countBufferOffset, maxDrawCount,
                                   stride);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::DrawIndirectCount, buffer, offset,
+                            countBuffer, countBufferOffset, maxDrawCount,
+                            stride);
+    }
+    m_stats.indirectDraws++;
 
     return *this;
 }
@@ -610,6 +789,8 @@ CommandBuffer& CommandBuffer::drawIndirectCount(
 CommandBuffer& CommandBuffer::endQuery(VkQueryPool queryPool, uint32_t query)
 {
     device().CmdEndQuery(m_commandBuffer.get(), queryPool, query);
+    if (m_capture)
+        m_capture->writeAll(capture::Command::EndQuery, queryPool, query);
 
     return *this;
 }
@@ -617,6 +798,8 @@ CommandBuffer& CommandBuffer::endQuery(VkQueryPool queryPool, uint32_t query)
 CommandBuffer& CommandBuffer::endRenderPass()
 {
     device().CmdEndRenderPass(m_commandBuffer.get());
+    if (m_capture)
+        m_capture->writeAll(capture::Command::EndRenderPass);
 
     return *this;
 }
@@ -625,6 +808,8 @@ CommandBuffer& CommandBuffer::endRenderPass2(
     const vk::SubpassEndInfo& subpassEndInfo)
 {
     device().CmdEndRenderPass2KHR(m_commandBuffer.get(), &subpassEndInfo);
+    if (m_capture)
+        m_capture->writeAll(capture::Command::EndRenderPass);
 
     return *this;
 }
@@ -634,6 +819,12 @@ CommandBuffer& CommandBuffer::executeCommands(
 {
     device().CmdExecuteCommands(m_commandBuffer.get(), commandBufferCount,
                                 pCommandBuffers);
+    if (m_capture)
+    {
+        m_capture->writeAll(
+            capture::Command::ExecuteCommands,
+            capture::array(pCommandBuffers, commandBufferCount));
+    }
 
     return *this;
 }
@@ -651,6 +842,11 @@ CommandBuffer& CommandBuffer::fillBuffer(VkBuffer dstBuffer,
 {
     device().CmdFillBuffer(m_commandBuffer.get(), dstBuffer, dstOffset, size,
                            data);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::FillBuffer, dstBuffer, dstOffset,
+                            size, data);
+    }
 
     return *this;
 }
@@ -658,6 +854,8 @@ CommandBuffer& CommandBuffer::fillBuffer(VkBuffer dstBuffer,
 CommandBuffer& CommandBuffer::nextSubpass(VkSubpassContents contents)
 {
     device().CmdNextSubpass(m_commandBuffer.get(), contents);
+    if (m_capture)
+        m_capture->writeAll(capture::Command::NextSubpass, contents);
 
     return *this;
 }
@@ -668,6 +866,11 @@ CommandBuffer& CommandBuffer::nextSubpass2(
 {
     device().CmdNextSubpass2(m_commandBuffer.get(), &subpassBeginInfo,
                              &subpassEndInfo);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::NextSubpass,
+                            subpassBeginInfo.contents);
+    }
 
     return *this;
 }
@@ -684,6 +887,16 @@ CommandBuffer& CommandBuffer::pipelineBarrier(
         m_commandBuffer.get(), srcStageMask, dstStageMask, dependencyFlags,
         memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount,
         pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    if (m_capture)
+    {
+        m_capture->writeAll(
+            capture::Command::PipelineBarrier, srcStageMask, dstStageMask,
+            dependencyFlags,
+            capture::array(pMemoryBarriers, memoryBarrierCount),
+            capture::array(pBufferMemoryBarriers, bufferMemoryBarrierCount),
+            capture::array(pImageMemoryBarriers, imageMemoryBarrierCount));
+    }
+    m_stats.barriers++;
 
     return *this;
 }
@@ -757,6 +970,79 @@ CommandBuffer& CommandBuffer::pushConstants(VkPipelineLayout layout,
 {
     device().CmdPushConstants(m_commandBuffer.get(), layout, stageFlags,
                               offset, size, pValues);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::PushConstants, layout, stageFlags,
+                            offset, capture::Bytes{ pValues, size });
+    }
+    m_stats.pushConstants++;
+
+    return *this;
+}
+
+CommandBuffer& CommandBuffer::pushDescriptorSet(
+    VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
+    uint32_t set, uint32_t descriptorWriteCount,
+    const VkWriteDescriptorSet* pDescriptorWrites)
+{
+    device().CmdPushDescriptorSetKHR(m_commandBuffer.get(), pipelineBindPoint,
+                                     layout, set, descriptorWriteCount,
+                                     pDescriptorWrites);
+    if (m_capture)
+    {
+        device().frameRecorder().recordPushDescriptorSet(
+            *m_capture, pipelineBindPoint, layout, set, descriptorWriteCount,
+            pDescriptorWrites);
+    }
+    m_stats.descriptorSetBinds++;
+
+    return *this;
+}
+
+CommandBuffer& CommandBuffer::pushDescriptorSet(
+    VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
+    uint32_t set, const VkWriteDescriptorSet& descriptorWrite)
+{
+    return pushDescriptorSet(pipelineBindPoint, layout, set, 1,
+                             &descriptorWrite);
+}
+
+CommandBuffer& CommandBuffer::pushDescriptorSet(
+    VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
+    uint32_t set, VkDescriptorSetLayout setLayout,
+    DescriptorAllocator& fallbackAllocator, uint32_t descriptorWriteCount,
+    const VkWriteDescriptorSet* pDescriptorWrites)
+{
+    auto& vk = device();
+
+    if (vk.pushDescriptorSupported())
+        return pushDescriptorSet(pipelineBindPoint, layout, set,
+                                 descriptorWriteCount, pDescriptorWrites);
+
+    VkDescriptorSet descriptorSet = fallbackAllocator.allocate(setLayout);
+
+    std::vector<vk::WriteDescriptorSet> writes(
+        pDescriptorWrites, pDescriptorWrites + descriptorWriteCount);
+    for (auto& write : writes)
+        write.dstSet = descriptorSet;
+
+    vk.updateDescriptorSets(uint32_t(writes.size()), writes.data());
+
+    return bindDescriptorSet(pipelineBindPoint, layout, set, descriptorSet);
+}
+
+CommandBuffer& CommandBuffer::pushDescriptorSetWithTemplate(
+    VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+    VkPipelineLayout layout, uint32_t set, const void* pData)
+{
+    device().CmdPushDescriptorSetWithTemplateKHR(
+        m_commandBuffer.get(), descriptorUpdateTemplate, layout, set, pData);
+    if (m_capture)
+    {
+        device().frameRecorder().recordPushDescriptorSet(
+            *m_capture, descriptorUpdateTemplate, layout, set, pData);
+    }
+    m_stats.descriptorSetBinds++;
 
     return *this;
 }
@@ -775,6 +1061,11 @@ CommandBuffer& CommandBuffer::resetQueryPool(VkQueryPool queryPool,
 {
     device().CmdResetQueryPool(m_commandBuffer.get(), queryPool, firstQuery,
                                queryCount);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::ResetQueryPool, queryPool,
+                            firstQuery, queryCount);
+    }
 
     return *this;
 }
@@ -788,6 +1079,12 @@ CommandBuffer& CommandBuffer::resolveImage(VkImage srcImage,
 {
     device().CmdResolveImage(m_commandBuffer.get(), srcImage, srcImageLayout,
                              dstImage, dstImageLayout, regionCount, pRegions);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::ResolveImage, srcImage,
+                            srcImageLayout, dstImage, dstImageLayout,
+                            capture::array(pRegions, regionCount));
+    }
 
     return *this;
 }
@@ -807,6 +1104,11 @@ CommandBuffer& CommandBuffer::resolveImage(VkImage srcImage,
 CommandBuffer& CommandBuffer::setBlendConstants(const float blendConstants[4])
 {
     device().CmdSetBlendConstants(m_commandBuffer.get(), blendConstants);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetBlendConstants,
+                            capture::array(blendConstants, 4));
+    }
 
     return *this;
 }
@@ -829,6 +1131,12 @@ CommandBuffer& CommandBuffer::setDepthBias(float depthBiasConstantFactor,
 {
     device().CmdSetDepthBias(m_commandBuffer.get(), depthBiasConstantFactor,
                              depthBiasClamp, depthBiasSlopeFactor);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetDepthBias,
+                            depthBiasConstantFactor, depthBiasClamp,
+                            depthBiasSlopeFactor);
+    }
 
     return *this;
 }
@@ -838,6 +1146,11 @@ CommandBuffer& CommandBuffer::setDepthBounds(float minDepthBounds,
 {
     device().CmdSetDepthBounds(m_commandBuffer.get(), minDepthBounds,
                                maxDepthBounds);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetDepthBounds, minDepthBounds,
+                            maxDepthBounds);
+    }
 
     return *this;
 }
@@ -845,6 +1158,8 @@ CommandBuffer& CommandBuffer::setDepthBounds(float minDepthBounds,
 CommandBuffer& CommandBuffer::setDeviceMask(uint32_t deviceMask)
 {
     device().CmdSetDeviceMask(m_commandBuffer.get(), deviceMask);
+    if (m_capture)
+        m_capture->writeAll(capture::Command::SetDeviceMask, deviceMask);
 
     return *this;
 }
@@ -860,6 +1175,8 @@ CommandBuffer& CommandBuffer::setEvent(VkEvent event,
 CommandBuffer& CommandBuffer::setLineWidth(float lineWidth)
 {
     device().CmdSetLineWidth(m_commandBuffer.get(), lineWidth);
+    if (m_capture)
+        m_capture->writeAll(capture::Command::SetLineWidth, lineWidth);
 
     return *this;
 }
@@ -870,6 +1187,11 @@ CommandBuffer& CommandBuffer::setScissor(uint32_t firstScissor,
 {
     device().CmdSetScissor(m_commandBuffer.get(), firstScissor, scissorCount,
                            pScissors);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetScissor, firstScissor,
+                            capture::array(pScissors, scissorCount));
+    }
 
     return *this;
 }
@@ -894,6 +1216,11 @@ CommandBuffer& CommandBuffer::setStencilCompareMask(
 {
     device().CmdSetStencilCompareMask(m_commandBuffer.get(), faceMask,
                                       compareMask);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetStencilCompareMask, faceMask,
+                            compareMask);
+    }
 
     return *this;
 }
@@ -903,6 +1230,11 @@ CommandBuffer& CommandBuffer::setStencilReference(VkStencilFaceFlags faceMask,
 {
     device().CmdSetStencilReference(m_commandBuffer.get(), faceMask,
                                     reference);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetStencilReference, faceMask,
+                            reference);
+    }
 
     return *this;
 }
@@ -912,6 +1244,11 @@ CommandBuffer& CommandBuffer::setStencilWriteMask(VkStencilFaceFlags faceMask,
 {
     device().CmdSetStencilWriteMask(m_commandBuffer.get(), faceMask,
                                     writeMask);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetStencilWriteMask, faceMask,
+                            writeMask);
+    }
 
     return *this;
 }
@@ -922,6 +1259,11 @@ CommandBuffer& CommandBuffer::setViewport(uint32_t firstViewport,
 {
     device().CmdSetViewport(m_commandBuffer.get(), firstViewport,
                             viewportCount, pViewports);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::SetViewport, firstViewport,
+                            capture::array(pViewports, viewportCount));
+    }
 
     return *this;
 }
@@ -948,6 +1290,11 @@ CommandBuffer& CommandBuffer::updateBuffer(VkBuffer dstBuffer,
 {
     device().CmdUpdateBuffer(m_commandBuffer.get(), dstBuffer, dstOffset,
                              dataSize, pData);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::UpdateBuffer, dstBuffer,
+                            dstOffset, capture::Bytes{ pData, dataSize });
+    }
 
     return *this;
 }
@@ -965,6 +1312,15 @@ CommandBuffer& CommandBuffer::waitEvents(
         m_commandBuffer.get(), eventCount, pEvents, srcStageMask, dstStageMask,
         memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount,
         pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    if (m_capture)
+    {
+        m_capture->writeAll(
+            capture::Command::PipelineBarrier, srcStageMask, dstStageMask,
+            VkDependencyFlags(0),
+            capture::array(pMemoryBarriers, memoryBarrierCount),
+            capture::array(pBufferMemoryBarriers, bufferMemoryBarrierCount),
+            capture::array(pImageMemoryBarriers, imageMemoryBarrierCount));
+    }
 
     return *this;
 }
@@ -1097,6 +1453,11 @@ CommandBuffer& CommandBuffer::writeTimestamp(
 {
     device().CmdWriteTimestamp(m_commandBuffer.get(), pipelineStage, queryPool,
                                query);
+    if (m_capture)
+    {
+        m_capture->writeAll(capture::Command::WriteTimestamp, pipelineStage,
+                            queryPool, query);
+    }
 
     return *this;
 }
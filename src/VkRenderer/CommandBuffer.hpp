@@ -1,5 +1,7 @@
 #pragma once
 
+#include "FrameCapture.hpp"
+#include "Stats.hpp"
 #include "VulkanDevice.hpp"
 
 #include "cdm_vulkan.hpp"
@@ -9,6 +11,7 @@
 namespace cdm
 {
 class CommandPool;
+class DescriptorAllocator;
 class UniqueComputePipeline;
 class UniqueGraphicsPipeline;
 
@@ -17,6 +20,10 @@ class CommandBuffer final : public VulkanDeviceObject
 	Movable<VkCommandPool> m_parentCommandPool;
 	Movable<VkCommandBuffer> m_commandBuffer;
 
+	RecordingStats m_stats;
+	/// commands of the frame being captured, shared with the `FrameRecorder`
+	std::shared_ptr<capture::Writer> m_capture;
+
 public:
 	CommandBuffer(
 	    const VulkanDevice& device, VkCommandPool parentCommandPool,
@@ -38,6 +45,9 @@ public:
 	operator VkCommandBuffer&() { return commandBuffer(); }
 	operator const VkCommandBuffer&() const { return commandBuffer(); }
 
+	/// Commands recorded since the last `begin`
+	const RecordingStats& stats() const { return m_stats; }
+
 	// clang-format off
 	VkResult begin();
 	VkResult begin(const cdm::vk::CommandBufferBeginInfo& beginInfo);
@@ -109,6 +119,13 @@ public:
 	CommandBuffer& pushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues);
 	template<typename T>
 	CommandBuffer& pushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, const T* pValues);
+	/// Requires `VulkanDevice::pushDescriptorSupported`, `layout` must have been created with a push descriptor set layout at index `set`
+	CommandBuffer& pushDescriptorSet(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t set, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites);
+	CommandBuffer& pushDescriptorSet(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t set, const VkWriteDescriptorSet& descriptorWrite);
+	/// Pushes the descriptors if the device supports it, otherwise allocates a set of `setLayout` from `fallbackAllocator`, writes and binds it. `dstSet` of the writes is ignored
+	CommandBuffer& pushDescriptorSet(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t set, VkDescriptorSetLayout setLayout, DescriptorAllocator& fallbackAllocator, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites);
+	/// `descriptorUpdateTemplate` must be of the `VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR` type
+	CommandBuffer& pushDescriptorSetWithTemplate(VkDescriptorUpdateTemplate descriptorUpdateTemplate, VkPipelineLayout layout, uint32_t set, const void* pData);
 	CommandBuffer& resetEvent(VkEvent event, VkPipelineStageFlags stageMask);
 	CommandBuffer& resetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount);
 	CommandBuffer& resolveImage(VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageResolve* pRegions);
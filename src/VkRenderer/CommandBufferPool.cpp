@@ -1,5 +1,5 @@
 #include "CommandBufferPool.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 
 namespace cdm
 {
@@ -0,0 +1,196 @@
+#include "CpuProfiler.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace cdm
+{
+namespace
+{
+constexpr size_t EventsPerThread = 1 << 16;
+
+struct ThreadBuffer
+{
+	uint32_t thread = 0;
+	uint32_t depth = 0;
+	/// capture of the events, only written by the owning thread
+	std::atomic<uint32_t> capture = 0;
+	std::atomic<size_t> count = 0;
+	std::unique_ptr<CpuProfiler::Event[]> events =
+	    std::make_unique<CpuProfiler::Event[]>(EventsPerThread);
+};
+
+/// incremented by both start and stop, odd while capturing
+std::atomic<uint32_t> captureIndex = 0;
+std::chrono::steady_clock::time_point captureStart;
+
+std::mutex buffersMutex;
+/// never freed, the events of exited threads stay readable
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+ThreadBuffer& threadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+
+	if (buffer == nullptr)
+	{
+		std::lock_guard lock(buffersMutex);
+		buffer = buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+		buffer->thread = uint32_t(buffers.size() - 1);
+	}
+
+	return *buffer;
+}
+
+uint32_t latestCapture()
+{
+	uint32_t index = captureIndex.load(std::memory_order_acquire);
+	return (index & 1) ? index : index - 1;
+}
+
+void writeEscaped(std::ostream& os, std::string_view str)
+{
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			os << '\\';
+		os << c;
+	}
+}
+
+double microseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::micro>(duration).count();
+}
+}  // namespace
+
+CpuProfiler::Zone::Zone(const char* name)
+    : m_name(name),
+      m_capture(captureIndex.load(std::memory_order_relaxed))
+{
+	if ((m_capture & 1) == 0)
+		return;
+
+	ThreadBuffer& buffer = threadBuffer();
+	if (buffer.capture.load(std::memory_order_relaxed) != m_capture)
+	{
+		buffer.count.store(0, std::memory_order_relaxed);
+		buffer.capture.store(m_capture, std::memory_order_release);
+	}
+	buffer.depth++;
+
+	m_begin = std::chrono::steady_clock::now();
+}
+
+CpuProfiler::Zone::~Zone()
+{
+	if ((m_capture & 1) == 0)
+		return;
+
+	auto end = std::chrono::steady_clock::now();
+
+	ThreadBuffer& buffer = threadBuffer();
+	buffer.depth--;
+
+	// a newer capture started by a nested zone
+	if (buffer.capture.load(std::memory_order_relaxed) != m_capture)
+		return;
+
+	size_t index = buffer.count.load(std::memory_order_relaxed);
+	if (index >= EventsPerThread)
+		return;
+
+	buffer.events[index] =
+	    Event{ m_name, buffer.thread, buffer.depth, m_begin, end };
+	buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::startCapture()
+{
+	if (capturing())
+		return;
+
+	captureStart = std::chrono::steady_clock::now();
+	captureIndex.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void CpuProfiler::stopCapture()
+{
+	if (capturing())
+		captureIndex.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool CpuProfiler::capturing()
+{
+	return captureIndex.load(std::memory_order_acquire) & 1;
+}
+
+std::vector<CpuProfiler::Event> CpuProfiler::events()
+{
+	std::vector<Event> res;
+
+	uint32_t capture = latestCapture();
+
+	std::lock_guard lock(buffersMutex);
+	for (const auto& buffer : buffers)
+	{
+		if (buffer->capture.load(std::memory_order_acquire) != capture)
+			continue;
+
+		size_t count = buffer->count.load(std::memory_order_acquire);
+		res.insert(res.end(), buffer->events.get(),
+		           buffer->events.get() + count);
+	}
+
+	return res;
+}
+
+bool CpuProfiler::writeChromeTrace(
+    const std::string& path, const std::vector<GpuProfiler::Result>& gpuResults)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << "error: failed to open " << path << std::endl;
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+	        "\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+	        "\"args\":{\"name\":\"GPU\"}}";
+
+	for (const Event& event : events())
+	{
+		file << ",\n{\"name\":\"";
+		writeEscaped(file, event.name);
+		file << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+		     << event.thread
+		     << ",\"ts\":" << microseconds(event.begin - captureStart)
+		     << ",\"dur\":" << microseconds(event.end - event.begin) << "}";
+	}
+
+	for (const GpuProfiler::Result& result : gpuResults)
+	{
+		// frames in flight when the capture started
+		if (result.begin < captureStart)
+			continue;
+
+		file << ",\n{\"name\":\"";
+		writeEscaped(file, result.name);
+		file << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+		     << ",\"ts\":" << microseconds(result.begin - captureStart)
+		     << ",\"dur\":" << result.milliseconds * 1000.0 << "}";
+	}
+
+	file << "\n]}\n";
+
+	return file.good();
+}
+}  // namespace cdm
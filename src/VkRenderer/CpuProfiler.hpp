@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GpuProfiler.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace cdm
+{
+/// Scoped CPU zones of every thread, recorded while a capture runs. Each
+/// thread appends to a fixed size buffer of its own without taking a
+/// lock; zones beyond its capacity are dropped.
+/// A capture is written with the GPU scopes as a Chrome trace, which
+/// chrome://tracing and Perfetto open
+class CpuProfiler final
+{
+public:
+	struct Event
+	{
+		/// zones are named by string literals, the name is not copied
+		const char* name = nullptr;
+		/// index of the thread in order of first recorded zone
+		uint32_t thread = 0;
+		uint32_t depth = 0;
+		std::chrono::steady_clock::time_point begin;
+		std::chrono::steady_clock::time_point end;
+	};
+
+	/// Records an event spanning its lifetime if a capture is running when
+	/// it is constructed. Costs one atomic load otherwise
+	class Zone final
+	{
+		const char* m_name = nullptr;
+		uint32_t m_capture = 0;
+		std::chrono::steady_clock::time_point m_begin;
+
+	public:
+		explicit Zone(const char* name);
+		Zone(const Zone&) = delete;
+		Zone(Zone&&) = delete;
+		~Zone();
+
+		Zone& operator=(const Zone&) = delete;
+		Zone& operator=(Zone&&) = delete;
+	};
+
+	CpuProfiler() = delete;
+
+	/// Drops the events of the previous capture
+	static void startCapture();
+	static void stopCapture();
+	static bool capturing();
+
+	/// Events of the current or latest capture, sorted by thread then by
+	/// end time. Must not be called concurrently with `startCapture`
+	static std::vector<Event> events();
+
+	/// Writes the events in the Chrome trace event format, with
+	/// `gpuResults` on a track of their own. Timestamps are relative to
+	/// the capture start
+	static bool writeChromeTrace(
+	    const std::string& path,
+	    const std::vector<GpuProfiler::Result>& gpuResults = {});
+};
+}  // namespace cdm
@@ -3,20 +3,22 @@
 #include "Buffer.hpp"
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
-#include "RenderWindow.hpp"
+#include "FrameRecorder.hpp"
+#include "RenderContext.hpp"
 #include "StagingBuffer.hpp"
+#include "Stats.hpp"
 
 #include <stdexcept>
 
 namespace cdm
 {
-Cubemap::Cubemap(RenderWindow& renderWindow, uint32_t imageWidth,
+Cubemap::Cubemap(RenderContext& renderContext, uint32_t imageWidth,
                  uint32_t imageHeight, VkFormat imageFormat,
                  VkImageTiling imageTiling, VkImageUsageFlags usage,
                  VmaMemoryUsage memoryUsage,
                  VkMemoryPropertyFlags requiredFlags, uint32_t mipLevels,
                  VkSampleCountFlagBits samples)
-    : rw(&renderWindow)
+    : rw(&renderContext)
 {
 	auto& vk = rw.get()->device();
 
@@ -52,6 +54,8 @@ Cubemap::Cubemap(RenderWindow& renderWindow, uint32_t imageWidth,
 
 	if (m_image == false)
 		throw std::runtime_error("could not create image");
+	vk.memoryStats().allocated(MemoryCategory::Texture, allocInfo.size);
+	vk.frameRecorder().recordImage(m_image.get(), info, imageAllocCreateInfo);
 #pragma endregion
 
 	m_width = imageWidth;
@@ -126,7 +130,12 @@ Cubemap::~Cubemap()
 		if (m_imageView)
 			m_imageView.reset();
 		if (m_image)
+		{
+			vk.memoryStats().freed(MemoryCategory::Texture, m_size);
+			vk.frameRecorder().recordDestruction(
+			    capture::handleId(m_image.get()));
 			vmaDestroyImage(vk.allocator(), m_image.get(), m_allocation.get());
+		}
 	}
 }
 
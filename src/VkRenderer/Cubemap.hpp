@@ -7,11 +7,11 @@
 
 namespace cdm
 {
-class RenderWindow;
+class RenderContext;
 
 class Cubemap final : public TextureInterface
 {
-	Movable<RenderWindow*> rw;
+	Movable<RenderContext*> rw;
 
 	Movable<VmaAllocation> m_allocation;
 	Movable<VkImage> m_image;
@@ -37,7 +37,7 @@ class Cubemap final : public TextureInterface
 
 public:
 	Cubemap() = default;
-	Cubemap(RenderWindow& renderWindow, uint32_t imageWidth,
+	Cubemap(RenderContext& renderContext, uint32_t imageWidth,
 	        uint32_t imageHeight, VkFormat imageFormat,
 	        VkImageTiling imageTiling, VkImageUsageFlags usage,
 	        VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags requiredFlags,
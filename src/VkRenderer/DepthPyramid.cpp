@@ -0,0 +1,889 @@
+#include "DepthPyramid.hpp"
+
+#include "CommandBuffer.hpp"
+#include "DepthTexture.hpp"
+#include "MyShaderWriter.hpp"
+#include "PipelineFactory.hpp"
+#include "RenderContext.hpp"
+#include "TextureFactory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace cdm
+{
+DepthPyramid::DepthPyramid(RenderContext& renderContext,
+                           const DepthTexture& depth)
+    : rw(renderContext),
+      m_extent(depth.extent2D()),
+      m_depthImage(depth.get())
+{
+	auto& vk = rw.get().device();
+
+	LogRRID log(vk);
+
+	const uint32_t levels =
+	    uint32_t(std::floor(std::log2(
+	        float(std::max(m_extent.width, m_extent.height))))) +
+	    1;
+
+#pragma region pyramid texture
+	TextureFactory f(vk);
+
+	f.setExtent(m_extent);
+	f.setMipLevels(levels);
+	f.setFormat(VK_FORMAT_R32G32_SFLOAT);
+	f.setUsage(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+	           VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+	f.setFilters(VK_FILTER_NEAREST, VK_FILTER_NEAREST);
+	f.setMipmapMode(VK_SAMPLER_MIPMAP_MODE_NEAREST);
+	f.setMaxLod(float(levels));
+
+	m_pyramid = f.createTexture2D();
+	m_pyramid.transitionLayoutImmediate(VK_IMAGE_LAYOUT_UNDEFINED,
+	                                    VK_IMAGE_LAYOUT_GENERAL);
+	vk.debugMarkerSetObjectName(m_pyramid.image(), "Depth pyramid image");
+
+	for (uint32_t i = 0; i < levels; i++)
+	{
+		vk::ImageViewCreateInfo viewInfo;
+		viewInfo.image = m_pyramid.image();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32G32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = i;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		m_levelViews.push_back(vk.create(viewInfo));
+		if (!m_levelViews.back())
+		{
+			std::cerr << "error: failed to create depth pyramid level view"
+			          << std::endl;
+			abort();
+		}
+		vk.debugMarkerSetObjectName(
+		    m_levelViews.back().get(),
+		    "Depth pyramid level " + std::to_string(i) + " imageView");
+	}
+
+	vk::SamplerCreateInfo samplerInfo;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = float(levels);
+
+	m_sampler = vk.create(samplerInfo);
+	if (!m_sampler)
+	{
+		std::cerr << "error: failed to create depth pyramid sampler"
+		          << std::endl;
+		abort();
+	}
+#pragma endregion
+
+#pragma region readback buffer
+	m_readbackLevel = levels - 1;
+	for (uint32_t i = 0; i < levels; i++)
+	{
+		VkExtent2D extent = levelExtent(i);
+		if (std::max(extent.width, extent.height) <= MaxReadbackResolution)
+		{
+			m_readbackLevel = i;
+			break;
+		}
+	}
+	m_readbackExtent = levelExtent(m_readbackLevel);
+
+	m_frames.resize(std::max(rw.get().framesInFlight(), 1u));
+	for (size_t i = 0; i < m_frames.size(); i++)
+	{
+		m_frames[i].readbackBuffer = Buffer(
+		    vk,
+		    sizeof(vector2) * m_readbackExtent.width *
+		        m_readbackExtent.height,
+		    VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_frames[i].readbackBuffer.setName(
+		    "Depth pyramid readback buffer " + std::to_string(i));
+	}
+#pragma endregion
+
+#pragma region reduce shaders
+	ComputeShaderHelperResult copyResult;
+	ComputeShaderHelperResult reduceResult;
+
+	{
+		using namespace sdw;
+		ComputeWriter writer;
+
+		auto in = writer.getIn();
+
+		writer.inputLayout(8, 8);
+
+		sdw::Pcb pcb(writer, "ReducePCB");
+		pcb.declMember<IVec2>("srcSize");
+		pcb.declMember<IVec2>("dstSize");
+		pcb.end();
+
+		auto dst = writer.declImage<ast::type::ImageFormat::eRg32f,
+		                            ast::type::AccessKind::eWrite,
+		                            ast::type::ImageDim::e2D, false, false,
+		                            false>("dst", 1, 0);
+		writer.addDescriptor(1, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+		// min and max of all the samples of a texel
+		auto implementCopy = [&](auto depthImage, uint32_t sampleCount) {
+			writer.implementMain([&]() {
+				Locale(coord,
+				       ivec2(writer.cast<Int>(in.globalInvocationID.x()),
+				             writer.cast<Int>(in.globalInvocationID.y())));
+				Locale(dstSize, pcb.getMember<IVec2>("dstSize"));
+
+				IF(writer, coord.x() >= dstSize.x() || coord.y() >= dstSize.y())
+				{
+					writer.returnStmt();
+				}
+				FI;
+
+				Locale(minMax, vec2(1.0_f, 0.0_f));
+				FLOAT(sampleDepth);
+
+				for (uint32_t i = 0; i < sampleCount; i++)
+				{
+					sampleDepth = depthImage.fetch(coord, Int(int32_t(i)));
+					minMax = vec2(min(minMax.x(), sampleDepth),
+					              max(minMax.y(), sampleDepth));
+				}
+
+				dst.store(coord, minMax);
+			});
+		};
+
+		if (depth.samples() == VK_SAMPLE_COUNT_1_BIT)
+			implementCopy(
+			    writer.declSampledImage<ast::type::ImageFormat::eR32f,
+			                            ast::type::ImageDim::e2D, false,
+			                            false, false>("depth", 0, 0),
+			    1);
+		else
+			implementCopy(
+			    writer.declSampledImage<ast::type::ImageFormat::eR32f,
+			                            ast::type::ImageDim::e2D, false,
+			                            false, true>("depth", 0, 0),
+			    uint32_t(depth.samples()));
+
+		copyResult = writer.createHelperResult(vk);
+		if (!copyResult.module)
+		{
+			std::cerr
+			    << "error: failed to create depth pyramid copy shader module"
+			    << std::endl;
+			abort();
+		}
+	}
+
+	{
+		using namespace sdw;
+		ComputeWriter writer;
+
+		auto in = writer.getIn();
+
+		writer.inputLayout(8, 8);
+
+		sdw::Pcb pcb(writer, "ReducePCB");
+		pcb.declMember<IVec2>("srcSize");
+		pcb.declMember<IVec2>("dstSize");
+		pcb.end();
+
+		auto src = writer.declSampledImage<FImg2DRg32>("src", 0, 0);
+		auto dst = writer.declImage<ast::type::ImageFormat::eRg32f,
+		                            ast::type::AccessKind::eWrite,
+		                            ast::type::ImageDim::e2D, false, false,
+		                            false>("dst", 1, 0);
+		writer.addDescriptor(1, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+
+		writer.implementMain([&]() {
+			Locale(coord, ivec2(writer.cast<Int>(in.globalInvocationID.x()),
+			                    writer.cast<Int>(in.globalInvocationID.y())));
+			Locale(srcSize, pcb.getMember<IVec2>("srcSize"));
+			Locale(dstSize, pcb.getMember<IVec2>("dstSize"));
+
+			IF(writer, coord.x() >= dstSize.x() || coord.y() >= dstSize.y())
+			{
+				writer.returnStmt();
+			}
+			FI;
+
+			// the last column and row also cover the remaining texels of an
+			// odd sized source level
+			Locale(footprint, ivec2(2_i, 2_i));
+			IF(writer, coord.x() == dstSize.x() - 1_i &&
+			               srcSize.x() % 2_i == 1_i)
+			{
+				footprint.x() = 3_i;
+			}
+			FI;
+			IF(writer, coord.y() == dstSize.y() - 1_i &&
+			               srcSize.y() % 2_i == 1_i)
+			{
+				footprint.y() = 3_i;
+			}
+			FI;
+
+			Locale(srcCoord, ivec2(coord.x() * 2_i, coord.y() * 2_i));
+			Locale(minMax, vec2(1.0_f, 0.0_f));
+			VEC2(texel);
+
+			FOR(writer, Int, y, 0_i, y < footprint.y(), y++)
+			{
+				FOR(writer, Int, x, 0_i, x < footprint.x(), x++)
+				{
+					texel = src.fetch(
+					    min(srcCoord + ivec2(x, y), srcSize - ivec2(1_i, 1_i)),
+					    0_i);
+					minMax = vec2(min(minMax.x(), texel.x()),
+					              max(minMax.y(), texel.y()));
+				}
+				ROF;
+			}
+			ROF;
+
+			dst.store(coord, minMax);
+		});
+
+		reduceResult = writer.createHelperResult(vk);
+		if (!reduceResult.module)
+		{
+			std::cerr
+			    << "error: failed to create depth pyramid reduce shader module"
+			    << std::endl;
+			abort();
+		}
+	}
+#pragma endregion
+
+#pragma region cull shader
+	ComputeShaderHelperResult cullResult;
+
+	{
+		using namespace sdw;
+		ComputeWriter writer;
+
+		auto in = writer.getIn();
+
+		writer.inputLayout(64);
+
+		sdw::Pcb pcb(writer, "CullPCB");
+		pcb.declMember<Mat4>("viewProj");
+		pcb.declMember<IVec2>("pyramidSize");
+		pcb.declMember<UInt>("objectCount");
+		pcb.declMember<Int>("levelCount");
+		pcb.end();
+
+		auto pyramid = writer.declSampledImage<FImg2DRg32>("pyramid", 0, 0);
+
+		sdw::Ssbo boundsSsbo(writer, "BoundsSSBO", 1, 0);
+		auto bounds = boundsSsbo.declMemberArray<Vec4>("bounds");
+		boundsSsbo.end();
+		writer.addDescriptor(1, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+		// tightly packed `VkDrawIndexedIndirectCommand`s
+		sdw::Ssbo commandsSsbo(writer, "DrawCommandsSSBO", 2, 0);
+		auto commands = commandsSsbo.declMemberArray<UInt>("commands");
+		commandsSsbo.end();
+		writer.addDescriptor(2, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+		writer.implementMain([&]() {
+			Locale(objectIndex, in.globalInvocationID.x());
+
+			IF(writer, objectIndex >= pcb.getMember<UInt>("objectCount"))
+			{
+				writer.returnStmt();
+			}
+			FI;
+
+			Locale(viewProj, pcb.getMember<Mat4>("viewProj"));
+			Locale(bMin, bounds[objectIndex * 2_u].xyz());
+			Locale(bMax, bounds[objectIndex * 2_u + 1_u].xyz());
+
+			Locale(rectMin, vec2(1.0_f, 1.0_f));
+			Locale(rectMax, vec2(0.0_f, 0.0_f));
+			Locale(nearestDepth, 1.0_f);
+			Locale(minW, 1.0_f);
+			auto clip = writer.declLocale<Vec4>("clip");
+			VEC3(ndc);
+
+			for (uint32_t c = 0; c < 8; c++)
+			{
+				clip = viewProj * vec4((c & 1) ? bMax.x() : bMin.x(),
+				                       (c & 2) ? bMax.y() : bMin.y(),
+				                       (c & 4) ? bMax.z() : bMin.z(), 1.0_f);
+				if (c == 0)
+					minW = clip.w();
+				else
+					minW = min(minW, clip.w());
+				ndc = clip.xyz() / clip.w();
+				rectMin = min(rectMin, ndc.xy() * vec2(0.5_f, 0.5_f) +
+				                           vec2(0.5_f, 0.5_f));
+				rectMax = max(rectMax, ndc.xy() * vec2(0.5_f, 0.5_f) +
+				                           vec2(0.5_f, 0.5_f));
+				nearestDepth = min(nearestDepth, ndc.z());
+			}
+
+			Locale(visible, 1_u);
+
+			// boxes crossing the near plane are always visible
+			IF(writer, minW > 0.0_f)
+			{
+				IF(writer, rectMin.x() > 1.0_f || rectMin.y() > 1.0_f ||
+				               rectMax.x() < 0.0_f || rectMax.y() < 0.0_f ||
+				               nearestDepth > 1.0_f)
+				{
+					visible = 0_u;
+				}
+				ELSE
+				{
+					Locale(pyramidSize, pcb.getMember<IVec2>("pyramidSize"));
+					Locale(pyramidSizef,
+					       vec2(writer.cast<Float>(pyramidSize.x()),
+					            writer.cast<Float>(pyramidSize.y())));
+					Locale(texelMinf, clamp(rectMin, vec2(0.0_f, 0.0_f),
+					                        vec2(1.0_f, 1.0_f)) *
+					                      pyramidSizef);
+					Locale(texelMaxf, clamp(rectMax, vec2(0.0_f, 0.0_f),
+					                        vec2(1.0_f, 1.0_f)) *
+					                      pyramidSizef);
+
+					// level where the box covers at most 2x2 texels
+					Locale(level,
+					       writer.cast<Int>(ceil(log2(
+					           max(max(texelMaxf.x() - texelMinf.x(),
+					                   texelMaxf.y() - texelMinf.y()),
+					               1.0_f)))));
+					level = min(level, pcb.getMember<Int>("levelCount") - 1_i);
+
+					Locale(lastTexel,
+					       ivec2(max(pyramidSize.x() >> level, 1_i) - 1_i,
+					             max(pyramidSize.y() >> level, 1_i) - 1_i));
+					Locale(texelMin,
+					       ivec2(min(writer.cast<Int>(texelMinf.x()) >> level,
+					                 lastTexel.x()),
+					             min(writer.cast<Int>(texelMinf.y()) >> level,
+					                 lastTexel.y())));
+					Locale(texelMax,
+					       ivec2(min(writer.cast<Int>(texelMaxf.x()) >> level,
+					                 lastTexel.x()),
+					             min(writer.cast<Int>(texelMaxf.y()) >> level,
+					                 lastTexel.y())));
+
+					Locale(farthestDepth, 0.0_f);
+					FOR(writer, Int, y, texelMin.y(), y <= texelMax.y(), y++)
+					{
+						FOR(writer, Int, x, texelMin.x(), x <= texelMax.x(),
+						    x++)
+						{
+							farthestDepth =
+							    max(farthestDepth,
+							        pyramid.fetch(ivec2(x, y), level).y());
+						}
+						ROF;
+					}
+					ROF;
+
+					IF(writer, nearestDepth > farthestDepth)
+					{
+						visible = 0_u;
+					}
+					FI;
+				}
+				FI;
+			}
+			FI;
+
+			commands[objectIndex * 5_u + 1_u] = visible;
+		});
+
+		cullResult = writer.createHelperResult(vk);
+		if (!cullResult.module)
+		{
+			std::cerr
+			    << "error: failed to create depth pyramid cull shader module"
+			    << std::endl;
+			abort();
+		}
+	}
+#pragma endregion
+
+#pragma region pipelines
+	ComputePipelineFactory factory(vk);
+
+	{
+		std::vector<VkPushConstantRange> pushConstants{
+			{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReducePcbStruct) },
+		};
+
+		auto [pipelineLayout, descriptorSetLayouts] =
+		    factory.createLayout(copyResult, pushConstants);
+
+		m_reducePipelineLayout = std::move(pipelineLayout);
+		m_reduceSetLayouts = std::move(descriptorSetLayouts);
+	}
+
+	factory.setLayout(m_reducePipelineLayout);
+	factory.setShaderModule(copyResult.module);
+	m_copyPipeline = factory.createPipeline();
+	factory.setShaderModule(reduceResult.module);
+	m_reducePipeline = factory.createPipeline();
+
+	{
+		std::vector<VkPushConstantRange> pushConstants{
+			{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPcbStruct) },
+		};
+
+		auto [pipelineLayout, descriptorSetLayouts] =
+		    factory.createLayout(cullResult, pushConstants);
+
+		m_cullPipelineLayout = std::move(pipelineLayout);
+		m_cullSetLayouts = std::move(descriptorSetLayouts);
+	}
+
+	factory.setLayout(m_cullPipelineLayout);
+	factory.setShaderModule(cullResult.module);
+	m_cullPipeline = factory.createPipeline();
+
+	if (!m_copyPipeline || !m_reducePipeline || !m_cullPipeline)
+	{
+		std::cerr << "error: failed to create depth pyramid pipelines"
+		          << std::endl;
+		abort();
+	}
+#pragma endregion
+
+#pragma region descriptor pool
+	const uint32_t frameCount = uint32_t(m_frames.size());
+
+	std::array poolSizes{
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		                      levels + frameCount },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levels },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		                      2 * frameCount },
+	};
+
+	vk::DescriptorPoolCreateInfo poolInfo;
+	poolInfo.maxSets = levels + frameCount;
+	poolInfo.poolSizeCount = uint32_t(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	m_descriptorPool = vk.create(poolInfo);
+	if (!m_descriptorPool)
+	{
+		std::cerr << "error: failed to create depth pyramid descriptor pool"
+		          << std::endl;
+		abort();
+	}
+#pragma endregion
+
+#pragma region descriptor sets
+	for (uint32_t i = 0; i < levels; i++)
+	{
+		VkDescriptorSet set =
+		    vk.allocate(m_descriptorPool, m_reduceSetLayouts[0]);
+		if (!set)
+		{
+			std::cerr << "error: failed to allocate descriptor set"
+			          << std::endl;
+			abort();
+		}
+		m_reduceDescriptorSets.push_back(set);
+
+		VkDescriptorImageInfo srcInfo{};
+		srcInfo.sampler = m_sampler;
+		if (i == 0)
+		{
+			srcInfo.imageView = depth.view();
+			srcInfo.imageLayout =
+			    VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		}
+		else
+		{
+			srcInfo.imageView = m_levelViews[i - 1];
+			srcInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		}
+
+		VkDescriptorImageInfo dstInfo{};
+		dstInfo.imageView = m_levelViews[i];
+		dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		vk::WriteDescriptorSet srcWrite;
+		srcWrite.descriptorCount = 1;
+		srcWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		srcWrite.dstArrayElement = 0;
+		srcWrite.dstBinding = 0;
+		srcWrite.dstSet = set;
+		srcWrite.pImageInfo = &srcInfo;
+
+		vk::WriteDescriptorSet dstWrite;
+		dstWrite.descriptorCount = 1;
+		dstWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		dstWrite.dstArrayElement = 0;
+		dstWrite.dstBinding = 1;
+		dstWrite.dstSet = set;
+		dstWrite.pImageInfo = &dstInfo;
+
+		vk.updateDescriptorSets({ srcWrite, dstWrite });
+	}
+
+	VkDescriptorImageInfo pyramidInfo{};
+	pyramidInfo.sampler = m_sampler;
+	pyramidInfo.imageView = m_pyramid.view();
+	pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	for (Frame& frame : m_frames)
+	{
+		frame.cullDescriptorSet =
+		    vk.allocate(m_descriptorPool, m_cullSetLayouts[0]);
+		if (!frame.cullDescriptorSet)
+		{
+			std::cerr << "error: failed to allocate descriptor set"
+			          << std::endl;
+			abort();
+		}
+
+		vk::WriteDescriptorSet pyramidWrite;
+		pyramidWrite.descriptorCount = 1;
+		pyramidWrite.descriptorType =
+		    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pyramidWrite.dstArrayElement = 0;
+		pyramidWrite.dstBinding = 0;
+		pyramidWrite.dstSet = frame.cullDescriptorSet;
+		pyramidWrite.pImageInfo = &pyramidInfo;
+
+		vk.updateDescriptorSets(pyramidWrite);
+	}
+#pragma endregion
+}
+
+VkExtent2D DepthPyramid::levelExtent(uint32_t level) const
+{
+	return { std::max(m_extent.width >> level, 1u),
+		     std::max(m_extent.height >> level, 1u) };
+}
+
+DepthPyramid::Frame& DepthPyramid::currentFrame()
+{
+	return m_frames[rw.get().currentFrame() % m_frames.size()];
+}
+
+void DepthPyramid::invalidate() noexcept
+{
+	m_valid = false;
+
+	// the readbacks in flight were built from another depth
+	for (Frame& frame : m_frames)
+		frame.readbackPending = false;
+	m_readbackDepths.clear();
+}
+
+void DepthPyramid::build(CommandBuffer& cb, const matrix4& viewProj)
+{
+	const uint32_t levels = levelCount();
+
+	cb.debugMarkerBegin("depth pyramid", 0.5f, 0.5f, 0.5f);
+
+	vk::ImageMemoryBarrier depthBarrier;
+	depthBarrier.image = m_depthImage;
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	depthBarrier.subresourceRange.baseMipLevel = 0;
+	depthBarrier.subresourceRange.levelCount = 1;
+	depthBarrier.subresourceRange.baseArrayLayer = 0;
+	depthBarrier.subresourceRange.layerCount = 1;
+	depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+	                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, depthBarrier);
+
+	// the previous pyramid may still be read by the culling pass and the
+	// readback copy
+	vk::ImageMemoryBarrier pyramidBarrier;
+	pyramidBarrier.image = m_pyramid.image();
+	pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	pyramidBarrier.subresourceRange.baseMipLevel = 0;
+	pyramidBarrier.subresourceRange.levelCount = levels;
+	pyramidBarrier.subresourceRange.baseArrayLayer = 0;
+	pyramidBarrier.subresourceRange.layerCount = 1;
+	pyramidBarrier.srcAccessMask =
+	    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+	                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+	                   pyramidBarrier);
+
+	cb.bindPipeline(m_copyPipeline);
+
+	for (uint32_t i = 0; i < levels; i++)
+	{
+		if (i == 1)
+			cb.bindPipeline(m_reducePipeline);
+
+		if (i > 0)
+		{
+			pyramidBarrier.subresourceRange.baseMipLevel = i - 1;
+			pyramidBarrier.subresourceRange.levelCount = 1;
+			pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			cb.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			                   pyramidBarrier);
+		}
+
+		const VkExtent2D srcExtent = i == 0 ? m_extent : levelExtent(i - 1);
+		const VkExtent2D dstExtent = levelExtent(i);
+
+		ReducePcbStruct pcb;
+		pcb.srcWidth = int32_t(srcExtent.width);
+		pcb.srcHeight = int32_t(srcExtent.height);
+		pcb.dstWidth = int32_t(dstExtent.width);
+		pcb.dstHeight = int32_t(dstExtent.height);
+
+		cb.bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE,
+		                     m_reducePipelineLayout, 0,
+		                     m_reduceDescriptorSets[i]);
+		cb.pushConstants(m_reducePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+		                 0, &pcb);
+		cb.dispatch((dstExtent.width + 7) / 8, (dstExtent.height + 7) / 8);
+	}
+
+	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+	                             VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+	                       VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+	                   0, depthBarrier);
+
+	pyramidBarrier.subresourceRange.baseMipLevel = levels - 1;
+	pyramidBarrier.subresourceRange.levelCount = 1;
+	pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	pyramidBarrier.dstAccessMask =
+	    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+	                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                   0, pyramidBarrier);
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = m_readbackLevel;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = m_readbackExtent.width;
+	region.imageExtent.height = m_readbackExtent.height;
+	region.imageExtent.depth = 1;
+
+	Frame& frame = currentFrame();
+
+	cb.copyImageToBuffer(m_pyramid.image(), VK_IMAGE_LAYOUT_GENERAL,
+	                     frame.readbackBuffer, region);
+
+	vk::BufferMemoryBarrier readbackBarrier;
+	readbackBarrier.buffer = frame.readbackBuffer;
+	readbackBarrier.offset = 0;
+	readbackBarrier.size = VK_WHOLE_SIZE;
+	readbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	readbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                   VK_PIPELINE_STAGE_HOST_BIT, 0, readbackBarrier);
+
+	cb.debugMarkerEnd();
+
+	m_viewProj = viewProj;
+	m_valid = true;
+	frame.readbackViewProj = viewProj;
+	frame.readbackPending = true;
+}
+
+void DepthPyramid::setCullingBuffers(uint32_t frameIndex,
+                                     const Buffer& boundsBuffer,
+                                     const Buffer& drawCommandsBuffer)
+{
+	auto& vk = rw.get().device();
+
+	if (frameIndex >= m_frames.size())
+		throw std::runtime_error("error: invalid depth pyramid frame index");
+
+	Frame& frame = m_frames[frameIndex];
+	frame.drawCommandsBuffer = drawCommandsBuffer;
+
+	VkDescriptorBufferInfo boundsInfo{};
+	boundsInfo.buffer = boundsBuffer;
+	boundsInfo.offset = 0;
+	boundsInfo.range = VK_WHOLE_SIZE;
+
+	VkDescriptorBufferInfo commandsInfo{};
+	commandsInfo.buffer = drawCommandsBuffer;
+	commandsInfo.offset = 0;
+	commandsInfo.range = VK_WHOLE_SIZE;
+
+	vk::WriteDescriptorSet boundsWrite;
+	boundsWrite.descriptorCount = 1;
+	boundsWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	boundsWrite.dstArrayElement = 0;
+	boundsWrite.dstBinding = 1;
+	boundsWrite.dstSet = frame.cullDescriptorSet;
+	boundsWrite.pBufferInfo = &boundsInfo;
+
+	vk::WriteDescriptorSet commandsWrite;
+	commandsWrite.descriptorCount = 1;
+	commandsWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	commandsWrite.dstArrayElement = 0;
+	commandsWrite.dstBinding = 2;
+	commandsWrite.dstSet = frame.cullDescriptorSet;
+	commandsWrite.pBufferInfo = &commandsInfo;
+
+	vk.updateDescriptorSets({ boundsWrite, commandsWrite });
+}
+
+void DepthPyramid::cull(CommandBuffer& cb, uint32_t objectCount)
+{
+	Frame& frame = currentFrame();
+
+	if (!m_valid || objectCount == 0 || frame.drawCommandsBuffer == nullptr)
+		return;
+
+	cb.debugMarkerBegin("occlusion culling", 0.5f, 0.5f, 0.5f);
+
+	CullPcbStruct pcb;
+	pcb.viewProj = m_viewProj.get_transposed();
+	pcb.pyramidWidth = int32_t(m_extent.width);
+	pcb.pyramidHeight = int32_t(m_extent.height);
+	pcb.objectCount = objectCount;
+	pcb.levelCount = int32_t(levelCount());
+
+	cb.bindPipeline(m_cullPipeline);
+	cb.bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipelineLayout,
+	                     0, frame.cullDescriptorSet);
+	cb.pushConstants(m_cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+	                 &pcb);
+	cb.dispatch((objectCount + 63) / 64);
+
+	vk::BufferMemoryBarrier barrier;
+	barrier.buffer = frame.drawCommandsBuffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	                   VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, barrier);
+
+	cb.debugMarkerEnd();
+}
+
+bool DepthPyramid::isOccluded(const vector3& boundsMin,
+                              const vector3& boundsMax)
+{
+	if (!m_valid)
+		return false;
+
+	// the current frame has been waited for, its readback is complete
+	Frame& frame = currentFrame();
+	if (frame.readbackPending)
+	{
+		m_readbackDepths = frame.readbackBuffer.download<vector2>();
+		m_readbackViewProj = frame.readbackViewProj;
+		frame.readbackPending = false;
+	}
+
+	if (m_readbackDepths.empty())
+		return false;
+
+	vector2 rectMin{ 1.0f, 1.0f };
+	vector2 rectMax{ 0.0f, 0.0f };
+	float nearestDepth = 1.0f;
+
+	for (uint32_t c = 0; c < 8; c++)
+	{
+		vector4 corner{ (c & 1) ? boundsMax.x : boundsMin.x,
+			            (c & 2) ? boundsMax.y : boundsMin.y,
+			            (c & 4) ? boundsMax.z : boundsMin.z, 1.0f };
+		vector4 clip = m_readbackViewProj * corner;
+
+		// boxes crossing the near plane are always visible
+		if (clip.w <= 0.0f)
+			return false;
+
+		vector3 ndc = clip.xyz() / clip.w;
+		rectMin.x = std::min(rectMin.x, ndc.x * 0.5f + 0.5f);
+		rectMin.y = std::min(rectMin.y, ndc.y * 0.5f + 0.5f);
+		rectMax.x = std::max(rectMax.x, ndc.x * 0.5f + 0.5f);
+		rectMax.y = std::max(rectMax.y, ndc.y * 0.5f + 0.5f);
+		nearestDepth = std::min(nearestDepth, ndc.z);
+	}
+
+	if (rectMin.x > 1.0f || rectMin.y > 1.0f || rectMax.x < 0.0f ||
+	    rectMax.y < 0.0f || nearestDepth > 1.0f)
+		return true;
+
+	auto toTexel = [&](float uv, uint32_t size, uint32_t readbackSize) {
+		uint32_t texel = uint32_t(std::clamp(uv, 0.0f, 1.0f) * float(size));
+		return std::min(texel >> m_readbackLevel, readbackSize - 1);
+	};
+
+	const uint32_t xMin =
+	    toTexel(rectMin.x, m_extent.width, m_readbackExtent.width);
+	const uint32_t xMax =
+	    toTexel(rectMax.x, m_extent.width, m_readbackExtent.width);
+	const uint32_t yMin =
+	    toTexel(rectMin.y, m_extent.height, m_readbackExtent.height);
+	const uint32_t yMax =
+	    toTexel(rectMax.y, m_extent.height, m_readbackExtent.height);
+
+	for (uint32_t y = yMin; y <= yMax; y++)
+	{
+		for (uint32_t x = xMin; x <= xMax; x++)
+		{
+			if (m_readbackDepths[y * m_readbackExtent.width + x].y >=
+			    nearestDepth)
+				return false;
+		}
+	}
+
+	return true;
+}
+}  // namespace cdm
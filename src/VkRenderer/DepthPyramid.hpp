@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "Texture2D.hpp"
+#include "VulkanDevice.hpp"
+
+#include "cdm_maths.hpp"
+
+#include <vector>
+
+namespace cdm
+{
+class CommandBuffer;
+class DepthTexture;
+class RenderContext;
+
+/// Hierarchical-Z buffer: mip chain of the min (r) and max (g) depth of a
+/// depth buffer. Bounding boxes are tested against the pyramid of the
+/// previous frame to skip the occluded ones, either on the CPU from a coarse
+/// level read back to host memory or in a compute pass that writes the
+/// instance count of indirect draw commands.
+/// Each frame in flight has its own readback buffer and culling buffers, the
+/// CPU tests are therefore `framesInFlight` frames late.
+class DepthPyramid final
+{
+public:
+	/// World-space bounding box, as laid out in the culling bounds buffer
+	struct BoundsStruct
+	{
+		vector4 min;
+		vector4 max;
+	};
+
+	/// Largest dimension of the level read back for the CPU tests
+	static constexpr uint32_t MaxReadbackResolution = 128;
+
+private:
+	std::reference_wrapper<RenderContext> rw;
+
+	VkExtent2D m_extent{};
+	VkImage m_depthImage = nullptr;
+
+	Texture2D m_pyramid;
+	std::vector<UniqueImageView> m_levelViews;
+	UniqueSampler m_sampler;
+
+	UniqueDescriptorPool m_descriptorPool;
+
+	/// layouts are owned by the device's `LayoutCache`
+	Movable<VkPipelineLayout> m_reducePipelineLayout;
+	std::vector<VkDescriptorSetLayout> m_reduceSetLayouts;
+	UniqueComputePipeline m_copyPipeline;
+	UniqueComputePipeline m_reducePipeline;
+	/// one per level, level 0 reads the depth buffer
+	std::vector<VkDescriptorSet> m_reduceDescriptorSets;
+
+	Movable<VkPipelineLayout> m_cullPipelineLayout;
+	std::vector<VkDescriptorSetLayout> m_cullSetLayouts;
+	UniqueComputePipeline m_cullPipeline;
+
+	uint32_t m_readbackLevel = 0;
+	VkExtent2D m_readbackExtent{};
+
+	/// only touched while its frame is recorded, once the GPU is done with
+	/// its previous use
+	struct Frame
+	{
+		VkDescriptorSet cullDescriptorSet = nullptr;
+		VkBuffer drawCommandsBuffer = nullptr;
+		Buffer readbackBuffer;
+		/// view-projection of the pyramid copied into `readbackBuffer`
+		matrix4 readbackViewProj = matrix4::identity();
+		bool readbackPending = false;
+	};
+	std::vector<Frame> m_frames;
+
+	/// last readback level downloaded and the view-projection it was built
+	/// with, empty until a frame in flight comes around again
+	std::vector<vector2> m_readbackDepths;
+	matrix4 m_readbackViewProj = matrix4::identity();
+
+	/// view-projection the pyramid was last built with
+	matrix4 m_viewProj = matrix4::identity();
+	bool m_valid = false;
+
+	struct ReducePcbStruct
+	{
+		int32_t srcWidth;
+		int32_t srcHeight;
+		int32_t dstWidth;
+		int32_t dstHeight;
+	};
+
+	struct CullPcbStruct
+	{
+		matrix4 viewProj;
+		int32_t pyramidWidth;
+		int32_t pyramidHeight;
+		uint32_t objectCount;
+		int32_t levelCount;
+	};
+
+	VkExtent2D levelExtent(uint32_t level) const;
+	Frame& currentFrame();
+
+public:
+	/// `depth` must have been created with `VK_IMAGE_USAGE_SAMPLED_BIT`,
+	/// `renderContext` gives the number of frames in flight
+	DepthPyramid(RenderContext& renderContext, const DepthTexture& depth);
+	DepthPyramid(const DepthPyramid&) = delete;
+	DepthPyramid(DepthPyramid&&) = default;
+	~DepthPyramid() = default;
+
+	DepthPyramid& operator=(const DepthPyramid&) = delete;
+	DepthPyramid& operator=(DepthPyramid&&) = default;
+
+	/// Records the reduction of the depth buffer, which must be in
+	/// `VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL` and is left in it,
+	/// and the copy of the readback level to the readback buffer of the
+	/// current frame
+	void build(CommandBuffer& cb, const matrix4& viewProj);
+
+	/// Binds the buffers used by `cull` in the frame in flight `frame`:
+	/// `boundsBuffer` holds a `BoundsStruct` per object,
+	/// `drawCommandsBuffer` a `VkDrawIndexedIndirectCommand` per object
+	void setCullingBuffers(uint32_t frame, const Buffer& boundsBuffer,
+	                       const Buffer& drawCommandsBuffer);
+
+	/// Records the compute pass setting the `instanceCount` of the draw
+	/// command of each occluded object to 0 in the buffers of the current
+	/// frame, must be recorded outside of a render pass
+	void cull(CommandBuffer& cb, uint32_t objectCount);
+
+	/// Tests a world-space bounding box against the readback level of the
+	/// last use of the current frame, whose GPU work has completed. Boxes
+	/// are visible until such a level exists
+	bool isOccluded(const vector3& boundsMin, const vector3& boundsMax);
+
+	/// false until the first `build`
+	bool valid() const noexcept { return m_valid; }
+	void invalidate() noexcept;
+
+	uint32_t framesInFlight() const noexcept
+	{
+		return uint32_t(m_frames.size());
+	}
+
+	Texture2D& texture() noexcept { return m_pyramid; }
+	uint32_t levelCount() const noexcept { return m_pyramid.mipLevels(); }
+};
+}  // namespace cdm
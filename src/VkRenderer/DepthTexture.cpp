@@ -1,31 +1,34 @@
 #include "DepthTexture.hpp"
 
 #include "CommandBuffer.hpp"
-#include "RenderWindow.hpp"
+#include "FrameRecorder.hpp"
+#include "RenderContext.hpp"
+#include "Stats.hpp"
 
 #include <stdexcept>
 
 namespace cdm
 {
-DepthTexture::DepthTexture(RenderWindow& renderWindow, VkImageUsageFlags usage,
+DepthTexture::DepthTexture(RenderContext& renderContext,
+                           VkImageUsageFlags usage,
                            VmaMemoryUsage memoryUsage,
                            VkMemoryPropertyFlags requiredFlags,
                            uint32_t mipLevels, VkSampleCountFlagBits samples)
-    : DepthTexture(renderWindow, renderWindow.swapchainExtent().width,
-                   renderWindow.swapchainExtent().height,
-                   renderWindow.depthImageFormat(), VK_IMAGE_TILING_OPTIMAL,
+    : DepthTexture(renderContext, renderContext.swapchainExtent().width,
+                   renderContext.swapchainExtent().height,
+                   renderContext.depthImageFormat(), VK_IMAGE_TILING_OPTIMAL,
                    usage | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
                    memoryUsage, requiredFlags, mipLevels, samples)
 {
 }
 
-DepthTexture::DepthTexture(RenderWindow& renderWindow, uint32_t imageWidth,
+DepthTexture::DepthTexture(RenderContext& renderContext, uint32_t imageWidth,
                            uint32_t imageHeight, VkFormat imageFormat,
                            VkImageTiling imageTiling, VkImageUsageFlags usage,
                            VmaMemoryUsage memoryUsage,
                            VkMemoryPropertyFlags requiredFlags,
                            uint32_t mipLevels, VkSampleCountFlagBits samples)
-    : rw(&renderWindow)
+    : rw(&renderContext)
 {
 	auto& vk = rw.get()->device();
 
@@ -59,6 +62,8 @@ DepthTexture::DepthTexture(RenderWindow& renderWindow, uint32_t imageWidth,
 
 	if (m_image == false)
 		throw std::runtime_error("could not create image");
+	vk.memoryStats().allocated(MemoryCategory::Texture, allocInfo.size);
+	vk.frameRecorder().recordImage(m_image.get(), info, imageAllocCreateInfo);
 
 	m_width = imageWidth;
 	m_height = imageHeight;
@@ -113,7 +118,12 @@ DepthTexture::~DepthTexture()
 		if (m_imageView)
 			m_imageView.reset();
 		if (m_image)
+		{
+			vk.memoryStats().freed(MemoryCategory::Texture, m_size);
+			vk.frameRecorder().recordDestruction(
+			    capture::handleId(m_image.get()));
 			vmaDestroyImage(vk.allocator(), m_image.get(), m_allocation.get());
+		}
 	}
 }
 
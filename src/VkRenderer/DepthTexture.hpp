@@ -4,11 +4,11 @@
 
 namespace cdm
 {
-class RenderWindow;
+class RenderContext;
 
 class DepthTexture final : public TextureInterface
 {
-	Movable<RenderWindow*> rw;
+	Movable<RenderContext*> rw;
 
 	Movable<VmaAllocation> m_allocation;
 	Movable<VkImage> m_image;
@@ -28,7 +28,7 @@ class DepthTexture final : public TextureInterface
 
 public:
 	DepthTexture() = default;
-	DepthTexture(RenderWindow& renderWindow,
+	DepthTexture(RenderContext& renderContext,
 	             VkImageUsageFlags usage = VkImageUsageFlags{},
 	             VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
 	             VkMemoryPropertyFlags requiredFlags =
@@ -36,7 +36,7 @@ public:
 	             uint32_t mipLevels = 1,
 	             VkSampleCountFlagBits samples =
 	                 VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT);
-	DepthTexture(RenderWindow& renderWindow, uint32_t imageWidth,
+	DepthTexture(RenderContext& renderContext, uint32_t imageWidth,
 	             uint32_t imageHeight, VkFormat imageFormat,
 	             VkImageTiling imageTiling, VkImageUsageFlags usage,
 	             VmaMemoryUsage memoryUsage,
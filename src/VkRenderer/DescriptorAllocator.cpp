@@ -0,0 +1,111 @@
+#include "DescriptorAllocator.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace cdm
+{
+const std::vector<DescriptorAllocator::PoolSizeRatio>&
+DescriptorAllocator::defaultPoolSizeRatios()
+{
+	static const std::vector<PoolSizeRatio> ratios{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+	};
+
+	return ratios;
+}
+
+DescriptorAllocator::DescriptorAllocator(
+    const VulkanDevice& vulkanDevice, uint32_t setsPerPool,
+    std::vector<PoolSizeRatio> poolSizeRatios)
+    : m_vulkanDevice(&vulkanDevice),
+      m_setsPerPool(setsPerPool),
+      m_poolSizeRatios(std::move(poolSizeRatios))
+{
+}
+
+void DescriptorAllocator::nextPool()
+{
+	if (!m_freePools.empty())
+	{
+		m_usedPools.push_back(std::move(m_freePools.back()));
+		m_freePools.pop_back();
+		return;
+	}
+
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	poolSizes.reserve(m_poolSizeRatios.size());
+	for (const auto& poolSizeRatio : m_poolSizeRatios)
+	{
+		poolSizes.push_back(VkDescriptorPoolSize{
+		    poolSizeRatio.type,
+		    std::max(uint32_t(poolSizeRatio.ratio * float(m_setsPerPool)),
+		             1u) });
+	}
+
+	vk::DescriptorPoolCreateInfo poolInfo;
+	poolInfo.maxSets = m_setsPerPool;
+	poolInfo.poolSizeCount = uint32_t(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	auto pool = m_vulkanDevice.get()->create(poolInfo);
+	if (!pool)
+	{
+		std::cerr << "error: failed to create descriptor pool" << std::endl;
+		abort();
+	}
+
+	m_usedPools.push_back(std::move(pool));
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+	auto& vk = *m_vulkanDevice.get();
+
+	if (m_usedPools.empty())
+		nextPool();
+
+	vk::DescriptorSetAllocateInfo allocateInfo;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet set = nullptr;
+
+	allocateInfo.descriptorPool = m_usedPools.back();
+	VkResult res = vk.allocate(allocateInfo, &set);
+
+	if (res == VK_ERROR_OUT_OF_POOL_MEMORY ||
+	    res == VK_ERROR_FRAGMENTED_POOL)
+	{
+		nextPool();
+
+		allocateInfo.descriptorPool = m_usedPools.back();
+		res = vk.allocate(allocateInfo, &set);
+	}
+
+	if (res != VK_SUCCESS)
+	{
+		std::cerr << "error: failed to allocate descriptor set" << std::endl;
+		abort();
+	}
+
+	return set;
+}
+
+void DescriptorAllocator::reset()
+{
+	auto& vk = *m_vulkanDevice.get();
+
+	for (auto& pool : m_usedPools)
+	{
+		vk.resetDescriptorPool(pool);
+		m_freePools.push_back(std::move(pool));
+	}
+	m_usedPools.clear();
+}
+}  // namespace cdm
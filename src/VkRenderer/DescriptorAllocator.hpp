@@ -0,0 +1,62 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <vector>
+
+namespace cdm
+{
+/// Allocates descriptor sets from a chain of pools, a new pool is added when
+/// the current one is exhausted. Sets are not freed one by one: `reset`
+/// recycles every pool at once, so that transient sets can be allocated
+/// freely each frame from an allocator per frame in flight, reset once the
+/// fence of its frame is signaled.
+class DescriptorAllocator final
+{
+public:
+	/// number of descriptors of `type` reserved per set in each pool
+	struct PoolSizeRatio
+	{
+		VkDescriptorType type;
+		float ratio;
+	};
+
+	static const std::vector<PoolSizeRatio>& defaultPoolSizeRatios();
+
+private:
+	Movable<const VulkanDevice*> m_vulkanDevice;
+
+	uint32_t m_setsPerPool = 0;
+	std::vector<PoolSizeRatio> m_poolSizeRatios;
+
+	/// the last one is the one allocated from
+	std::vector<UniqueDescriptorPool> m_usedPools;
+	/// pools recycled by `reset`
+	std::vector<UniqueDescriptorPool> m_freePools;
+
+	void nextPool();
+
+public:
+	DescriptorAllocator() = default;
+	DescriptorAllocator(
+	    const VulkanDevice& vulkanDevice, uint32_t setsPerPool = 64,
+	    std::vector<PoolSizeRatio> poolSizeRatios = defaultPoolSizeRatios());
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator(DescriptorAllocator&&) = default;
+	~DescriptorAllocator() = default;
+
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(DescriptorAllocator&&) = default;
+
+	VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+	/// Every set allocated so far becomes invalid, none of them may be used
+	/// by a pending command buffer
+	void reset();
+
+	uint32_t poolCount() const noexcept
+	{
+		return uint32_t(m_usedPools.size() + m_freePools.size());
+	}
+};
+}  // namespace cdm
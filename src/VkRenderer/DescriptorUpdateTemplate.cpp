@@ -0,0 +1,73 @@
+#include "DescriptorUpdateTemplate.hpp"
+
+#include <iostream>
+
+namespace cdm
+{
+VkDescriptorUpdateTemplateEntry DescriptorUpdateTemplate::entry(
+    uint32_t binding, VkDescriptorType type, size_t offset, uint32_t count,
+    size_t stride)
+{
+	VkDescriptorUpdateTemplateEntry res{};
+	res.dstBinding = binding;
+	res.dstArrayElement = 0;
+	res.descriptorCount = count;
+	res.descriptorType = type;
+	res.offset = offset;
+	res.stride = stride;
+
+	return res;
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+    const VulkanDevice& vulkanDevice, VkDescriptorSetLayout layout,
+    const std::vector<VkDescriptorUpdateTemplateEntry>& entries)
+    : m_vulkanDevice(&vulkanDevice)
+{
+	vk::DescriptorUpdateTemplateCreateInfo info;
+	info.descriptorUpdateEntryCount = uint32_t(entries.size());
+	info.pDescriptorUpdateEntries = entries.data();
+	info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	info.descriptorSetLayout = layout;
+
+	m_updateTemplate = vulkanDevice.create(info);
+	if (!m_updateTemplate)
+	{
+		std::cerr << "error: failed to create descriptor update template"
+		          << std::endl;
+		abort();
+	}
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+    const VulkanDevice& vulkanDevice, VkDescriptorSetLayout layout,
+    const std::vector<VkDescriptorUpdateTemplateEntry>& entries,
+    VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout pipelineLayout,
+    uint32_t set)
+    : m_vulkanDevice(&vulkanDevice)
+{
+	vk::DescriptorUpdateTemplateCreateInfo info;
+	info.descriptorUpdateEntryCount = uint32_t(entries.size());
+	info.pDescriptorUpdateEntries = entries.data();
+	info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+	info.descriptorSetLayout = layout;
+	info.pipelineBindPoint = pipelineBindPoint;
+	info.pipelineLayout = pipelineLayout;
+	info.set = set;
+
+	m_updateTemplate = vulkanDevice.create(info);
+	if (!m_updateTemplate)
+	{
+		std::cerr << "error: failed to create push descriptor update template"
+		          << std::endl;
+		abort();
+	}
+}
+
+void DescriptorUpdateTemplate::update(VkDescriptorSet descriptorSet,
+                                      const void* data) const
+{
+	m_vulkanDevice.get()->updateDescriptorSetWithTemplate(
+	    descriptorSet, m_updateTemplate, data);
+}
+}  // namespace cdm
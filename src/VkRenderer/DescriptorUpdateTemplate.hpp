@@ -0,0 +1,64 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <type_traits>
+#include <vector>
+
+namespace cdm
+{
+/// Writes every descriptor of a set from a packed struct of
+/// `VkDescriptorImageInfo`/`VkDescriptorBufferInfo`/`VkBufferView` in a
+/// single call instead of a `VkWriteDescriptorSet` per binding
+class DescriptorUpdateTemplate final
+{
+	Movable<const VulkanDevice*> m_vulkanDevice;
+
+	UniqueDescriptorUpdateTemplate m_updateTemplate;
+
+public:
+	/// Binding `binding` is read at `offset` in the struct passed to
+	/// `update`, `count` elements `stride` bytes apart
+	static VkDescriptorUpdateTemplateEntry entry(uint32_t binding,
+	                                             VkDescriptorType type,
+	                                             size_t offset,
+	                                             uint32_t count = 1,
+	                                             size_t stride = 0);
+
+	DescriptorUpdateTemplate() = default;
+	DescriptorUpdateTemplate(
+	    const VulkanDevice& vulkanDevice, VkDescriptorSetLayout layout,
+	    const std::vector<VkDescriptorUpdateTemplateEntry>& entries);
+	/// Template for `CommandBuffer::pushDescriptorSetWithTemplate`, `layout`
+	/// must be a push descriptor set layout used at index `set` of
+	/// `pipelineLayout`
+	DescriptorUpdateTemplate(
+	    const VulkanDevice& vulkanDevice, VkDescriptorSetLayout layout,
+	    const std::vector<VkDescriptorUpdateTemplateEntry>& entries,
+	    VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout pipelineLayout,
+	    uint32_t set);
+	DescriptorUpdateTemplate(const DescriptorUpdateTemplate&) = delete;
+	DescriptorUpdateTemplate(DescriptorUpdateTemplate&&) = default;
+	~DescriptorUpdateTemplate() = default;
+
+	DescriptorUpdateTemplate& operator=(const DescriptorUpdateTemplate&) =
+	    delete;
+	DescriptorUpdateTemplate& operator=(DescriptorUpdateTemplate&&) =
+	    default;
+
+	void update(VkDescriptorSet descriptorSet, const void* data) const;
+
+	template <typename T>
+	void update(VkDescriptorSet descriptorSet, const T& data) const
+	{
+		static_assert(!std::is_pointer_v<T>,
+		              "pass the struct, not a pointer to it");
+		update(descriptorSet, static_cast<const void*>(&data));
+	}
+
+	const VkDescriptorUpdateTemplate& get() const noexcept
+	{
+		return m_updateTemplate;
+	}
+};
+}  // namespace cdm
@@ -2,6 +2,7 @@
 
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
+#include "ShaderArchive.hpp"
 #include "StagingBuffer.hpp"
 
 #include <CompilerSpirV/compileSpirV.hpp>
@@ -28,9 +29,9 @@ struct EquirectangularToCubemapPushConstant
     matrix4 matrix;
 };
 
-EquirectangularToCubemap::EquirectangularToCubemap(RenderWindow& renderWindow,
-                                                   uint32_t cubemapWidth)
-    : rw(renderWindow),
+EquirectangularToCubemap::EquirectangularToCubemap(
+    RenderContext& renderContext, uint32_t cubemapWidth)
+    : rw(renderContext),
       m_cubemapWidth(cubemapWidth)
 {
     auto& vk = rw.get().device();
@@ -94,93 +95,24 @@ EquirectangularToCubemap::EquirectangularToCubemap(RenderWindow& renderWindow,
 #pragma endregion
 
 #pragma region vertexShader
+    m_vertexModule = createShaderModule(vk, "EquirectangularToCubemap.vert",
+                                        &vertexShaderBytecode);
+    if (!m_vertexModule)
     {
-        using namespace sdw;
-        VertexWriter writer;
-
-        auto inPosition = writer.declInput<Vec3>("inPosition", 0);
-        auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
-
-        auto pc = Pcb(writer, "pc");
-        pc.declMember<Mat4>("matrix");
-        pc.end();
-
-        auto out = writer.getOut();
-
-#define Locale(name, value) auto name = writer.declLocale(#name, value);
-
-        writer.implementMain([&]() {
-            fragPosition = inPosition;
-            out.vtx.position =
-                pc.getMember<Mat4>("matrix") * vec4(inPosition, 1.0_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_vertexModule = vk.create(createInfo);
-        if (!m_vertexModule)
-        {
-            std::cerr << "error: failed to create vertex shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create vertex shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
 #pragma region fragmentShader
+    m_fragmentModule = createShaderModule(vk, "EquirectangularToCubemap.frag",
+                                          &fragmentShaderBytecode);
+    if (!m_fragmentModule)
     {
-        using namespace sdw;
-        FragmentWriter writer;
-
-        auto in = writer.getIn();
-
-        auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
-        auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
-
-        auto equirectangularMap =
-            writer.declSampledImage<FImg2DRgba32>("equirectangularMap", 0, 0);
-
-        auto invAtan =
-            writer.declConstant("invAtan", vec2(0.1591_f, 0.3183_f));
-
-        auto SampleSphericalMap = writer.implementFunction<Vec2>(
-            "SampleSphericalMap",
-            [&](const Vec3& v) {
-                Locale(uv, vec2(atan2(v.z(), v.x()), asin(v.y())));
-                uv = uv * invAtan;
-                uv = uv + vec2(0.5_f);
-
-                writer.returnStmt(uv);
-            },
-            InVec3{ writer, "v" });
-
-        writer.implementMain([&]() {
-            Locale(uv, SampleSphericalMap(normalize(fragPosition)));
-
-            fragColor = equirectangularMap.sample(uv);
-
-            fragColor.a() = 1.0_f;
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_fragmentModule = vk.create(createInfo);
-        if (!m_fragmentModule)
-        {
-            std::cerr << "error: failed to create fragment shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create fragment shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
@@ -456,6 +388,69 @@ EquirectangularToCubemap::EquirectangularToCubemap(RenderWindow& renderWindow,
 #pragma endregion
 }
 
+std::vector<uint32_t> EquirectangularToCubemap::vertexShaderBytecode()
+{
+    using namespace sdw;
+    VertexWriter writer;
+
+    auto inPosition = writer.declInput<Vec3>("inPosition", 0);
+    auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
+
+    auto pc = Pcb(writer, "pc");
+    pc.declMember<Mat4>("matrix");
+    pc.end();
+
+    auto out = writer.getOut();
+
+#define Locale(name, value) auto name = writer.declLocale(#name, value);
+
+    writer.implementMain([&]() {
+        fragPosition = inPosition;
+        out.vtx.position =
+            pc.getMember<Mat4>("matrix") * vec4(inPosition, 1.0_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
+std::vector<uint32_t> EquirectangularToCubemap::fragmentShaderBytecode()
+{
+    using namespace sdw;
+    FragmentWriter writer;
+
+    auto in = writer.getIn();
+
+    auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
+    auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
+
+    auto equirectangularMap =
+        writer.declSampledImage<FImg2DRgba32>("equirectangularMap", 0, 0);
+
+    auto invAtan =
+        writer.declConstant("invAtan", vec2(0.1591_f, 0.3183_f));
+
+    auto SampleSphericalMap = writer.implementFunction<Vec2>(
+        "SampleSphericalMap",
+        [&](const Vec3& v) {
+            Locale(uv, vec2(atan2(v.z(), v.x()), asin(v.y())));
+            uv = uv * invAtan;
+            uv = uv + vec2(0.5_f);
+
+            writer.returnStmt(uv);
+        },
+        InVec3{ writer, "v" });
+
+    writer.implementMain([&]() {
+        Locale(uv, SampleSphericalMap(normalize(fragPosition)));
+
+        fragColor = equirectangularMap.sample(uv);
+
+        fragColor.a() = 1.0_f;
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
 EquirectangularToCubemap::~EquirectangularToCubemap() = default;
 
 Cubemap EquirectangularToCubemap::computeCubemap(
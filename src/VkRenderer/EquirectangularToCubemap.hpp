@@ -4,7 +4,7 @@
 
 #include "Buffer.hpp"
 #include "Cubemap.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Texture2D.hpp"
 
 #include <string_view>
@@ -13,7 +13,7 @@ namespace cdm
 {
 class EquirectangularToCubemap final
 {
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	UniqueRenderPass m_renderPass;
 
@@ -31,9 +31,13 @@ class EquirectangularToCubemap final
 	uint32_t m_cubemapWidth;
 
 public:
-	EquirectangularToCubemap(RenderWindow& renderWindow, uint32_t cubemapWidth);
+	EquirectangularToCubemap(RenderContext& renderContext,
+	                         uint32_t cubemapWidth);
 	~EquirectangularToCubemap();
 
+	static std::vector<uint32_t> vertexShaderBytecode();
+	static std::vector<uint32_t> fragmentShaderBytecode();
+
 	Cubemap computeCubemap(Texture2D& equirectangularTexture);
 };
 }  // namespace cdm
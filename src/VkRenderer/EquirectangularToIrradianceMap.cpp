@@ -2,6 +2,7 @@
 
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
+#include "ShaderArchive.hpp"
 #include "StagingBuffer.hpp"
 
 #include <CompilerSpirV/compileSpirV.hpp>
@@ -29,8 +30,8 @@ struct EquirectangularToIrradianceMapPushConstant
 };
 
 EquirectangularToIrradianceMap::EquirectangularToIrradianceMap(
-    RenderWindow& renderWindow, uint32_t resolution)
-    : rw(renderWindow),
+    RenderContext& renderContext, uint32_t resolution)
+    : rw(renderContext),
       m_resolution(resolution)
 {
     auto& vk = rw.get().device();
@@ -97,125 +98,24 @@ EquirectangularToIrradianceMap::EquirectangularToIrradianceMap(
 #define Constant(name, value) auto name = writer.declConstant(#name, value);
 
 #pragma region vertexShader
+    m_vertexModule = createShaderModule(vk, "EquirectangularToIrradianceMap.vert",
+                                        &vertexShaderBytecode);
+    if (!m_vertexModule)
     {
-        using namespace sdw;
-        VertexWriter writer;
-
-        auto inPosition = writer.declInput<Vec3>("inPosition", 0);
-        auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
-
-        auto pc = Pcb(writer, "pc");
-        pc.declMember<Mat4>("matrix");
-        pc.end();
-
-        auto out = writer.getOut();
-
-        writer.implementMain([&]() {
-            fragPosition = inPosition;
-            out.vtx.position =
-                pc.getMember<Mat4>("matrix") * vec4(inPosition, 1.0_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_vertexModule = vk.create(createInfo);
-        if (!m_vertexModule)
-        {
-            std::cerr << "error: failed to create vertex shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create vertex shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
 #pragma region fragmentShader
+    m_fragmentModule = createShaderModule(vk, "EquirectangularToIrradianceMap.frag",
+                                          &fragmentShaderBytecode);
+    if (!m_fragmentModule)
     {
-        using namespace sdw;
-        FragmentWriter writer;
-
-        auto in = writer.getIn();
-
-        auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
-        auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
-
-        auto equirectangularMap =
-            writer.declSampledImage<FImg2DRgba32>("equirectangularMap", 0, 0);
-
-        Constant(PI, 3.14159265359_f);
-        Constant(invAtan, vec2(0.1591_f, 0.3183_f));
-
-        auto SampleSphericalMap = writer.implementFunction<Vec2>(
-            "SampleSphericalMap",
-            [&](const Vec3& v) {
-                Locale(uv, vec2(atan2(v.z(), v.x()), asin(v.y())));
-                uv = uv * invAtan;
-                uv = uv + vec2(0.5_f);
-
-                writer.returnStmt(uv);
-            },
-            InVec3{ writer, "v" });
-
-        writer.implementMain([&]() {
-            Locale(N, normalize(fragPosition));
-
-            Locale(irradiance, vec3(0.0_f));
-            Locale(up, vec3(0.0_f, 1.0_f, 0.0_f));
-            Locale(right, cross(up, N));
-            up = cross(N, right);
-
-            Locale(sampleDelta, 0.025_f);
-            Locale(nrSamples, 0.0_f);
-
-            auto tangentSample = writer.declLocale<Vec3>("tangentSample");
-            auto sampleVec = writer.declLocale<Vec3>("sampleVec");
-
-            FOR(writer, Float, phi, 0.0_f, phi < 2.0_f * PI,
-                phi += sampleDelta)
-            {
-                FOR(writer, Float, theta, 0.0_f, theta < 0.5_f * PI,
-                    theta += sampleDelta)
-                {
-                    tangentSample = vec3(sin(theta) * cos(phi),
-                                         sin(theta) * sin(phi), cos(theta));
-                    sampleVec = normalize(vec3(tangentSample.x()) * right +
-                                          vec3(tangentSample.y()) * up +
-                                          vec3(tangentSample.z()) * N);
-
-                    irradiance +=
-                        equirectangularMap.sample(
-                                          SampleSphericalMap(sampleVec))
-                                      .rgb() *
-                                  cos(theta) * sin(theta);
-                    nrSamples = nrSamples + 1.0_f;
-                }
-                ROF;
-            }
-            ROF;
-            irradiance = PI * irradiance * vec3(1.0_f / nrSamples);
-
-            fragColor = vec4(irradiance, 1.0_f);
-            // fragColor = vec4(1.0_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_fragmentModule = vk.create(createInfo);
-        if (!m_fragmentModule)
-        {
-            std::cerr << "error: failed to create fragment shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create fragment shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
@@ -491,6 +391,101 @@ EquirectangularToIrradianceMap::EquirectangularToIrradianceMap(
 #pragma endregion
 }
 
+std::vector<uint32_t> EquirectangularToIrradianceMap::vertexShaderBytecode()
+{
+    using namespace sdw;
+    VertexWriter writer;
+
+    auto inPosition = writer.declInput<Vec3>("inPosition", 0);
+    auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
+
+    auto pc = Pcb(writer, "pc");
+    pc.declMember<Mat4>("matrix");
+    pc.end();
+
+    auto out = writer.getOut();
+
+    writer.implementMain([&]() {
+        fragPosition = inPosition;
+        out.vtx.position =
+            pc.getMember<Mat4>("matrix") * vec4(inPosition, 1.0_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
+std::vector<uint32_t> EquirectangularToIrradianceMap::fragmentShaderBytecode()
+{
+    using namespace sdw;
+    FragmentWriter writer;
+
+    auto in = writer.getIn();
+
+    auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
+    auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
+
+    auto equirectangularMap =
+        writer.declSampledImage<FImg2DRgba32>("equirectangularMap", 0, 0);
+
+    Constant(PI, 3.14159265359_f);
+    Constant(invAtan, vec2(0.1591_f, 0.3183_f));
+
+    auto SampleSphericalMap = writer.implementFunction<Vec2>(
+        "SampleSphericalMap",
+        [&](const Vec3& v) {
+            Locale(uv, vec2(atan2(v.z(), v.x()), asin(v.y())));
+            uv = uv * invAtan;
+            uv = uv + vec2(0.5_f);
+
+            writer.returnStmt(uv);
+        },
+        InVec3{ writer, "v" });
+
+    writer.implementMain([&]() {
+        Locale(N, normalize(fragPosition));
+
+        Locale(irradiance, vec3(0.0_f));
+        Locale(up, vec3(0.0_f, 1.0_f, 0.0_f));
+        Locale(right, cross(up, N));
+        up = cross(N, right);
+
+        Locale(sampleDelta, 0.025_f);
+        Locale(nrSamples, 0.0_f);
+
+        auto tangentSample = writer.declLocale<Vec3>("tangentSample");
+        auto sampleVec = writer.declLocale<Vec3>("sampleVec");
+
+        FOR(writer, Float, phi, 0.0_f, phi < 2.0_f * PI,
+            phi += sampleDelta)
+        {
+            FOR(writer, Float, theta, 0.0_f, theta < 0.5_f * PI,
+                theta += sampleDelta)
+            {
+                tangentSample = vec3(sin(theta) * cos(phi),
+                                     sin(theta) * sin(phi), cos(theta));
+                sampleVec = normalize(vec3(tangentSample.x()) * right +
+                                      vec3(tangentSample.y()) * up +
+                                      vec3(tangentSample.z()) * N);
+
+                irradiance +=
+                    equirectangularMap.sample(
+                                      SampleSphericalMap(sampleVec))
+                                  .rgb() *
+                              cos(theta) * sin(theta);
+                nrSamples = nrSamples + 1.0_f;
+            }
+            ROF;
+        }
+        ROF;
+        irradiance = PI * irradiance * vec3(1.0_f / nrSamples);
+
+        fragColor = vec4(irradiance, 1.0_f);
+        // fragColor = vec4(1.0_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
 EquirectangularToIrradianceMap::~EquirectangularToIrradianceMap() = default;
 
 Cubemap EquirectangularToIrradianceMap::computeCubemap(
@@ -4,7 +4,7 @@
 
 #include "Buffer.hpp"
 #include "Cubemap.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Texture2D.hpp"
 
 #include <string_view>
@@ -13,7 +13,7 @@ namespace cdm
 {
 class EquirectangularToIrradianceMap final
 {
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	UniqueRenderPass m_renderPass;
 
@@ -31,10 +31,13 @@ class EquirectangularToIrradianceMap final
 	uint32_t m_resolution;
 
 public:
-	EquirectangularToIrradianceMap(RenderWindow& renderWindow,
+	EquirectangularToIrradianceMap(RenderContext& renderContext,
 	                               uint32_t resolution);
 	~EquirectangularToIrradianceMap();
 
+	static std::vector<uint32_t> vertexShaderBytecode();
+	static std::vector<uint32_t> fragmentShaderBytecode();
+
 	Cubemap computeCubemap(Texture2D& equirectangularTexture);
 };
 }  // namespace cdm
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace cdm
+{
+/// Binary format shared by `FrameRecorder` and `FrameReplayer`.
+///
+/// A capture is a header followed by events. The events before
+/// `Event::FrameBegin` rebuild the state of the device when the capture
+/// began, the ones after it are the frame itself. Values are written as
+/// their bytes: a capture is only read back by a build of the same
+/// architecture
+namespace capture
+{
+constexpr uint32_t Magic = 0x4d52464b;  // "KFRM"
+constexpr uint32_t Version = 1;
+
+enum class Event : uint32_t
+{
+	/// `Object` type, captured handle and creation parameters
+	Create,
+	/// buffer handle and its whole contents
+	BufferData,
+	/// set handle and array of `Descriptor`
+	UpdateDescriptorSet,
+	/// separates the state from the frame
+	FrameBegin,
+	/// array of command buffers, each one a block of commands
+	Submit,
+};
+
+enum class Object : uint32_t
+{
+	Buffer,
+	Image,
+	ImageView,
+	Sampler,
+	ShaderModule,
+	DescriptorSetLayout,
+	PipelineLayout,
+	RenderPass,
+	RenderPass2,
+	Framebuffer,
+	QueryPool,
+	DescriptorPool,
+	DescriptorSet,
+	GraphicsPipeline,
+	ComputePipeline,
+};
+
+/// One per `CommandBuffer` recording function, the overloads are recorded
+/// as the one they forward to
+enum class Command : uint32_t
+{
+	BeginQuery,
+	BeginRenderPass,
+	BindDescriptorSets,
+	BindIndexBuffer,
+	BindPipeline,
+	BindVertexBuffers,
+	BlitImage,
+	ClearAttachments,
+	ClearColorImage,
+	ClearDepthStencilImage,
+	CopyBuffer,
+	CopyBufferToImage,
+	CopyImage,
+	CopyImageToBuffer,
+	CopyQueryPoolResults,
+	DebugMarkerBegin,
+	DebugMarkerEnd,
+	DebugMarkerInsert,
+	Dispatch,
+	DispatchBase,
+	DispatchIndirect,
+	Draw,
+	DrawIndexed,
+	DrawIndexedIndirect,
+	DrawIndexedIndirectCount,
+	DrawIndirect,
+	DrawIndirectCount,
+	EndQuery,
+	EndRenderPass,
+	ExecuteCommands,
+	FillBuffer,
+	NextSubpass,
+	PipelineBarrier,
+	PushConstants,
+	PushDescriptorSet,
+	ResetQueryPool,
+	ResolveImage,
+	SetBlendConstants,
+	SetDepthBias,
+	SetDepthBounds,
+	SetDeviceMask,
+	SetLineWidth,
+	SetScissor,
+	SetStencilCompareMask,
+	SetStencilReference,
+	SetStencilWriteMask,
+	SetViewport,
+	UpdateBuffer,
+	WriteTimestamp,
+};
+
+/// A single descriptor of a set, `VkWriteDescriptorSet` without the
+/// pointers
+struct Descriptor
+{
+	uint32_t binding = 0;
+	uint32_t arrayElement = 0;
+	VkDescriptorType type = VK_DESCRIPTOR_TYPE_SAMPLER;
+	VkDescriptorImageInfo image{};
+	VkDescriptorBufferInfo buffer{};
+	VkBufferView texelBufferView = nullptr;
+};
+
+/// Handles are stored as 64 bit ids whether they are pointers or not
+template <typename T>
+uint64_t handleId(T handle)
+{
+	if constexpr (std::is_pointer_v<T>)
+		return uint64_t(reinterpret_cast<uintptr_t>(handle));
+	else
+		return uint64_t(handle);
+}
+
+template <typename T>
+T handleFromId(uint64_t id)
+{
+	if constexpr (std::is_pointer_v<T>)
+		return reinterpret_cast<T>(uintptr_t(id));
+	else
+		return T(id);
+}
+
+template <typename T>
+struct Array
+{
+	const T* data = nullptr;
+	uint32_t count = 0;
+};
+
+template <typename T>
+Array<T> array(const T* data, uint32_t count)
+{
+	return { data, count };
+}
+
+/// Bytes of variable size, such as push constants or buffer contents
+struct Bytes
+{
+	const void* data = nullptr;
+	uint64_t size = 0;
+};
+
+class Writer final
+{
+	std::vector<uint8_t> m_data;
+
+public:
+	const std::vector<uint8_t>& data() const noexcept { return m_data; }
+	size_t size() const noexcept { return m_data.size(); }
+	bool empty() const noexcept { return m_data.empty(); }
+	void clear() noexcept { m_data.clear(); }
+
+	void writeBytes(const void* data, size_t size)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		m_data.insert(m_data.end(), bytes, bytes + size);
+	}
+
+	/// Pointers are taken for handles
+	template <typename T>
+	void write(const T& value)
+	{
+		if constexpr (std::is_pointer_v<T>)
+		{
+			uint64_t id = handleId(value);
+			writeBytes(&id, sizeof(id));
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			writeBytes(&value, sizeof(T));
+		}
+	}
+
+	void write(std::string_view string)
+	{
+		write(uint32_t(string.size()));
+		writeBytes(string.data(), string.size());
+	}
+
+	void write(const Bytes& bytes)
+	{
+		write(bytes.size);
+		writeBytes(bytes.data, size_t(bytes.size));
+	}
+
+	/// Size and contents of `block`, read back with `Reader::readBlock`
+	void write(const Writer& block)
+	{
+		write(Bytes{ block.m_data.data(), block.m_data.size() });
+	}
+
+	template <typename T>
+	void write(const Array<T>& array)
+	{
+		write(array.count);
+		for (uint32_t i = 0; i < array.count; i++)
+			write(array.data[i]);
+	}
+
+	template <typename... Args>
+	void writeAll(const Args&... args)
+	{
+		(write(args), ...);
+	}
+};
+
+/// Reads what a `Writer` wrote, throws on truncated data
+class Reader final
+{
+	const uint8_t* m_cursor = nullptr;
+	const uint8_t* m_end = nullptr;
+
+public:
+	Reader() = default;
+	Reader(const void* data, size_t size)
+	    : m_cursor(static_cast<const uint8_t*>(data)),
+	      m_end(m_cursor + size)
+	{
+	}
+
+	bool atEnd() const noexcept { return m_cursor == m_end; }
+	/// What is left to read
+	const uint8_t* data() const noexcept { return m_cursor; }
+	size_t size() const noexcept { return size_t(m_end - m_cursor); }
+
+	const void* readBytes(size_t size)
+	{
+		if (size > this->size())
+			throw std::runtime_error("error: truncated capture");
+
+		const uint8_t* res = m_cursor;
+		m_cursor += size;
+		return res;
+	}
+
+	/// Handles are read as `uint64_t` ids
+	template <typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T> &&
+		              !std::is_pointer_v<T>);
+		T res;
+		std::memcpy(&res, readBytes(sizeof(T)), sizeof(T));
+		return res;
+	}
+
+	std::string readString()
+	{
+		auto size = read<uint32_t>();
+		auto data = static_cast<const char*>(readBytes(size));
+		return std::string(data, size);
+	}
+
+	template <typename T>
+	std::vector<T> readArray()
+	{
+		auto count = read<uint32_t>();
+		if (size_t(count) * sizeof(T) > size())
+			throw std::runtime_error("error: truncated capture");
+
+		std::vector<T> res(count);
+		for (T& value : res)
+			value = read<T>();
+		return res;
+	}
+
+	/// What `Writer::write(const Bytes&)` wrote, points into the data read
+	Bytes readData()
+	{
+		auto size = read<uint64_t>();
+		return { readBytes(size_t(size)), size };
+	}
+
+	Reader readBlock()
+	{
+		auto size = size_t(read<uint64_t>());
+		return Reader(readBytes(size), size);
+	}
+};
+}  // namespace capture
+}  // namespace cdm
@@ -0,0 +1,891 @@
+#include "FrameRecorder.hpp"
+
+#include "Buffer.hpp"
+#include "CommandBuffer.hpp"
+#include "CommandPool.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace cdm
+{
+namespace
+{
+/// Fills the resource of `descriptor` from `info`, which points to the
+/// `VkDescriptorImageInfo`, `VkDescriptorBufferInfo` or `VkBufferView`
+/// matching its type. False for the types that are not replayed
+bool fillDescriptor(capture::Descriptor& descriptor, const void* info)
+{
+	switch (descriptor.type)
+	{
+	case VK_DESCRIPTOR_TYPE_SAMPLER:
+	case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+	case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+	case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+	case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+		descriptor.image = *static_cast<const VkDescriptorImageInfo*>(info);
+		return true;
+	case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+	case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+		descriptor.texelBufferView = *static_cast<const VkBufferView*>(info);
+		return true;
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		descriptor.buffer = *static_cast<const VkDescriptorBufferInfo*>(info);
+		return true;
+	default: return false;
+	}
+}
+
+std::vector<capture::Descriptor> descriptorsOf(
+    const VkWriteDescriptorSet& write)
+{
+	std::vector<capture::Descriptor> res;
+	res.reserve(write.descriptorCount);
+
+	for (uint32_t i = 0; i < write.descriptorCount; i++)
+	{
+		capture::Descriptor descriptor;
+		descriptor.binding = write.dstBinding;
+		descriptor.arrayElement = write.dstArrayElement + i;
+		descriptor.type = write.descriptorType;
+
+		const void* info = write.pImageInfo ? (const void*)&write.pImageInfo[i]
+		                   : write.pBufferInfo
+		                       ? (const void*)&write.pBufferInfo[i]
+		                       : (const void*)&write.pTexelBufferView[i];
+
+		if (fillDescriptor(descriptor, info))
+			res.push_back(descriptor);
+	}
+
+	return res;
+}
+
+/// Extensions in `pNext` are dropped except the binding flags
+void writeDescriptorSetLayout(capture::Writer& out,
+                              const VkDescriptorSetLayoutCreateInfo& info)
+{
+	out.writeAll(info.flags, info.bindingCount);
+	for (uint32_t i = 0; i < info.bindingCount; i++)
+	{
+		const VkDescriptorSetLayoutBinding& binding = info.pBindings[i];
+		out.writeAll(binding.binding, binding.descriptorType,
+		             binding.descriptorCount, binding.stageFlags,
+		             capture::array(binding.pImmutableSamplers,
+		                            binding.pImmutableSamplers
+		                                ? binding.descriptorCount
+		                                : 0));
+	}
+
+	capture::Array<VkDescriptorBindingFlagsEXT> bindingFlags;
+	for (auto next = static_cast<const VkBaseInStructure*>(info.pNext); next;
+	     next = next->pNext)
+	{
+		if (next->sType ==
+		    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT)
+		{
+			auto flagsInfo = reinterpret_cast<
+			    const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT*>(next);
+			bindingFlags = capture::array(flagsInfo->pBindingFlags,
+			                              flagsInfo->bindingCount);
+		}
+	}
+	out.write(bindingFlags);
+}
+
+void writeRenderPass(capture::Writer& out, const VkRenderPassCreateInfo& info)
+{
+	out.writeAll(info.flags,
+	             capture::array(info.pAttachments, info.attachmentCount),
+	             info.subpassCount);
+
+	VkAttachmentReference unused{ VK_ATTACHMENT_UNUSED,
+		                          VK_IMAGE_LAYOUT_UNDEFINED };
+	for (uint32_t i = 0; i < info.subpassCount; i++)
+	{
+		const VkSubpassDescription& subpass = info.pSubpasses[i];
+		out.writeAll(
+		    subpass.flags, subpass.pipelineBindPoint,
+		    capture::array(subpass.pInputAttachments,
+		                   subpass.inputAttachmentCount),
+		    capture::array(subpass.pColorAttachments,
+		                   subpass.colorAttachmentCount),
+		    capture::array(subpass.pResolveAttachments,
+		                   subpass.pResolveAttachments
+		                       ? subpass.colorAttachmentCount
+		                       : 0),
+		    subpass.pDepthStencilAttachment ? *subpass.pDepthStencilAttachment
+		                                    : unused,
+		    capture::array(subpass.pPreserveAttachments,
+		                   subpass.preserveAttachmentCount));
+	}
+
+	out.write(capture::array(info.pDependencies, info.dependencyCount));
+}
+
+/// The structures are written with their `pNext`, cleared on replay
+void writeRenderPass2(capture::Writer& out,
+                      const VkRenderPassCreateInfo2& info)
+{
+	out.writeAll(info.flags,
+	             capture::array(info.pAttachments, info.attachmentCount),
+	             info.subpassCount);
+
+	VkAttachmentReference2 unused{};
+	unused.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+	unused.attachment = VK_ATTACHMENT_UNUSED;
+	for (uint32_t i = 0; i < info.subpassCount; i++)
+	{
+		const VkSubpassDescription2& subpass = info.pSubpasses[i];
+		out.writeAll(
+		    subpass.flags, subpass.pipelineBindPoint, subpass.viewMask,
+		    capture::array(subpass.pInputAttachments,
+		                   subpass.inputAttachmentCount),
+		    capture::array(subpass.pColorAttachments,
+		                   subpass.colorAttachmentCount),
+		    capture::array(subpass.pResolveAttachments,
+		                   subpass.pResolveAttachments
+		                       ? subpass.colorAttachmentCount
+		                       : 0),
+		    subpass.pDepthStencilAttachment ? *subpass.pDepthStencilAttachment
+		                                    : unused,
+		    capture::array(subpass.pPreserveAttachments,
+		                   subpass.preserveAttachmentCount));
+	}
+
+	out.writeAll(capture::array(info.pDependencies, info.dependencyCount),
+	             capture::array(info.pCorrelatedViewMasks,
+	                            info.correlatedViewMaskCount));
+}
+
+void writeShaderStage(capture::Writer& out,
+                      const VkPipelineShaderStageCreateInfo& stage)
+{
+	out.writeAll(stage.flags, stage.stage, stage.module,
+	             std::string_view(stage.pName));
+
+	const VkSpecializationInfo* specialization = stage.pSpecializationInfo;
+	out.write(uint32_t(specialization != nullptr));
+	if (specialization)
+	{
+		out.writeAll(capture::array(specialization->pMapEntries,
+		                            specialization->mapEntryCount),
+		             capture::Bytes{ specialization->pData,
+		                             specialization->dataSize });
+	}
+}
+
+/// Whether `state` is set then its fields, the arrays it points to are
+/// written by the caller
+template <typename T>
+bool writeState(capture::Writer& out, const T* state)
+{
+	out.write(uint32_t(state != nullptr));
+	if (state)
+		out.write(*state);
+	return state != nullptr;
+}
+
+void writeGraphicsPipeline(capture::Writer& out,
+                           const VkGraphicsPipelineCreateInfo& info)
+{
+	out.writeAll(info.flags, info.stageCount);
+	for (uint32_t i = 0; i < info.stageCount; i++)
+		writeShaderStage(out, info.pStages[i]);
+
+	if (auto state = info.pVertexInputState; writeState(out, state))
+	{
+		out.writeAll(capture::array(state->pVertexBindingDescriptions,
+		                            state->vertexBindingDescriptionCount),
+		             capture::array(state->pVertexAttributeDescriptions,
+		                            state->vertexAttributeDescriptionCount));
+	}
+	writeState(out, info.pInputAssemblyState);
+	writeState(out, info.pTessellationState);
+	if (auto state = info.pViewportState; writeState(out, state))
+	{
+		out.writeAll(capture::array(state->pViewports,
+		                            state->pViewports ? state->viewportCount
+		                                              : 0),
+		             capture::array(state->pScissors,
+		                            state->pScissors ? state->scissorCount
+		                                             : 0));
+	}
+	writeState(out, info.pRasterizationState);
+	if (auto state = info.pMultisampleState; writeState(out, state))
+	{
+		uint32_t maskWords = (uint32_t(state->rasterizationSamples) + 31) / 32;
+		out.write(capture::array(state->pSampleMask,
+		                         state->pSampleMask ? maskWords : 0));
+	}
+	writeState(out, info.pDepthStencilState);
+	if (auto state = info.pColorBlendState; writeState(out, state))
+	{
+		out.write(
+		    capture::array(state->pAttachments, state->attachmentCount));
+	}
+	if (auto state = info.pDynamicState; writeState(out, state))
+	{
+		out.write(
+		    capture::array(state->pDynamicStates, state->dynamicStateCount));
+	}
+
+	out.writeAll(info.layout, info.renderPass, info.subpass);
+}
+}  // namespace
+
+FrameRecorder::FrameRecorder(const VulkanDevice& vulkanDevice)
+    : m_vulkanDevice(vulkanDevice)
+{
+}
+
+void FrameRecorder::setTracking(bool tracking)
+{
+	std::lock_guard lock(m_mutex);
+
+	m_tracking = tracking;
+	if (!tracking)
+	{
+		m_objects.clear();
+		m_bufferSizes.clear();
+		m_descriptorSets.clear();
+		m_updateTemplates.clear();
+	}
+}
+
+void FrameRecorder::beginCapture()
+{
+	if (m_capturing)
+		return;
+	if (!m_tracking)
+	{
+		std::cerr << "warning: capturing a frame without tracking, none of "
+		             "its objects will be replayed"
+		          << std::endl;
+	}
+
+	m_vulkanDevice.get().wait();
+
+	std::lock_guard lock(m_mutex);
+
+	m_events.clear();
+	m_commandBuffers.clear();
+	m_submittedCommandBuffers = 0;
+	m_missedCommandBuffers = 0;
+
+	std::vector<const Object*> objects;
+	objects.reserve(m_objects.size());
+	for (const auto& [handle, object] : m_objects)
+		objects.push_back(&object);
+	std::sort(objects.begin(), objects.end(),
+	          [](const Object* a, const Object* b) {
+		          return a->sequence < b->sequence;
+	          });
+
+	for (const Object* object : objects)
+		addEvent(capture::Event::Create, object->record);
+
+	// the objects of the snapshot must not be recorded
+	bool tracking = m_tracking.exchange(false);
+	writeBufferSnapshots();
+	m_tracking = tracking;
+
+	for (const auto& [set, state] : m_descriptorSets)
+	{
+		std::vector<capture::Descriptor> descriptors;
+		descriptors.reserve(state.descriptors.size());
+		for (const auto& [key, descriptor] : state.descriptors)
+			descriptors.push_back(descriptor);
+
+		capture::Writer payload;
+		payload.writeAll(set, capture::array(descriptors.data(),
+		                                     uint32_t(descriptors.size())));
+		addEvent(capture::Event::UpdateDescriptorSet, payload);
+	}
+
+	addEvent(capture::Event::FrameBegin, capture::Writer{});
+
+	m_capturing = true;
+}
+
+bool FrameRecorder::endCapture(std::string_view path)
+{
+	if (!m_capturing)
+		return false;
+
+	m_vulkanDevice.get().wait();
+
+	std::lock_guard lock(m_mutex);
+	m_capturing = false;
+
+	if (m_missedCommandBuffers != 0)
+	{
+		std::cerr << "warning: " << m_missedCommandBuffers << " of the "
+		          << m_submittedCommandBuffers + m_missedCommandBuffers
+		          << " command buffers submitted were recorded before the "
+		             "capture and are left out"
+		          << std::endl;
+	}
+
+	std::ofstream file(std::string(path), std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "error: failed to open " << path << std::endl;
+		return false;
+	}
+
+	capture::Writer header;
+	header.writeAll(capture::Magic, capture::Version);
+	file.write(reinterpret_cast<const char*>(header.data().data()),
+	           std::streamsize(header.size()));
+	file.write(reinterpret_cast<const char*>(m_events.data().data()),
+	           std::streamsize(m_events.size()));
+
+	m_events.clear();
+	m_commandBuffers.clear();
+
+	return file.good();
+}
+
+void FrameRecorder::addObject(capture::Object type, uint64_t handle,
+                              const capture::Writer& createInfo)
+{
+	Object& object = m_objects[handle];
+	object.type = type;
+	object.sequence = m_sequence++;
+	object.record.clear();
+	object.record.writeAll(type, handle);
+	object.record.writeBytes(createInfo.data().data(), createInfo.size());
+
+	if (m_capturing)
+		addEvent(capture::Event::Create, object.record);
+}
+
+void FrameRecorder::addEvent(capture::Event type,
+                             const capture::Writer& payload)
+{
+	m_events.writeAll(type, payload);
+}
+
+void FrameRecorder::writeBufferSnapshots()
+{
+	auto& vk = m_vulkanDevice.get();
+
+	std::vector<std::pair<uint64_t, VkDeviceSize>> buffers(
+	    m_bufferSizes.begin(), m_bufferSizes.end());
+	if (buffers.empty())
+		return;
+
+	std::vector<VkDeviceSize> offsets;
+	offsets.reserve(buffers.size());
+	VkDeviceSize totalSize = 0;
+	for (const auto& [buffer, size] : buffers)
+	{
+		offsets.push_back(totalSize);
+		totalSize += (size + 15) & ~VkDeviceSize(15);
+	}
+
+	Buffer readback(vk, totalSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+	CommandPool commandPool(vk,
+	                        vk.queueFamilyIndices().graphicsFamily.value());
+	CommandBuffer cb(commandPool);
+	cb.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		cb.copyBuffer(capture::handleFromId<VkBuffer>(buffers[i].first),
+		              readback.get(), buffers[i].second, 0, offsets[i]);
+	}
+	cb.end();
+
+	if (vk.queueSubmit(vk.graphicsQueue(), cb.get()) != VK_SUCCESS)
+	{
+		std::cerr << "error: failed to read back the buffers, the capture "
+		             "starts from empty buffers"
+		          << std::endl;
+		return;
+	}
+	vk.wait(vk.graphicsQueue());
+
+	auto data = static_cast<const uint8_t*>(readback.map());
+	for (size_t i = 0; i < buffers.size(); i++)
+	{
+		capture::Writer payload;
+		payload.writeAll(
+		    buffers[i].first,
+		    capture::Bytes{ data + offsets[i], buffers[i].second });
+		addEvent(capture::Event::BufferData, payload);
+	}
+	readback.unmap();
+}
+
+void FrameRecorder::recordCreation(const void* createInfo, uint64_t handle)
+{
+	if (!m_tracking)
+		return;
+
+	auto base = static_cast<const VkBaseInStructure*>(createInfo);
+	capture::Writer out;
+	std::lock_guard lock(m_mutex);
+
+	switch (base->sType)
+	{
+	case VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO:
+	{
+		auto info = *static_cast<const VkImageViewCreateInfo*>(createInfo);
+		info.pNext = nullptr;
+		out.write(info);
+		addObject(capture::Object::ImageView, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO:
+	{
+		auto info = *static_cast<const VkSamplerCreateInfo*>(createInfo);
+		info.pNext = nullptr;
+		out.write(info);
+		addObject(capture::Object::Sampler, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO:
+	{
+		auto& info = *static_cast<const VkShaderModuleCreateInfo*>(createInfo);
+		out.writeAll(info.flags, capture::Bytes{ info.pCode, info.codeSize });
+		addObject(capture::Object::ShaderModule, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO:
+	{
+		writeDescriptorSetLayout(
+		    out,
+		    *static_cast<const VkDescriptorSetLayoutCreateInfo*>(createInfo));
+		addObject(capture::Object::DescriptorSetLayout, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO:
+	{
+		auto& info =
+		    *static_cast<const VkPipelineLayoutCreateInfo*>(createInfo);
+		out.writeAll(info.flags,
+		             capture::array(info.pSetLayouts, info.setLayoutCount),
+		             capture::array(info.pPushConstantRanges,
+		                            info.pushConstantRangeCount));
+		addObject(capture::Object::PipelineLayout, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO:
+	{
+		writeRenderPass(
+		    out, *static_cast<const VkRenderPassCreateInfo*>(createInfo));
+		addObject(capture::Object::RenderPass, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2:
+	{
+		writeRenderPass2(
+		    out, *static_cast<const VkRenderPassCreateInfo2*>(createInfo));
+		addObject(capture::Object::RenderPass2, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO:
+	{
+		auto& info = *static_cast<const VkFramebufferCreateInfo*>(createInfo);
+		out.writeAll(info.flags, info.renderPass,
+		             capture::array(info.pAttachments, info.attachmentCount),
+		             info.width, info.height, info.layers);
+		addObject(capture::Object::Framebuffer, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO:
+	{
+		auto info = *static_cast<const VkQueryPoolCreateInfo*>(createInfo);
+		info.pNext = nullptr;
+		out.write(info);
+		addObject(capture::Object::QueryPool, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO:
+	{
+		auto& info =
+		    *static_cast<const VkDescriptorPoolCreateInfo*>(createInfo);
+		out.writeAll(info.flags, info.maxSets,
+		             capture::array(info.pPoolSizes, info.poolSizeCount));
+		addObject(capture::Object::DescriptorPool, handle, out);
+		break;
+	}
+	case VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO:
+	{
+		// only needed to decode the updates
+		auto& info =
+		    *static_cast<const VkDescriptorUpdateTemplateCreateInfo*>(
+		        createInfo);
+		UpdateTemplate& updateTemplate = m_updateTemplates[handle];
+		updateTemplate.type = info.templateType;
+		updateTemplate.pipelineBindPoint = info.pipelineBindPoint;
+		updateTemplate.entries.assign(
+		    info.pDescriptorUpdateEntries,
+		    info.pDescriptorUpdateEntries + info.descriptorUpdateEntryCount);
+		break;
+	}
+	default: break;
+	}
+}
+
+void FrameRecorder::recordBuffer(VkBuffer buffer,
+                                 const VkBufferCreateInfo& createInfo,
+                                 const VmaAllocationCreateInfo& allocationInfo)
+{
+	if (!m_tracking)
+		return;
+
+	capture::Writer out;
+	out.writeAll(createInfo.flags, createInfo.size, createInfo.usage,
+	             allocationInfo.usage, allocationInfo.requiredFlags);
+
+	std::lock_guard lock(m_mutex);
+	addObject(capture::Object::Buffer, capture::handleId(buffer), out);
+	m_bufferSizes[capture::handleId(buffer)] = createInfo.size;
+}
+
+void FrameRecorder::recordImage(VkImage image,
+                                const VkImageCreateInfo& createInfo,
+                                const VmaAllocationCreateInfo& allocationInfo)
+{
+	if (!m_tracking)
+		return;
+
+	VkImageCreateInfo info = createInfo;
+	info.pNext = nullptr;
+	info.queueFamilyIndexCount = 0;
+	info.pQueueFamilyIndices = nullptr;
+
+	capture::Writer out;
+	out.writeAll(info, allocationInfo.usage, allocationInfo.requiredFlags);
+
+	std::lock_guard lock(m_mutex);
+	addObject(capture::Object::Image, capture::handleId(image), out);
+}
+
+void FrameRecorder::recordGraphicsPipelines(
+    uint32_t count, const VkGraphicsPipelineCreateInfo* createInfos,
+    const VkPipeline* pipelines)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (pipelines[i] == nullptr)
+			continue;
+
+		capture::Writer out;
+		writeGraphicsPipeline(out, createInfos[i]);
+		addObject(capture::Object::GraphicsPipeline,
+		          capture::handleId(pipelines[i]), out);
+	}
+}
+
+void FrameRecorder::recordComputePipelines(
+    uint32_t count, const VkComputePipelineCreateInfo* createInfos,
+    const VkPipeline* pipelines)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (pipelines[i] == nullptr)
+			continue;
+
+		capture::Writer out;
+		out.write(createInfos[i].flags);
+		writeShaderStage(out, createInfos[i].stage);
+		out.write(createInfos[i].layout);
+		addObject(capture::Object::ComputePipeline,
+		          capture::handleId(pipelines[i]), out);
+	}
+}
+
+void FrameRecorder::recordDescriptorSets(
+    const VkDescriptorSetAllocateInfo& allocateInfo,
+    const VkDescriptorSet* sets)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+	for (uint32_t i = 0; i < allocateInfo.descriptorSetCount; i++)
+	{
+		capture::Writer out;
+		out.writeAll(allocateInfo.descriptorPool,
+		             allocateInfo.pSetLayouts[i]);
+		addObject(capture::Object::DescriptorSet,
+		          capture::handleId(sets[i]), out);
+
+		DescriptorSet& set = m_descriptorSets[capture::handleId(sets[i])];
+		set.pool = capture::handleId(allocateInfo.descriptorPool);
+		set.descriptors.clear();
+	}
+}
+
+void FrameRecorder::recordDestruction(uint64_t handle)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+
+	m_updateTemplates.erase(handle);
+
+	auto found = m_objects.find(handle);
+	if (found == m_objects.end())
+		return;
+
+	if (found->second.type == capture::Object::DescriptorPool)
+		dropDescriptorSets(handle);
+
+	m_objects.erase(found);
+	m_bufferSizes.erase(handle);
+	m_descriptorSets.erase(handle);
+}
+
+void FrameRecorder::recordDescriptorPoolReset(VkDescriptorPool pool)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+	dropDescriptorSets(capture::handleId(pool));
+}
+
+void FrameRecorder::recordDescriptorUpdates(uint32_t writeCount,
+                                            const VkWriteDescriptorSet* writes,
+                                            uint32_t copyCount,
+                                            const VkCopyDescriptorSet* copies)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+
+	for (uint32_t i = 0; i < writeCount; i++)
+	{
+		writeDescriptorSet(capture::handleId(writes[i].dstSet),
+		                   descriptorsOf(writes[i]));
+	}
+
+	for (uint32_t i = 0; i < copyCount; i++)
+	{
+		const VkCopyDescriptorSet& copy = copies[i];
+
+		auto source = m_descriptorSets.find(capture::handleId(copy.srcSet));
+		if (source == m_descriptorSets.end())
+			continue;
+
+		std::vector<capture::Descriptor> copied;
+		for (uint32_t j = 0; j < copy.descriptorCount; j++)
+		{
+			auto found = source->second.descriptors.find(
+			    { copy.srcBinding, copy.srcArrayElement + j });
+			if (found == source->second.descriptors.end())
+				continue;
+
+			capture::Descriptor descriptor = found->second;
+			descriptor.binding = copy.dstBinding;
+			descriptor.arrayElement = copy.dstArrayElement + j;
+			copied.push_back(descriptor);
+		}
+
+		writeDescriptorSet(capture::handleId(copy.dstSet), copied);
+	}
+}
+
+void FrameRecorder::recordDescriptorUpdate(
+    VkDescriptorSet set, VkDescriptorUpdateTemplate updateTemplate,
+    const void* data)
+{
+	if (!m_tracking)
+		return;
+
+	std::lock_guard lock(m_mutex);
+
+	auto found = m_updateTemplates.find(capture::handleId(updateTemplate));
+	if (found == m_updateTemplates.end())
+		return;
+
+	writeDescriptorSet(capture::handleId(set),
+	                   decodeTemplate(found->second, data));
+}
+
+void FrameRecorder::recordBufferData(VkBuffer buffer, const void* data,
+                                     VkDeviceSize size)
+{
+	if (!m_capturing)
+		return;
+
+	std::lock_guard lock(m_mutex);
+
+	auto found = m_bufferSizes.find(capture::handleId(buffer));
+	if (found == m_bufferSizes.end())
+		return;
+
+	capture::Writer payload;
+	payload.writeAll(buffer,
+	                 capture::Bytes{ data, std::min(size, found->second) });
+	addEvent(capture::Event::BufferData, payload);
+}
+
+void FrameRecorder::recordSubmission(uint32_t submitCount,
+                                     const VkSubmitInfo* submits)
+{
+	if (!m_capturing)
+		return;
+
+	std::lock_guard lock(m_mutex);
+
+	for (uint32_t i = 0; i < submitCount; i++)
+	{
+		std::vector<const capture::Writer*> streams;
+		for (uint32_t j = 0; j < submits[i].commandBufferCount; j++)
+		{
+			auto found = m_commandBuffers.find(
+			    capture::handleId(submits[i].pCommandBuffers[j]));
+			if (found == m_commandBuffers.end())
+			{
+				m_missedCommandBuffers++;
+				continue;
+			}
+			streams.push_back(found->second.get());
+			m_submittedCommandBuffers++;
+		}
+
+		// the streams are copied, the command buffers can be recorded again
+		capture::Writer payload;
+		payload.write(uint32_t(streams.size()));
+		for (const capture::Writer* stream : streams)
+			payload.write(*stream);
+		addEvent(capture::Event::Submit, payload);
+	}
+}
+
+std::shared_ptr<capture::Writer> FrameRecorder::beginCommandBuffer(
+    VkCommandBuffer commandBuffer)
+{
+	if (!m_capturing)
+		return nullptr;
+
+	auto res = std::make_shared<capture::Writer>();
+
+	std::lock_guard lock(m_mutex);
+	m_commandBuffers[capture::handleId(commandBuffer)] = res;
+
+	return res;
+}
+
+void FrameRecorder::recordPushDescriptorSet(
+    capture::Writer& stream, VkPipelineBindPoint pipelineBindPoint,
+    VkPipelineLayout layout, uint32_t set, uint32_t writeCount,
+    const VkWriteDescriptorSet* writes) const
+{
+	std::vector<capture::Descriptor> descriptors;
+	for (uint32_t i = 0; i < writeCount; i++)
+	{
+		std::vector<capture::Descriptor> written = descriptorsOf(writes[i]);
+		descriptors.insert(descriptors.end(), written.begin(), written.end());
+	}
+
+	stream.writeAll(capture::Command::PushDescriptorSet, pipelineBindPoint,
+	                layout, set,
+	                capture::array(descriptors.data(),
+	                               uint32_t(descriptors.size())));
+}
+
+void FrameRecorder::recordPushDescriptorSet(
+    capture::Writer& stream, VkDescriptorUpdateTemplate updateTemplate,
+    VkPipelineLayout layout, uint32_t set, const void* data) const
+{
+	std::lock_guard lock(m_mutex);
+
+	auto found = m_updateTemplates.find(capture::handleId(updateTemplate));
+	if (found == m_updateTemplates.end())
+		return;
+
+	std::vector<capture::Descriptor> descriptors =
+	    decodeTemplate(found->second, data);
+
+	stream.writeAll(capture::Command::PushDescriptorSet,
+	                found->second.pipelineBindPoint, layout, set,
+	                capture::array(descriptors.data(),
+	                               uint32_t(descriptors.size())));
+}
+
+void FrameRecorder::writeDescriptorSet(
+    uint64_t set, const std::vector<capture::Descriptor>& updated)
+{
+	auto found = m_descriptorSets.find(set);
+	if (found == m_descriptorSets.end() || updated.empty())
+		return;
+
+	for (const capture::Descriptor& descriptor : updated)
+	{
+		found->second.descriptors[{ descriptor.binding,
+		                            descriptor.arrayElement }] = descriptor;
+	}
+
+	if (m_capturing)
+	{
+		capture::Writer payload;
+		payload.writeAll(set, capture::array(updated.data(),
+		                                     uint32_t(updated.size())));
+		addEvent(capture::Event::UpdateDescriptorSet, payload);
+	}
+}
+
+std::vector<capture::Descriptor> FrameRecorder::decodeTemplate(
+    const UpdateTemplate& updateTemplate, const void* data) const
+{
+	std::vector<capture::Descriptor> res;
+
+	for (const VkDescriptorUpdateTemplateEntry& entry :
+	     updateTemplate.entries)
+	{
+		for (uint32_t i = 0; i < entry.descriptorCount; i++)
+		{
+			capture::Descriptor descriptor;
+			descriptor.binding = entry.dstBinding;
+			descriptor.arrayElement = entry.dstArrayElement + i;
+			descriptor.type = entry.descriptorType;
+
+			const void* info = static_cast<const uint8_t*>(data) +
+			                   entry.offset + i * entry.stride;
+			if (fillDescriptor(descriptor, info))
+				res.push_back(descriptor);
+		}
+	}
+
+	return res;
+}
+
+void FrameRecorder::dropDescriptorSets(uint64_t pool)
+{
+	for (auto it = m_descriptorSets.begin(); it != m_descriptorSets.end();)
+	{
+		if (it->second.pool == pool)
+		{
+			m_objects.erase(it->first);
+			it = m_descriptorSets.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+}  // namespace cdm
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "FrameCapture.hpp"
+#include "VulkanDevice.hpp"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cdm
+{
+/// Captures a frame for `FrameReplayer`, owned by the `VulkanDevice`.
+///
+/// While tracking, the device, `Buffer` and the texture classes report the
+/// objects they create and the descriptor sets are mirrored. `beginCapture`
+/// writes down these objects and the contents of the buffers, then the
+/// command buffers recorded, the descriptor updates, the host writes to
+/// buffers and the submissions are appended until `endCapture`.
+///
+/// Image contents, events and secondary command buffers are not captured,
+/// neither are the objects created while not tracking such as the
+/// swapchain images: the replayer skips the commands that use them
+class FrameRecorder final
+{
+	struct Object
+	{
+		capture::Object type = capture::Object::Buffer;
+		uint64_t sequence = 0;
+		/// `capture::Event::Create` payload
+		capture::Writer record;
+	};
+
+	struct DescriptorSet
+	{
+		uint64_t pool = 0;
+		/// keyed by binding and array element
+		std::map<std::pair<uint32_t, uint32_t>, capture::Descriptor>
+		    descriptors;
+	};
+
+	struct UpdateTemplate
+	{
+		VkDescriptorUpdateTemplateType type;
+		VkPipelineBindPoint pipelineBindPoint;
+		std::vector<VkDescriptorUpdateTemplateEntry> entries;
+	};
+
+	std::reference_wrapper<const VulkanDevice> m_vulkanDevice;
+
+	/// objects are created from the pipeline compiler threads too
+	mutable std::mutex m_mutex;
+	std::atomic<bool> m_tracking = false;
+	std::atomic<bool> m_capturing = false;
+
+	uint64_t m_sequence = 0;
+	std::unordered_map<uint64_t, Object> m_objects;
+	std::unordered_map<uint64_t, VkDeviceSize> m_bufferSizes;
+	std::unordered_map<uint64_t, DescriptorSet> m_descriptorSets;
+	std::unordered_map<uint64_t, UpdateTemplate> m_updateTemplates;
+
+	/// events of the capture in progress
+	capture::Writer m_events;
+	std::unordered_map<uint64_t, std::shared_ptr<capture::Writer>>
+	    m_commandBuffers;
+	uint32_t m_submittedCommandBuffers = 0;
+	uint32_t m_missedCommandBuffers = 0;
+
+	void addObject(capture::Object type, uint64_t handle,
+	               const capture::Writer& createInfo);
+	void addEvent(capture::Event type, const capture::Writer& payload);
+
+	void writeDescriptorSet(uint64_t set,
+	                        const std::vector<capture::Descriptor>& updated);
+	std::vector<capture::Descriptor> decodeTemplate(
+	    const UpdateTemplate& updateTemplate, const void* data) const;
+
+	/// Contents of every tracked buffer, read back through a copy
+	void writeBufferSnapshots();
+	/// Forgets the sets of `pool` when it is reset or destroyed, the
+	/// replayer keeps them until the end
+	void dropDescriptorSets(uint64_t pool);
+
+public:
+	explicit FrameRecorder(const VulkanDevice& vulkanDevice);
+	FrameRecorder(const FrameRecorder&) = delete;
+	FrameRecorder(FrameRecorder&&) = delete;
+	~FrameRecorder() = default;
+
+	FrameRecorder& operator=(const FrameRecorder&) = delete;
+	FrameRecorder& operator=(FrameRecorder&&) = delete;
+
+	bool tracking() const noexcept { return m_tracking; }
+	bool capturing() const noexcept { return m_capturing; }
+
+	/// To be enabled right after the device is created, the objects
+	/// created before cannot be replayed. Adds the transfer source usage to
+	/// the buffers created meanwhile so that they can be read back
+	void setTracking(bool tracking);
+
+	/// Waits for the device and writes down the tracked objects, to be
+	/// called between two frames on the rendering thread
+	void beginCapture();
+	/// Writes the capture to `path`, false if it failed
+	bool endCapture(std::string_view path);
+
+	// Called by the device and the resource classes
+
+	/// `createInfo` is any of the create infos of `VulkanDeviceDestroyer`,
+	/// the types that cannot be replayed are ignored
+	void recordCreation(const void* createInfo, uint64_t handle);
+	void recordBuffer(VkBuffer buffer, const VkBufferCreateInfo& createInfo,
+	                  const VmaAllocationCreateInfo& allocationInfo);
+	void recordImage(VkImage image, const VkImageCreateInfo& createInfo,
+	                 const VmaAllocationCreateInfo& allocationInfo);
+	void recordGraphicsPipelines(
+	    uint32_t count, const VkGraphicsPipelineCreateInfo* createInfos,
+	    const VkPipeline* pipelines);
+	void recordComputePipelines(uint32_t count,
+	                            const VkComputePipelineCreateInfo* createInfos,
+	                            const VkPipeline* pipelines);
+	void recordDescriptorSets(const VkDescriptorSetAllocateInfo& allocateInfo,
+	                          const VkDescriptorSet* sets);
+	void recordDestruction(uint64_t handle);
+	void recordDescriptorPoolReset(VkDescriptorPool pool);
+	void recordDescriptorUpdates(uint32_t writeCount,
+	                             const VkWriteDescriptorSet* writes,
+	                             uint32_t copyCount,
+	                             const VkCopyDescriptorSet* copies);
+	void recordDescriptorUpdate(VkDescriptorSet set,
+	                            VkDescriptorUpdateTemplate updateTemplate,
+	                            const void* data);
+	/// `size` is clamped to the size of the buffer
+	void recordBufferData(VkBuffer buffer, const void* data,
+	                      VkDeviceSize size);
+	void recordSubmission(uint32_t submitCount, const VkSubmitInfo* submits);
+
+	/// Stream the commands of `commandBuffer` are recorded into until its
+	/// next `begin`, null when not capturing
+	std::shared_ptr<capture::Writer> beginCommandBuffer(
+	    VkCommandBuffer commandBuffer);
+	/// Writes a `capture::Command::PushDescriptorSet` into `stream`
+	void recordPushDescriptorSet(capture::Writer& stream,
+	                             VkPipelineBindPoint pipelineBindPoint,
+	                             VkPipelineLayout layout, uint32_t set,
+	                             uint32_t writeCount,
+	                             const VkWriteDescriptorSet* writes) const;
+	void recordPushDescriptorSet(capture::Writer& stream,
+	                             VkDescriptorUpdateTemplate updateTemplate,
+	                             VkPipelineLayout layout, uint32_t set,
+	                             const void* data) const;
+};
+}  // namespace cdm
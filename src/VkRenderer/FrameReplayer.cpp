@@ -0,0 +1,1810 @@
+#include "FrameReplayer.hpp"
+
+#include "StagingBuffer.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace cdm
+{
+namespace
+{
+/// Counts are checked before allocating, a corrupted capture must not ask
+/// for gigabytes
+void checkCount(const capture::Reader& in, uint32_t count)
+{
+	if (count > in.size())
+		throw std::runtime_error("error: truncated capture");
+}
+
+VkImageAspectFlags aspectOf(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT: return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_S8_UINT: return VK_IMAGE_ASPECT_STENCIL_BIT;
+	default: return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+/// Id of `object` once moved into `objects`, 0 if its creation failed
+template <typename U, typename T>
+uint64_t keep(std::vector<U>& objects, T&& object)
+{
+	if (!object)
+		return 0;
+
+	uint64_t res = capture::handleId(object.get());
+	objects.push_back(std::move(object));
+	return res;
+}
+
+/// A shader stage and what it points to, must not move once read
+struct ShaderStage
+{
+	vk::PipelineShaderStageCreateInfo info;
+	/// captured id, resolved by the caller
+	uint64_t module = 0;
+	std::string name;
+	std::vector<VkSpecializationMapEntry> mapEntries;
+	VkSpecializationInfo specialization{};
+};
+
+void readShaderStage(capture::Reader& in, ShaderStage& stage)
+{
+	stage.info.flags = in.read<VkPipelineShaderStageCreateFlags>();
+	stage.info.stage = in.read<VkShaderStageFlagBits>();
+	stage.module = in.read<uint64_t>();
+	stage.name = in.readString();
+	stage.info.pName = stage.name.c_str();
+
+	if (in.read<uint32_t>() != 0)
+	{
+		stage.mapEntries = in.readArray<VkSpecializationMapEntry>();
+		capture::Bytes data = in.readData();
+
+		stage.specialization.mapEntryCount =
+		    uint32_t(stage.mapEntries.size());
+		stage.specialization.pMapEntries = stage.mapEntries.data();
+		stage.specialization.dataSize = size_t(data.size);
+		stage.specialization.pData = data.data;
+		stage.info.pSpecializationInfo = &stage.specialization;
+	}
+}
+
+/// Whether the state was set, its `pNext` is cleared
+template <typename T>
+bool readState(capture::Reader& in, T& state)
+{
+	if (in.read<uint32_t>() == 0)
+		return false;
+
+	state = in.read<T>();
+	state.pNext = nullptr;
+	return true;
+}
+
+template <typename Info>
+struct RenderPassTypes;
+
+template <>
+struct RenderPassTypes<vk::RenderPassCreateInfo>
+{
+	using Attachment = VkAttachmentDescription;
+	using Reference = VkAttachmentReference;
+	using Subpass = VkSubpassDescription;
+	using Dependency = VkSubpassDependency;
+	static constexpr bool Version2 = false;
+};
+
+template <>
+struct RenderPassTypes<vk::RenderPassCreateInfo2>
+{
+	using Attachment = VkAttachmentDescription2;
+	using Reference = VkAttachmentReference2;
+	using Subpass = VkSubpassDescription2;
+	using Dependency = VkSubpassDependency2;
+	static constexpr bool Version2 = true;
+};
+
+/// Both versions are written the same way, the structures of the second one
+/// have a `pNext` to clear and come with view masks. `initialLayouts`
+/// receives the initial layout of each attachment
+template <typename Info>
+UniqueRenderPass readRenderPass(const VulkanDevice& vk, capture::Reader& in,
+                                std::vector<VkImageLayout>& initialLayouts)
+{
+	using Types = RenderPassTypes<Info>;
+	using Reference = typename Types::Reference;
+
+	auto clearNext = [](auto& values) {
+		if constexpr (Types::Version2)
+		{
+			for (auto& value : values)
+				value.pNext = nullptr;
+		}
+	};
+
+	Info info;
+	info.flags = in.read<VkRenderPassCreateFlags>();
+	auto attachments = in.readArray<typename Types::Attachment>();
+	clearNext(attachments);
+
+	auto subpassCount = in.read<uint32_t>();
+	checkCount(in, subpassCount);
+
+	struct References
+	{
+		std::vector<Reference> inputs;
+		std::vector<Reference> colors;
+		std::vector<Reference> resolves;
+		Reference depthStencil;
+		std::vector<uint32_t> preserves;
+	};
+	std::vector<References> references(subpassCount);
+	std::vector<typename Types::Subpass> subpasses(subpassCount);
+
+	for (uint32_t i = 0; i < subpassCount; i++)
+	{
+		auto& subpass = subpasses[i];
+		References& refs = references[i];
+
+		if constexpr (Types::Version2)
+			subpass.sType = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2;
+		subpass.flags = in.read<VkSubpassDescriptionFlags>();
+		subpass.pipelineBindPoint = in.read<VkPipelineBindPoint>();
+		if constexpr (Types::Version2)
+			subpass.viewMask = in.read<uint32_t>();
+
+		refs.inputs = in.readArray<Reference>();
+		refs.colors = in.readArray<Reference>();
+		refs.resolves = in.readArray<Reference>();
+		refs.depthStencil = in.read<Reference>();
+		refs.preserves = in.readArray<uint32_t>();
+		clearNext(refs.inputs);
+		clearNext(refs.colors);
+		clearNext(refs.resolves);
+		if constexpr (Types::Version2)
+			refs.depthStencil.pNext = nullptr;
+
+		subpass.inputAttachmentCount = uint32_t(refs.inputs.size());
+		subpass.pInputAttachments = refs.inputs.data();
+		subpass.colorAttachmentCount = uint32_t(refs.colors.size());
+		subpass.pColorAttachments = refs.colors.data();
+		subpass.pResolveAttachments =
+		    refs.resolves.empty() ? nullptr : refs.resolves.data();
+		subpass.pDepthStencilAttachment =
+		    refs.depthStencil.attachment == VK_ATTACHMENT_UNUSED
+		        ? nullptr
+		        : &refs.depthStencil;
+		subpass.preserveAttachmentCount = uint32_t(refs.preserves.size());
+		subpass.pPreserveAttachments = refs.preserves.data();
+	}
+
+	auto dependencies = in.readArray<typename Types::Dependency>();
+	clearNext(dependencies);
+
+	info.attachmentCount = uint32_t(attachments.size());
+	info.pAttachments = attachments.data();
+	info.subpassCount = subpassCount;
+	info.pSubpasses = subpasses.data();
+	info.dependencyCount = uint32_t(dependencies.size());
+	info.pDependencies = dependencies.data();
+
+	std::vector<uint32_t> correlatedViewMasks;
+	if constexpr (Types::Version2)
+	{
+		correlatedViewMasks = in.readArray<uint32_t>();
+		info.correlatedViewMaskCount = uint32_t(correlatedViewMasks.size());
+		info.pCorrelatedViewMasks = correlatedViewMasks.data();
+	}
+
+	for (const auto& attachment : attachments)
+		initialLayouts.push_back(attachment.initialLayout);
+
+	return vk.create(info);
+}
+}  // namespace
+
+template <typename T>
+T FrameReplayer::lookup(uint64_t id)
+{
+	if (id == 0)
+		return capture::handleFromId<T>(0);
+
+	auto found = m_handles.find(id);
+	if (found == m_handles.end())
+	{
+		m_missing = true;
+		return capture::handleFromId<T>(0);
+	}
+
+	return capture::handleFromId<T>(found->second);
+}
+
+template <typename T>
+std::vector<T> FrameReplayer::lookup(const std::vector<uint64_t>& ids)
+{
+	std::vector<T> res;
+	res.reserve(ids.size());
+	for (uint64_t id : ids)
+		res.push_back(lookup<T>(id));
+
+	return res;
+}
+
+FrameReplayer::FrameReplayer(const VulkanDevice& vulkanDevice,
+                             std::string_view path)
+    : m_vulkanDevice(vulkanDevice),
+      m_commandPool(vulkanDevice,
+                    vulkanDevice.queueFamilyIndices().graphicsFamily.value())
+{
+	load(path);
+
+	try
+	{
+		prepare();
+	}
+	catch (...)
+	{
+		m_vulkanDevice.get().wait();
+		destroyImages();
+		throw;
+	}
+}
+
+FrameReplayer::~FrameReplayer()
+{
+	m_vulkanDevice.get().wait();
+	destroyImages();
+}
+
+void FrameReplayer::load(std::string_view path)
+{
+	std::ifstream file(std::string(path), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		throw std::runtime_error("error: failed to open " + std::string(path));
+
+	m_capture.resize(size_t(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(m_capture.data()),
+	          std::streamsize(m_capture.size()));
+	if (!file)
+		throw std::runtime_error("error: failed to read " + std::string(path));
+}
+
+void FrameReplayer::prepare()
+{
+	auto& vk = m_vulkanDevice.get();
+
+	capture::Reader in(m_capture.data(), m_capture.size());
+	if (in.size() < 2 * sizeof(uint32_t) ||
+	    in.read<uint32_t>() != capture::Magic)
+		throw std::runtime_error("error: not a frame capture");
+	if (in.read<uint32_t>() != capture::Version)
+		throw std::runtime_error("error: unsupported frame capture version");
+
+	std::vector<std::pair<VkBuffer, capture::Bytes>> uploads;
+	std::unordered_map<uint64_t, DescriptorWrites> initialDescriptors;
+	std::unordered_set<uint64_t> updatedSets;
+	bool frame = false;
+
+	while (!in.atEnd())
+	{
+		auto event = in.read<capture::Event>();
+		capture::Reader payload = in.readBlock();
+
+		switch (event)
+		{
+		case capture::Event::Create: create(payload); break;
+		case capture::Event::BufferData:
+		{
+			auto id = payload.read<uint64_t>();
+			capture::Bytes data = payload.readData();
+
+			auto found = m_buffersById.find(id);
+			if (found == m_buffersById.end())
+				break;
+
+			if (!frame)
+			{
+				uploads.emplace_back(found->second->get(), data);
+				break;
+			}
+
+			Step step;
+			step.type = StepType::BufferData;
+			step.buffer = found->second;
+			step.data = data;
+			m_steps.push_back(std::move(step));
+			break;
+		}
+		case capture::Event::UpdateDescriptorSet:
+		{
+			auto id = payload.read<uint64_t>();
+			auto descriptors = payload.readArray<capture::Descriptor>();
+
+			m_missing = false;
+			auto set = lookup<VkDescriptorSet>(id);
+			if (m_missing)
+				break;
+
+			if (!frame)
+			{
+				DescriptorWrites writes = resolveDescriptors(set, descriptors);
+				vk.updateDescriptorSets(uint32_t(writes.writes.size()),
+				                        writes.writes.data());
+				initialDescriptors[id] = std::move(writes);
+				break;
+			}
+
+			updatedSets.insert(id);
+
+			Step step;
+			step.type = StepType::UpdateDescriptorSet;
+			step.descriptors = resolveDescriptors(set, descriptors);
+			m_steps.push_back(std::move(step));
+			break;
+		}
+		case capture::Event::FrameBegin: frame = true; break;
+		case capture::Event::Submit:
+			if (frame)
+				recordSubmit(payload);
+			break;
+		default:
+			throw std::runtime_error("error: unknown event in the capture");
+		}
+	}
+
+	for (uint64_t set : updatedSets)
+	{
+		auto found = initialDescriptors.find(set);
+		if (found != initialDescriptors.end())
+			m_restoredDescriptors.push_back(std::move(found->second));
+	}
+
+	uploadData(uploads);
+	transitionImages();
+	createTimestamps();
+
+	m_statistics.submits = uint32_t(m_submits.size());
+}
+
+void FrameReplayer::create(capture::Reader& in)
+{
+	auto& vk = m_vulkanDevice.get();
+
+	auto type = in.read<capture::Object>();
+	auto id = in.read<uint64_t>();
+
+	m_missing = false;
+	uint64_t handle = 0;
+
+	switch (type)
+	{
+	case capture::Object::Buffer: handle = createBuffer(in, id); break;
+	case capture::Object::Image: handle = createImage(in); break;
+	case capture::Object::ImageView: handle = createImageView(in); break;
+	case capture::Object::Sampler:
+	{
+		vk::SamplerCreateInfo info(in.read<VkSamplerCreateInfo>());
+		handle = keep(m_samplers, vk.create(info));
+		break;
+	}
+	case capture::Object::ShaderModule:
+	{
+		vk::ShaderModuleCreateInfo info;
+		info.flags = in.read<VkShaderModuleCreateFlags>();
+		capture::Bytes code = in.readData();
+
+		// the capture does not keep the code aligned
+		std::vector<uint32_t> words(size_t(code.size) / sizeof(uint32_t));
+		std::memcpy(words.data(), code.data, words.size() * sizeof(uint32_t));
+		info.codeSize = words.size() * sizeof(uint32_t);
+		info.pCode = words.data();
+
+		handle = keep(m_shaderModules, vk.create(info));
+		break;
+	}
+	case capture::Object::DescriptorSetLayout:
+		handle = createDescriptorSetLayout(in);
+		break;
+	case capture::Object::PipelineLayout:
+		handle = createPipelineLayout(in);
+		break;
+	case capture::Object::RenderPass:
+	case capture::Object::RenderPass2:
+	{
+		std::vector<VkImageLayout> initialLayouts;
+		UniqueRenderPass renderPass =
+		    type == capture::Object::RenderPass
+		        ? readRenderPass<vk::RenderPassCreateInfo>(vk, in,
+		                                                   initialLayouts)
+		        : readRenderPass<vk::RenderPassCreateInfo2>(vk, in,
+		                                                    initialLayouts);
+		if (renderPass)
+			m_renderPassLayouts[renderPass.get()] = std::move(initialLayouts);
+
+		handle = keep(m_renderPasses, std::move(renderPass));
+		break;
+	}
+	case capture::Object::Framebuffer: handle = createFramebuffer(in); break;
+	case capture::Object::QueryPool:
+	{
+		vk::QueryPoolCreateInfo info(in.read<VkQueryPoolCreateInfo>());
+		handle = keep(m_queryPools, vk.create(info));
+		break;
+	}
+	case capture::Object::DescriptorPool:
+	{
+		vk::DescriptorPoolCreateInfo info;
+		info.flags = in.read<VkDescriptorPoolCreateFlags>();
+		info.maxSets = in.read<uint32_t>();
+		auto poolSizes = in.readArray<VkDescriptorPoolSize>();
+		info.poolSizeCount = uint32_t(poolSizes.size());
+		info.pPoolSizes = poolSizes.data();
+
+		handle = keep(m_descriptorPools, vk.create(info));
+		break;
+	}
+	case capture::Object::DescriptorSet:
+		handle = createDescriptorSet(in);
+		break;
+	case capture::Object::GraphicsPipeline:
+		handle = createGraphicsPipeline(in);
+		break;
+	case capture::Object::ComputePipeline:
+		handle = createComputePipeline(in);
+		break;
+	default:
+		throw std::runtime_error("error: unknown object in the capture");
+	}
+
+	if (handle == 0)
+	{
+		// a later object may have been given the handle of a destroyed one
+		m_handles.erase(id);
+		m_statistics.skippedObjects++;
+		return;
+	}
+
+	m_handles[id] = handle;
+	m_statistics.objects++;
+}
+
+uint64_t FrameReplayer::createBuffer(capture::Reader& in, uint64_t id)
+{
+	// sparse and protected buffers are created as regular ones
+	in.read<VkBufferCreateFlags>();
+	auto size = in.read<VkDeviceSize>();
+	auto usage = in.read<VkBufferUsageFlags>();
+	auto memoryUsage = in.read<VmaMemoryUsage>();
+	auto requiredFlags = in.read<VkMemoryPropertyFlags>();
+
+	// filled through copies
+	Buffer& buffer = m_buffers.emplace_back(
+	    m_vulkanDevice.get(), size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	    memoryUsage, requiredFlags);
+	m_buffersById[id] = &buffer;
+
+	return capture::handleId(buffer.get());
+}
+
+uint64_t FrameReplayer::createImage(capture::Reader& in)
+{
+	auto info = in.read<VkImageCreateInfo>();
+	// everything is replayed on the graphics queue
+	info.pNext = nullptr;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.queueFamilyIndexCount = 0;
+	info.pQueueFamilyIndices = nullptr;
+
+	VmaAllocationCreateInfo allocationInfo{};
+	allocationInfo.usage = in.read<VmaMemoryUsage>();
+	allocationInfo.requiredFlags = in.read<VkMemoryPropertyFlags>();
+
+	ImageAllocation image;
+	image.format = info.format;
+	if (vmaCreateImage(m_vulkanDevice.get().allocator(), &info,
+	                   &allocationInfo, &image.image, &image.allocation,
+	                   nullptr) != VK_SUCCESS)
+		return 0;
+
+	m_images.push_back(image);
+
+	return capture::handleId(image.image);
+}
+
+uint64_t FrameReplayer::createImageView(capture::Reader& in)
+{
+	vk::ImageViewCreateInfo info(in.read<VkImageViewCreateInfo>());
+	info.image = lookup<VkImage>(capture::handleId(info.image));
+	if (m_missing)
+		return 0;
+
+	UniqueImageView view = m_vulkanDevice.get().create(info);
+	if (view)
+		m_viewImages[view.get()] = info.image;
+
+	return keep(m_imageViews, std::move(view));
+}
+
+uint64_t FrameReplayer::createDescriptorSetLayout(capture::Reader& in)
+{
+	vk::DescriptorSetLayoutCreateInfo info;
+	info.flags = in.read<VkDescriptorSetLayoutCreateFlags>();
+	auto bindingCount = in.read<uint32_t>();
+	checkCount(in, bindingCount);
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(bindingCount);
+	std::vector<std::vector<VkSampler>> immutableSamplers(bindingCount);
+	for (uint32_t i = 0; i < bindingCount; i++)
+	{
+		VkDescriptorSetLayoutBinding& binding = bindings[i];
+		binding.binding = in.read<uint32_t>();
+		binding.descriptorType = in.read<VkDescriptorType>();
+		binding.descriptorCount = in.read<uint32_t>();
+		binding.stageFlags = in.read<VkShaderStageFlags>();
+
+		immutableSamplers[i] = lookup<VkSampler>(in.readArray<uint64_t>());
+		if (!immutableSamplers[i].empty())
+			binding.pImmutableSamplers = immutableSamplers[i].data();
+	}
+	info.bindingCount = bindingCount;
+	info.pBindings = bindings.data();
+
+	auto bindingFlags = in.readArray<VkDescriptorBindingFlagsEXT>();
+	vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo;
+	if (!bindingFlags.empty())
+	{
+		bindingFlagsInfo.bindingCount = uint32_t(bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+		info.pNext = &bindingFlagsInfo;
+	}
+
+	if (m_missing)
+		return 0;
+
+	return keep(m_descriptorSetLayouts, m_vulkanDevice.get().create(info));
+}
+
+uint64_t FrameReplayer::createPipelineLayout(capture::Reader& in)
+{
+	vk::PipelineLayoutCreateInfo info;
+	info.flags = in.read<VkPipelineLayoutCreateFlags>();
+	auto setLayouts = lookup<VkDescriptorSetLayout>(in.readArray<uint64_t>());
+	auto pushConstantRanges = in.readArray<VkPushConstantRange>();
+	if (m_missing)
+		return 0;
+
+	info.setLayoutCount = uint32_t(setLayouts.size());
+	info.pSetLayouts = setLayouts.data();
+	info.pushConstantRangeCount = uint32_t(pushConstantRanges.size());
+	info.pPushConstantRanges = pushConstantRanges.data();
+
+	return keep(m_pipelineLayouts, m_vulkanDevice.get().create(info));
+}
+
+uint64_t FrameReplayer::createFramebuffer(capture::Reader& in)
+{
+	vk::FramebufferCreateInfo info;
+	info.flags = in.read<VkFramebufferCreateFlags>();
+	info.renderPass = lookup<VkRenderPass>(in.read<uint64_t>());
+	auto attachments = lookup<VkImageView>(in.readArray<uint64_t>());
+	info.width = in.read<uint32_t>();
+	info.height = in.read<uint32_t>();
+	info.layers = in.read<uint32_t>();
+	if (m_missing)
+		return 0;
+
+	info.attachmentCount = uint32_t(attachments.size());
+	info.pAttachments = attachments.data();
+
+	UniqueFramebuffer framebuffer = m_vulkanDevice.get().create(info);
+	if (framebuffer)
+		m_framebufferViews[framebuffer.get()] = std::move(attachments);
+
+	return keep(m_framebuffers, std::move(framebuffer));
+}
+
+uint64_t FrameReplayer::createDescriptorSet(capture::Reader& in)
+{
+	auto pool = lookup<VkDescriptorPool>(in.read<uint64_t>());
+	auto layout = lookup<VkDescriptorSetLayout>(in.read<uint64_t>());
+	if (m_missing)
+		return 0;
+
+	vk::DescriptorSetAllocateInfo info;
+	info.descriptorPool = pool;
+	info.descriptorSetCount = 1;
+	info.pSetLayouts = &layout;
+
+	// freed with their pool
+	VkDescriptorSet set = nullptr;
+	if (m_vulkanDevice.get().allocateDescriptorSets(info, &set) != VK_SUCCESS)
+		return 0;
+
+	return capture::handleId(set);
+}
+
+uint64_t FrameReplayer::createGraphicsPipeline(capture::Reader& in)
+{
+	vk::GraphicsPipelineCreateInfo info;
+	// the base pipelines are not captured
+	info.flags = in.read<VkPipelineCreateFlags>() &
+	             ~VkPipelineCreateFlags(VK_PIPELINE_CREATE_DERIVATIVE_BIT);
+
+	auto stageCount = in.read<uint32_t>();
+	checkCount(in, stageCount);
+	std::vector<ShaderStage> stages(stageCount);
+	std::vector<VkPipelineShaderStageCreateInfo> stageInfos;
+	for (ShaderStage& stage : stages)
+	{
+		readShaderStage(in, stage);
+		stage.info.module = lookup<VkShaderModule>(stage.module);
+		stageInfos.push_back(stage.info);
+	}
+	info.stageCount = stageCount;
+	info.pStages = stageInfos.data();
+
+	VkPipelineVertexInputStateCreateInfo vertexInput;
+	std::vector<VkVertexInputBindingDescription> bindings;
+	std::vector<VkVertexInputAttributeDescription> attributes;
+	if (readState(in, vertexInput))
+	{
+		bindings = in.readArray<VkVertexInputBindingDescription>();
+		attributes = in.readArray<VkVertexInputAttributeDescription>();
+		vertexInput.vertexBindingDescriptionCount = uint32_t(bindings.size());
+		vertexInput.pVertexBindingDescriptions = bindings.data();
+		vertexInput.vertexAttributeDescriptionCount =
+		    uint32_t(attributes.size());
+		vertexInput.pVertexAttributeDescriptions = attributes.data();
+		info.pVertexInputState = &vertexInput;
+	}
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+	if (readState(in, inputAssembly))
+		info.pInputAssemblyState = &inputAssembly;
+
+	VkPipelineTessellationStateCreateInfo tessellation;
+	if (readState(in, tessellation))
+		info.pTessellationState = &tessellation;
+
+	// the counts are kept without the arrays when they are dynamic
+	VkPipelineViewportStateCreateInfo viewport;
+	std::vector<VkViewport> viewports;
+	std::vector<VkRect2D> scissors;
+	if (readState(in, viewport))
+	{
+		viewports = in.readArray<VkViewport>();
+		scissors = in.readArray<VkRect2D>();
+		viewport.pViewports = viewports.empty() ? nullptr : viewports.data();
+		viewport.pScissors = scissors.empty() ? nullptr : scissors.data();
+		info.pViewportState = &viewport;
+	}
+
+	VkPipelineRasterizationStateCreateInfo rasterization;
+	if (readState(in, rasterization))
+		info.pRasterizationState = &rasterization;
+
+	VkPipelineMultisampleStateCreateInfo multisample;
+	std::vector<VkSampleMask> sampleMask;
+	if (readState(in, multisample))
+	{
+		sampleMask = in.readArray<VkSampleMask>();
+		multisample.pSampleMask =
+		    sampleMask.empty() ? nullptr : sampleMask.data();
+		info.pMultisampleState = &multisample;
+	}
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil;
+	if (readState(in, depthStencil))
+		info.pDepthStencilState = &depthStencil;
+
+	VkPipelineColorBlendStateCreateInfo colorBlend;
+	std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+	if (readState(in, colorBlend))
+	{
+		blendAttachments = in.readArray<VkPipelineColorBlendAttachmentState>();
+		colorBlend.attachmentCount = uint32_t(blendAttachments.size());
+		colorBlend.pAttachments = blendAttachments.data();
+		info.pColorBlendState = &colorBlend;
+	}
+
+	VkPipelineDynamicStateCreateInfo dynamic;
+	std::vector<VkDynamicState> dynamicStates;
+	if (readState(in, dynamic))
+	{
+		dynamicStates = in.readArray<VkDynamicState>();
+		dynamic.dynamicStateCount = uint32_t(dynamicStates.size());
+		dynamic.pDynamicStates = dynamicStates.data();
+		info.pDynamicState = &dynamic;
+	}
+
+	info.layout = lookup<VkPipelineLayout>(in.read<uint64_t>());
+	info.renderPass = lookup<VkRenderPass>(in.read<uint64_t>());
+	info.subpass = in.read<uint32_t>();
+	if (m_missing)
+		return 0;
+
+	return keep(m_pipelines, m_vulkanDevice.get().create(info));
+}
+
+uint64_t FrameReplayer::createComputePipeline(capture::Reader& in)
+{
+	vk::ComputePipelineCreateInfo info;
+	info.flags = in.read<VkPipelineCreateFlags>() &
+	             ~VkPipelineCreateFlags(VK_PIPELINE_CREATE_DERIVATIVE_BIT);
+
+	ShaderStage stage;
+	readShaderStage(in, stage);
+	stage.info.module = lookup<VkShaderModule>(stage.module);
+	info.stage = stage.info;
+	info.layout = lookup<VkPipelineLayout>(in.read<uint64_t>());
+	if (m_missing)
+		return 0;
+
+	return keep(m_pipelines, m_vulkanDevice.get().create(info));
+}
+
+FrameReplayer::DescriptorWrites FrameReplayer::resolveDescriptors(
+    VkDescriptorSet set, const std::vector<capture::Descriptor>& descriptors)
+{
+	DescriptorWrites res;
+	res.writes.reserve(descriptors.size());
+
+	for (const capture::Descriptor& descriptor : descriptors)
+	{
+		m_missing = false;
+		bool resolved = false;
+
+		vk::WriteDescriptorSet write;
+		write.dstSet = set;
+		write.dstBinding = descriptor.binding;
+		write.dstArrayElement = descriptor.arrayElement;
+		write.descriptorCount = 1;
+		write.descriptorType = descriptor.type;
+
+		switch (descriptor.type)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+		{
+			VkDescriptorImageInfo info = descriptor.image;
+			uint64_t sampler = capture::handleId(info.sampler);
+			uint64_t imageView = capture::handleId(info.imageView);
+			info.sampler = nullptr;
+			info.imageView = nullptr;
+
+			if (descriptor.type == VK_DESCRIPTOR_TYPE_SAMPLER ||
+			    descriptor.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+				info.sampler = lookup<VkSampler>(sampler);
+			if (descriptor.type != VK_DESCRIPTOR_TYPE_SAMPLER)
+				info.imageView = lookup<VkImageView>(imageView);
+			if (m_missing)
+				break;
+
+			auto image = m_viewImages.find(info.imageView);
+			if (image != m_viewImages.end())
+			{
+				m_descriptorLayouts.try_emplace(image->second,
+				                               info.imageLayout);
+			}
+
+			res.images.push_back(info);
+			write.pImageInfo = &res.images.back();
+			resolved = true;
+			break;
+		}
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		{
+			VkDescriptorBufferInfo info = descriptor.buffer;
+			info.buffer = lookup<VkBuffer>(capture::handleId(info.buffer));
+			if (m_missing)
+				break;
+
+			res.buffers.push_back(info);
+			write.pBufferInfo = &res.buffers.back();
+			resolved = true;
+			break;
+		}
+		// buffer views are not captured
+		default: break;
+		}
+
+		if (resolved)
+			res.writes.push_back(write);
+		else
+			m_statistics.skippedDescriptors++;
+	}
+
+	return res;
+}
+
+void FrameReplayer::recordSubmit(capture::Reader& in)
+{
+	auto count = in.read<uint32_t>();
+	checkCount(in, count);
+
+	std::vector<VkCommandBuffer> commandBuffers;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		capture::Reader stream = in.readBlock();
+
+		// recorded once, submitted on every replay
+		CommandBuffer& cb = m_commandBuffers.emplace_back(m_commandPool);
+		cb.begin();
+		recordCommands(stream, cb);
+		cb.end();
+
+		commandBuffers.push_back(cb.get());
+	}
+	m_statistics.commandBuffers += count;
+
+	Step step;
+	step.type = StepType::Submit;
+	step.submit = m_submits.size();
+	m_steps.push_back(std::move(step));
+
+	m_submits.push_back(std::move(commandBuffers));
+}
+
+void FrameReplayer::recordCommands(capture::Reader& stream, CommandBuffer& cb)
+{
+	using capture::Command;
+
+	auto readBuffer = [&] { return lookup<VkBuffer>(stream.read<uint64_t>()); };
+	auto readImage = [&] { return lookup<VkImage>(stream.read<uint64_t>()); };
+	auto readQueryPool = [&] {
+		return lookup<VkQueryPool>(stream.read<uint64_t>());
+	};
+	auto readLayout = [&] {
+		return lookup<VkPipelineLayout>(stream.read<uint64_t>());
+	};
+
+	// The commands of a skipped render pass are skipped until its end, and
+	// a skipped bind skips the draws or dispatches that would have used it.
+	// State, queries and barriers are valid outside of a render pass, they
+	// are kept
+	bool skippingRenderPass = false;
+	bool graphicsBound = true;
+	bool computeBound = true;
+	auto unbind = [&](VkPipelineBindPoint bindPoint) {
+		if (bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE)
+			computeBound = false;
+		else
+			graphicsBound = false;
+	};
+
+	while (!stream.atEnd())
+	{
+		auto command = stream.read<Command>();
+		m_missing = false;
+		bool recorded = false;
+
+		// arguments are read in separate statements, the order in which
+		// function arguments are evaluated is unspecified
+		switch (command)
+		{
+		case Command::BeginQuery:
+		{
+			auto queryPool = readQueryPool();
+			auto query = stream.read<uint32_t>();
+			auto flags = stream.read<VkQueryControlFlags>();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.beginQuery(queryPool, query, flags);
+			break;
+		}
+		case Command::BeginRenderPass:
+		{
+			vk::RenderPassBeginInfo info;
+			info.renderPass = lookup<VkRenderPass>(stream.read<uint64_t>());
+			info.framebuffer = lookup<VkFramebuffer>(stream.read<uint64_t>());
+			info.renderArea = stream.read<VkRect2D>();
+			auto clearValues = stream.readArray<VkClearValue>();
+			auto contents = stream.read<VkSubpassContents>();
+			info.clearValueCount = uint32_t(clearValues.size());
+			info.pClearValues = clearValues.data();
+
+			skippingRenderPass = m_missing;
+			recorded = !m_missing;
+			if (recorded)
+			{
+				noteRenderPass(info.renderPass, info.framebuffer);
+				cb.beginRenderPass(info, contents);
+			}
+			break;
+		}
+		case Command::BindDescriptorSets:
+		{
+			auto bindPoint = stream.read<VkPipelineBindPoint>();
+			auto layout = readLayout();
+			auto firstSet = stream.read<uint32_t>();
+			auto sets = lookup<VkDescriptorSet>(stream.readArray<uint64_t>());
+			auto dynamicOffsets = stream.readArray<uint32_t>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				cb.bindDescriptorSets(bindPoint, layout, firstSet,
+				                      uint32_t(sets.size()), sets.data(),
+				                      uint32_t(dynamicOffsets.size()),
+				                      dynamicOffsets.data());
+			}
+			else
+			{
+				unbind(bindPoint);
+			}
+			break;
+		}
+		case Command::BindIndexBuffer:
+		{
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+			auto indexType = stream.read<VkIndexType>();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.bindIndexBuffer(buffer, offset, indexType);
+			else
+				graphicsBound = false;
+			break;
+		}
+		case Command::BindPipeline:
+		{
+			auto bindPoint = stream.read<VkPipelineBindPoint>();
+			auto pipeline = lookup<VkPipeline>(stream.read<uint64_t>());
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.bindPipeline(bindPoint, pipeline);
+			else
+				unbind(bindPoint);
+			break;
+		}
+		case Command::BindVertexBuffers:
+		{
+			auto firstBinding = stream.read<uint32_t>();
+			auto buffers = lookup<VkBuffer>(stream.readArray<uint64_t>());
+			auto offsets = stream.readArray<VkDeviceSize>();
+
+			recorded = !m_missing && buffers.size() == offsets.size();
+			if (recorded)
+			{
+				cb.bindVertexBuffers(firstBinding, uint32_t(buffers.size()),
+				                     buffers.data(), offsets.data());
+			}
+			else
+			{
+				graphicsBound = false;
+			}
+			break;
+		}
+		case Command::BlitImage:
+		case Command::CopyImage:
+		case Command::ResolveImage:
+		{
+			auto srcImage = readImage();
+			auto srcLayout = stream.read<VkImageLayout>();
+			auto dstImage = readImage();
+			auto dstLayout = stream.read<VkImageLayout>();
+
+			recorded = true;
+			if (command == Command::BlitImage)
+			{
+				auto regions = stream.readArray<VkImageBlit>();
+				auto filter = stream.read<VkFilter>();
+				if ((recorded = !m_missing))
+				{
+					cb.blitImage(srcImage, srcLayout, dstImage, dstLayout,
+					             uint32_t(regions.size()), regions.data(),
+					             filter);
+				}
+			}
+			else if (command == Command::CopyImage)
+			{
+				auto regions = stream.readArray<VkImageCopy>();
+				if ((recorded = !m_missing))
+				{
+					cb.copyImage(srcImage, srcLayout, dstImage, dstLayout,
+					             uint32_t(regions.size()), regions.data());
+				}
+			}
+			else
+			{
+				auto regions = stream.readArray<VkImageResolve>();
+				if ((recorded = !m_missing))
+				{
+					cb.resolveImage(srcImage, srcLayout, dstImage, dstLayout,
+					                uint32_t(regions.size()), regions.data());
+				}
+			}
+
+			if (recorded)
+			{
+				noteLayout(srcImage, srcLayout);
+				noteLayout(dstImage, dstLayout);
+			}
+			break;
+		}
+		case Command::ClearAttachments:
+		{
+			auto attachments = stream.readArray<VkClearAttachment>();
+			auto rects = stream.readArray<VkClearRect>();
+
+			recorded = !skippingRenderPass;
+			if (recorded)
+			{
+				cb.clearAttachments(uint32_t(attachments.size()),
+				                    attachments.data(), uint32_t(rects.size()),
+				                    rects.data());
+			}
+			break;
+		}
+		case Command::ClearColorImage:
+		{
+			auto image = readImage();
+			auto layout = stream.read<VkImageLayout>();
+			auto color = stream.read<VkClearColorValue>();
+			auto ranges = stream.readArray<VkImageSubresourceRange>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				noteLayout(image, layout);
+				cb.clearColorImage(image, layout, &color,
+				                   uint32_t(ranges.size()), ranges.data());
+			}
+			break;
+		}
+		case Command::ClearDepthStencilImage:
+		{
+			auto image = readImage();
+			auto layout = stream.read<VkImageLayout>();
+			auto depthStencil = stream.read<VkClearDepthStencilValue>();
+			auto ranges = stream.readArray<VkImageSubresourceRange>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				noteLayout(image, layout);
+				cb.clearDepthStencilImage(image, layout, &depthStencil,
+				                          uint32_t(ranges.size()),
+				                          ranges.data());
+			}
+			break;
+		}
+		case Command::CopyBuffer:
+		{
+			auto srcBuffer = readBuffer();
+			auto dstBuffer = readBuffer();
+			auto regions = stream.readArray<VkBufferCopy>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				cb.copyBuffer(srcBuffer, dstBuffer, uint32_t(regions.size()),
+				              regions.data());
+			}
+			break;
+		}
+		case Command::CopyBufferToImage:
+		{
+			auto buffer = readBuffer();
+			auto image = readImage();
+			auto layout = stream.read<VkImageLayout>();
+			auto regions = stream.readArray<VkBufferImageCopy>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				noteLayout(image, layout);
+				cb.copyBufferToImage(buffer, image, layout,
+				                     uint32_t(regions.size()), regions.data());
+			}
+			break;
+		}
+		case Command::CopyImageToBuffer:
+		{
+			auto image = readImage();
+			auto layout = stream.read<VkImageLayout>();
+			auto buffer = readBuffer();
+			auto regions = stream.readArray<VkBufferImageCopy>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				noteLayout(image, layout);
+				cb.copyImageToBuffer(image, layout, buffer,
+				                     uint32_t(regions.size()), regions.data());
+			}
+			break;
+		}
+		case Command::CopyQueryPoolResults:
+		{
+			auto queryPool = readQueryPool();
+			auto firstQuery = stream.read<uint32_t>();
+			auto queryCount = stream.read<uint32_t>();
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+			auto stride = stream.read<VkDeviceSize>();
+			auto flags = stream.read<VkQueryResultFlags>();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				cb.copyQueryPoolResults(queryPool, firstQuery, queryCount,
+				                        buffer, offset, stride, flags);
+			}
+			break;
+		}
+		// markers are valid anywhere, they are always kept balanced
+		case Command::DebugMarkerBegin:
+		case Command::DebugMarkerInsert:
+		{
+			std::string name = stream.readString();
+			auto color = stream.read<std::array<float, 4>>();
+
+			if (command == Command::DebugMarkerBegin)
+				cb.debugMarkerBegin(name, color);
+			else
+				cb.debugMarkerInsert(name, color);
+			recorded = true;
+			break;
+		}
+		case Command::DebugMarkerEnd:
+			cb.debugMarkerEnd();
+			recorded = true;
+			break;
+		case Command::Dispatch:
+		{
+			auto x = stream.read<uint32_t>();
+			auto y = stream.read<uint32_t>();
+			auto z = stream.read<uint32_t>();
+
+			recorded = computeBound;
+			if (recorded)
+				cb.dispatch(x, y, z);
+			break;
+		}
+		case Command::DispatchBase:
+		{
+			std::array<uint32_t, 6> values;
+			for (uint32_t& value : values)
+				value = stream.read<uint32_t>();
+
+			recorded = computeBound;
+			if (recorded)
+			{
+				cb.dispatchBase(values[0], values[1], values[2], values[3],
+				                values[4], values[5]);
+			}
+			break;
+		}
+		case Command::DispatchIndirect:
+		{
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+
+			recorded = !m_missing && computeBound;
+			if (recorded)
+				cb.dispatchIndirect(buffer, offset);
+			break;
+		}
+		case Command::Draw:
+		{
+			auto vertexCount = stream.read<uint32_t>();
+			auto instanceCount = stream.read<uint32_t>();
+			auto firstVertex = stream.read<uint32_t>();
+			auto firstInstance = stream.read<uint32_t>();
+
+			recorded = !skippingRenderPass && graphicsBound;
+			if (recorded)
+				cb.draw(vertexCount, instanceCount, firstVertex, firstInstance);
+			break;
+		}
+		case Command::DrawIndexed:
+		{
+			auto indexCount = stream.read<uint32_t>();
+			auto instanceCount = stream.read<uint32_t>();
+			auto firstIndex = stream.read<uint32_t>();
+			auto vertexOffset = stream.read<int32_t>();
+			auto firstInstance = stream.read<uint32_t>();
+
+			recorded = !skippingRenderPass && graphicsBound;
+			if (recorded)
+			{
+				cb.drawIndexed(indexCount, instanceCount, firstIndex,
+				               vertexOffset, firstInstance);
+			}
+			break;
+		}
+		case Command::DrawIndexedIndirect:
+		case Command::DrawIndirect:
+		{
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+			auto drawCount = stream.read<uint32_t>();
+			auto stride = stream.read<uint32_t>();
+
+			recorded = !m_missing && !skippingRenderPass && graphicsBound;
+			if (recorded && command == Command::DrawIndexedIndirect)
+				cb.drawIndexedIndirect(buffer, offset, drawCount, stride);
+			else if (recorded)
+				cb.drawIndirect(buffer, offset, drawCount, stride);
+			break;
+		}
+		case Command::DrawIndexedIndirectCount:
+		case Command::DrawIndirectCount:
+		{
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+			auto countBuffer = readBuffer();
+			auto countOffset = stream.read<VkDeviceSize>();
+			auto maxDrawCount = stream.read<uint32_t>();
+			auto stride = stream.read<uint32_t>();
+
+			recorded = !m_missing && !skippingRenderPass && graphicsBound;
+			if (recorded && command == Command::DrawIndexedIndirectCount)
+			{
+				cb.drawIndexedIndirectCount(buffer, offset, countBuffer,
+				                            countOffset, maxDrawCount, stride);
+			}
+			else if (recorded)
+			{
+				cb.drawIndirectCount(buffer, offset, countBuffer, countOffset,
+				                     maxDrawCount, stride);
+			}
+			break;
+		}
+		case Command::EndQuery:
+		{
+			auto queryPool = readQueryPool();
+			auto query = stream.read<uint32_t>();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.endQuery(queryPool, query);
+			break;
+		}
+		case Command::EndRenderPass:
+			recorded = !skippingRenderPass;
+			if (recorded)
+				cb.endRenderPass();
+			skippingRenderPass = false;
+			break;
+		// secondary command buffers are not captured
+		case Command::ExecuteCommands:
+			stream.readArray<uint64_t>();
+			break;
+		case Command::FillBuffer:
+		{
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+			auto size = stream.read<VkDeviceSize>();
+			auto data = stream.read<uint32_t>();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.fillBuffer(buffer, offset, size, data);
+			break;
+		}
+		case Command::NextSubpass:
+		{
+			auto contents = stream.read<VkSubpassContents>();
+
+			recorded = !skippingRenderPass;
+			if (recorded)
+				cb.nextSubpass(contents);
+			break;
+		}
+		case Command::PipelineBarrier:
+		{
+			auto srcStageMask = stream.read<VkPipelineStageFlags>();
+			auto dstStageMask = stream.read<VkPipelineStageFlags>();
+			auto dependencyFlags = stream.read<VkDependencyFlags>();
+			auto memoryBarriers = stream.readArray<VkMemoryBarrier>();
+			auto bufferBarriers = stream.readArray<VkBufferMemoryBarrier>();
+			auto imageBarriers = stream.readArray<VkImageMemoryBarrier>();
+
+			for (VkMemoryBarrier& barrier : memoryBarriers)
+				barrier.pNext = nullptr;
+			resolveBarriers(bufferBarriers);
+			resolveBarriers(imageBarriers);
+
+			cb.pipelineBarrier(
+			    srcStageMask, dstStageMask, dependencyFlags,
+			    uint32_t(memoryBarriers.size()), memoryBarriers.data(),
+			    uint32_t(bufferBarriers.size()), bufferBarriers.data(),
+			    uint32_t(imageBarriers.size()), imageBarriers.data());
+			recorded = true;
+			break;
+		}
+		case Command::PushConstants:
+		{
+			auto layout = readLayout();
+			auto stageFlags = stream.read<VkShaderStageFlags>();
+			auto offset = stream.read<uint32_t>();
+			capture::Bytes values = stream.readData();
+
+			recorded = !m_missing;
+			if (recorded)
+			{
+				cb.pushConstants(layout, stageFlags, offset,
+				                 uint32_t(values.size), values.data);
+			}
+			break;
+		}
+		case Command::PushDescriptorSet:
+		{
+			auto bindPoint = stream.read<VkPipelineBindPoint>();
+			auto layout = readLayout();
+			auto set = stream.read<uint32_t>();
+			auto descriptors = stream.readArray<capture::Descriptor>();
+
+			recorded = !m_missing &&
+			           m_vulkanDevice.get().pushDescriptorSupported();
+			if (recorded)
+			{
+				// the writes are copied when recorded
+				DescriptorWrites writes =
+				    resolveDescriptors(nullptr, descriptors);
+				cb.pushDescriptorSet(bindPoint, layout, set,
+				                     uint32_t(writes.writes.size()),
+				                     writes.writes.data());
+			}
+			else
+			{
+				unbind(bindPoint);
+			}
+			break;
+		}
+		case Command::ResetQueryPool:
+		{
+			auto queryPool = readQueryPool();
+			auto firstQuery = stream.read<uint32_t>();
+			auto queryCount = stream.read<uint32_t>();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.resetQueryPool(queryPool, firstQuery, queryCount);
+			break;
+		}
+		case Command::SetBlendConstants:
+		{
+			auto blendConstants = stream.readArray<float>();
+
+			recorded = blendConstants.size() == 4;
+			if (recorded)
+				cb.setBlendConstants(blendConstants.data());
+			break;
+		}
+		case Command::SetDepthBias:
+		{
+			auto constantFactor = stream.read<float>();
+			auto clamp = stream.read<float>();
+			auto slopeFactor = stream.read<float>();
+
+			cb.setDepthBias(constantFactor, clamp, slopeFactor);
+			recorded = true;
+			break;
+		}
+		case Command::SetDepthBounds:
+		{
+			auto minDepthBounds = stream.read<float>();
+			auto maxDepthBounds = stream.read<float>();
+
+			cb.setDepthBounds(minDepthBounds, maxDepthBounds);
+			recorded = true;
+			break;
+		}
+		case Command::SetDeviceMask:
+			cb.setDeviceMask(stream.read<uint32_t>());
+			recorded = true;
+			break;
+		case Command::SetLineWidth:
+			cb.setLineWidth(stream.read<float>());
+			recorded = true;
+			break;
+		case Command::SetScissor:
+		{
+			auto firstScissor = stream.read<uint32_t>();
+			auto scissors = stream.readArray<VkRect2D>();
+
+			cb.setScissor(firstScissor, uint32_t(scissors.size()),
+			              scissors.data());
+			recorded = true;
+			break;
+		}
+		case Command::SetStencilCompareMask:
+		case Command::SetStencilReference:
+		case Command::SetStencilWriteMask:
+		{
+			auto faceMask = stream.read<VkStencilFaceFlags>();
+			auto value = stream.read<uint32_t>();
+
+			if (command == Command::SetStencilCompareMask)
+				cb.setStencilCompareMask(faceMask, value);
+			else if (command == Command::SetStencilReference)
+				cb.setStencilReference(faceMask, value);
+			else
+				cb.setStencilWriteMask(faceMask, value);
+			recorded = true;
+			break;
+		}
+		case Command::SetViewport:
+		{
+			auto firstViewport = stream.read<uint32_t>();
+			auto viewports = stream.readArray<VkViewport>();
+
+			cb.setViewport(firstViewport, uint32_t(viewports.size()),
+			               viewports.data());
+			recorded = true;
+			break;
+		}
+		case Command::UpdateBuffer:
+		{
+			auto buffer = readBuffer();
+			auto offset = stream.read<VkDeviceSize>();
+			capture::Bytes data = stream.readData();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.updateBuffer(buffer, offset, data.size, data.data);
+			break;
+		}
+		case Command::WriteTimestamp:
+		{
+			auto stage = stream.read<VkPipelineStageFlagBits>();
+			auto queryPool = readQueryPool();
+			auto query = stream.read<uint32_t>();
+
+			recorded = !m_missing;
+			if (recorded)
+				cb.writeTimestamp(stage, queryPool, query);
+			break;
+		}
+		default:
+			throw std::runtime_error("error: unknown command in the capture");
+		}
+
+		m_statistics.commands++;
+		if (!recorded)
+			m_statistics.skippedCommands++;
+	}
+}
+
+void FrameReplayer::resolveBarriers(
+    std::vector<VkBufferMemoryBarrier>& barriers)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < barriers.size(); i++)
+	{
+		VkBufferMemoryBarrier barrier = barriers[i];
+
+		m_missing = false;
+		barrier.pNext = nullptr;
+		barrier.buffer = lookup<VkBuffer>(capture::handleId(barrier.buffer));
+		// everything is replayed on the graphics queue
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		if (!m_missing)
+			barriers[kept++] = barrier;
+	}
+	barriers.resize(kept);
+}
+
+void FrameReplayer::resolveBarriers(std::vector<VkImageMemoryBarrier>& barriers)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < barriers.size(); i++)
+	{
+		VkImageMemoryBarrier barrier = barriers[i];
+
+		m_missing = false;
+		barrier.pNext = nullptr;
+		barrier.image = lookup<VkImage>(capture::handleId(barrier.image));
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		if (!m_missing)
+		{
+			noteLayout(barrier.image, barrier.oldLayout);
+			barriers[kept++] = barrier;
+		}
+	}
+	barriers.resize(kept);
+}
+
+void FrameReplayer::noteLayout(VkImage image, VkImageLayout layout)
+{
+	// only the first use matters
+	m_initialLayouts.try_emplace(image, layout);
+}
+
+void FrameReplayer::noteRenderPass(VkRenderPass renderPass,
+                                   VkFramebuffer framebuffer)
+{
+	auto layouts = m_renderPassLayouts.find(renderPass);
+	auto views = m_framebufferViews.find(framebuffer);
+	if (layouts == m_renderPassLayouts.end() ||
+	    views == m_framebufferViews.end())
+		return;
+
+	size_t count = std::min(layouts->second.size(), views->second.size());
+	for (size_t i = 0; i < count; i++)
+	{
+		auto image = m_viewImages.find(views->second[i]);
+		if (image != m_viewImages.end())
+			noteLayout(image->second, layouts->second[i]);
+	}
+}
+
+void FrameReplayer::submitAndWait(const CommandBuffer& cb)
+{
+	auto& vk = m_vulkanDevice.get();
+
+	if (vk.queueSubmit(vk.graphicsQueue(), cb.get()) != VK_SUCCESS)
+		throw std::runtime_error("error: failed to prepare the replay");
+	vk.wait(vk.graphicsQueue());
+}
+
+void FrameReplayer::uploadData(
+    const std::vector<std::pair<VkBuffer, capture::Bytes>>& uploads)
+{
+	std::vector<VkDeviceSize> offsets;
+	offsets.reserve(uploads.size());
+	VkDeviceSize totalSize = 0;
+	for (const auto& [buffer, data] : uploads)
+	{
+		offsets.push_back(totalSize);
+		totalSize += (data.size + 15) & ~VkDeviceSize(15);
+	}
+	if (totalSize == 0)
+		return;
+
+	StagingBuffer staging(m_vulkanDevice.get(), totalSize);
+	auto mapped = static_cast<uint8_t*>(staging.map());
+	for (size_t i = 0; i < uploads.size(); i++)
+	{
+		std::memcpy(mapped + offsets[i], uploads[i].second.data,
+		            size_t(uploads[i].second.size));
+	}
+	staging.unmap();
+
+	CommandBuffer cb(m_commandPool);
+	cb.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	for (size_t i = 0; i < uploads.size(); i++)
+	{
+		if (uploads[i].second.size != 0)
+		{
+			cb.copyBuffer(staging.get(), uploads[i].first,
+			              uploads[i].second.size, offsets[i], 0);
+		}
+	}
+	cb.end();
+
+	submitAndWait(cb);
+}
+
+void FrameReplayer::transitionImages()
+{
+	std::vector<vk::ImageMemoryBarrier> barriers;
+
+	for (const ImageAllocation& image : m_images)
+	{
+		// the images only sampled are never transitioned by the frame
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (auto found = m_initialLayouts.find(image.image);
+		    found != m_initialLayouts.end())
+			layout = found->second;
+		else if (auto found = m_descriptorLayouts.find(image.image);
+		         found != m_descriptorLayouts.end())
+			layout = found->second;
+
+		if (layout == VK_IMAGE_LAYOUT_UNDEFINED ||
+		    layout == VK_IMAGE_LAYOUT_PREINITIALIZED)
+			continue;
+
+		vk::ImageMemoryBarrier barrier;
+		barrier.dstAccessMask =
+		    VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image.image;
+		barrier.subresourceRange = { aspectOf(image.format), 0,
+			                         VK_REMAINING_MIP_LEVELS, 0,
+			                         VK_REMAINING_ARRAY_LAYERS };
+		barriers.push_back(barrier);
+	}
+
+	if (barriers.empty())
+		return;
+
+	CommandBuffer cb(m_commandPool);
+	cb.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	cb.pipelineBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+	                   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+	                   uint32_t(barriers.size()), barriers.data());
+	cb.end();
+
+	submitAndWait(cb);
+}
+
+void FrameReplayer::createTimestamps()
+{
+	auto& vk = m_vulkanDevice.get();
+
+	VkPhysicalDeviceProperties properties{};
+	vk.GetPhysicalDeviceProperties(vk.physicalDevice(), &properties);
+	m_timestampPeriod = double(properties.limits.timestampPeriod);
+
+	uint32_t queueFamilyCount = 0;
+	vk.GetPhysicalDeviceQueueFamilyProperties(vk.physicalDevice(),
+	                                          &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vk.GetPhysicalDeviceQueueFamilyProperties(
+	    vk.physicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+	uint32_t validBits =
+	    queueFamilies[vk.queueFamilyIndices().graphicsFamily.value()]
+	        .timestampValidBits;
+	if (validBits == 0)
+	{
+		std::cerr << "warning: timestamps are not supported by the graphics "
+		             "queue, the GPU time of the frame will not be measured"
+		          << std::endl;
+		return;
+	}
+	m_timestampMask = validBits >= 64 ? ~uint64_t(0)
+	                                  : (uint64_t(1) << validBits) - 1;
+
+	if (m_submits.empty())
+		return;
+
+	vk::QueryPoolCreateInfo queryPoolInfo;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = 2 * uint32_t(m_submits.size());
+	m_timestamps = vk.create(queryPoolInfo);
+	if (!m_timestamps)
+		throw std::runtime_error("error: failed to create the replay queries");
+
+	// each submission gets its own pair, they may run in parallel
+	for (size_t i = 0; i < m_submits.size(); i++)
+	{
+		auto query = uint32_t(2 * i);
+
+		CommandBuffer& prologue = m_commandBuffers.emplace_back(m_commandPool);
+		prologue.begin();
+		prologue.resetQueryPool(m_timestamps.get(), query, 2);
+		prologue.writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		                        m_timestamps.get(), query);
+		prologue.end();
+
+		CommandBuffer& epilogue = m_commandBuffers.emplace_back(m_commandPool);
+		epilogue.begin();
+		epilogue.writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		                        m_timestamps.get(), query + 1);
+		epilogue.end();
+
+		m_submits[i].insert(m_submits[i].begin(), prologue.get());
+		m_submits[i].push_back(epilogue.get());
+	}
+}
+
+void FrameReplayer::destroyImages()
+{
+	// the views and the framebuffers using them go first
+	m_framebuffers.clear();
+	m_imageViews.clear();
+
+	for (const ImageAllocation& image : m_images)
+	{
+		vmaDestroyImage(m_vulkanDevice.get().allocator(), image.image,
+		                image.allocation);
+	}
+	m_images.clear();
+}
+
+FrameReplayer::Timings FrameReplayer::replay()
+{
+	auto& vk = m_vulkanDevice.get();
+	Timings res;
+
+	// the previous replay left the sets as the frame ends
+	for (const DescriptorWrites& writes : m_restoredDescriptors)
+	{
+		vk.updateDescriptorSets(uint32_t(writes.writes.size()),
+		                        writes.writes.data());
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+
+	// The application wrote to buffers and sets that were not in use, a
+	// single frame can only wait for the submissions before the writes
+	bool submitted = false;
+	for (const Step& step : m_steps)
+	{
+		if (step.type != StepType::Submit && submitted)
+		{
+			vk.wait(vk.graphicsQueue());
+			submitted = false;
+		}
+
+		switch (step.type)
+		{
+		case StepType::Submit:
+		{
+			const std::vector<VkCommandBuffer>& commandBuffers =
+			    m_submits[step.submit];
+
+			vk::SubmitInfo submit;
+			submit.commandBufferCount = uint32_t(commandBuffers.size());
+			submit.pCommandBuffers = commandBuffers.data();
+			if (vk.queueSubmit(vk.graphicsQueue(), submit) != VK_SUCCESS)
+			{
+				throw std::runtime_error(
+				    "error: failed to submit a replayed command buffer");
+			}
+			submitted = true;
+			break;
+		}
+		case StepType::BufferData:
+			step.buffer->upload(step.data.data, size_t(step.data.size));
+			break;
+		case StepType::UpdateDescriptorSet:
+			vk.updateDescriptorSets(uint32_t(step.descriptors.writes.size()),
+			                        step.descriptors.writes.data());
+			break;
+		}
+	}
+	vk.wait(vk.graphicsQueue());
+
+	auto end = std::chrono::steady_clock::now();
+	res.cpuTime =
+	    std::chrono::duration<double, std::milli>(end - begin).count();
+
+	if (m_timestamps)
+	{
+		std::vector<uint64_t> ticks(2 * m_submits.size());
+		VkResult result = vk.GetQueryPoolResults(
+		    vk.vkDevice(), m_timestamps.get(), 0, uint32_t(ticks.size()),
+		    ticks.size() * sizeof(uint64_t), ticks.data(), sizeof(uint64_t),
+		    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+		if (result != VK_SUCCESS)
+			return res;
+
+		for (size_t i = 0; i < m_submits.size(); i++)
+		{
+			uint64_t elapsed = (ticks[2 * i + 1] - ticks[2 * i]) &
+			                   m_timestampMask;
+			res.gpuTime += double(elapsed) * m_timestampPeriod * 1e-6;
+		}
+	}
+
+	return res;
+}
+}  // namespace cdm
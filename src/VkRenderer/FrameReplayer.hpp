@@ -0,0 +1,193 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandBuffer.hpp"
+#include "CommandPool.hpp"
+#include "FrameCapture.hpp"
+#include "VulkanDevice.hpp"
+
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cdm
+{
+/// Replays a capture of `FrameRecorder`, usually on a headless device, to
+/// time a frame without the application that rendered it.
+///
+/// Everything is prepared at construction: the objects are created, the
+/// buffers are filled and the command buffers of the frame are recorded
+/// once, `replay` only updates what the frame updates and submits them.
+/// Objects that were not captured are skipped along with the commands that
+/// use them, `statistics` tells how much of the frame is replayed
+class FrameReplayer final
+{
+public:
+	struct Statistics
+	{
+		uint32_t objects = 0;
+		uint32_t skippedObjects = 0;
+		uint32_t submits = 0;
+		uint32_t commandBuffers = 0;
+		uint32_t commands = 0;
+		uint32_t skippedCommands = 0;
+		/// texel buffers or resources that were not captured
+		uint32_t skippedDescriptors = 0;
+	};
+
+	/// In milliseconds
+	struct Timings
+	{
+		/// sum of the submissions, 0 without timestamp support
+		double gpuTime = 0.0;
+		/// from the first host write of the frame until the device is idle
+		double cpuTime = 0.0;
+	};
+
+private:
+	struct ImageAllocation
+	{
+		VkImage image = nullptr;
+		VmaAllocation allocation = nullptr;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+	};
+
+	/// Write infos are kept in deques so that the writes can point to them
+	struct DescriptorWrites
+	{
+		std::vector<vk::WriteDescriptorSet> writes;
+		std::deque<VkDescriptorImageInfo> images;
+		std::deque<VkDescriptorBufferInfo> buffers;
+	};
+
+	enum class StepType
+	{
+		Submit,
+		BufferData,
+		UpdateDescriptorSet,
+	};
+
+	/// What the frame does in order, from the events after
+	/// `capture::Event::FrameBegin`
+	struct Step
+	{
+		StepType type = StepType::Submit;
+		/// for `StepType::Submit`
+		size_t submit = 0;
+		/// for `StepType::BufferData`, points into the capture
+		Buffer* buffer = nullptr;
+		capture::Bytes data;
+		/// for `StepType::UpdateDescriptorSet`
+		DescriptorWrites descriptors;
+	};
+
+	std::reference_wrapper<const VulkanDevice> m_vulkanDevice;
+
+	std::vector<uint8_t> m_capture;
+	Statistics m_statistics;
+
+	/// captured handle id to replayed handle id
+	std::unordered_map<uint64_t, uint64_t> m_handles;
+	/// set by `lookup` when a handle was not replayed
+	bool m_missing = false;
+
+	std::deque<Buffer> m_buffers;
+	std::unordered_map<uint64_t, Buffer*> m_buffersById;
+	std::vector<ImageAllocation> m_images;
+	std::vector<UniqueImageView> m_imageViews;
+	std::vector<UniqueSampler> m_samplers;
+	std::vector<UniqueShaderModule> m_shaderModules;
+	std::vector<UniqueDescriptorSetLayout> m_descriptorSetLayouts;
+	std::vector<UniquePipelineLayout> m_pipelineLayouts;
+	std::vector<UniqueRenderPass> m_renderPasses;
+	std::vector<UniqueFramebuffer> m_framebuffers;
+	std::vector<UniqueQueryPool> m_queryPools;
+	std::vector<UniqueDescriptorPool> m_descriptorPools;
+	std::vector<UniquePipeline> m_pipelines;
+
+	/// to find the layout of the images when the frame begins
+	std::unordered_map<VkImageView, VkImage> m_viewImages;
+	std::unordered_map<VkFramebuffer, std::vector<VkImageView>>
+	    m_framebufferViews;
+	std::unordered_map<VkRenderPass, std::vector<VkImageLayout>>
+	    m_renderPassLayouts;
+	/// first layout the frame expects, from barriers and render passes
+	std::unordered_map<VkImage, VkImageLayout> m_initialLayouts;
+	/// layout of the descriptors, for the images only sampled
+	std::unordered_map<VkImage, VkImageLayout> m_descriptorLayouts;
+
+	/// state before the frame of the sets it updates, restored before
+	/// each replay
+	std::vector<DescriptorWrites> m_restoredDescriptors;
+
+	CommandPool m_commandPool;
+	std::deque<CommandBuffer> m_commandBuffers;
+	/// command buffers of each submission, between the timestamps
+	std::vector<std::vector<VkCommandBuffer>> m_submits;
+	std::vector<Step> m_steps;
+
+	UniqueQueryPool m_timestamps;
+	double m_timestampPeriod = 0.0;
+	uint64_t m_timestampMask = 0;
+
+	void load(std::string_view path);
+	void prepare();
+
+	template <typename T>
+	T lookup(uint64_t id);
+	template <typename T>
+	std::vector<T> lookup(const std::vector<uint64_t>& ids);
+
+	void create(capture::Reader& in);
+	uint64_t createBuffer(capture::Reader& in, uint64_t id);
+	uint64_t createImage(capture::Reader& in);
+	uint64_t createImageView(capture::Reader& in);
+	uint64_t createDescriptorSetLayout(capture::Reader& in);
+	uint64_t createPipelineLayout(capture::Reader& in);
+	uint64_t createFramebuffer(capture::Reader& in);
+	uint64_t createDescriptorSet(capture::Reader& in);
+	uint64_t createGraphicsPipeline(capture::Reader& in);
+	uint64_t createComputePipeline(capture::Reader& in);
+
+	/// Resolves the handles of `descriptors`, the ones that cannot be
+	/// replayed are left out
+	DescriptorWrites resolveDescriptors(
+	    VkDescriptorSet set,
+	    const std::vector<capture::Descriptor>& descriptors);
+	void recordSubmit(capture::Reader& in);
+	void recordCommands(capture::Reader& stream, CommandBuffer& cb);
+	/// Drops the barriers of the resources that were not replayed
+	void resolveBarriers(std::vector<VkBufferMemoryBarrier>& barriers);
+	void resolveBarriers(std::vector<VkImageMemoryBarrier>& barriers);
+
+	void noteLayout(VkImage image, VkImageLayout layout);
+	void noteRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer);
+
+	void submitAndWait(const CommandBuffer& cb);
+	/// The host writes captured before the frame, all at once
+	void uploadData(
+	    const std::vector<std::pair<VkBuffer, capture::Bytes>>& uploads);
+	/// Moves the images from undefined to the first layout the frame uses
+	void transitionImages();
+	void createTimestamps();
+	void destroyImages();
+
+public:
+	/// Throws `std::runtime_error` when the file cannot be read or was not
+	/// written by a compatible `FrameRecorder`
+	FrameReplayer(const VulkanDevice& vulkanDevice, std::string_view path);
+	FrameReplayer(const FrameReplayer&) = delete;
+	FrameReplayer(FrameReplayer&&) = delete;
+	~FrameReplayer();
+
+	FrameReplayer& operator=(const FrameReplayer&) = delete;
+	FrameReplayer& operator=(FrameReplayer&&) = delete;
+
+	const Statistics& statistics() const noexcept { return m_statistics; }
+
+	/// Runs the frame once and waits for it
+	Timings replay();
+};
+}  // namespace cdm
@@ -1,17 +1,17 @@
 #include "Framebuffer.hpp"
 #include "ImageView.hpp"
+#include "RenderContext.hpp"
 #include "RenderPass.hpp"
-#include "RenderWindow.hpp"
 
 #include <stdexcept>
 
 namespace cdm
 {
 Framebuffer::Framebuffer(
-    RenderWindow& renderWindow, RenderPass& renderPass,
+    RenderContext& renderContext, RenderPass& renderPass,
     std::vector<std::reference_wrapper<ImageView>> imageViews)
-    : VulkanDeviceObject(renderWindow.device()),
-      rw(renderWindow),
+    : VulkanDeviceObject(renderContext.device()),
+      rw(renderContext),
       m_renderPass(renderPass),
       m_imageViews(std::move(imageViews))
 {
@@ -53,8 +53,7 @@ void Framebuffer::recreate()
 
 	vk.destroy(m_framebuffer.get());
 
-	int width, height;
-	rw.framebufferSize(width, height);
+	VkExtent2D extent = rw.swapchainExtent();
 
 	std::vector<VkImageView> vkImageViews;
 	vkImageViews.reserve(m_imageViews.size());
@@ -67,8 +66,8 @@ void Framebuffer::recreate()
 	framebufferInfo.renderPass = m_renderPass.get().renderPass();
 	framebufferInfo.attachmentCount = uint32_t(vkImageViews.size());
 	framebufferInfo.pAttachments = vkImageViews.data();
-	framebufferInfo.width = width;
-	framebufferInfo.height = height;
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
 	framebufferInfo.layers = 1;
 
 	if (vk.create(framebufferInfo, m_framebuffer.get()) != VK_SUCCESS)
@@ -6,13 +6,13 @@
 
 namespace cdm
 {
-class RenderWindow;
+class RenderContext;
 class RenderPass;
 class ImageView;
 
 class Framebuffer final : public VulkanDeviceObject
 {
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	std::reference_wrapper<RenderPass> m_renderPass;
 	std::vector<std::reference_wrapper<ImageView>> m_imageViews;
@@ -20,7 +20,7 @@ class Framebuffer final : public VulkanDeviceObject
 	Movable<VkFramebuffer> m_framebuffer;
 
 public:
-	Framebuffer(RenderWindow& renderWindow, RenderPass& renderPass,
+	Framebuffer(RenderContext& renderContext, RenderPass& renderPass,
 	            std::vector<std::reference_wrapper<ImageView>> imageViews);
 	~Framebuffer();
 
@@ -0,0 +1,272 @@
+#include "GpuProfiler.hpp"
+
+#include "CommandBuffer.hpp"
+#include "CommandBufferPool.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace cdm
+{
+GpuProfiler::Scope::Scope(GpuProfiler& profiler, CommandBuffer& cb,
+                          std::string_view name, std::array<float, 4> color)
+    : m_profiler(&profiler),
+      m_commandBuffer(&cb)
+{
+	Frame& frame = profiler.m_frames[profiler.m_currentFrame];
+
+	m_entry = uint32_t(frame.entries.size());
+	frame.entries.push_back(
+	    Entry{ std::string(name), profiler.m_depth, m_entry });
+	profiler.m_depth++;
+
+	// the marker name must be null terminated
+	cb.debugMarkerBegin(frame.entries.back().name.c_str(), color);
+
+	if (profiler.enabled() && m_entry < profiler.m_maxScopes)
+		cb.writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool,
+		                  2 * m_entry);
+}
+
+GpuProfiler::Scope::Scope(Scope&& scope) noexcept
+    : m_profiler(scope.m_profiler),
+      m_commandBuffer(scope.m_commandBuffer),
+      m_entry(scope.m_entry)
+{
+	scope.m_profiler = nullptr;
+}
+
+GpuProfiler::Scope::~Scope()
+{
+	if (m_profiler == nullptr)
+		return;
+
+	Frame& frame = m_profiler->m_frames[m_profiler->m_currentFrame];
+
+	if (m_profiler->enabled() && m_entry < m_profiler->m_maxScopes)
+		m_commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		                                frame.queryPool, 2 * m_entry + 1);
+
+	m_commandBuffer->debugMarkerEnd();
+	m_profiler->m_depth--;
+}
+
+GpuProfiler::GpuProfiler(const VulkanDevice& vulkanDevice, uint32_t frameCount,
+                         uint32_t maxScopesPerFrame)
+    : m_vulkanDevice(&vulkanDevice),
+      m_maxScopes(maxScopesPerFrame)
+{
+	auto& vk = vulkanDevice;
+
+	VkPhysicalDeviceProperties properties{};
+	vk.GetPhysicalDeviceProperties(vk.physicalDevice(), &properties);
+	m_timestampPeriod = double(properties.limits.timestampPeriod);
+
+	uint32_t queueFamilyCount = 0;
+	vk.GetPhysicalDeviceQueueFamilyProperties(vk.physicalDevice(),
+	                                          &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vk.GetPhysicalDeviceQueueFamilyProperties(
+	    vk.physicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+	uint32_t validBits =
+	    queueFamilies[vk.queueFamilyIndices().graphicsFamily.value()]
+	        .timestampValidBits;
+	if (validBits == 0)
+	{
+		std::cerr << "warning: timestamps are not supported by the graphics "
+		             "queue, GPU scopes will not be measured"
+		          << std::endl;
+	}
+	m_timestampMask = validBits >= 64 ? ~uint64_t(0)
+	                                  : (uint64_t(1) << validBits) - 1;
+
+	vk::QueryPoolCreateInfo queryPoolInfo;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = 2 * maxScopesPerFrame;
+
+	m_frames.resize(frameCount);
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		m_frames[i].queryPool = vk.create(queryPoolInfo);
+		if (!m_frames[i].queryPool)
+		{
+			std::cerr << "error: failed to create GPU profiler query pool"
+			          << std::endl;
+			abort();
+		}
+		vk.debugMarkerSetObjectName(
+		    m_frames[i].queryPool.get(),
+		    "GpuProfiler::frames[" + std::to_string(i) + "].queryPool");
+	}
+
+	// the first frame would otherwise reset the last one
+	m_currentFrame = frameCount - 1;
+
+	if (enabled())
+		calibrate();
+}
+
+void GpuProfiler::calibrate()
+{
+	auto& vk = *m_vulkanDevice.get();
+
+	// a pool of its own, the frame ones may still hold unread results
+	vk::QueryPoolCreateInfo queryPoolInfo;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = 1;
+	UniqueQueryPool queryPool = vk.create(queryPoolInfo);
+	if (!queryPool)
+	{
+		std::cerr << "error: failed to create GPU profiler query pool"
+		          << std::endl;
+		abort();
+	}
+
+	CommandBufferPool pool(vk, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	auto& frame = pool.getAvailableCommandBuffer();
+	CommandBuffer& cb = frame.commandBuffer;
+
+	cb.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	cb.resetQueryPool(queryPool, 0, 1);
+	cb.writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+	if (cb.end() != VK_SUCCESS)
+		throw std::runtime_error("failed to record calibration commands");
+
+	auto submitTime = std::chrono::steady_clock::now();
+	if (frame.submit(vk.graphicsQueue()) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit calibration commands");
+	pool.waitForAllCommandBuffers();
+	auto completionTime = std::chrono::steady_clock::now();
+
+	uint64_t ticks = 0;
+	VkResult res = vk.GetQueryPoolResults(
+	    vk.vkDevice(), queryPool, 0, 1, sizeof(uint64_t), &ticks,
+	    sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+	if (res != VK_SUCCESS)
+		throw std::runtime_error("failed to read calibration timestamp");
+
+	// the timestamp was written somewhere between the two, the error is
+	// at most half of a submission round trip
+	m_calibrationTicks = ticks & m_timestampMask;
+	m_calibrationTime = submitTime + (completionTime - submitTime) / 2;
+}
+
+std::chrono::steady_clock::time_point GpuProfiler::toCpuTime(
+    uint64_t ticks) const
+{
+	uint64_t elapsed = (ticks - m_calibrationTicks) & m_timestampMask;
+	double nanoseconds = double(elapsed) * m_timestampPeriod;
+
+	return m_calibrationTime +
+	       std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	           std::chrono::duration<double, std::nano>(nanoseconds));
+}
+
+void GpuProfiler::beginFrame(CommandBuffer& cb)
+{
+	if (m_depth != 0)
+		throw std::runtime_error("GpuProfiler: a scope is still open");
+
+	m_currentFrame = (m_currentFrame + 1) % uint32_t(m_frames.size());
+	Frame& frame = m_frames[m_currentFrame];
+
+	if (frame.pending)
+		resolve(frame);
+
+	frame.entries.clear();
+	frame.pending = enabled();
+
+	if (enabled())
+		cb.resetQueryPool(frame.queryPool, 0, 2 * m_maxScopes);
+}
+
+GpuProfiler::Scope GpuProfiler::scope(CommandBuffer& cb,
+                                      std::string_view name,
+                                      std::array<float, 4> color)
+{
+	return Scope(*this, cb, name, color);
+}
+
+void GpuProfiler::resolve(Frame& frame)
+{
+	const auto& vk = *m_vulkanDevice.get();
+
+	uint32_t queryCount = 2 * std::min(uint32_t(frame.entries.size()),
+	                                   m_maxScopes);
+	if (queryCount == 0)
+		return;
+
+	std::vector<uint64_t> timestamps(queryCount);
+	// no VK_QUERY_RESULT_WAIT_BIT, the slot is skipped if the GPU is late
+	VkResult res = vk.GetQueryPoolResults(
+	    vk.vkDevice(), frame.queryPool, 0, queryCount,
+	    timestamps.size() * sizeof(uint64_t), timestamps.data(),
+	    sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (res != VK_SUCCESS)
+		return;
+
+	m_results.clear();
+	for (const Entry& entry : frame.entries)
+	{
+		if (entry.index >= m_maxScopes)
+			continue;
+
+		uint64_t begin = timestamps[2 * entry.index] & m_timestampMask;
+		uint64_t end = timestamps[2 * entry.index + 1] & m_timestampMask;
+		uint64_t ticks = (end - begin) & m_timestampMask;
+
+		m_results.push_back(Result{ entry.name, entry.depth,
+		                            double(ticks) * m_timestampPeriod * 1e-6,
+		                            toCpuTime(begin) });
+	}
+	m_resolvedFrameCount++;
+
+	if (m_capturing)
+	{
+		m_capturedResults.insert(m_capturedResults.end(), m_results.begin(),
+		                         m_results.end());
+	}
+}
+
+void GpuProfiler::startCapture()
+{
+	m_capturedResults.clear();
+	m_capturing = true;
+}
+
+void GpuProfiler::stopCapture() { m_capturing = false; }
+
+double GpuProfiler::frameMilliseconds() const
+{
+	double res = 0.0;
+	for (const Result& result : m_results)
+		if (result.depth == 0)
+			res += result.milliseconds;
+
+	return res;
+}
+
+void GpuProfiler::imgui(const char* windowName) const
+{
+	ImGui::Begin(windowName);
+
+	if (!enabled())
+		ImGui::Text("timestamps not supported");
+	else
+		ImGui::Text("frame: %.3f ms", frameMilliseconds());
+
+	ImGui::Separator();
+
+	for (const Result& result : m_results)
+	{
+		ImGui::Text("%*s%s: %.3f ms", int(2 * result.depth), "",
+		            result.name.c_str(), result.milliseconds);
+	}
+
+	ImGui::End();
+}
+}  // namespace cdm
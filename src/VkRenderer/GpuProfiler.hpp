@@ -0,0 +1,146 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cdm
+{
+class CommandBuffer;
+
+/// Measures GPU time of nested scopes with timestamp queries. Each frame
+/// writes into its own query pool of a ring, a pool is read back when its
+/// slot comes around again so that the CPU never waits for the results
+class GpuProfiler final
+{
+public:
+	/// Resolved duration of a scope, in recording order. Children follow
+	/// their parent with a greater `depth`
+	struct Result
+	{
+		std::string name;
+		uint32_t depth = 0;
+		double milliseconds = 0.0;
+		/// GPU start of the scope translated to the CPU clock, see
+		/// `calibrate`
+		std::chrono::steady_clock::time_point begin;
+	};
+
+	/// Writes a timestamp at construction and one at destruction, inside a
+	/// debug marker of the same name
+	class Scope final
+	{
+		GpuProfiler* m_profiler = nullptr;
+		CommandBuffer* m_commandBuffer = nullptr;
+		uint32_t m_entry = 0;
+
+	public:
+		Scope(GpuProfiler& profiler, CommandBuffer& cb, std::string_view name,
+		      std::array<float, 4> color);
+		Scope(const Scope&) = delete;
+		Scope(Scope&& scope) noexcept;
+		~Scope();
+
+		Scope& operator=(const Scope&) = delete;
+		Scope& operator=(Scope&&) = delete;
+	};
+
+private:
+	struct Entry
+	{
+		std::string name;
+		uint32_t depth = 0;
+		/// the end timestamp is at `2 * index + 1`
+		uint32_t index = 0;
+	};
+
+	struct Frame
+	{
+		UniqueQueryPool queryPool;
+		std::vector<Entry> entries;
+		bool pending = false;
+	};
+
+	Movable<const VulkanDevice*> m_vulkanDevice;
+
+	std::vector<Frame> m_frames;
+	uint32_t m_currentFrame = 0;
+	uint32_t m_maxScopes = 0;
+	uint32_t m_depth = 0;
+
+	/// nanoseconds per tick
+	double m_timestampPeriod = 0.0;
+	uint64_t m_timestampMask = 0;
+
+	uint64_t m_calibrationTicks = 0;
+	std::chrono::steady_clock::time_point m_calibrationTime;
+
+	std::vector<Result> m_results;
+	uint64_t m_resolvedFrameCount = 0;
+	std::vector<Result> m_capturedResults;
+	bool m_capturing = false;
+
+	void resolve(Frame& frame);
+	std::chrono::steady_clock::time_point toCpuTime(uint64_t ticks) const;
+
+public:
+	GpuProfiler() = default;
+	/// `frameCount` must be at least the number of frames in flight.
+	/// Scopes beyond `maxScopesPerFrame` are not measured
+	GpuProfiler(const VulkanDevice& vulkanDevice, uint32_t frameCount = 3,
+	            uint32_t maxScopesPerFrame = 64);
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler(GpuProfiler&&) = default;
+	~GpuProfiler() = default;
+
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(GpuProfiler&&) = default;
+
+	/// false if the graphics queue has no timestamp support, scopes are
+	/// then only debug markers
+	bool enabled() const noexcept { return m_timestampMask != 0; }
+
+	/// Moves to the next frame, reading back its previous results if the
+	/// GPU is done with them, and resets its queries. Must be recorded
+	/// outside of a render pass, before any scope of the frame
+	void beginFrame(CommandBuffer& cb);
+
+	Scope scope(CommandBuffer& cb, std::string_view name,
+	            std::array<float, 4> color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	/// Scopes of the latest resolved frame
+	const std::vector<Result>& results() const noexcept { return m_results; }
+	/// Sum of the top level scopes of the latest resolved frame
+	double frameMilliseconds() const;
+	/// Incremented each time `results` is replaced, a frame whose queries
+	/// were not ready yet is skipped without changing it
+	uint64_t resolvedFrameCount() const noexcept
+	{
+		return m_resolvedFrameCount;
+	}
+
+	/// Matches a GPU timestamp with the CPU clock by submitting a single
+	/// timestamp and waiting for it. Done at construction, the clocks
+	/// drift apart over long sessions so it can be repeated before a
+	/// capture
+	void calibrate();
+
+	/// Keeps the results of every frame resolved until `stopCapture`,
+	/// the last frames in flight are not included
+	void startCapture();
+	void stopCapture();
+	bool capturing() const noexcept { return m_capturing; }
+	const std::vector<Result>& capturedResults() const noexcept
+	{
+		return m_capturedResults;
+	}
+
+	/// Draws the results in an ImGui window, between `ImGui::NewFrame` and
+	/// `ImGui::Render`
+	void imgui(const char* windowName = "GPU profiler") const;
+};
+}  // namespace cdm
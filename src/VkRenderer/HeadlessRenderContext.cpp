@@ -0,0 +1,243 @@
+#include "HeadlessRenderContext.hpp"
+
+#include "TextureFactory.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace cdm
+{
+static QueueFamilyIndices findGraphicsQueueFamily(const VulkanDevice& vk)
+{
+	uint32_t queueFamilyCount = 0;
+	vk.GetPhysicalDeviceQueueFamilyProperties(vk.physicalDevice(),
+	                                          &queueFamilyCount, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vk.GetPhysicalDeviceQueueFamilyProperties(
+	    vk.physicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+	QueueFamilyIndices indices;
+	for (uint32_t i = 0; i < queueFamilyCount; i++)
+	{
+		if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		{
+			// nothing is presented, the "present" queue is the graphics one
+			indices.graphicsFamily = i;
+			indices.presentFamily = i;
+			break;
+		}
+	}
+
+	if (!indices.graphicsFamily.has_value())
+	{
+		std::cerr << "error: no graphics queue family" << std::endl;
+		exit(1);
+	}
+
+	return indices;
+}
+
+HeadlessRenderContext::HeadlessRenderContext(VkExtent2D extent,
+                                             uint32_t imageCount,
+                                             VkFormat imageFormat, bool layers)
+    : m_vulkanDevice(layers),
+      m_extent(extent),
+      m_imageFormat(imageFormat)
+{
+	auto& vk = m_vulkanDevice;
+
+	QueueFamilyIndices indices = findGraphicsQueueFamily(vk);
+	vk.createDevice(nullptr, indices);
+
+	vk::CommandPoolCreateInfo poolInfo;
+	poolInfo.queueFamilyIndex = indices.graphicsFamily.value();
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	m_commandPool = vk.create(poolInfo);
+	m_oneTimeCommandPool = vk.create(poolInfo);
+	if (!m_commandPool || !m_oneTimeCommandPool)
+	{
+		std::cerr << "error: failed to create command pools" << std::endl;
+		abort();
+	}
+
+	TextureFactory f(vk);
+	f.setExtent(extent);
+	f.setFormat(imageFormat);
+	f.setUsage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+	           VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+	           VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+	           VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+	m_images.reserve(imageCount);
+	// SwapchainImage is referenced by the views, it must not be reallocated
+	m_swapchainImages.reserve(imageCount);
+	m_imageViews.reserve(imageCount);
+	for (uint32_t i = 0; i < imageCount; i++)
+	{
+		Texture2D& image = m_images.emplace_back(f.createTexture2D());
+		image.transitionLayoutImmediate(VK_IMAGE_LAYOUT_UNDEFINED,
+		                                swapchainImageLayout());
+
+		vk.debugMarkerSetObjectName(
+		    image.get(),
+		    "HeadlessRenderContext::images[" + std::to_string(i) + "]");
+
+		SwapchainImage& swapchainImage =
+		    m_swapchainImages.emplace_back(vk, image.get(), imageFormat);
+		m_imageViews.push_back(std::make_unique<ImageView>(
+		    vk, swapchainImage, imageFormat));
+	}
+}
+
+HeadlessRenderContext::~HeadlessRenderContext()
+{
+	m_vulkanDevice.wait();
+}
+
+uint32_t HeadlessRenderContext::acquireNextImage(VkSemaphore semaphore,
+                                                 VkFence fence)
+{
+	const auto& vk = device();
+
+	vk::SubmitInfo submitInfo;
+	submitInfo.signalSemaphoreCount = semaphore ? 1 : 0;
+	submitInfo.pSignalSemaphores = &semaphore;
+
+	if (vk.queueSubmit(vk.graphicsQueue(), submitInfo, fence) != VK_SUCCESS)
+	{
+		std::cerr << "error: failed to acquire next image" << std::endl;
+		abort();
+	}
+
+	return m_imageIndex;
+}
+
+void HeadlessRenderContext::present()
+{
+	const auto& vk = device();
+
+	if (!m_presentWaitSemaphores.empty())
+	{
+		// consumes the semaphores as vkQueuePresentKHR would
+		std::vector<VkPipelineStageFlags> waitStages(
+		    m_presentWaitSemaphores.size(),
+		    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		vk::SubmitInfo submitInfo;
+		submitInfo.waitSemaphoreCount =
+		    uint32_t(m_presentWaitSemaphores.size());
+		submitInfo.pWaitSemaphores = m_presentWaitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+
+		if (vk.queueSubmit(vk.graphicsQueue(), submitInfo) != VK_SUCCESS)
+		{
+			std::cerr << "error: failed to present" << std::endl;
+			abort();
+		}
+
+		m_presentWaitSemaphores.clear();
+	}
+
+	vk.wait(vk.graphicsQueue());
+
+	m_imageIndex = (m_imageIndex + 1) % imageCount();
+	m_currentFrame = (m_currentFrame + 1) % framesInFlight();
+}
+
+void HeadlessRenderContext::pushPresentWaitSemaphore(VkSemaphore semaphore)
+{
+	m_presentWaitSemaphores.push_back(semaphore);
+}
+
+VkFormat HeadlessRenderContext::depthImageFormat()
+{
+	const auto& vk = device();
+
+	for (VkFormat format : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT,
+	                         VK_FORMAT_D24_UNORM_S8_UINT })
+	{
+		VkFormatProperties props =
+		    vk.getPhysicalDeviceFormatProperties(format);
+
+		if (props.optimalTilingFeatures &
+		    VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			return format;
+	}
+
+	throw std::runtime_error("failed to find supported format");
+}
+
+std::vector<VkImage> HeadlessRenderContext::swapchainImages() const
+{
+	std::vector<VkImage> res;
+	res.reserve(m_images.size());
+
+	for (const auto& image : m_images)
+		res.push_back(image.get());
+
+	return res;
+}
+
+std::vector<std::reference_wrapper<ImageView>>
+HeadlessRenderContext::swapchainImageViews() const
+{
+	std::vector<std::reference_wrapper<ImageView>> res;
+	res.reserve(m_imageViews.size());
+
+	for (const auto& view : m_imageViews)
+		res.emplace_back(*view);
+
+	return res;
+}
+
+ResettableFrameCommandBuffer& HeadlessRenderContext::getAvailableCommandBuffer()
+{
+	const auto& vk = device();
+
+	int outCommandBufferIndex = 0;
+	for (auto& frame : m_frameCommandBuffers)
+	{
+		if (frame.isAvailable())
+			return frame;
+
+		outCommandBufferIndex++;
+		if (outCommandBufferIndex >= 256)
+			abort();
+	}
+
+	m_frameCommandBuffers.emplace_front(ResettableFrameCommandBuffer{
+	    CommandBuffer(vk, commandPool()),
+	    vk.createFence(VK_FENCE_CREATE_SIGNALED_BIT), vk.createSemaphore() });
+
+	vk.debugMarkerSetObjectName(
+	    m_frameCommandBuffers.front().commandBuffer.get(),
+	    "HeadlessRenderContext::frameCommandBuffers[" +
+	        std::to_string(outCommandBufferIndex) + "].commandBuffer");
+
+	return m_frameCommandBuffers.front();
+}
+
+void HeadlessRenderContext::waitForAllCommandBuffers()
+{
+	const auto& vk = device();
+
+	for (auto& frame : m_frameCommandBuffers)
+	{
+		if (frame.submitted)
+		{
+			vk.wait(frame.fence);
+			frame.reset();
+		}
+	}
+}
+
+double HeadlessRenderContext::getTime() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+	                                     m_creationTime)
+	    .count();
+}
+}  // namespace cdm
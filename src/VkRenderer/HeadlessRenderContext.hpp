@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CommandBufferPool.hpp"
+#include "Image.hpp"
+#include "ImageView.hpp"
+#include "RenderContext.hpp"
+#include "Texture2D.hpp"
+
+#include <chrono>
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+namespace cdm
+{
+/// `RenderContext` with no window nor surface, for machines without a
+/// display such as render nodes running a software driver (lavapipe).
+/// A ring of offscreen images stands in for the swapchain, they can be
+/// read back through `image`
+class HeadlessRenderContext final : public RenderContext
+{
+	VulkanDevice m_vulkanDevice;
+
+	UniqueCommandPool m_commandPool;
+	UniqueCommandPool m_oneTimeCommandPool;
+
+	VkExtent2D m_extent;
+	VkFormat m_imageFormat;
+	std::vector<Texture2D> m_images;
+	std::vector<SwapchainImage> m_swapchainImages;
+	std::vector<std::unique_ptr<ImageView>> m_imageViews;
+
+	std::forward_list<ResettableFrameCommandBuffer> m_frameCommandBuffers;
+
+	std::vector<VkSemaphore> m_presentWaitSemaphores;
+
+	uint32_t m_imageIndex = 0;
+	size_t m_currentFrame = 0;
+
+	std::chrono::steady_clock::time_point m_creationTime =
+	    std::chrono::steady_clock::now();
+
+public:
+	/// `imageCount` images of `extent` usable as color attachments, storage
+	/// images and transfer sources
+	HeadlessRenderContext(VkExtent2D extent, uint32_t imageCount = 3,
+	                      VkFormat imageFormat = VK_FORMAT_R8G8B8A8_UNORM,
+	                      bool layers = false);
+	HeadlessRenderContext(const HeadlessRenderContext&) = delete;
+	HeadlessRenderContext(HeadlessRenderContext&&) = delete;
+	~HeadlessRenderContext() override;
+
+	HeadlessRenderContext& operator=(const HeadlessRenderContext&) = delete;
+	HeadlessRenderContext& operator=(HeadlessRenderContext&&) = delete;
+
+	const VulkanDevice& device() const override { return m_vulkanDevice; }
+
+	VkCommandPool commandPool() const override { return m_commandPool; }
+	VkCommandPool oneTimeCommandPool() const override
+	{
+		return m_oneTimeCommandPool;
+	}
+
+	/// The images are never in use by a presentation engine, the
+	/// semaphore and fence are signaled by an empty submission
+	uint32_t acquireNextImage(VkSemaphore semaphore, VkFence fence) override;
+	/// Waits for the pushed semaphores and moves to the next image. Frames
+	/// are not overlapped, the graphics queue is waited for
+	void present() override;
+	void pushPresentWaitSemaphore(VkSemaphore semaphore) override;
+
+	uint32_t imageIndex() const override { return m_imageIndex; }
+	size_t currentFrame() const override { return m_currentFrame; }
+	uint32_t framesInFlight() const override { return 1; }
+
+	VkExtent2D swapchainExtent() override { return m_extent; }
+	VkFormat swapchainImageFormat() override { return m_imageFormat; }
+	VkFormat depthImageFormat() override;
+	std::vector<VkImage> swapchainImages() const override;
+	std::vector<std::reference_wrapper<ImageView>> swapchainImageViews()
+	    const override;
+	/// ready to be copied out
+	VkImageLayout swapchainImageLayout() const override
+	{
+		return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	}
+
+	ResettableFrameCommandBuffer& getAvailableCommandBuffer() override;
+	void waitForAllCommandBuffers() override;
+
+	double getTime() const override;
+
+	uint32_t imageCount() const { return uint32_t(m_images.size()); }
+	Texture2D& image(uint32_t index) { return m_images[index]; }
+	const Texture2D& image(uint32_t index) const { return m_images[index]; }
+};
+}  // namespace cdm
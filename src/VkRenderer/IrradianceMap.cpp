@@ -12,11 +12,11 @@
 
 namespace cdm
 {
-IrradianceMap::IrradianceMap(RenderWindow& renderWindow, uint32_t resolution,
+IrradianceMap::IrradianceMap(RenderContext& renderContext, uint32_t resolution,
                              Texture2D& equirectangularTexture,
                              std::string_view filePath)
 {
-	auto& vk = renderWindow.device();
+	auto& vk = renderContext.device();
 
 	using namespace std::literals;
 	namespace fs = std::filesystem;
@@ -37,7 +37,7 @@ IrradianceMap::IrradianceMap(RenderWindow& renderWindow, uint32_t resolution,
 			is >> infoResolution;
 
 			m_irradianceMap = Cubemap(
-			    renderWindow, infoResolution, infoResolution,
+			    renderContext, infoResolution, infoResolution,
 			    VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
 			    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
 			    VMA_MEMORY_USAGE_GPU_ONLY,
@@ -83,7 +83,7 @@ IrradianceMap::IrradianceMap(RenderWindow& renderWindow, uint32_t resolution,
 	std::cout << "irradianceMap not found in \"" << cacheFilePath
 	          << "\". Generating it, please wait..." << std::endl;
 
-	EquirectangularToIrradianceMap e2i(renderWindow, resolution);
+	EquirectangularToIrradianceMap e2i(renderContext, resolution);
 	m_irradianceMap = e2i.computeCubemap(equirectangularTexture);
 
 	std::filesystem::create_directory(cacheDirPath);
@@ -3,7 +3,7 @@
 #include "VulkanDevice.hpp"
 
 #include "Cubemap.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Texture2D.hpp"
 
 #include <string_view>
@@ -16,7 +16,7 @@ class IrradianceMap final
 
 public:
 	IrradianceMap() = default;
-	IrradianceMap(RenderWindow& renderWindow, uint32_t resolution,
+	IrradianceMap(RenderContext& renderContext, uint32_t resolution,
 	              Texture2D& equirectangularTexture,
 	              std::string_view filePath);
 
@@ -0,0 +1,124 @@
+#include "LayoutCache.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace cdm
+{
+size_t LayoutCache::KeyHash::operator()(const Key& key) const noexcept
+{
+	size_t hash = key.size();
+	for (uint64_t word : key)
+		hash ^= std::hash<uint64_t>()(word) + 0x9e3779b9 + (hash << 6) +
+		        (hash >> 2);
+	return hash;
+}
+
+LayoutCache::LayoutCache(const VulkanDevice& vulkanDevice)
+    : m_vulkanDevice(vulkanDevice)
+{
+}
+
+VkDescriptorSetLayout LayoutCache::descriptorSetLayout(
+    const vk::DescriptorSetLayoutCreateInfo& createInfo)
+{
+	if (createInfo.pNext != nullptr)
+		throw std::runtime_error(
+		    "cached descriptor set layouts can not have a pNext chain");
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings(
+	    createInfo.pBindings, createInfo.pBindings + createInfo.bindingCount);
+	std::sort(bindings.begin(), bindings.end(),
+	          [](const VkDescriptorSetLayoutBinding& a,
+	             const VkDescriptorSetLayoutBinding& b) {
+		          return a.binding < b.binding;
+	          });
+
+	Key key;
+	key.push_back(createInfo.flags);
+	for (const auto& binding : bindings)
+	{
+		key.push_back(binding.binding);
+		key.push_back(binding.descriptorType);
+		key.push_back(binding.descriptorCount);
+		key.push_back(binding.stageFlags);
+		if (binding.pImmutableSamplers)
+		{
+			for (uint32_t i = 0; i < binding.descriptorCount; i++)
+				key.push_back(uint64_t(binding.pImmutableSamplers[i]));
+		}
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	auto found = m_descriptorSetLayouts.find(key);
+	if (found != m_descriptorSetLayouts.end())
+		return found->second;
+
+	auto setLayout = m_vulkanDevice.get().create(createInfo);
+	if (!setLayout)
+	{
+		std::cerr << "error: failed to create descriptor set layout"
+		          << std::endl;
+		abort();
+	}
+
+	return m_descriptorSetLayouts.emplace(std::move(key), std::move(setLayout))
+	    .first->second;
+}
+
+VkPipelineLayout LayoutCache::pipelineLayout(
+    const vk::PipelineLayoutCreateInfo& createInfo)
+{
+	std::vector<VkPushConstantRange> ranges(
+	    createInfo.pPushConstantRanges,
+	    createInfo.pPushConstantRanges + createInfo.pushConstantRangeCount);
+	std::sort(ranges.begin(), ranges.end(),
+	          [](const VkPushConstantRange& a, const VkPushConstantRange& b) {
+		          return a.offset < b.offset ||
+		                 (a.offset == b.offset && a.stageFlags < b.stageFlags);
+	          });
+
+	Key key;
+	key.push_back(createInfo.flags);
+	key.push_back(createInfo.setLayoutCount);
+	for (uint32_t i = 0; i < createInfo.setLayoutCount; i++)
+		key.push_back(uint64_t(createInfo.pSetLayouts[i]));
+	for (const auto& range : ranges)
+	{
+		key.push_back(range.stageFlags);
+		key.push_back(range.offset);
+		key.push_back(range.size);
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	auto found = m_pipelineLayouts.find(key);
+	if (found != m_pipelineLayouts.end())
+		return found->second;
+
+	auto pipelineLayout = m_vulkanDevice.get().create(createInfo);
+	if (!pipelineLayout)
+	{
+		std::cerr << "error: failed to create pipeline layout" << std::endl;
+		abort();
+	}
+
+	return m_pipelineLayouts
+	    .emplace(std::move(key), std::move(pipelineLayout))
+	    .first->second;
+}
+
+uint32_t LayoutCache::descriptorSetLayoutCount()
+{
+	std::lock_guard lock(m_mutex);
+	return uint32_t(m_descriptorSetLayouts.size());
+}
+
+uint32_t LayoutCache::pipelineLayoutCount()
+{
+	std::lock_guard lock(m_mutex);
+	return uint32_t(m_pipelineLayouts.size());
+}
+}  // namespace cdm
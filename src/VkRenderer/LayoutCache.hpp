@@ -0,0 +1,51 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cdm
+{
+/// Device-wide cache of descriptor set layouts and pipeline layouts keyed by
+/// their content, so that pipelines built from identical bindings share
+/// their layouts and stay compatible when switching between them.
+/// The layouts live as long as the device, see `VulkanDevice::layoutCache`
+class LayoutCache final
+{
+	std::reference_wrapper<const VulkanDevice> m_vulkanDevice;
+
+	/// canonical serialization of a create info
+	using Key = std::vector<uint64_t>;
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const noexcept;
+	};
+
+	std::mutex m_mutex;
+	std::unordered_map<Key, UniqueDescriptorSetLayout, KeyHash>
+	    m_descriptorSetLayouts;
+	std::unordered_map<Key, UniquePipelineLayout, KeyHash> m_pipelineLayouts;
+
+public:
+	LayoutCache(const VulkanDevice& vulkanDevice);
+	LayoutCache(const LayoutCache&) = delete;
+	LayoutCache(LayoutCache&&) = delete;
+	~LayoutCache() = default;
+
+	LayoutCache& operator=(const LayoutCache&) = delete;
+	LayoutCache& operator=(LayoutCache&&) = delete;
+
+	/// Bindings are compared regardless of their order, `pNext` chains are
+	/// not supported
+	VkDescriptorSetLayout descriptorSetLayout(
+	    const vk::DescriptorSetLayoutCreateInfo& createInfo);
+	/// Push constant ranges are compared regardless of their order
+	VkPipelineLayout pipelineLayout(
+	    const vk::PipelineLayoutCreateInfo& createInfo);
+
+	uint32_t descriptorSetLayoutCount();
+	uint32_t pipelineLayoutCount();
+};
+}  // namespace cdm
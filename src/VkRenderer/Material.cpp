@@ -1,12 +1,14 @@
 #include "Material.hpp"
 #include "MyShaderWriter.hpp"
 #include "CommandBuffer.hpp"
+#include "RenderContext.hpp"
 #include "RenderPass.hpp"
-#include "RenderWindow.hpp"
 #include "UniformBuffer.hpp"
 
+#include <algorithm>
 #include <array>
 #include <iostream>
+#include <stdexcept>
 
 namespace cdm
 {
@@ -250,14 +252,14 @@ void MaterialInstance::pushOffset(CommandBuffer& cb, VkPipelineLayout layout)
 	cb.pushConstants(layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, &offset);
 }
 
-Material::Material(RenderWindow& renderWindow, PbrShadingModel& shadingModel,
+Material::Material(RenderContext& renderContext, PbrShadingModel& shadingModel,
                    uint32_t instancePoolSize)
-    : rw(&renderWindow),
+    : rw(&renderContext),
       m_shadingModel(&shadingModel),
       m_instancePoolSize(instancePoolSize)
 {
 	m_instances.reserve(m_instancePoolSize);
-	/// TODO: resize descriptor pool
+	m_frameDirtyRanges.resize(frameCount());
 }
 
 std::unique_ptr<Material::VertexShaderBuildDataBase>
@@ -274,11 +276,26 @@ Material::instantiateFragmentShaderBuildData()
 
 MaterialInstance* Material::instanciate()
 {
+	if (!m_freeInstances.empty())
+	{
+		uint32_t instanceIndex = m_freeInstances.back();
+		m_freeInstances.pop_back();
+
+		m_instances[instanceIndex - 1].reset(
+		    new MaterialInstance(*this, instanceIndex));
+		return m_instances[instanceIndex - 1].get();
+	}
+
 	if (m_instances.size() >= m_instancePoolSize)
-		return nullptr;
+	{
+		uint32_t instancePoolSize =
+		    std::max(m_instancePoolSize.get() * 2, 1u);
+		resizeInstancePool(instancePoolSize);
+		m_instancePoolSize = instancePoolSize;
+	}
 
 	m_instances.emplace_back(
-	    MaterialInstance(*this, uint32_t(m_instances.size() + 1)));
+	    new MaterialInstance(*this, uint32_t(m_instances.size() + 1)));
 	//m_instances.back().m_floatParameters = m_floatParameters;
 	//m_instances.back().m_vec2Parameters = m_vec2Parameters;
 	//m_instances.back().m_vec3Parameters = m_vec3Parameters;
@@ -290,7 +307,58 @@ MaterialInstance* Material::instanciate()
 	//m_instances.back().m_intParameters = m_intParameters;
 	//m_instances.back().m_instanceOffset = m_instances.size() + 1;
 
-	return &m_instances.back();
+	return m_instances.back().get();
+}
+
+void Material::retire(std::vector<Buffer> buffers)
+{
+	RetiredResources retired;
+	retired.descriptorPool = std::move(m_descriptorPool);
+	retired.buffers = std::move(buffers);
+	retired.framesLeft = frameCount();
+	m_retiredResources.push_back(std::move(retired));
+
+	m_descriptorSets.clear();
+}
+
+uint32_t Material::frameCount() const
+{
+	return rw ? std::max(rw.get()->framesInFlight(), 1u) : 1u;
+}
+
+uint32_t Material::frameIndex() const
+{
+	return rw ? uint32_t(rw.get()->currentFrame() % frameCount()) : 0u;
+}
+
+const VkDescriptorSet& Material::descriptorSet() const
+{
+	return m_descriptorSets[frameIndex()];
+}
+
+void Material::beginFrame()
+{
+	for (RetiredResources& retired : m_retiredResources)
+		retired.framesLeft--;
+	m_retiredResources.erase(
+	    std::remove_if(m_retiredResources.begin(), m_retiredResources.end(),
+	                   [](const RetiredResources& retired) {
+		                   return retired.framesLeft == 0;
+	                   }),
+	    m_retiredResources.end());
+}
+
+void Material::release(MaterialInstance* instance)
+{
+	if (instance == nullptr || &instance->material() != this)
+		throw std::runtime_error("instance does not belong to this material");
+
+	uint32_t instanceIndex = instance->index();
+
+	resetInstance(instanceIndex);
+
+	m_instances[instanceIndex - 1].reset();
+	m_freeInstances.push_back(instanceIndex);
 }
 
 //float Material::floatParameter(const std::string& name)
@@ -482,10 +550,32 @@ MaterialInstance* Material::instanciate()
 //	}
 //}
 
+void Material::flushParameters()
+{
+	// the buffers of the other frames may still be read, they get the
+	// changes on their next flush
+	for (DirtyRange& range : m_frameDirtyRanges)
+	{
+		range.begin = std::min(range.begin, m_dirtyBegin);
+		range.end = std::max(range.end, m_dirtyEnd);
+	}
+	m_dirtyBegin = ~0u;
+	m_dirtyEnd = 0;
+
+	const uint32_t frame = frameIndex();
+	DirtyRange& range = m_frameDirtyRanges[frame];
+	if (range.begin >= range.end)
+		return;
+
+	uploadParameters(frame, range.begin, range.end - range.begin);
+
+	range = DirtyRange{};
+}
+
 void Material::bind(CommandBuffer& cb, VkPipelineLayout layout)
 {
 	cb.bindDescriptorSet(VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
-	                     layout, 0, m_descriptorSet);
+	                     layout, 0, descriptorSet());
 }
 
 void Material::pushOffset(CommandBuffer& cb, VkPipelineLayout layout)
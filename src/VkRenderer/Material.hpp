@@ -8,14 +8,22 @@
 
 #include "cdm_maths.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 namespace cdm
 {
-class RenderWindow;
+class RenderContext;
 class RenderPass;
 class CommandBuffer;
 class Material;
@@ -43,6 +51,57 @@ public:
 	using UIntParameter = NumberParameter<uint32_t>;
 	using IntParameter = NumberParameter<int32_t>;
 
+	enum class ParameterType
+	{
+		Float,
+		Vec2,
+		Vec3,
+		Vec4,
+		Mat2,
+		Mat3,
+		Mat4,
+		UInt,
+		Int,
+	};
+
+	template <typename T>
+	static constexpr ParameterType parameterTypeOf() noexcept
+	{
+		if constexpr (std::is_same_v<T, float>)
+			return ParameterType::Float;
+		else if constexpr (std::is_same_v<T, vector2>)
+			return ParameterType::Vec2;
+		else if constexpr (std::is_same_v<T, vector3>)
+			return ParameterType::Vec3;
+		else if constexpr (std::is_same_v<T, vector4>)
+			return ParameterType::Vec4;
+		else if constexpr (std::is_same_v<T, matrix2>)
+			return ParameterType::Mat2;
+		else if constexpr (std::is_same_v<T, matrix3>)
+			return ParameterType::Mat3;
+		else if constexpr (std::is_same_v<T, matrix4>)
+			return ParameterType::Mat4;
+		else if constexpr (std::is_same_v<T, uint32_t>)
+			return ParameterType::UInt;
+		else if constexpr (std::is_same_v<T, int32_t>)
+			return ParameterType::Int;
+		else
+			static_assert(sizeof(T) == 0, "unsupported parameter type");
+	}
+
+	/// Byte offset of a parameter in the data of an instance, resolved once
+	/// by `Material::parameterHandle` so that setting it does no string work
+	template <typename T>
+	class ParameterHandle
+	{
+	public:
+		static constexpr uint32_t InvalidOffset = ~0u;
+
+		uint32_t offset = InvalidOffset;
+
+		bool valid() const noexcept { return offset != InvalidOffset; }
+	};
+
 protected:
 	virtual float floatParameter(const std::string& name,
 	                             uint32_t instanceIndex)
@@ -198,6 +257,11 @@ public:
 	void setIntParameter(const std::string& name, int32_t a);
 	void setTextureParameter(const std::string& name, Texture2D& a);
 
+	template <typename T>
+	T parameter(ParameterHandle<T> handle);
+	template <typename T>
+	void setParameter(ParameterHandle<T> handle, const T& a);
+
 	void bind(CommandBuffer& cb, VkPipelineLayout layout) override;
 	void pushOffset(CommandBuffer& cb, VkPipelineLayout layout) override;
 
@@ -209,17 +273,59 @@ class Material : public MaterialInterface
 {
 	friend MaterialInstance;
 
-	Movable<RenderWindow*> rw;
+	Movable<RenderContext*> rw;
 	Movable<PbrShadingModel*> m_shadingModel;
 
-	std::vector<MaterialInstance> m_instances;
+	/// indexed by instance index - 1, released instances are null
+	std::vector<std::unique_ptr<MaterialInstance>> m_instances;
+	/// released instance indices, reused before the pool grows
+	std::vector<uint32_t> m_freeInstances;
 	Movable<uint32_t, 0ull> m_instancePoolSize;
 
+	/// instances whose parameters changed since the last flush
+	uint32_t m_dirtyBegin = ~0u;
+	uint32_t m_dirtyEnd = 0;
+
+	struct DirtyRange
+	{
+		uint32_t begin = ~0u;
+		uint32_t end = 0;
+	};
+	/// instances not uploaded yet to the buffer of each frame in flight, a
+	/// flush only writes the buffer of the frame being recorded
+	std::vector<DirtyRange> m_frameDirtyRanges{ DirtyRange{} };
+
+	uint32_t m_shadingFeatures = PbrShadingModel::AllShadingFeatures;
+	uint64_t m_shaderGeneration = 0;
+
+	struct FragmentShader
+	{
+		uint64_t shaderGeneration = 0;
+		std::shared_ptr<const std::vector<uint32_t>> bytecode;
+	};
+	/// fragment shader SPIR-V of the scene objects using this material,
+	/// keyed by the non specialized shading features
+	std::unordered_map<uint32_t, FragmentShader> m_fragmentShaders;
+	/// variants are compiled by the `PipelineCompiler` workers
+	std::unique_ptr<std::mutex> m_fragmentShadersMutex =
+	    std::make_unique<std::mutex>();
+
+	/// Replaced descriptor sets and buffers the frames in flight may still
+	/// use
+	struct RetiredResources
+	{
+		UniqueDescriptorPool descriptorPool;
+		std::vector<Buffer> buffers;
+		uint32_t framesLeft = 0;
+	};
+	std::vector<RetiredResources> m_retiredResources;
+
 protected:
 	UniqueDescriptorPool m_descriptorPool;
 
 	UniqueDescriptorSetLayout m_descriptorSetLayout;
-	Movable<VkDescriptorSet> m_descriptorSet;
+	/// one per frame in flight, see `frameIndex`
+	std::vector<VkDescriptorSet> m_descriptorSets;
 
 public:
 	struct VertexShaderBuildDataBase
@@ -232,7 +338,7 @@ public:
 	};
 
 	Material() = default;
-	Material(RenderWindow& rw, PbrShadingModel& shadingModel,
+	Material(RenderContext& rw, PbrShadingModel& shadingModel,
 	         uint32_t instancePoolSize = 0);
 	Material(const Material&) = delete;
 	Material(Material&&) = default;
@@ -262,20 +368,158 @@ public:
 	virtual std::unique_ptr<FragmentShaderBuildDataBase>
 	instantiateFragmentShaderBuildData();
 
-	RenderWindow& renderWindow() { return *rw; }
+	RenderContext& renderContext() { return *rw; }
 	PbrShadingModel& shadingModel() { return *m_shadingModel; }
 	uint32_t instancePoolSize() const noexcept { return m_instancePoolSize; }
 
+	/// `PbrShadingModel::ShadingFeature` flags the shaders of this material
+	/// are generated with, pipelines of other variants are built on the next
+	/// draw
+	uint32_t shadingFeatures() const noexcept { return m_shadingFeatures; }
+	void setShadingFeatures(uint32_t features) noexcept
+	{
+		m_shadingFeatures = features;
+	}
+
+	/// Incremented by `invalidateShaders`, the pipelines embedding
+	/// `vertexFunction` or `fragmentFunction` are rebuilt when it changes
+	uint64_t shaderGeneration() const noexcept { return m_shaderGeneration; }
+	void invalidateShaders() noexcept { m_shaderGeneration++; }
+
+	/// null if the variant was not compiled yet for `shaderGeneration`, the
+	/// sum of the generations of the shader dependencies
+	std::shared_ptr<const std::vector<uint32_t>> fragmentShader(
+	    uint32_t variant, uint64_t shaderGeneration) const
+	{
+		std::lock_guard lock(*m_fragmentShadersMutex);
+		auto found = m_fragmentShaders.find(variant);
+		if (found == m_fragmentShaders.end() ||
+		    found->second.shaderGeneration != shaderGeneration)
+			return nullptr;
+		return found->second.bytecode;
+	}
+	/// Keeps the bytecode of the first thread to finish when a variant is
+	/// compiled concurrently, replaces the ones of older generations
+	std::shared_ptr<const std::vector<uint32_t>> setFragmentShader(
+	    uint32_t variant, uint64_t shaderGeneration,
+	    std::vector<uint32_t> bytecode)
+	{
+		std::lock_guard lock(*m_fragmentShadersMutex);
+		auto& fragmentShader = m_fragmentShaders[variant];
+		if (fragmentShader.bytecode == nullptr ||
+		    fragmentShader.shaderGeneration < shaderGeneration)
+		{
+			fragmentShader.shaderGeneration = shaderGeneration;
+			fragmentShader.bytecode =
+			    std::make_shared<const std::vector<uint32_t>>(
+			        std::move(bytecode));
+		}
+		return fragmentShader.bytecode;
+	}
+
 	const VkDescriptorSetLayout& descriptorSetLayout() const noexcept
 	{
 		return m_descriptorSetLayout;
 	}
-	const VkDescriptorSet& descriptorSet() const noexcept
+	/// Set of the frame being recorded
+	const VkDescriptorSet& descriptorSet() const;
+
+	/// Grows the instance pool when it is full. The grown descriptor sets
+	/// are bound by the commands recorded afterwards, the previous ones stay
+	/// valid for the frames in flight
+	MaterialInstance* instanciate();
+	/// Resets the parameters of `instance` and recycles its index, the
+	/// pointer must not be used afterwards
+	void release(MaterialInstance* instance);
+	uint32_t instanceCount() const noexcept
 	{
-		return m_descriptorSet;
+		return uint32_t(m_instances.size() - m_freeInstances.size());
 	}
 
-	MaterialInstance* instanciate();
+	template <typename T>
+	ParameterHandle<T> parameterHandle(const std::string& name)
+	{
+		ParameterHandle<T> handle;
+		handle.offset = parameterOffset(name, parameterTypeOf<T>());
+		if (!handle.valid())
+			throw std::runtime_error("could not find parameter " + name);
+
+		return handle;
+	}
+
+	template <typename T>
+	T parameter(uint32_t instanceIndex, ParameterHandle<T> handle)
+	{
+		T res;
+		std::memcpy(&res, parameterData(instanceIndex) + handle.offset,
+		            sizeof(T));
+		return res;
+	}
+
+	template <typename T>
+	void setParameter(uint32_t instanceIndex, ParameterHandle<T> handle,
+	                  const T& a)
+	{
+		std::memcpy(parameterData(instanceIndex) + handle.offset, &a,
+		            sizeof(T));
+		markDirty(instanceIndex);
+	}
+
+	/// Uploads the parameters changed since the last flush of the frame
+	/// being recorded in a single copy to this frame's buffer
+	void flushParameters();
+
+	/// Frame boundary of the instance pool growth: releases the descriptor
+	/// sets and buffers replaced `framesInFlight` frames ago, must be called
+	/// once per frame before recording it
+	void beginFrame();
+
+protected:
+	/// Offset of the parameter `name` in the data returned by
+	/// `parameterData`, `ParameterHandle<T>::InvalidOffset` if the material
+	/// has no parameter of this name and type
+	virtual uint32_t parameterOffset(const std::string& name,
+	                                 ParameterType type)
+	{
+		return ParameterHandle<float>::InvalidOffset;
+	}
+	/// Parameters of an instance as laid out in the material buffer
+	virtual std::byte* parameterData(uint32_t instanceIndex)
+	{
+		assert(false);
+		return nullptr;
+	}
+	/// Copies the parameters of `instanceCount` instances to the material
+	/// buffer of the frame `frame`, see `frameIndex`
+	virtual void uploadParameters(uint32_t frame, uint32_t firstInstance,
+	                              uint32_t instanceCount)
+	{
+	}
+	/// Reallocates the material buffers for `instancePoolSize` instances,
+	/// keeping the parameters of the existing ones, in new descriptor sets.
+	/// The previous ones go to `retire`. Materials that do not override it
+	/// have the fixed capacity given at construction
+	virtual void resizeInstancePool(uint32_t instancePoolSize)
+	{
+		throw std::runtime_error("material instance pool is full");
+	}
+	/// Keeps `m_descriptorPool` and `buffers` alive until the frames in
+	/// flight are done with them
+	void retire(std::vector<Buffer> buffers);
+
+	/// Number of copies of the per-frame resources, 1 without a render
+	/// context
+	uint32_t frameCount() const;
+	/// Index of the per-frame resources of the frame being recorded
+	uint32_t frameIndex() const;
+	/// Restores the default parameters of a released instance
+	virtual void resetInstance(uint32_t instanceIndex) {}
+
+	void markDirty(uint32_t instanceIndex) noexcept
+	{
+		m_dirtyBegin = std::min(m_dirtyBegin, instanceIndex);
+		m_dirtyEnd = std::max(m_dirtyEnd, instanceIndex + 1);
+	}
 
 protected:
 	using MaterialInterface::floatParameter;
@@ -419,4 +663,16 @@ public:
 
 	Material& material() override { return *this; }
 };
+
+template <typename T>
+T MaterialInstance::parameter(ParameterHandle<T> handle)
+{
+	return m_material.get().parameter(m_instanceOffset, handle);
+}
+
+template <typename T>
+void MaterialInstance::setParameter(ParameterHandle<T> handle, const T& a)
+{
+	m_material.get().setParameter(m_instanceOffset, handle, a);
+}
 }  // namespace cdm
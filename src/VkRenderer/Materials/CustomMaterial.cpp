@@ -1,7 +1,7 @@
 #include "CustomMaterial.hpp"
 #include "CommandBuffer.hpp"
+#include "RenderContext.hpp"
 #include "RenderPass.hpp"
-#include "RenderWindow.hpp"
 
 #include <array>
 #include <iostream>
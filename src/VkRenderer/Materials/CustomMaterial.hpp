@@ -33,7 +33,7 @@ class DefaultMaterial : public Material
 
 public:
 	DefaultMaterial() = default;
-	DefaultMaterial(RenderWindow& rw, PbrShadingModel& shadingModel,
+	DefaultMaterial(RenderContext& rw, PbrShadingModel& shadingModel,
 	                uint32_t instancePoolSize = 0);
 	DefaultMaterial(const DefaultMaterial&) = delete;
 	DefaultMaterial(DefaultMaterial&&) = default;
@@ -1,9 +1,11 @@
 #include "DefaultMaterial.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "TextureFactory.hpp"
 
+#include <cstddef>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 using namespace sdw;
 
@@ -72,28 +74,14 @@ struct TypeTraits<shader::DefaultMaterialData>
 
 namespace cdm
 {
-DefaultMaterial::DefaultMaterial(RenderWindow& renderWindow,
+DefaultMaterial::DefaultMaterial(RenderContext& renderContext,
                                  PbrShadingModel& shadingModel,
                                  uint32_t instancePoolSize)
-    : Material(renderWindow, shadingModel, instancePoolSize),
-      m_textureRef(m_texture)
+    : DefaultMaterialParameters(renderContext, shadingModel,
+                                instancePoolSize),
+      m_textureTable(&shadingModel.textureTable())
 {
-    auto& vk = renderWindow.device();
-
-    m_uniformBuffer =
-        Buffer(vk, sizeof(UBOStruct) * (size_t(instancePoolSize) + 1),
-               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_ONLY,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    m_uniformBuffer.setName("DefaultMaterial SSBO");
-
-    UBOStruct uboStruct;
-    uboStruct.color = vector4{ 0.9f, 0.5f, 0.25f, 1.0f };
-    uboStruct.metalness = 0.1f;
-    uboStruct.roughness = 0.3f;
-    uboStruct.textureIndex = 1023;
-
-    m_uboStructs.resize(size_t(instancePoolSize) + 1, uboStruct);
+    auto& vk = renderContext.device();
 
     // for (auto& s : m_uboStructs)
     //  s = uboStruct;
@@ -122,31 +110,6 @@ DefaultMaterial::DefaultMaterial(RenderWindow& renderWindow,
     // m_uboStruct.metalness = m_floatParameters["metalness"].value;
     // m_uboStruct.roughness = m_floatParameters["roughness"].value;
 
-    void* ptr = m_uniformBuffer.map();
-    std::memcpy(ptr, m_uboStructs.data(),
-                sizeof(*m_uboStructs.data()) * m_uboStructs.size());
-    m_uniformBuffer.unmap();
-
-#pragma region descriptor pool
-    std::array poolSizes{
-        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
-        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                              1024 },
-    };
-
-    vk::DescriptorPoolCreateInfo poolInfo;
-    poolInfo.maxSets = 1;
-    poolInfo.poolSizeCount = uint32_t(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-
-    m_descriptorPool = vk.create(poolInfo);
-    if (!m_descriptorPool)
-    {
-        std::cerr << "error: failed to create descriptor pool" << std::endl;
-        abort();
-    }
-#pragma endregion
-
 #pragma region descriptor set layout
     VkDescriptorSetLayoutBinding layoutBindingUbo{};
     layoutBindingUbo.binding = 0;
@@ -154,17 +117,8 @@ DefaultMaterial::DefaultMaterial(RenderWindow& renderWindow,
     layoutBindingUbo.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     layoutBindingUbo.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-    VkDescriptorSetLayoutBinding layoutBindingTextureUbo{};
-    layoutBindingTextureUbo.binding = 1;
-    layoutBindingTextureUbo.descriptorCount = 1024;
-    layoutBindingTextureUbo.descriptorType =
-        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    layoutBindingTextureUbo.stageFlags =
-        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-
     std::array layoutBindings{
         layoutBindingUbo,
-        layoutBindingTextureUbo,
     };
 
     vk::DescriptorSetLayoutCreateInfo setLayoutInfo;
@@ -180,30 +134,7 @@ DefaultMaterial::DefaultMaterial(RenderWindow& renderWindow,
     }
 #pragma endregion
 
-#pragma region descriptor set
-    m_descriptorSet = vk.allocate(m_descriptorPool, m_descriptorSetLayout);
-
-    if (!m_descriptorSet)
-    {
-        std::cerr << "error: failed to allocate descriptor set" << std::endl;
-        abort();
-    }
-#pragma endregion
-
-    VkDescriptorBufferInfo setBufferInfo{};
-    setBufferInfo.buffer = m_uniformBuffer;
-    setBufferInfo.range = sizeof(UBOStruct) * (size_t(instancePoolSize) + 1);
-    setBufferInfo.offset = 0;
-
-    vk::WriteDescriptorSet uboWrite;
-    uboWrite.descriptorCount = 1;
-    uboWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    uboWrite.dstArrayElement = 0;
-    uboWrite.dstBinding = 0;
-    uboWrite.dstSet = m_descriptorSet;
-    uboWrite.pBufferInfo = &setBufferInfo;
-
-    vk.updateDescriptorSets(uboWrite);
+    createDescriptorSets();
 
     TextureFactory f(vk);
 
@@ -214,7 +145,7 @@ DefaultMaterial::DefaultMaterial(RenderWindow& renderWindow,
     m_texture = f.createTexture2D();
 
     // m_texture = Texture2D(
-    //  renderWindow, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+    //  renderContext, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
     //  VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
     //  VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
@@ -245,139 +176,148 @@ DefaultMaterial::DefaultMaterial(RenderWindow& renderWindow,
         &u.defaultTextureTexel, sizeof(uint32_t), defaultTextureCopy,
         VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-    VkDescriptorImageInfo imageInfo{};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = m_texture.view();
-    imageInfo.sampler = m_texture.sampler();
-
-    vk::WriteDescriptorSet textureWrite;
-    textureWrite.descriptorCount = 1;
-    textureWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    textureWrite.dstArrayElement = 0;
-    textureWrite.dstBinding = 1;
-    textureWrite.dstSet = m_descriptorSet;
-    textureWrite.pImageInfo = &imageInfo;
+    // every instance holds a reference to its texture slot
+    for (auto& s : m_uboStructs)
+        s.textureIndex = m_textureTable.get()->registerTexture(m_texture);
+#pragma endregion
 
-    m_textures.reserve(1024);
+    createUniformBuffers();
+}
 
-    for (uint32_t i = 0; i < 1024; i++)
+DefaultMaterial::~DefaultMaterial()
+{
+    if (m_textureTable)
     {
-        textureWrite.dstArrayElement = i;
-        m_textures.push_back(m_texture);
-        vk.updateDescriptorSets(textureWrite);
+        for (auto& s : m_uboStructs)
+            m_textureTable.get()->unregisterTexture(s.textureIndex);
     }
-
-    /*vk::WriteDescriptorSet textureWrite;
-    textureWrite.descriptorCount = 1;
-    textureWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    textureWrite.dstArrayElement = 0;
-    textureWrite.dstBinding = 1;
-    textureWrite.dstSet = m_descriptorSet;
-    textureWrite.pImageInfo = &imageInfo;*/
-
-#pragma endregion
 }
 
-float DefaultMaterial::floatParameter(const std::string& name,
-                                      uint32_t instanceIndex)
+void DefaultMaterial::setTextureParameter(const std::string& name,
+                                          uint32_t instanceIndex,
+                                          Texture2D& texture)
 {
-    if (name == "metalness")
-        return m_uboStructs[instanceIndex].metalness;
-    else if (name == "roughness")
-        return m_uboStructs[instanceIndex].roughness;
-    else
-        return Material::floatParameter(name, instanceIndex);
-}
+    TextureTable& textureTable = *m_textureTable.get();
 
-vector4 DefaultMaterial::vec4Parameter(const std::string& name,
-                                       uint32_t instanceIndex)
-{
-    if (name == "color")
-        return m_uboStructs[instanceIndex].color;
-    else
-        return Material::vec4Parameter(name, instanceIndex);
-}
+    // registered first so that setting the same texture again does not
+    // release its slot
+    uint32_t textureIndex = textureTable.registerTexture(texture);
+    textureTable.unregisterTexture(m_uboStructs[instanceIndex].textureIndex);
 
-void DefaultMaterial::setFloatParameter(const std::string& name,
-                                        uint32_t instanceIndex, float a)
-{
-    if (name == "metalness")
-        m_uboStructs[instanceIndex].metalness = a;
-    else if (name == "roughness")
-        m_uboStructs[instanceIndex].roughness = a;
-    else
-        Material::setFloatParameter(name, instanceIndex, a);
-
-    UBOStruct* ptr = m_uniformBuffer.map<UBOStruct>();
-    ptr[instanceIndex] = m_uboStructs[instanceIndex];
-    m_uniformBuffer.unmap();
-}
+    m_uboStructs[instanceIndex].textureIndex = textureIndex;
 
-void DefaultMaterial::setVec4Parameter(const std::string& name,
-                                       uint32_t instanceIndex,
-                                       const vector4& a)
-{
-    if (name == "color")
-        m_uboStructs[instanceIndex].color = a;
-    else
-        Material::setVec4Parameter(name, instanceIndex, a);
-
-    UBOStruct* ptr = m_uniformBuffer.map<UBOStruct>();
-    ptr[instanceIndex] = m_uboStructs[instanceIndex];
-    m_uniformBuffer.unmap();
+    markDirty(instanceIndex);
 }
 
-void DefaultMaterial::setTextureParameter(const std::string& name,
-                                          uint32_t instanceIndex,
-                                          Texture2D& texture)
+void DefaultMaterial::createDescriptorSets()
 {
-    auto found =
-        std::find_if(m_textures.begin(), m_textures.end(),
-                     [&](const Texture2D& a) { return a == texture; });
+    auto& vk = renderContext().device();
 
-    uint32_t textureIndex = 0;
-    if (found == m_textures.end())
+#pragma region descriptor pool
+    std::array poolSizes{
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount() },
+    };
+
+    vk::DescriptorPoolCreateInfo poolInfo;
+    poolInfo.maxSets = frameCount();
+    poolInfo.poolSizeCount = uint32_t(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    m_descriptorPool = vk.create(poolInfo);
+    if (!m_descriptorPool)
     {
-        for (auto& tex : m_textures)
+        std::cerr << "error: failed to create descriptor pool" << std::endl;
+        abort();
+    }
+#pragma endregion
+
+#pragma region descriptor sets
+    for (uint32_t i = 0; i < frameCount(); i++)
+    {
+        m_descriptorSets.push_back(
+            vk.allocate(m_descriptorPool, m_descriptorSetLayout));
+
+        if (!m_descriptorSets.back())
         {
-            if (tex.get() == m_texture)
-            {
-                tex = texture;
-                break;
-            }
-            textureIndex++;
+            std::cerr << "error: failed to allocate descriptor set"
+                      << std::endl;
+            abort();
         }
+    }
+#pragma endregion
+}
 
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = texture.view();
-        imageInfo.sampler = texture.sampler();
+void DefaultMaterial::createUniformBuffers()
+{
+    auto& vk = renderContext().device();
 
-        vk::WriteDescriptorSet textureWrite;
-        textureWrite.descriptorCount = 1;
-        textureWrite.descriptorType =
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    const VkDeviceSize size = sizeof(UBOStruct) * m_uboStructs.size();
 
-        textureWrite.dstArrayElement = textureIndex;
-        textureWrite.dstBinding = 1;
-        textureWrite.dstSet = m_descriptorSet;
-        textureWrite.pImageInfo = &imageInfo;
+    m_uniformBuffers.clear();
+    for (uint32_t i = 0; i < frameCount(); i++)
+    {
+        Buffer& buffer = m_uniformBuffers.emplace_back(
+            vk, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        buffer.setName("DefaultMaterial SSBO " + std::to_string(i));
+
+        void* ptr = buffer.map();
+        std::memcpy(ptr, m_uboStructs.data(), size);
+        buffer.unmap();
+
+        VkDescriptorBufferInfo setBufferInfo{};
+        setBufferInfo.buffer = buffer;
+        setBufferInfo.range = size;
+        setBufferInfo.offset = 0;
+
+        vk::WriteDescriptorSet uboWrite;
+        uboWrite.descriptorCount = 1;
+        uboWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        uboWrite.dstArrayElement = 0;
+        uboWrite.dstBinding = 0;
+        uboWrite.dstSet = m_descriptorSets[i];
+        uboWrite.pBufferInfo = &setBufferInfo;
+
+        vk.updateDescriptorSets(uboWrite);
+    }
+}
 
-        auto& vk = renderWindow().device();
-        vk.updateDescriptorSets(textureWrite);
+void DefaultMaterial::resizeInstancePool(uint32_t instancePoolSize)
+{
+    const size_t previousCount = m_uboStructs.size();
+    DefaultMaterialParameters::resizeInstancePool(instancePoolSize);
 
-        m_textureRef = texture;
-    }
-    else
+    for (size_t i = previousCount; i < m_uboStructs.size(); i++)
     {
-        textureIndex = std::distance(m_textures.begin(), found);
+        m_uboStructs[i].textureIndex =
+            m_textureTable.get()->registerTexture(m_texture);
     }
 
-    m_uboStructs[instanceIndex].textureIndex = textureIndex;
+    // the frames in flight keep reading the previous buffers through the
+    // previous descriptor sets, the commands recorded from now on use the
+    // grown ones
+    retire(std::move(m_uniformBuffers));
+    createDescriptorSets();
+    createUniformBuffers();
+}
 
-    UBOStruct* ptr = m_uniformBuffer.map<UBOStruct>();
-    ptr[instanceIndex].textureIndex = textureIndex;
-    m_uniformBuffer.unmap();
+void DefaultMaterial::resetInstance(uint32_t instanceIndex)
+{
+    setTextureParameter("", instanceIndex, m_texture);
+
+    DefaultMaterialParameters::resetInstance(instanceIndex);
+}
+
+void DefaultMaterial::uploadParameters(uint32_t frame, uint32_t firstInstance,
+                                       uint32_t instanceCount)
+{
+    Buffer& buffer = m_uniformBuffers[frame];
+    UBOStruct* ptr = buffer.map<UBOStruct>();
+    std::memcpy(ptr + firstInstance, &m_uboStructs[firstInstance],
+                sizeof(UBOStruct) * instanceCount);
+    buffer.unmap();
 }
 
 MaterialVertexFunction DefaultMaterial::vertexFunction(
@@ -415,9 +355,11 @@ MaterialFragmentFunction DefaultMaterial::fragmentFunction(
 
     buildData->ssbo = std::make_unique<sdw::ArraySsboT<shader::DefaultMaterialData>>(writer, "DefaultMaterialUBO", 0, 2);
 
+    // bindless texture table of the shading model
     buildData->textures =
         std::make_unique<sdw::Array<sdw::SampledImage2DRgba32>>(
-            writer.declSampledImageArray<FImg2DRgba32>("tex", 1, 2, 1024));
+            writer.declSampledImageArray<FImg2DRgba32>(
+                "tex", 0, 3, TextureTable::MaxTextureCount));
 
     // buildData->ubo->declMember<DefaultMaterialUBOStruct>(
     //    "materials", instancePoolSize() + 1);
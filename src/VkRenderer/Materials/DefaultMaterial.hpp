@@ -1,8 +1,9 @@
 #pragma once
 
 #include "Buffer.hpp"
-#include "Material.hpp"
+#include "DefaultMaterialParameters.hpp"
 #include "Texture2D.hpp"
+#include "TextureTable.hpp"
 
 #include <memory>
 
@@ -13,25 +14,10 @@ struct DefaultMaterialData;
 
 namespace cdm
 {
-class DefaultMaterial : public Material
+class DefaultMaterial : public DefaultMaterialParameters
 {
-	Buffer m_uniformBuffer;
-
-	struct alignas(16) UBOStruct
-	{
-		vector4 color;
-
-		float metalness;
-		float roughness;
-
-		uint32_t textureIndex;
-
-		// padding
-		// float _0{ float(0xcccccccc) };
-		float _1{ float(0xcccccccc) };
-	};
-
-	std::vector<UBOStruct> m_uboStructs;
+	/// one copy of `m_uboStructs` per frame in flight
+	std::vector<Buffer> m_uniformBuffers;
 
 	struct FragmentShaderBuildData : FragmentShaderBuildDataBase
 	{
@@ -40,33 +26,34 @@ class DefaultMaterial : public Material
 	};
 
 	Texture2D m_texture;
-	std::reference_wrapper<Texture2D> m_textureRef;
-	std::vector<std::reference_wrapper<Texture2D>> m_textures;
+	Movable<TextureTable*> m_textureTable;
+
+	/// Creates the descriptor pool and allocates `m_descriptorSets` from it
+	void createDescriptorSets();
+	/// (Re)creates the SSBOs holding `m_uboStructs` and writes their
+	/// descriptors
+	void createUniformBuffers();
 
 public:
 	DefaultMaterial() = default;
-	DefaultMaterial(RenderWindow& rw, PbrShadingModel& shadingModel,
+	DefaultMaterial(RenderContext& rw, PbrShadingModel& shadingModel,
 	                uint32_t instancePoolSize = 0);
 	DefaultMaterial(const DefaultMaterial&) = delete;
 	DefaultMaterial(DefaultMaterial&&) = default;
-	~DefaultMaterial() = default;
+	~DefaultMaterial();
 
 	DefaultMaterial& operator=(const DefaultMaterial&) = delete;
 	DefaultMaterial& operator=(DefaultMaterial&&) = default;
 
 protected:
-	float floatParameter(const std::string& name,
-	                     uint32_t instanceIndex) override;
-	vector4 vec4Parameter(const std::string& name,
-	                      uint32_t instanceIndex) override;
-
-	void setFloatParameter(const std::string& name, uint32_t instanceIndex,
-	                       float a) override;
-	void setVec4Parameter(const std::string& name, uint32_t instanceIndex,
-	                      const vector4& a) override;
 	void setTextureParameter(const std::string& name, uint32_t instanceIndex,
 	                         Texture2D& texture);
 
+	void uploadParameters(uint32_t frame, uint32_t firstInstance,
+	                      uint32_t instanceCount) override;
+	void resizeInstancePool(uint32_t instancePoolSize) override;
+	void resetInstance(uint32_t instanceIndex) override;
+
 public:
 	// void vertexFunction(Vec3& inOutPosition, Vec3& inOutNormal);
 	MaterialVertexFunction vertexFunction(
@@ -0,0 +1,98 @@
+#include "DefaultMaterialParameters.hpp"
+
+#include <cstddef>
+
+namespace cdm
+{
+DefaultMaterialParameters::DefaultMaterialParameters()
+{
+    // the material itself is instance 0
+    m_uboStructs.resize(1, m_defaultUboStruct);
+}
+
+DefaultMaterialParameters::DefaultMaterialParameters(
+    RenderContext& rw, PbrShadingModel& shadingModel,
+    uint32_t instancePoolSize)
+    : Material(rw, shadingModel, instancePoolSize)
+{
+    m_uboStructs.resize(size_t(instancePoolSize) + 1, m_defaultUboStruct);
+}
+
+float DefaultMaterialParameters::floatParameter(const std::string& name,
+                                                uint32_t instanceIndex)
+{
+    if (name == "metalness")
+        return m_uboStructs[instanceIndex].metalness;
+    else if (name == "roughness")
+        return m_uboStructs[instanceIndex].roughness;
+    else
+        return Material::floatParameter(name, instanceIndex);
+}
+
+vector4 DefaultMaterialParameters::vec4Parameter(const std::string& name,
+                                                 uint32_t instanceIndex)
+{
+    if (name == "color")
+        return m_uboStructs[instanceIndex].color;
+    else
+        return Material::vec4Parameter(name, instanceIndex);
+}
+
+void DefaultMaterialParameters::setFloatParameter(const std::string& name,
+                                                  uint32_t instanceIndex,
+                                                  float a)
+{
+    if (name == "metalness")
+        m_uboStructs[instanceIndex].metalness = a;
+    else if (name == "roughness")
+        m_uboStructs[instanceIndex].roughness = a;
+    else
+        Material::setFloatParameter(name, instanceIndex, a);
+
+    markDirty(instanceIndex);
+}
+
+void DefaultMaterialParameters::setVec4Parameter(const std::string& name,
+                                                 uint32_t instanceIndex,
+                                                 const vector4& a)
+{
+    if (name == "color")
+        m_uboStructs[instanceIndex].color = a;
+    else
+        Material::setVec4Parameter(name, instanceIndex, a);
+
+    markDirty(instanceIndex);
+}
+
+uint32_t DefaultMaterialParameters::parameterOffset(const std::string& name,
+                                                    ParameterType type)
+{
+    if (name == "color" && type == ParameterType::Vec4)
+        return uint32_t(offsetof(UBOStruct, color));
+    else if (name == "metalness" && type == ParameterType::Float)
+        return uint32_t(offsetof(UBOStruct, metalness));
+    else if (name == "roughness" && type == ParameterType::Float)
+        return uint32_t(offsetof(UBOStruct, roughness));
+    else
+        return Material::parameterOffset(name, type);
+}
+
+std::byte* DefaultMaterialParameters::parameterData(uint32_t instanceIndex)
+{
+    return reinterpret_cast<std::byte*>(&m_uboStructs[instanceIndex]);
+}
+
+void DefaultMaterialParameters::resizeInstancePool(uint32_t instancePoolSize)
+{
+    m_uboStructs.resize(size_t(instancePoolSize) + 1, m_defaultUboStruct);
+}
+
+void DefaultMaterialParameters::resetInstance(uint32_t instanceIndex)
+{
+    const uint32_t textureIndex = m_uboStructs[instanceIndex].textureIndex;
+    m_uboStructs[instanceIndex] = m_defaultUboStruct;
+    m_uboStructs[instanceIndex].textureIndex = textureIndex;
+
+    markDirty(instanceIndex);
+}
+}  // namespace cdm
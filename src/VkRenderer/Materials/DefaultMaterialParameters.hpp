@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Material.hpp"
+#include "TextureTable.hpp"
+
+#include <vector>
+
+namespace cdm
+{
+/// Instance parameters of `DefaultMaterial` as laid out in its SSBO, and the
+/// lookups of the `Material` setters. Creates no Vulkan object, uploading
+/// and texturing are left to `DefaultMaterial`
+class DefaultMaterialParameters : public Material
+{
+protected:
+	struct alignas(16) UBOStruct
+	{
+		vector4 color;
+
+		float metalness;
+		float roughness;
+
+		uint32_t textureIndex;
+
+		// padding
+		// float _0{ float(0xcccccccc) };
+		float _1{ float(0xcccccccc) };
+	};
+
+	std::vector<UBOStruct> m_uboStructs;
+	/// parameters of new and released instances
+	UBOStruct m_defaultUboStruct{ vector4{ 0.9f, 0.5f, 0.25f, 1.0f }, 0.1f,
+	                              0.3f, TextureTable::InvalidSlot };
+
+public:
+	/// Without a render context, the pool grows on `instanciate`
+	DefaultMaterialParameters();
+	DefaultMaterialParameters(RenderContext& rw, PbrShadingModel& shadingModel,
+	                          uint32_t instancePoolSize = 0);
+	DefaultMaterialParameters(const DefaultMaterialParameters&) = delete;
+	DefaultMaterialParameters(DefaultMaterialParameters&&) = default;
+	~DefaultMaterialParameters() = default;
+
+	DefaultMaterialParameters& operator=(const DefaultMaterialParameters&) =
+	    delete;
+	DefaultMaterialParameters& operator=(DefaultMaterialParameters&&) =
+	    default;
+
+protected:
+	float floatParameter(const std::string& name,
+	                     uint32_t instanceIndex) override;
+	vector4 vec4Parameter(const std::string& name,
+	                      uint32_t instanceIndex) override;
+
+	void setFloatParameter(const std::string& name, uint32_t instanceIndex,
+	                       float a) override;
+	void setVec4Parameter(const std::string& name, uint32_t instanceIndex,
+	                      const vector4& a) override;
+
+	uint32_t parameterOffset(const std::string& name,
+	                         ParameterType type) override;
+	std::byte* parameterData(uint32_t instanceIndex) override;
+	/// Only grows `m_uboStructs`
+	void resizeInstancePool(uint32_t instancePoolSize) override;
+	/// Keeps the texture index of the instance
+	void resetInstance(uint32_t instanceIndex) override;
+};
+}  // namespace cdm
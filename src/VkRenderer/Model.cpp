@@ -4,7 +4,7 @@
 #include "Material.hpp"
 #include "MyShaderWriter.hpp"
 #include "PbrShadingModel.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Scene.hpp"
 #include "StandardMesh.hpp"
 
@@ -12,9 +12,9 @@
 
 namespace cdm
 {
-Model::Model(RenderWindow& renderWindow, StandardMesh& mesh,
+Model::Model(RenderContext& renderContext, StandardMesh& mesh,
              MaterialInterface& material)
-    : rw(&renderWindow),
+    : rw(&renderContext),
       m_mesh(&mesh),
       m_material(&material)
 {
@@ -10,18 +10,18 @@ namespace cdm
 class CommandBuffer;
 class MaterialInterface;
 class StandardMesh;
-class RenderWindow;
+class RenderContext;
 
 class Model final
 {
-	Movable<RenderWindow*> rw;
+	Movable<RenderContext*> rw;
 
 	Movable<MaterialInterface*> m_material;
 	Movable<StandardMesh*> m_mesh;
 
 public:
 	Model() = default;
-	Model(RenderWindow& rw, StandardMesh& mesh, MaterialInterface& material);
+	Model(RenderContext& rw, StandardMesh& mesh, MaterialInterface& material);
 	Model(const Model&) = delete;
 	Model(Model&&) = default;
 	~Model() = default;
@@ -1,5 +1,7 @@
 #include "MyShaderWriter.hpp"
 
+#include "SpirvOptimizer.hpp"
+
 namespace cdm
 {
 Ubo::Ubo(VertexWriter& writer, std::string const& name, uint32_t bind,
@@ -41,7 +43,8 @@ Ubo::Ubo(ComputeWriter& writer, std::string const& name, uint32_t bind,
 UniqueShaderModule VertexWriter::createShaderModule(
     const VulkanDevice& vk) const
 {
-	std::vector<uint32_t> bytecode = spirv::serialiseSpirv(getShader());
+	std::vector<uint32_t> bytecode =
+	    optimizeSpirv(spirv::serialiseSpirv(getShader()));
 
 	vk::ShaderModuleCreateInfo createInfo;
 	createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -59,7 +62,8 @@ VertexShaderHelperResult VertexWriter::createHelperResult(
 UniqueShaderModule FragmentWriter::createShaderModule(
     const VulkanDevice& vk) const
 {
-	std::vector<uint32_t> bytecode = spirv::serialiseSpirv(getShader());
+	std::vector<uint32_t> bytecode =
+	    optimizeSpirv(spirv::serialiseSpirv(getShader()));
 
 	vk::ShaderModuleCreateInfo createInfo;
 	createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -87,7 +91,8 @@ void ComputeWriter::addDescriptor(uint32_t binding, uint32_t set, VkDescriptorTy
 UniqueShaderModule ComputeWriter::createShaderModule(
     const VulkanDevice& vk) const
 {
-	std::vector<uint32_t> bytecode = spirv::serialiseSpirv(getShader());
+	std::vector<uint32_t> bytecode =
+	    optimizeSpirv(spirv::serialiseSpirv(getShader()));
 
 	vk::ShaderModuleCreateInfo createInfo;
 	createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -840,7 +840,7 @@ ComputeWriter::declSampledImage(std::string const& name, uint32_t binding,
 	b.binding = binding;
 	b.descriptorCount = 1;
 	b.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	b.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	b.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 	m_descriptors.push_back({ set, b });
 
 	return sdw::ComputeWriter::declSampledImage<FormatT, DimT, ArrayedT,
@@ -858,7 +858,7 @@ ComputeWriter::declSampledImage(std::string const& name, uint32_t binding,
 	b.binding = binding;
 	b.descriptorCount = 1;
 	b.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	b.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	b.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 	m_descriptors.push_back({ set, b });
 
 	return sdw::ComputeWriter::declSampledImage<FormatT, DimT, ArrayedT,
@@ -877,7 +877,7 @@ ComputeWriter::declSampledImageArray(std::string const& name,
 	b.binding = binding;
 	b.descriptorCount = dimension;
 	b.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	b.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	b.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 	m_descriptors.push_back({ set, b });
 
 	return sdw::ComputeWriter::declSampledImageArray<FormatT, DimT, ArrayedT,
@@ -897,7 +897,7 @@ ComputeWriter::declSampledImageArray(std::string const& name,
 	b.binding = binding;
 	b.descriptorCount = dimension;
 	b.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	b.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	b.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 	m_descriptors.push_back({ set, b });
 
 	return sdw::ComputeWriter::declSampledImageArray<FormatT, DimT, ArrayedT,
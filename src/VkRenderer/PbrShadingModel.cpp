@@ -192,9 +192,11 @@ struct FragmentShaderBuildData : PbrShadingModel::FragmentShaderBuildDataBase
 	std::unique_ptr<ArraySsboT<shader::DirectionalLights>> directionalLights;
 
 	std::unique_ptr<Float> PI;
+	std::unique_ptr<UInt> receiveShadows;
+	std::unique_ptr<UInt> imageBasedLighting;
 
 	// std::unique_ptr<Scene::SceneUbo> sceneUbo;
-	std::unique_ptr<SampledImage2DShadowR32> shadowmap;
+	std::unique_ptr<SampledImage2DArrayShadowR32> shadowmap;
 
 	DistributionGGX_Signature DistributionGGX;
 	DistributionBeckmann_Signature DistributionBeckmann;
@@ -210,13 +212,16 @@ struct FragmentShaderBuildData : PbrShadingModel::FragmentShaderBuildDataBase
 
 PbrShadingModel::PbrShadingModel(const VulkanDevice& vulkanDevice,
                                  uint32_t maxPointLights,
-                                 uint32_t maxDirectionalLights)
+                                 uint32_t maxDirectionalLights,
+                                 uint32_t framesInFlight)
     : m_vulkanDevice(&vulkanDevice),
       m_maxPointLights(maxPointLights),
       m_maxDirectionalLights(maxDirectionalLights)
 {
 	auto& vk = *m_vulkanDevice.get();
 
+	m_textureTable = TextureTable(vk, framesInFlight);
+
 #pragma region descriptor pool
 	std::array poolSizes{
 		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5 },
@@ -479,7 +484,8 @@ void PbrShadingModel::uploadDirectionalLightsStaging()
 CombinedMaterialShadingFragmentFunction
 PbrShadingModel::combinedMaterialFragmentFunction(
     sdw::FragmentWriter& writer, MaterialFragmentFunction& materialFunction,
-    FragmentShaderBuildDataBase* shaderBuildData, Scene::SceneUbo& sceneUbo)
+    FragmentShaderBuildDataBase* shaderBuildData, Scene::SceneUbo& sceneUbo,
+    uint32_t features)
 {
 	FragmentShaderBuildData* buildData =
 	    dynamic_cast<FragmentShaderBuildData*>(shaderBuildData);
@@ -519,8 +525,15 @@ PbrShadingModel::combinedMaterialFragmentFunction(
 	buildData->PI =
 	    std::make_unique<Float>(writer.declConstant("PI", 3.14159265359_f));
 
-	buildData->shadowmap = std::make_unique<SampledImage2DShadowR32>(
-	    writer.declSampledImage<FImg2DShadowR32>("shadowmap", 2, 0));
+	buildData->receiveShadows =
+	    std::make_unique<UInt>(writer.declSpecConstant<UInt>(
+	        "receiveShadows", ReceiveShadowsConstantId, 1_u));
+	buildData->imageBasedLighting =
+	    std::make_unique<UInt>(writer.declSpecConstant<UInt>(
+	        "imageBasedLighting", ImageBasedLightingConstantId, 1_u));
+
+	buildData->shadowmap = std::make_unique<SampledImage2DArrayShadowR32>(
+	    writer.declSampledImage<FImg2DArrayShadowR32>("shadowmap", 2, 0));
 
 	buildData->DistributionGGX = writer.implementFunction<Float>(
 	    "DistributionGGX",
@@ -680,249 +693,253 @@ PbrShadingModel::combinedMaterialFragmentFunction(
 	    InFloat{ writer, "cosTheta" }, InVec4{ writer, "F0" },
 	    InFloat{ writer, "roughness" });
 
-	buildData->LTC_Evaluate = writer.implementFunction<Vec3>(
-	    "LTC_Evaluate",
-	    [&writer, buildData, &sceneUbo](const Vec3& N, const Vec3& V,
-	                                    const Vec3& P, const Mat3& Minv) {
-		    Locale(T1, normalize(V - N * dot(V, N)));
-		    Locale(T2, normalize(cross(N, T1)));
-		    // Locale(T1, normalize(O - wsNormal * dot(O, wsNormal)));
-		    // Locale(T2, cross(wsNormal, T1));
-
-		    Locale(M, Minv * transpose(mat3(T1, T2, N)));
-
-		    Locale(sigma, sceneUbo.getSigma());
-
-		    Locale(lightRotx,
-		           transpose(mat3(vec3(1.0_f, 0.0_f, 0.0_f),
-		                          vec3(0.0_f, cos(sigma), -sin(sigma)),
-		                          vec3(0.0_f, sin(sigma), cos(sigma)))));
-
-		    // Locale(lightRoty,
-		    //       transpose(mat3(vec3(cos(M[0][1]), 0.0_f, sin(M[0][1])),
-		    //                      vec3(0.0_f, 1.0_f, 0.0_f),
-		    //                      vec3(-sin(M[0][1]), 0.0_f,
-		    //                      cos(M[0][1])))));
-
-		    Locale(lightRotz,
-		           transpose(mat3(vec3(cos(sigma), -sin(sigma), 0.0_f),
-		                          vec3(sin(sigma), cos(sigma), 0.0_f),
-		                          vec3(0.0_f, 0.0_f, 1.0_f))));
-
-		    // Locale(lightTr, lightRotz * lightRotx * lightRoty);
-		    Locale(lightTr, lightRotz);
-
-		    Locale(P1, vec3(10.0_f, 0.0_f, 10.0_f));
-		    Locale(P2, vec3(-10.0_f, 0.0_f, 10.0_f));
-		    Locale(P3, vec3(-10.0_f, 0.0_f, -10.0_f));
-		    Locale(P4, vec3(10.0_f, 0.0_f, -10.0_f));
-
-		    Locale(L0, M * ((buildData->pointLights->operator[](0).position +
-		                     (lightTr * P1)) -
-		                    P));
-		    Locale(L1, M * ((buildData->pointLights->operator[](0).position +
-		                     (lightTr * P2)) -
-		                    P));
-		    Locale(L2, M * ((buildData->pointLights->operator[](0).position +
-		                     (lightTr * P3)) -
-		                    P));
-		    Locale(L3, M * ((buildData->pointLights->operator[](0).position +
-		                     (lightTr * P4)) -
-		                    P));
-		    Locale(L4, L3);
-
-		    Locale(numVertices, 0_u);
+	// only the area light needs it, skipped entirely otherwise
+	if (features & AreaLight)
+	{
+		buildData->LTC_Evaluate = writer.implementFunction<Vec3>(
+		    "LTC_Evaluate",
+		    [&writer, buildData, &sceneUbo](const Vec3& N, const Vec3& V,
+		                                    const Vec3& P, const Mat3& Minv) {
+			    Locale(T1, normalize(V - N * dot(V, N)));
+			    Locale(T2, normalize(cross(N, T1)));
+			    // Locale(T1, normalize(O - wsNormal * dot(O, wsNormal)));
+			    // Locale(T2, cross(wsNormal, T1));
+
+			    Locale(M, Minv * transpose(mat3(T1, T2, N)));
+
+			    Locale(sigma, sceneUbo.getSigma());
+
+			    Locale(lightRotx,
+			           transpose(mat3(vec3(1.0_f, 0.0_f, 0.0_f),
+			                          vec3(0.0_f, cos(sigma), -sin(sigma)),
+			                          vec3(0.0_f, sin(sigma), cos(sigma)))));
+
+			    // Locale(lightRoty,
+			    //       transpose(mat3(vec3(cos(M[0][1]), 0.0_f, sin(M[0][1])),
+			    //                      vec3(0.0_f, 1.0_f, 0.0_f),
+			    //                      vec3(-sin(M[0][1]), 0.0_f,
+			    //                      cos(M[0][1])))));
+
+			    Locale(lightRotz,
+			           transpose(mat3(vec3(cos(sigma), -sin(sigma), 0.0_f),
+			                          vec3(sin(sigma), cos(sigma), 0.0_f),
+			                          vec3(0.0_f, 0.0_f, 1.0_f))));
+
+			    // Locale(lightTr, lightRotz * lightRotx * lightRoty);
+			    Locale(lightTr, lightRotz);
+
+			    Locale(P1, vec3(10.0_f, 0.0_f, 10.0_f));
+			    Locale(P2, vec3(-10.0_f, 0.0_f, 10.0_f));
+			    Locale(P3, vec3(-10.0_f, 0.0_f, -10.0_f));
+			    Locale(P4, vec3(10.0_f, 0.0_f, -10.0_f));
+
+			    Locale(L0, M * ((buildData->pointLights->operator[](0).position +
+			                     (lightTr * P1)) -
+			                    P));
+			    Locale(L1, M * ((buildData->pointLights->operator[](0).position +
+			                     (lightTr * P2)) -
+			                    P));
+			    Locale(L2, M * ((buildData->pointLights->operator[](0).position +
+			                     (lightTr * P3)) -
+			                    P));
+			    Locale(L3, M * ((buildData->pointLights->operator[](0).position +
+			                     (lightTr * P4)) -
+			                    P));
+			    Locale(L4, L3);
+
+			    Locale(numVertices, 0_u);
 
 #pragma region ClipQuadToHorizon
-		    // detect clipping config
-		    Locale(config, 0_u);
-		    IF(writer, L0.z() > 0.0_f) { config += 1_u; }
-		    FI;
-		    IF(writer, L1.z() > 0.0_f) { config += 2_u; }
-		    FI;
-		    IF(writer, L2.z() > 0.0_f) { config += 4_u; }
-		    FI;
-		    IF(writer, L3.z() > 0.0_f) { config += 8_u; }
-		    FI;
-
-		    // clip
-		    numVertices = 0_u;
+			    // detect clipping config
+			    Locale(config, 0_u);
+			    IF(writer, L0.z() > 0.0_f) { config += 1_u; }
+			    FI;
+			    IF(writer, L1.z() > 0.0_f) { config += 2_u; }
+			    FI;
+			    IF(writer, L2.z() > 0.0_f) { config += 4_u; }
+			    FI;
+			    IF(writer, L3.z() > 0.0_f) { config += 8_u; }
+			    FI;
 
-		    IF(writer, config == 0_u)
-		    {
-			    // clip all
-		    }
-		    ELSEIF(config == 1_u)  // V1 clip V2 V3 V4
-		    {
-			    numVertices = 3_u;
-			    L1 = -L1.z() * L0 + L0.z() * L1;
-			    L2 = -L3.z() * L0 + L0.z() * L3;
-		    }
-		    ELSEIF(config == 2_u)  // V2 clip V1 V3 V4
-		    {
-			    numVertices = 3_u;
-			    L0 = -L0.z() * L1 + L1.z() * L0;
-			    L2 = -L2.z() * L1 + L1.z() * L2;
-		    }
-		    ELSEIF(config == 3_u)  // V1 V2 clip V3 V4
-		    {
-			    numVertices = 4_u;
-			    L2 = -L2.z() * L1 + L1.z() * L2;
-			    L3 = -L3.z() * L0 + L0.z() * L3;
-		    }
-		    ELSEIF(config == 4_u)  // V3 clip V1 V2 V4
-		    {
-			    numVertices = 3_u;
-			    L0 = -L3.z() * L2 + L2.z() * L3;
-			    L1 = -L1.z() * L2 + L2.z() * L1;
-		    }
-		    ELSEIF(config == 5_u)  // V1 V3 clip V2 V4) impossible
-		    {
+			    // clip
 			    numVertices = 0_u;
-		    }
-		    ELSEIF(config == 6_u)  // V2 V3 clip V1 V4
-		    {
-			    numVertices = 4_u;
-			    L0 = -L0.z() * L1 + L1.z() * L0;
-			    L3 = -L3.z() * L2 + L2.z() * L3;
-		    }
-		    ELSEIF(config == 7_u)  // V1 V2 V3 clip V4
-		    {
-			    numVertices = 5_u;
-			    L4 = -L3.z() * L0 + L0.z() * L3;
-			    L3 = -L3.z() * L2 + L2.z() * L3;
-		    }
-		    ELSEIF(config == 8_u)  // V4 clip V1 V2 V3
-		    {
-			    numVertices = 3_u;
-			    L0 = -L0.z() * L3 + L3.z() * L0;
-			    L1 = -L2.z() * L3 + L3.z() * L2;
-			    L2 = L3;
-		    }
-		    ELSEIF(config == 9_u)  // V1 V4 clip V2 V3
-		    {
-			    numVertices = 4_u;
-			    L1 = -L1.z() * L0 + L0.z() * L1;
-			    L2 = -L2.z() * L3 + L3.z() * L2;
-		    }
-		    ELSEIF(config == 10_u)  // V2 V4 clip V1 V3) impossible
-		    {
-			    numVertices = 0_u;
-		    }
-		    ELSEIF(config == 11_u)  // V1 V2 V4 clip V3
-		    {
-			    numVertices = 5_u;
-			    L4 = L3;
-			    L3 = -L2.z() * L3 + L3.z() * L2;
-			    L2 = -L2.z() * L1 + L1.z() * L2;
-		    }
-		    ELSEIF(config == 12_u)  // V3 V4 clip V1 V2
-		    {
-			    numVertices = 4_u;
-			    L1 = -L1.z() * L2 + L2.z() * L1;
-			    L0 = -L0.z() * L3 + L3.z() * L0;
-		    }
-		    ELSEIF(config == 13_u)  // V1 V3 V4 clip V2
-		    {
-			    numVertices = 5_u;
-			    L4 = L3;
-			    L3 = L2;
-			    L2 = -L1.z() * L2 + L2.z() * L1;
-			    L1 = -L1.z() * L0 + L0.z() * L1;
-		    }
-		    ELSEIF(config == 14_u)  // V2 V3 V4 clip V1
-		    {
-			    numVertices = 5_u;
-			    L4 = -L0.z() * L3 + L3.z() * L0;
-			    L0 = -L0.z() * L1 + L1.z() * L0;
-		    }
-		    ELSEIF(config == 15_u)  // V1 V2 V3 V4
-		    {
-			    numVertices = 4_u;
-		    }
-		    FI;
-
-		    IF(writer, numVertices == 3_u) { L3 = L0; }
-		    FI;
-		    IF(writer, numVertices == 4_u) { L4 = L0; }
-		    FI;
-#pragma endregion
-
-		    Locale(schlick, vec2(0.0_f));
-
-		    IF(writer, numVertices == 0_u) { writer.returnStmt(vec3(0.0_f)); }
-		    FI;
-
-			    L0 = normalize(L0);
-			    L1 = normalize(L1);
-			    L2 = normalize(L2);
-			    L3 = normalize(L3);
-			    L4 = normalize(L4);
-
-			    Locale(sum, 0.0_f);
-			    Locale(cosTheta, 0.0_f);
-			    Locale(theta_2, 0.0_f);
-			    Locale(res, 0.0_f);
 
-			    Locale(v1, L0);
-			    Locale(v2, L1);
+			    IF(writer, config == 0_u)
+			    {
+				    // clip all
+			    }
+			    ELSEIF(config == 1_u)  // V1 clip V2 V3 V4
+			    {
+				    numVertices = 3_u;
+				    L1 = -L1.z() * L0 + L0.z() * L1;
+				    L2 = -L3.z() * L0 + L0.z() * L3;
+			    }
+			    ELSEIF(config == 2_u)  // V2 clip V1 V3 V4
+			    {
+				    numVertices = 3_u;
+				    L0 = -L0.z() * L1 + L1.z() * L0;
+				    L2 = -L2.z() * L1 + L1.z() * L2;
+			    }
+			    ELSEIF(config == 3_u)  // V1 V2 clip V3 V4
+			    {
+				    numVertices = 4_u;
+				    L2 = -L2.z() * L1 + L1.z() * L2;
+				    L3 = -L3.z() * L0 + L0.z() * L3;
+			    }
+			    ELSEIF(config == 4_u)  // V3 clip V1 V2 V4
+			    {
+				    numVertices = 3_u;
+				    L0 = -L3.z() * L2 + L2.z() * L3;
+				    L1 = -L1.z() * L2 + L2.z() * L1;
+			    }
+			    ELSEIF(config == 5_u)  // V1 V3 clip V2 V4) impossible
+			    {
+				    numVertices = 0_u;
+			    }
+			    ELSEIF(config == 6_u)  // V2 V3 clip V1 V4
+			    {
+				    numVertices = 4_u;
+				    L0 = -L0.z() * L1 + L1.z() * L0;
+				    L3 = -L3.z() * L2 + L2.z() * L3;
+			    }
+			    ELSEIF(config == 7_u)  // V1 V2 V3 clip V4
+			    {
+				    numVertices = 5_u;
+				    L4 = -L3.z() * L0 + L0.z() * L3;
+				    L3 = -L3.z() * L2 + L2.z() * L3;
+			    }
+			    ELSEIF(config == 8_u)  // V4 clip V1 V2 V3
+			    {
+				    numVertices = 3_u;
+				    L0 = -L0.z() * L3 + L3.z() * L0;
+				    L1 = -L2.z() * L3 + L3.z() * L2;
+				    L2 = L3;
+			    }
+			    ELSEIF(config == 9_u)  // V1 V4 clip V2 V3
+			    {
+				    numVertices = 4_u;
+				    L1 = -L1.z() * L0 + L0.z() * L1;
+				    L2 = -L2.z() * L3 + L3.z() * L2;
+			    }
+			    ELSEIF(config == 10_u)  // V2 V4 clip V1 V3) impossible
+			    {
+				    numVertices = 0_u;
+			    }
+			    ELSEIF(config == 11_u)  // V1 V2 V4 clip V3
+			    {
+				    numVertices = 5_u;
+				    L4 = L3;
+				    L3 = -L2.z() * L3 + L3.z() * L2;
+				    L2 = -L2.z() * L1 + L1.z() * L2;
+			    }
+			    ELSEIF(config == 12_u)  // V3 V4 clip V1 V2
+			    {
+				    numVertices = 4_u;
+				    L1 = -L1.z() * L2 + L2.z() * L1;
+				    L0 = -L0.z() * L3 + L3.z() * L0;
+			    }
+			    ELSEIF(config == 13_u)  // V1 V3 V4 clip V2
+			    {
+				    numVertices = 5_u;
+				    L4 = L3;
+				    L3 = L2;
+				    L2 = -L1.z() * L2 + L2.z() * L1;
+				    L1 = -L1.z() * L0 + L0.z() * L1;
+			    }
+			    ELSEIF(config == 14_u)  // V2 V3 V4 clip V1
+			    {
+				    numVertices = 5_u;
+				    L4 = -L0.z() * L3 + L3.z() * L0;
+				    L0 = -L0.z() * L1 + L1.z() * L0;
+			    }
+			    ELSEIF(config == 15_u)  // V1 V2 V3 V4
+			    {
+				    numVertices = 4_u;
+			    }
+			    FI;
 
-			    cosTheta = dot(v1, v2);
-			    // cosTheta = clamp(cosTheta, -0.9999_f, 0.9999_f);
-			    theta_2 = acos(cosTheta);
-			    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
+			    IF(writer, numVertices == 3_u) { L3 = L0; }
+			    FI;
+			    IF(writer, numVertices == 4_u) { L4 = L0; }
+			    FI;
+#pragma endregion
 
-			    v1 = L1;
-			    v2 = L2;
+			    Locale(schlick, vec2(0.0_f));
 
-			    cosTheta = dot(v1, v2);
-			    // cosTheta = clamp(cosTheta, -0.9999_f, 0.9999_f);
-			    theta_2 = acos(cosTheta);
-			    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
+			    IF(writer, numVertices == 0_u) { writer.returnStmt(vec3(0.0_f)); }
+			    FI;
 
-			    v1 = L2;
-			    v2 = L3;
+				    L0 = normalize(L0);
+				    L1 = normalize(L1);
+				    L2 = normalize(L2);
+				    L3 = normalize(L3);
+				    L4 = normalize(L4);
 
-			    cosTheta = dot(v1, v2);
-			    // cosTheta = sdw::clamp(cosTheta, -0.9999_f, 0.9999_f);
-			    theta_2 = acos(cosTheta);
-			    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
+				    Locale(sum, 0.0_f);
+				    Locale(cosTheta, 0.0_f);
+				    Locale(theta_2, 0.0_f);
+				    Locale(res, 0.0_f);
 
-			    IF(writer, numVertices >= 4_u)
-			    {
-				    v1 = L3;
-				    v2 = L4;
+				    Locale(v1, L0);
+				    Locale(v2, L1);
 
 				    cosTheta = dot(v1, v2);
 				    // cosTheta = clamp(cosTheta, -0.9999_f, 0.9999_f);
 				    theta_2 = acos(cosTheta);
 				    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
-			    }
-			    FI;
 
-			    IF(writer, numVertices == 5_u)
-			    {
-				    v1 = L4;
-				    v2 = L0;
+				    v1 = L1;
+				    v2 = L2;
 
 				    cosTheta = dot(v1, v2);
 				    // cosTheta = clamp(cosTheta, -0.9999_f, 0.9999_f);
 				    theta_2 = acos(cosTheta);
 				    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
-			    }
-			    FI;
 
-			    // sum = abs(sum);
-			    sum = max(0.0_f, -sum);
+				    v1 = L2;
+				    v2 = L3;
 
-			    writer.returnStmt(vec3(sum));
-	    },
-	    InVec3{ writer, "N" }, InVec3{ writer, "V" }, InVec3{ writer, "P" },
-	    InMat3{ writer, "Minv" });
+				    cosTheta = dot(v1, v2);
+				    // cosTheta = sdw::clamp(cosTheta, -0.9999_f, 0.9999_f);
+				    theta_2 = acos(cosTheta);
+				    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
+
+				    IF(writer, numVertices >= 4_u)
+				    {
+					    v1 = L3;
+					    v2 = L4;
+
+					    cosTheta = dot(v1, v2);
+					    // cosTheta = clamp(cosTheta, -0.9999_f, 0.9999_f);
+					    theta_2 = acos(cosTheta);
+					    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
+				    }
+				    FI;
+
+				    IF(writer, numVertices == 5_u)
+				    {
+					    v1 = L4;
+					    v2 = L0;
+
+					    cosTheta = dot(v1, v2);
+					    // cosTheta = clamp(cosTheta, -0.9999_f, 0.9999_f);
+					    theta_2 = acos(cosTheta);
+					    sum += cross(v1, v2).z() * theta_2 / sin(theta_2);
+				    }
+				    FI;
+
+				    // sum = abs(sum);
+				    sum = max(0.0_f, -sum);
+
+				    writer.returnStmt(vec3(sum));
+		    },
+		    InVec3{ writer, "N" }, InVec3{ writer, "V" }, InVec3{ writer, "P" },
+		    InMat3{ writer, "Minv" });
+	}
 
 	return writer.implementFunction<Vec4>(
 	    "combinedMaterialShading",
-	    [&writer, &materialFunction, &sceneUbo, buildData](
+	    [&writer, &materialFunction, &sceneUbo, buildData, features](
 	        const UInt& inMaterialInstanceIndex, const Vec3& wsPosition_arg,
 	        const Vec2& uv_arg, const Vec3& wsNormal_arg,
 	        const Vec3& wsTangent_arg) {
@@ -1270,9 +1287,31 @@ PbrShadingModel::combinedMaterialFragmentFunction(
 			    ELSE
 			    {
 				    // ================= Shadow =================
-				    Locale(shadowView, sceneUbo.getShadowView());
-				    Locale(shadowProj, sceneUbo.getShadowProj());
 				    Locale(shadowBias, sceneUbo.getShadowBias());
+				    Locale(cascadeSplits, sceneUbo.getCascadeSplits());
+				    Locale(viewDepth,
+				           -(sceneUbo.getView() * vec4(wsPosition, 1.0_f)).z());
+
+				    Locale(cascadeIndex, 0_u);
+				    Locale(cascadeLayer, 0.0_f);
+				    IF(writer, viewDepth > cascadeSplits.x())
+				    {
+					    cascadeIndex = 1_u;
+					    cascadeLayer = 1.0_f;
+				    }
+				    FI;
+				    IF(writer, viewDepth > cascadeSplits.y())
+				    {
+					    cascadeIndex = 2_u;
+					    cascadeLayer = 2.0_f;
+				    }
+				    FI;
+				    IF(writer, viewDepth > cascadeSplits.z())
+				    {
+					    cascadeIndex = 3_u;
+					    cascadeLayer = 3.0_f;
+				    }
+				    FI;
 
 				    Locale(wsPositionDepthBiased,
 				           wsPosition +
@@ -1282,14 +1321,20 @@ PbrShadingModel::combinedMaterialFragmentFunction(
 				                   shadowBias);
 
 				    Locale(lsPositionW,
-				           shadowProj * shadowView *
+				           sceneUbo.getShadowViewProj()[cascadeIndex] *
 				               vec4(wsPositionDepthBiased, 1.0_f));
 				    Locale(
 				        lsPosition,
 				        (lsPositionW.xyz() / lsPositionW.w()) * 0.5_f + 0.5_f);
 
-				    shadow = buildData->shadowmap->sample(lsPosition.xy(),
-				                                          lsPositionW.z());
+				    shadow = 1.0_f;
+				    IF(writer, *buildData->receiveShadows != 0_u &&
+				                   viewDepth <= cascadeSplits.w())
+				    {
+					    shadow = buildData->shadowmap->sample(
+					        vec3(lsPosition.xy(), cascadeLayer), lsPositionW.z());
+				    }
+				    FI;
 				    // ==========================================
 
 				    Locale(DBeckmann,
@@ -1316,36 +1361,47 @@ PbrShadingModel::combinedMaterialFragmentFunction(
 		    ROF;
 
 		    // ==================== IBL =====================
-		    F = buildData->fresnelSchlickRoughness(max(cosThetao, 0.0_f), F0,
-		                                           roughness);
+		    Locale(ambient, vec4(0.0_f));
+		    IF(writer, *buildData->imageBasedLighting != 0_u)
+		    {
+			    F = buildData->fresnelSchlickRoughness(max(cosThetao, 0.0_f), F0,
+			                                           roughness);
 
-		    kS = F;
-		    kD = vec4(1.0_f) - kS;
-		    kD = kD * vec4(1.0_f - metalness);
+			    kS = F;
+			    kD = vec4(1.0_f) - kS;
+			    kD = kD * vec4(1.0_f - metalness);
 
-		    Locale(reflected, reflect(-wo, tsNormal));
+			    Locale(reflected, reflect(-wo, tsNormal));
 
-		    Locale(TBNMinusOne, inverse(TBN));
+			    Locale(TBNMinusOne, inverse(TBN));
 
-		    Locale(irradiance,
-		           buildData->irradianceMap->sample(TBNMinusOne * tsNormal));
-		    Locale(diffuse, irradiance * albedo);
+			    Locale(irradiance,
+			           buildData->irradianceMap->sample(TBNMinusOne * tsNormal));
+			    Locale(diffuse, irradiance * albedo);
 
-		    Locale(MAX_REFLECTION_LOD,
-		           writer.cast<Float>(buildData->prefilteredMap->getLevels()));
-		    Locale(prefilteredColor,
-		           buildData->prefilteredMap->lod(
-		               reflected, roughness * MAX_REFLECTION_LOD));
-		    Locale(brdf, buildData->brdfLut
-		                     ->sample(vec2(max(cosThetao, 0.0_f), roughness))
-		                     .rg());
-		    specular = prefilteredColor * (F * brdf.x() + brdf.y());
+			    Locale(MAX_REFLECTION_LOD,
+			           writer.cast<Float>(buildData->prefilteredMap->getLevels()));
+			    Locale(prefilteredColor,
+			           buildData->prefilteredMap->lod(
+			               reflected, roughness * MAX_REFLECTION_LOD));
+			    Locale(brdf, buildData->brdfLut
+			                     ->sample(vec2(max(cosThetao, 0.0_f), roughness))
+			                     .rg());
+			    specular = prefilteredColor * (F * brdf.x() + brdf.y());
 
-		    Locale(ambient, kD * diffuse + specular);
+			    ambient = kD * diffuse + specular;
+		    }
+		    FI;
 		    // ==============================================
 
 		    Locale(color, ambient + Lo);
 
+		    if (!(features & AreaLight))
+		    {
+			    writer.returnStmt(vec4(color.rgb(), 1.0_f));
+			    return;
+		    }
+
 		    // =============== RTPLS with LTC ===============
 		    Locale(Lo_i_diff, vec3(0.0_f));
 		    Locale(Lo_i_spec, vec3(0.0_f));
@@ -2,10 +2,12 @@
 
 #include "MyShaderWriter.hpp"
 #include "StagingBuffer.hpp"
+#include "TextureTable.hpp"
 #include "VulkanDevice.hpp"
 #include "Scene.hpp"
 #include "cdm_maths.hpp"
 
+#include <array>
 #include <memory>
 
 namespace cdm
@@ -23,12 +25,44 @@ class PbrShadingModel final
 	Buffer m_pointLightsUbo;
 	Buffer m_directionalLightsUbo;
 
+	uint64_t m_shaderGeneration = 0;
+
 public:
 	struct FragmentShaderBuildDataBase
 	{
 		virtual ~FragmentShaderBuildDataBase() {}
 	};
 
+	/// Optional parts of the shading, a material only pays for the ones it
+	/// enables (see `Material::setShadingFeatures`)
+	enum ShadingFeature : uint32_t
+	{
+		ReceiveShadows = 1 << 0,
+		CastShadows = 1 << 1,
+		ImageBasedLighting = 1 << 2,
+		/// LTC area light driven by the scene parameters
+		AreaLight = 1 << 3,
+
+		AllShadingFeatures =
+		    ReceiveShadows | CastShadows | ImageBasedLighting | AreaLight,
+	};
+
+	/// Features toggled by specialization constants at pipeline creation,
+	/// the shader code is shared by the variants differing only by these.
+	/// Other features produce distinct SPIR-V
+	static constexpr uint32_t SpecializedShadingFeatures =
+	    ReceiveShadows | ImageBasedLighting;
+	static constexpr uint32_t ReceiveShadowsConstantId = 0;
+	static constexpr uint32_t ImageBasedLightingConstantId = 1;
+
+	/// Specialization constant values of the variant `features`, one
+	/// `uint32_t` per constant id
+	static std::array<uint32_t, 2> specializationData(uint32_t features)
+	{
+		return { (features & ReceiveShadows) ? 1u : 0u,
+			     (features & ImageBasedLighting) ? 1u : 0u };
+	}
+
 	StagingBuffer m_shadingModelStaging;
 	StagingBuffer m_pointLightsStaging;
 	StagingBuffer m_directionalLightsStaging;
@@ -71,9 +105,15 @@ public:
 	UniqueDescriptorSetLayout m_descriptorSetLayout;
 	Movable<VkDescriptorSet> m_descriptorSet;
 
+	/// bindless textures of the materials using this shading model
+	TextureTable m_textureTable;
+
 	PbrShadingModel() = default;
+	/// `framesInFlight` is how long released texture slots are kept, see
+	/// `TextureTable::beginFrame`
 	PbrShadingModel(const VulkanDevice& vulkanDevice, uint32_t maxPointLights,
-	                uint32_t maxDirectionalLights);
+	                uint32_t maxDirectionalLights,
+	                uint32_t framesInFlight = 3);
 	PbrShadingModel(const PbrShadingModel&) = delete;
 	PbrShadingModel(PbrShadingModel&&) = default;
 	~PbrShadingModel() = default;
@@ -81,6 +121,8 @@ public:
 	PbrShadingModel& operator=(const PbrShadingModel&) = delete;
 	PbrShadingModel& operator=(PbrShadingModel&&) = default;
 
+	TextureTable& textureTable() noexcept { return m_textureTable; }
+
 	void uploadShadingModelDataStaging();
 	void uploadPointLightsStaging();
 	void uploadDirectionalLightsStaging();
@@ -89,9 +131,15 @@ public:
 	    sdw::FragmentWriter& writer,
 	    MaterialFragmentFunction& materialFunction,
 	    FragmentShaderBuildDataBase* shaderBuildData,
-	    Scene::SceneUbo& sceneUbo);
+	    Scene::SceneUbo& sceneUbo,
+	    uint32_t features = AllShadingFeatures);
 
 	std::unique_ptr<FragmentShaderBuildDataBase>
 	instantiateFragmentShaderBuildData();
+
+	/// Incremented by `invalidateShaders`, the pipelines embedding
+	/// `combinedMaterialFragmentFunction` are rebuilt when it changes
+	uint64_t shaderGeneration() const noexcept { return m_shaderGeneration; }
+	void invalidateShaders() noexcept { m_shaderGeneration++; }
 };
 }  // namespace cdm
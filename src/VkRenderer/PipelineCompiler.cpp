@@ -0,0 +1,59 @@
+#include "PipelineCompiler.hpp"
+
+#include <algorithm>
+
+namespace cdm
+{
+PipelineCompiler::PipelineCompiler(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	m_workers.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+		m_workers.emplace_back([this]() { workerLoop(); });
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+	m_jobAvailable.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void PipelineCompiler::workerLoop()
+{
+	std::unique_lock lock(m_mutex);
+	for (;;)
+	{
+		m_jobAvailable.wait(lock,
+		                    [this]() { return m_stopping || !m_jobs.empty(); });
+
+		// the queue is drained before stopping so that no future is left
+		// without a result
+		if (m_jobs.empty())
+			return;
+
+		auto job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		m_runningJobCount++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		m_runningJobCount--;
+	}
+}
+
+uint32_t PipelineCompiler::pendingJobCount()
+{
+	std::lock_guard lock(m_mutex);
+	return uint32_t(m_jobs.size()) + m_runningJobCount;
+}
+}  // namespace cdm
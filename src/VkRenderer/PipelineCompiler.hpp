@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cdm
+{
+/// Worker threads generating shaders and creating pipelines away from the
+/// render thread. Each job uses its own ShaderWriter so jobs run in
+/// parallel, results are polled with the returned future.
+class PipelineCompiler final
+{
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	std::deque<std::function<void()>> m_jobs;
+	uint32_t m_runningJobCount = 0;
+	bool m_stopping = false;
+
+	void workerLoop();
+
+public:
+	/// 0 uses all the hardware threads but one, left to the render thread
+	PipelineCompiler(uint32_t threadCount = 0);
+	PipelineCompiler(const PipelineCompiler&) = delete;
+	PipelineCompiler(PipelineCompiler&&) = delete;
+	/// Waits for the submitted jobs
+	~PipelineCompiler();
+
+	PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+	PipelineCompiler& operator=(PipelineCompiler&&) = delete;
+
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F&& job);
+
+	/// Jobs queued or running
+	uint32_t pendingJobCount();
+	uint32_t threadCount() const noexcept
+	{
+		return uint32_t(m_workers.size());
+	}
+
+	/// true if `future` holds its result, never blocks
+	template <typename T>
+	static bool ready(const std::future<T>& future)
+	{
+		return future.wait_for(std::chrono::seconds(0)) ==
+		       std::future_status::ready;
+	}
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> PipelineCompiler::submit(F&& job)
+{
+	using Result = std::invoke_result_t<F>;
+
+	// std::function needs a copyable callable
+	auto task = std::make_shared<std::packaged_task<Result()>>(
+	    std::forward<F>(job));
+	std::future<Result> future = task->get_future();
+
+	{
+		std::lock_guard lock(m_mutex);
+		m_jobs.emplace_back([task]() { (*task)(); });
+	}
+	m_jobAvailable.notify_one();
+
+	return future;
+}
+}  // namespace cdm
@@ -1,11 +1,64 @@
 #include "PipelineFactory.hpp"
 
+#include "LayoutCache.hpp"
 #include "MyShaderWriter.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
 
 namespace cdm
 {
+namespace
+{
+/// Layouts of the sets in `mapped` (indexed by set), unused set indices get
+/// an empty layout. `pushDescriptorSet` is created as a push descriptor set
+/// layout if the device supports it
+std::pair<VkPipelineLayout, std::vector<VkDescriptorSetLayout>>
+createCachedLayout(
+	const VulkanDevice& vk,
+	const std::unordered_map<uint32_t,
+	                         std::vector<VkDescriptorSetLayoutBinding>>& mapped,
+	const std::vector<VkPushConstantRange>& pushConstants,
+	std::optional<uint32_t> pushDescriptorSet)
+{
+	auto& layoutCache = vk.layoutCache();
+
+	std::pair<VkPipelineLayout, std::vector<VkDescriptorSetLayout>> res;
+
+	for (auto& pair : mapped)
+		res.second.resize(
+			std::max(res.second.size(), size_t(pair.first) + 1));
+
+	for (uint32_t set = 0; set < res.second.size(); set++)
+	{
+		vk::DescriptorSetLayoutCreateInfo info;
+		auto found = mapped.find(set);
+		if (found != mapped.end())
+		{
+			info.bindingCount = uint32_t(found->second.size());
+			info.pBindings = found->second.data();
+		}
+		if (pushDescriptorSet == set && vk.pushDescriptorSupported())
+			info.flags |=
+				VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+
+		res.second[set] = layoutCache.descriptorSetLayout(info);
+	}
+
+	vk::PipelineLayoutCreateInfo info;
+	info.setLayoutCount = uint32_t(res.second.size());
+	info.pSetLayouts = res.second.data();
+	info.pushConstantRangeCount = uint32_t(pushConstants.size());
+	info.pPushConstantRanges =
+		pushConstants.empty() ? nullptr : pushConstants.data();
+
+	res.first = layoutCache.pipelineLayout(info);
+
+	return res;
+}
+}  // namespace
+
 GraphicsPipelineFactory::GraphicsPipelineFactory(
 	const VulkanDevice& vulkanDevice)
 	: m_vulkanDevice(vulkanDevice)
@@ -248,16 +301,13 @@ void GraphicsPipelineFactory::setLayout(VkPipelineLayout layout)
 	m_layout = layout;
 }
 
-std::pair<UniquePipelineLayout, std::vector<UniqueDescriptorSetLayout>>
+std::pair<VkPipelineLayout, std::vector<VkDescriptorSetLayout>>
 GraphicsPipelineFactory::createLayout(
 	const VertexShaderHelperResult& vertexHelperResult,
 	const FragmentShaderHelperResult& fragmentHelperResult,
-	const std::vector<VkPushConstantRange>& pushConstants)
+	const std::vector<VkPushConstantRange>& pushConstants,
+	std::optional<uint32_t> pushDescriptorSet)
 {
-	const auto& vk = m_vulkanDevice.get();
-
-	std::pair<UniquePipelineLayout, std::vector<UniqueDescriptorSetLayout>>
-		res;
 
 	const auto& vertexDescriptors = vertexHelperResult.descriptors;
 	const auto& fragmentDescriptors = fragmentHelperResult.descriptors;
@@ -288,32 +338,8 @@ GraphicsPipelineFactory::createLayout(
 				fragmentDescriptor.second);
 	}
 
-	for (auto& pair : mapped)
-	{
-		res.second.resize(size_t(pair.first) + 1);
-
-		vk::DescriptorSetLayoutCreateInfo info;
-		info.bindingCount = uint32_t(pair.second.size());
-		info.pBindings = pair.second.data();
-
-		res.second[pair.first] = vk.createDescriptorSetLayout(info);
-	}
-
-	std::vector<VkDescriptorSetLayout> layouts;
-	layouts.reserve(res.second.size());
-	for (auto& setLayout : res.second)
-		layouts.push_back(setLayout.get());
-
-	vk::PipelineLayoutCreateInfo info;
-	info.setLayoutCount = uint32_t(layouts.size());
-	info.pSetLayouts = layouts.data();
-	info.pushConstantRangeCount = uint32_t(pushConstants.size());
-	info.pPushConstantRanges =
-		pushConstants.empty() ? nullptr : pushConstants.data();
-
-	res.first = vk.createPipelineLayout(info);
-
-	return res;
+	return createCachedLayout(m_vulkanDevice, mapped, pushConstants,
+		pushDescriptorSet);
 }
 
 UniqueGraphicsPipeline GraphicsPipelineFactory::createPipeline()
@@ -389,14 +415,11 @@ void ComputePipelineFactory::setLayout(VkPipelineLayout layout)
 	m_layout = layout;
 }
 
-std::pair<UniquePipelineLayout, std::vector<UniqueDescriptorSetLayout>>
+std::pair<VkPipelineLayout, std::vector<VkDescriptorSetLayout>>
 ComputePipelineFactory::createLayout(const ComputeShaderHelperResult& computeHelperResult,
-	const std::vector<VkPushConstantRange>& pushConstants)
+	const std::vector<VkPushConstantRange>& pushConstants,
+	std::optional<uint32_t> pushDescriptorSet)
 {
-	const auto& vk = m_vulkanDevice.get();
-
-	std::pair<UniquePipelineLayout, std::vector<UniqueDescriptorSetLayout>>
-		res;
 
 	const auto& descriptors = computeHelperResult.descriptors;
 
@@ -426,32 +449,8 @@ ComputePipelineFactory::createLayout(const ComputeShaderHelperResult& computeHel
 	//			fragmentDescriptor.second);
 	//}
 
-	for (auto& pair : mapped)
-	{
-		res.second.resize(size_t(pair.first) + 1);
-
-		vk::DescriptorSetLayoutCreateInfo info;
-		info.bindingCount = uint32_t(pair.second.size());
-		info.pBindings = pair.second.data();
-
-		res.second[pair.first] = vk.createDescriptorSetLayout(info);
-	}
-
-	std::vector<VkDescriptorSetLayout> layouts;
-	layouts.reserve(res.second.size());
-	for (auto& setLayout : res.second)
-		layouts.push_back(setLayout.get());
-
-	vk::PipelineLayoutCreateInfo info;
-	info.setLayoutCount = uint32_t(layouts.size());
-	info.pSetLayouts = layouts.data();
-	info.pushConstantRangeCount = uint32_t(pushConstants.size());
-	info.pPushConstantRanges =
-		pushConstants.empty() ? nullptr : pushConstants.data();
-
-	res.first = vk.createPipelineLayout(info);
-
-	return res;
+	return createCachedLayout(m_vulkanDevice, mapped, pushConstants,
+		pushDescriptorSet);
 }
 
 UniqueComputePipeline ComputePipelineFactory::createPipeline()
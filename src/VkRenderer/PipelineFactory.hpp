@@ -4,6 +4,8 @@
 #include "VertexInputHelper.hpp"
 #include "VulkanDevice.hpp"
 
+#include <optional>
+
 namespace cdm
 {
 class GraphicsPipelineFactory
@@ -91,10 +93,15 @@ public:
 	void setRenderPass(VkRenderPass renderPass);
 	void setLayout(VkPipelineLayout layout);
 
-	std::pair<UniquePipelineLayout, std::vector<UniqueDescriptorSetLayout>>
+	/// The layouts are shared through `VulkanDevice::layoutCache`, they must
+	/// not be destroyed. If the device supports `VK_KHR_push_descriptor`,
+	/// `pushDescriptorSet` is laid out to be written with
+	/// `CommandBuffer::pushDescriptorSet` instead of being allocated
+	std::pair<VkPipelineLayout, std::vector<VkDescriptorSetLayout>>
 	createLayout(const VertexShaderHelperResult& vertexHelperResult,
 	             const FragmentShaderHelperResult& fragmentHelperResult,
-	             const std::vector<VkPushConstantRange>& pushConstants = {});
+	             const std::vector<VkPushConstantRange>& pushConstants = {},
+	             std::optional<uint32_t> pushDescriptorSet = std::nullopt);
 
 	UniqueGraphicsPipeline createPipeline();
 };
@@ -119,9 +126,13 @@ public:
 	void setShaderModule(VkShaderModule computeModule);
 	void setLayout(VkPipelineLayout layout);
 
-	std::pair<UniquePipelineLayout, std::vector<UniqueDescriptorSetLayout>>
+	/// The layouts are shared through `VulkanDevice::layoutCache`, they must
+	/// not be destroyed. See `GraphicsPipelineFactory::createLayout` for
+	/// `pushDescriptorSet`
+	std::pair<VkPipelineLayout, std::vector<VkDescriptorSetLayout>>
 	createLayout(const ComputeShaderHelperResult& computeHelperResult,
-	             const std::vector<VkPushConstantRange>& pushConstants = {});
+	             const std::vector<VkPushConstantRange>& pushConstants = {},
+	             std::optional<uint32_t> pushDescriptorSet = std::nullopt);
 
 	UniqueComputePipeline createPipeline();
 };
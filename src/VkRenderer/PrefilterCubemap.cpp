@@ -2,6 +2,7 @@
 
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
+#include "ShaderArchive.hpp"
 #include "StagingBuffer.hpp"
 
 #include "CompilerSpirV/compileSpirV.hpp"
@@ -15,6 +16,7 @@
 #include <array>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 namespace cdm
 {
@@ -29,9 +31,9 @@ struct PrefilterCubemapPushConstant
     float roughness;
 };
 
-PrefilterCubemap::PrefilterCubemap(RenderWindow& renderWindow,
+PrefilterCubemap::PrefilterCubemap(RenderContext& renderContext,
                                    uint32_t cubemapWidth, uint32_t mipLevels)
-    : rw(renderWindow),
+    : rw(renderContext),
       m_cubemapWidth(cubemapWidth),
       m_mipLevels(mipLevels)
 {
@@ -102,210 +104,25 @@ PrefilterCubemap::PrefilterCubemap(RenderWindow& renderWindow,
 #define Constant(name, value) auto name = writer.declConstant(#name, value);
 
 #pragma region vertexShader
+    m_vertexModule = createShaderModule(vk, "PrefilterCubemap.vert",
+                                        &vertexShaderBytecode);
+    if (!m_vertexModule)
     {
-        using namespace sdw;
-        VertexWriter writer;
-
-        auto inPosition = writer.declInput<Vec3>("inPosition", 0);
-        auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
-
-        auto pc = Pcb(writer, "pc");
-        auto matrix = pc.declMember<Mat4>("matrix");
-        pc.declMember<Float>("inRoughness");
-        pc.end();
-
-        auto out = writer.getOut();
-
-        writer.implementMain([&]() {
-            // fragPosition = inPosition;
-            fragPosition =
-                vec3(inPosition.x(), -inPosition.y(), inPosition.z());
-            out.vtx.position = matrix * vec4(inPosition, 1.0_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_vertexModule = vk.create(createInfo);
-        if (!m_vertexModule)
-        {
-            std::cerr << "error: failed to create vertex shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create vertex shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
 #pragma region fragmentShader
+    m_fragmentModule = createShaderModule(
+        vk, "PrefilterCubemap.frag/" + std::to_string(cubemapWidth),
+        [&]() { return fragmentShaderBytecode(cubemapWidth); });
+    if (!m_fragmentModule)
     {
-        using namespace sdw;
-        FragmentWriter writer;
-
-        auto in = writer.getIn();
-
-        auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
-        auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
-
-        auto environmentMap =
-            writer.declSampledImage<FImgCubeRgba32>("environmentMap", 0, 0);
-
-        Pcb pc(writer, "pc");
-        pc.declMember<Mat4>("matrix");
-        pc.declMember<Float>("inRoughness");
-        pc.end();
-
-        Constant(PI, 3.14159265359_f);
-        Constant(invAtan, vec2(0.1591_f, 0.3183_f));
-
-        auto DistributionGGX = writer.implementFunction<Float>(
-            "DistributionGGX",
-            [&](const Vec3& N, const Vec3& H, const Float& roughness) {
-                Locale(a, roughness * roughness);
-                Locale(a2, a * a);
-                Locale(NdotH, max(dot(N, H), 0.0_f));
-                Locale(NdotH2, NdotH * NdotH);
-
-                Locale(denom, NdotH2 * (a2 - 1.0_f) + 1.0_f);
-                denom = PI * denom * denom;
-
-                writer.returnStmt(a2 / denom);
-            },
-            InVec3{ writer, "N" }, InVec3{ writer, "H" },
-            InFloat{ writer, "roughness" });
-
-        auto RadicalInverse_VdC = writer.implementFunction<Float>(
-            "RadicalInverse_VdC",
-            [&](const UInt& bits_arg) {
-                Locale(bits, bits_arg);
-
-                bits = (bits << 16_u) | (bits >> 16_u);
-                bits = ((bits & 0x55555555_u) << 1_u) |
-                       ((bits & 0xAAAAAAAA_u) >> 1_u);
-                bits = ((bits & 0x33333333_u) << 2_u) |
-                       ((bits & 0xCCCCCCCC_u) >> 2_u);
-                bits = ((bits & 0x0F0F0F0F_u) << 4_u) |
-                       ((bits & 0xF0F0F0F0_u) >> 4_u);
-                bits = ((bits & 0x00FF00FF_u) << 8_u) |
-                       ((bits & 0xFF00FF00_u) >> 8_u);
-
-                writer.returnStmt(writer.cast<Float>(bits) *
-                                  2.3283064365386963e-10_f);
-            },
-            InUInt{ writer, "bits_arg" });
-
-        auto Hammersley = writer.implementFunction<Vec2>(
-            "Hammersley",
-            [&](const UInt& i, const UInt& N) {
-                writer.returnStmt(
-                    vec2(writer.cast<Float>(i) / writer.cast<Float>(N),
-                         RadicalInverse_VdC(i)));
-            },
-            InUInt{ writer, "i" }, InUInt{ writer, "N" });
-
-        auto ImportanceSampleGGX = writer.implementFunction<Vec3>(
-            "ImportanceSampleGGX",
-            [&](const Vec2& Xi, const Vec3& N, const Float& roughness) {
-                Locale(a, roughness * roughness);
-
-                Locale(phi, 2.0_f * PI * Xi.x());
-                Locale(cosTheta, sqrt((1.0_f - Xi.y()) /
-                                      (1.0_f + (a * a - 1.0_f) * Xi.y())));
-                Locale(sinTheta, sqrt(1.0_f - cosTheta * cosTheta));
-
-                Locale(H, vec3(cos(phi) * sinTheta, sin(phi) * sinTheta,
-                               cosTheta));
-
-                auto ternaryRes = TERNARY(writer, Vec3, abs(N.z()) < 0.999_f,
-                                          vec3(0.0_f, 0.0_f, 1.0_f),
-                                          vec3(1.0_f, 0.0_f, 0.0_f));
-                Locale(up, ternaryRes);
-                Locale(tangent, normalize(cross(up, N)));
-                Locale(bitangent, cross(N, tangent));
-
-                Locale(sampleVec,
-                       tangent * H.x() + bitangent * H.y() + N * H.z());
-                writer.returnStmt(normalize(sampleVec));
-            },
-            InVec2{ writer, "Xi" }, InVec3{ writer, "N" },
-            InFloat{ writer, "roughness" });
-
-        writer.implementMain([&]() {
-            Locale(N, normalize(fragPosition));
-
-            auto& R = N;
-            auto& V = R;
-
-            Locale(SAMPLE_COUNT, 2048_u);
-            Locale(SAMPLE_COUNTf, 2048.0_f);
-            Locale(prefilteredColor, vec3(0.0_f));
-            Locale(totalWeight, 0.0_f);
-
-            VEC2(Xi);
-            VEC3(H);
-            VEC3(L);
-            FLOAT(NdotL);
-            FLOAT(D);
-            FLOAT(NdotH);
-            FLOAT(HdotV);
-            FLOAT(pdf);
-            Locale(resolution, Float(float(cubemapWidth)));
-            Locale(saTexel, 4.0_f * PI / (6.0_f * resolution * resolution));
-            FLOAT(saSample);
-            FLOAT(mipLevel);
-            Locale(inRoughness, pc.getMember<Float>("inRoughness"));
-
-            FOR(writer, UInt, i, 0_u, i < SAMPLE_COUNT, i++)
-            {
-                Xi = Hammersley(i, SAMPLE_COUNT);
-                H = ImportanceSampleGGX(Xi, N, inRoughness);
-                L = normalize(2.0_f * dot(V, H) * H - V);
-
-                NdotL = max(dot(N, L), 0.0_f);
-
-                IF(writer, NdotL > 0.0_f)
-                {
-                    D = DistributionGGX(N, H, inRoughness);
-                    NdotH = max(dot(N, H), 0.0_f);
-                    HdotV = max(dot(H, V), 0.0_f);
-                    pdf = D * NdotH / (4.0_f * HdotV) + 0.0001_f;
-
-                    saSample = 1.0_f / (SAMPLE_COUNTf * pdf + 0.0001_f);
-
-                    mipLevel =
-                        TERNARY(writer, Float, inRoughness == 0.0_f, 0.0_f,
-                                0.5_f * log2(saSample / saTexel));
-
-                    prefilteredColor +=
-                        environmentMap.lod(L, mipLevel).rgb() * NdotL;
-                    totalWeight += NdotL;
-                }
-                FI;
-            }
-            ROF;
-
-            prefilteredColor = prefilteredColor / totalWeight;
-
-            fragColor = vec4(prefilteredColor, 1.0_f);
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_fragmentModule = vk.create(createInfo);
-        if (!m_fragmentModule)
-        {
-            std::cerr << "error: failed to create fragment shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create fragment shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
@@ -595,6 +412,187 @@ PrefilterCubemap::PrefilterCubemap(RenderWindow& renderWindow,
 #pragma endregion
 }
 
+std::vector<uint32_t> PrefilterCubemap::vertexShaderBytecode()
+{
+    using namespace sdw;
+    VertexWriter writer;
+
+    auto inPosition = writer.declInput<Vec3>("inPosition", 0);
+    auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
+
+    auto pc = Pcb(writer, "pc");
+    auto matrix = pc.declMember<Mat4>("matrix");
+    pc.declMember<Float>("inRoughness");
+    pc.end();
+
+    auto out = writer.getOut();
+
+    writer.implementMain([&]() {
+        // fragPosition = inPosition;
+        fragPosition =
+            vec3(inPosition.x(), -inPosition.y(), inPosition.z());
+        out.vtx.position = matrix * vec4(inPosition, 1.0_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
+std::vector<uint32_t> PrefilterCubemap::fragmentShaderBytecode(
+    uint32_t cubemapWidth)
+{
+    using namespace sdw;
+    FragmentWriter writer;
+
+    auto in = writer.getIn();
+
+    auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
+    auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
+
+    auto environmentMap =
+        writer.declSampledImage<FImgCubeRgba32>("environmentMap", 0, 0);
+
+    Pcb pc(writer, "pc");
+    pc.declMember<Mat4>("matrix");
+    pc.declMember<Float>("inRoughness");
+    pc.end();
+
+    Constant(PI, 3.14159265359_f);
+    Constant(invAtan, vec2(0.1591_f, 0.3183_f));
+
+    auto DistributionGGX = writer.implementFunction<Float>(
+        "DistributionGGX",
+        [&](const Vec3& N, const Vec3& H, const Float& roughness) {
+            Locale(a, roughness * roughness);
+            Locale(a2, a * a);
+            Locale(NdotH, max(dot(N, H), 0.0_f));
+            Locale(NdotH2, NdotH * NdotH);
+
+            Locale(denom, NdotH2 * (a2 - 1.0_f) + 1.0_f);
+            denom = PI * denom * denom;
+
+            writer.returnStmt(a2 / denom);
+        },
+        InVec3{ writer, "N" }, InVec3{ writer, "H" },
+        InFloat{ writer, "roughness" });
+
+    auto RadicalInverse_VdC = writer.implementFunction<Float>(
+        "RadicalInverse_VdC",
+        [&](const UInt& bits_arg) {
+            Locale(bits, bits_arg);
+
+            bits = (bits << 16_u) | (bits >> 16_u);
+            bits = ((bits & 0x55555555_u) << 1_u) |
+                   ((bits & 0xAAAAAAAA_u) >> 1_u);
+            bits = ((bits & 0x33333333_u) << 2_u) |
+                   ((bits & 0xCCCCCCCC_u) >> 2_u);
+            bits = ((bits & 0x0F0F0F0F_u) << 4_u) |
+                   ((bits & 0xF0F0F0F0_u) >> 4_u);
+            bits = ((bits & 0x00FF00FF_u) << 8_u) |
+                   ((bits & 0xFF00FF00_u) >> 8_u);
+
+            writer.returnStmt(writer.cast<Float>(bits) *
+                              2.3283064365386963e-10_f);
+        },
+        InUInt{ writer, "bits_arg" });
+
+    auto Hammersley = writer.implementFunction<Vec2>(
+        "Hammersley",
+        [&](const UInt& i, const UInt& N) {
+            writer.returnStmt(
+                vec2(writer.cast<Float>(i) / writer.cast<Float>(N),
+                     RadicalInverse_VdC(i)));
+        },
+        InUInt{ writer, "i" }, InUInt{ writer, "N" });
+
+    auto ImportanceSampleGGX = writer.implementFunction<Vec3>(
+        "ImportanceSampleGGX",
+        [&](const Vec2& Xi, const Vec3& N, const Float& roughness) {
+            Locale(a, roughness * roughness);
+
+            Locale(phi, 2.0_f * PI * Xi.x());
+            Locale(cosTheta, sqrt((1.0_f - Xi.y()) /
+                                  (1.0_f + (a * a - 1.0_f) * Xi.y())));
+            Locale(sinTheta, sqrt(1.0_f - cosTheta * cosTheta));
+
+            Locale(H, vec3(cos(phi) * sinTheta, sin(phi) * sinTheta,
+                           cosTheta));
+
+            auto ternaryRes = TERNARY(writer, Vec3, abs(N.z()) < 0.999_f,
+                                      vec3(0.0_f, 0.0_f, 1.0_f),
+                                      vec3(1.0_f, 0.0_f, 0.0_f));
+            Locale(up, ternaryRes);
+            Locale(tangent, normalize(cross(up, N)));
+            Locale(bitangent, cross(N, tangent));
+
+            Locale(sampleVec,
+                   tangent * H.x() + bitangent * H.y() + N * H.z());
+            writer.returnStmt(normalize(sampleVec));
+        },
+        InVec2{ writer, "Xi" }, InVec3{ writer, "N" },
+        InFloat{ writer, "roughness" });
+
+    writer.implementMain([&]() {
+        Locale(N, normalize(fragPosition));
+
+        auto& R = N;
+        auto& V = R;
+
+        Locale(SAMPLE_COUNT, 2048_u);
+        Locale(SAMPLE_COUNTf, 2048.0_f);
+        Locale(prefilteredColor, vec3(0.0_f));
+        Locale(totalWeight, 0.0_f);
+
+        VEC2(Xi);
+        VEC3(H);
+        VEC3(L);
+        FLOAT(NdotL);
+        FLOAT(D);
+        FLOAT(NdotH);
+        FLOAT(HdotV);
+        FLOAT(pdf);
+        Locale(resolution, Float(float(cubemapWidth)));
+        Locale(saTexel, 4.0_f * PI / (6.0_f * resolution * resolution));
+        FLOAT(saSample);
+        FLOAT(mipLevel);
+        Locale(inRoughness, pc.getMember<Float>("inRoughness"));
+
+        FOR(writer, UInt, i, 0_u, i < SAMPLE_COUNT, i++)
+        {
+            Xi = Hammersley(i, SAMPLE_COUNT);
+            H = ImportanceSampleGGX(Xi, N, inRoughness);
+            L = normalize(2.0_f * dot(V, H) * H - V);
+
+            NdotL = max(dot(N, L), 0.0_f);
+
+            IF(writer, NdotL > 0.0_f)
+            {
+                D = DistributionGGX(N, H, inRoughness);
+                NdotH = max(dot(N, H), 0.0_f);
+                HdotV = max(dot(H, V), 0.0_f);
+                pdf = D * NdotH / (4.0_f * HdotV) + 0.0001_f;
+
+                saSample = 1.0_f / (SAMPLE_COUNTf * pdf + 0.0001_f);
+
+                mipLevel =
+                    TERNARY(writer, Float, inRoughness == 0.0_f, 0.0_f,
+                            0.5_f * log2(saSample / saTexel));
+
+                prefilteredColor +=
+                    environmentMap.lod(L, mipLevel).rgb() * NdotL;
+                totalWeight += NdotL;
+            }
+            FI;
+        }
+        ROF;
+
+        prefilteredColor = prefilteredColor / totalWeight;
+
+        fragColor = vec4(prefilteredColor, 1.0_f);
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
 PrefilterCubemap::~PrefilterCubemap() = default;
 
 Cubemap PrefilterCubemap::computeCubemap(Cubemap& inputCubemap)
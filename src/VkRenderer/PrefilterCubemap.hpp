@@ -4,7 +4,7 @@
 
 #include "Buffer.hpp"
 #include "Cubemap.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 
 #include <string_view>
 
@@ -12,7 +12,7 @@ namespace cdm
 {
 class PrefilterCubemap final
 {
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	UniqueRenderPass m_renderPass;
 
@@ -31,10 +31,15 @@ class PrefilterCubemap final
 	uint32_t m_mipLevels;
 
 public:
-	PrefilterCubemap(RenderWindow& renderWindow,
+	PrefilterCubemap(RenderContext& renderContext,
 	                                uint32_t cubemapWidth, uint32_t mipLevels);
 	~PrefilterCubemap();
 
+	static std::vector<uint32_t> vertexShaderBytecode();
+	/// Archived under `PrefilterCubemap.frag/<cubemapWidth>`, one variant
+	/// per width
+	static std::vector<uint32_t> fragmentShaderBytecode(uint32_t cubemapWidth);
+
 	Cubemap computeCubemap(Cubemap& cubemap);
 };
 }  // namespace cdm
@@ -12,12 +12,12 @@
 
 namespace cdm
 {
-PrefilteredCubemap::PrefilteredCubemap(RenderWindow& renderWindow,
+PrefilteredCubemap::PrefilteredCubemap(RenderContext& renderContext,
                                        uint32_t resolution, uint32_t mipLevels,
                                        Cubemap& cubemap,
                                        std::string_view filePath)
 {
-	auto& vk = renderWindow.device();
+	auto& vk = renderContext.device();
 
 	using namespace std::literals;
 	namespace fs = std::filesystem;
@@ -40,7 +40,7 @@ PrefilteredCubemap::PrefilteredCubemap(RenderWindow& renderWindow,
 			is >> infoMipLevels;
 
 			m_prefilteredCubemap = Cubemap(
-			    renderWindow, infoResolution, infoResolution,
+			    renderContext, infoResolution, infoResolution,
 			    VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
 			    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
 			    VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
@@ -90,7 +90,7 @@ PrefilteredCubemap::PrefilteredCubemap(RenderWindow& renderWindow,
 	std::cout << "prefiltered cubemap not found in \"" << cacheFilePath
 	          << "\". Generating it, please wait..." << std::endl;
 
-	PrefilterCubemap pcm(renderWindow, resolution, mipLevels);
+	PrefilterCubemap pcm(renderContext, resolution, mipLevels);
 	m_prefilteredCubemap = pcm.computeCubemap(cubemap);
 
 	std::filesystem::create_directory(cacheDirPath);
@@ -3,7 +3,7 @@
 #include "VulkanDevice.hpp"
 
 #include "Cubemap.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 
 #include <string_view>
 
@@ -15,7 +15,7 @@ class PrefilteredCubemap final
 
 public:
 	PrefilteredCubemap() = default;
-	PrefilteredCubemap(RenderWindow& renderWindow, uint32_t resolution,
+	PrefilteredCubemap(RenderContext& renderContext, uint32_t resolution,
 	                   uint32_t mipLevels, Cubemap& cubemap,
 	                   std::string_view filePath);
 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace cdm
+{
+class ImageView;
+
+struct ResettableFrameCommandBuffer;
+
+/// Device, command pools and the images a frame is rendered into. Resources
+/// only depend on this interface so that they work the same on screen
+/// (`RenderWindow`) and offscreen (`HeadlessRenderContext`)
+class RenderContext
+{
+public:
+	virtual ~RenderContext() = default;
+
+	virtual const VulkanDevice& device() const = 0;
+
+	virtual VkCommandPool commandPool() const = 0;
+	virtual VkCommandPool oneTimeCommandPool() const = 0;
+
+	/// `semaphore` and `fence` are signaled once the image can be written
+	virtual uint32_t acquireNextImage(VkSemaphore semaphore,
+	                                  VkFence fence) = 0;
+	virtual void present() = 0;
+	virtual void pushPresentWaitSemaphore(VkSemaphore semaphore) = 0;
+
+	virtual uint32_t imageIndex() const = 0;
+	virtual size_t currentFrame() const = 0;
+	/// Frames recorded ahead of the GPU, `currentFrame()` stays below it.
+	/// The GPU is done with the previous use of the current frame, so
+	/// resources kept per frame can be rewritten while it is recorded
+	virtual uint32_t framesInFlight() const = 0;
+
+	virtual VkExtent2D swapchainExtent() = 0;
+	virtual VkFormat swapchainImageFormat() = 0;
+	virtual VkFormat depthImageFormat() = 0;
+	virtual std::vector<VkImage> swapchainImages() const = 0;
+	virtual std::vector<std::reference_wrapper<ImageView>>
+	swapchainImageViews() const = 0;
+	/// Layout of the swapchain images outside of the frames
+	virtual VkImageLayout swapchainImageLayout() const = 0;
+
+	virtual ResettableFrameCommandBuffer& getAvailableCommandBuffer() = 0;
+	virtual void waitForAllCommandBuffers() = 0;
+
+	/// Seconds since the context creation
+	virtual double getTime() const = 0;
+};
+}  // namespace cdm
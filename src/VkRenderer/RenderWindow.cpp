@@ -1,6 +1,8 @@
 #include "RenderWindow.hpp"
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
+#include "CpuProfiler.hpp"
+#include "DescriptorAllocator.hpp"
 #include "Image.hpp"
 #include "ImageView.hpp"
 #include "Texture2D.hpp"
@@ -20,18 +22,17 @@
 #include <GLFW/glfw3native.h>
 
 #include <algorithm>
-#include <forward_list>
+#include <chrono>
+#include <deque>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace cdm
 {
-void VulkanDeviceObject::setCreationTime() { m_creationTime = glfwGetTime(); }
-// void VulkanDeviceObject::setCreationTime() { m_creationTime++; }
-
 struct SwapChainSupportDetails
 {
 	vk::SurfaceCapabilities2KHR capabilities{};
@@ -58,7 +59,22 @@ struct RenderWindowPrivate
 	VkCommandPool commandPool = nullptr;
 	VkCommandPool oneTimeCommandPool = nullptr;
 
-	std::forward_list<ResettableFrameCommandBuffer> frameCommandBuffers;
+	/// Everything a frame uses while the GPU may still be working on it. A
+	/// frame waits for the fences of its slot before recycling it, the CPU
+	/// is never more than `framesInFlight.size()` frames ahead
+	struct FrameInFlight
+	{
+		/// handed out by `getAvailableCommandBuffer`, in order
+		std::deque<ResettableFrameCommandBuffer> commandBuffers;
+		size_t usedCommandBuffers = 0;
+
+		UniqueSemaphore imageAcquiredSemaphore;
+		UniqueSemaphore renderFinishedSemaphore;
+
+		DescriptorAllocator descriptorAllocator;
+	};
+
+	std::vector<FrameInFlight> framesInFlight;
 
 	UniqueDescriptorPool imguiDescriptorPool;
 	UniqueRenderPass imguiRenderPass;
@@ -68,20 +84,20 @@ struct RenderWindowPrivate
 	VkFormat swapchainImageFormat;
 	VkExtent2D swapchainExtent;
 
-	UniqueSemaphore acquireToCopySemaphore;
-	UniqueSemaphore copyToPresentSemaphore;
-
 	std::vector<VkSemaphore> imageAvailableSemaphores;
 	// std::vector<VkSemaphore> renderFinishedSemaphores;
 	std::vector<VkFence> inFlightFences;
 	std::vector<VkFence> imagesInFlight;
 
-	std::vector<UniqueFence> imageAcquisitionFences;
-	std::vector<UniqueSemaphore> imageAcquisitionSemaphores;
-
 	std::vector<VkSemaphore> presentWaitSemaphores;
 
 	SwapChainSupportDetails swapChainSupport;
+	VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	bool presentModeChanged = false;
+
+	double targetFrameTime = 0.0;
+	std::chrono::steady_clock::time_point lastFrameEnd;
 
 	std::vector<std::shared_ptr<VkFramebuffer>> screenSizedFramebuffers;
 	std::vector<std::shared_ptr<VkPipeline>> screenSizedPipelines;
@@ -95,12 +111,16 @@ struct RenderWindowPrivate
 
 	double swapchainCreationTime = 0.0;
 
-	RenderWindowPrivate(int width, int height, bool layers);
+	RenderWindowPrivate(int width, int height, bool layers,
+	                    uint32_t frameCount);
 	~RenderWindowPrivate();
 
 	void createImageViews();
 	void recreateSwapchain(int width, int height);
 
+	/// Waits for the submitted command buffers of `frame` and recycles it
+	void waitForFrame(FrameInFlight& frame);
+
 	static void keyCallback(GLFWwindow* window, int key, int scancode,
 	                        int action, int mods);
 
@@ -234,14 +254,20 @@ SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice,
 VkSurfaceFormatKHR chooseSwapSurfaceFormat(
     const std::vector<VkSurfaceFormatKHR>& availableFormats)
 {
-	for (const auto& availableFormat : availableFormats)
+	// R8G8B8A8 first, it is the format of the imgui render pass and of the
+	// images the applications present, so they can render straight into
+	// the swapchain
+	for (VkFormat format :
+	     { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8A8_UNORM })
 	{
-		if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM &&
-		    availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
-		// if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
-		//    availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		for (const auto& availableFormat : availableFormats)
 		{
-			return availableFormat;
+			if (availableFormat.format == format &&
+			    availableFormat.colorSpace ==
+			        VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+			{
+				return availableFormat;
+			}
 		}
 	}
 
@@ -249,17 +275,18 @@ VkSurfaceFormatKHR chooseSwapSurfaceFormat(
 }
 
 VkPresentModeKHR chooseSwapPresentMode(
-    const std::vector<VkPresentModeKHR>& availablePresentModes)
+    const std::vector<VkPresentModeKHR>& availablePresentModes,
+    VkPresentModeKHR requestedPresentMode)
 {
 	for (const auto& availablePresentMode : availablePresentModes)
 	{
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		if (availablePresentMode == requestedPresentMode)
 		{
 			return availablePresentMode;
 		}
 	}
 
-	// return VK_PRESENT_MODE_IMMEDIATE_KHR;
+	// the only mode every surface must support
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -337,7 +364,8 @@ bool hasStencilComponent(VkFormat format)
 }
 #pragma endregion
 
-RenderWindowPrivate::RenderWindowPrivate(int width, int height, bool layers)
+RenderWindowPrivate::RenderWindowPrivate(int width, int height, bool layers,
+                                         uint32_t frameCount)
     : vulkanDevice(layers)
 {
 	auto& vk = vulkanDevice;
@@ -435,16 +463,31 @@ RenderWindowPrivate::RenderWindowPrivate(int width, int height, bool layers)
 
 	recreateSwapchain(width, height);
 
-	acquireToCopySemaphore = vk.createSemaphore();
-	copyToPresentSemaphore = vk.createSemaphore();
+	// `currentImageAvailableSemaphore` indexes per image semaphores with the
+	// current frame
+	frameCount = std::clamp(
+	    frameCount, 1u,
+	    std::min(RenderWindow::MaxFramesInFlight,
+	             uint32_t(swapchainImages.size())));
 
-	for (size_t i = 0; i < swapchainImages.size(); i++)
+	framesInFlight.resize(frameCount);
+	for (uint32_t i = 0; i < frameCount; i++)
 	{
-		imageAcquisitionFences.emplace_back(
-		    vk.createFence(VK_FENCE_CREATE_SIGNALED_BIT));
-		imageAcquisitionSemaphores.emplace_back(vk.createSemaphore());
+		FrameInFlight& frame = framesInFlight[i];
+		frame.imageAcquiredSemaphore = vk.createSemaphore();
+		frame.renderFinishedSemaphore = vk.createSemaphore();
+		frame.descriptorAllocator = DescriptorAllocator(vk);
+
+		const std::string name =
+		    "RenderWindow::framesInFlight[" + std::to_string(i) + "]";
+		vk.debugMarkerSetObjectName(frame.imageAcquiredSemaphore.get(),
+		                            name + ".imageAcquiredSemaphore");
+		vk.debugMarkerSetObjectName(frame.renderFinishedSemaphore.get(),
+		                            name + ".renderFinishedSemaphore");
 	}
 
+	lastFrameEnd = std::chrono::steady_clock::now();
+
 #pragma endregion
 
 #pragma region imguirenderPass
@@ -618,8 +661,6 @@ RenderWindowPrivate::~RenderWindowPrivate()
 {
 	auto& vk = vulkanDevice;
 
-	for (auto& imageAcquisitionFence : imageAcquisitionFences)
-		vk.wait(imageAcquisitionFence);
 	vk.wait();
 
 	auto instance = vk.instance();
@@ -644,7 +685,7 @@ RenderWindowPrivate::~RenderWindowPrivate()
 	vk.destroy(swapchain);
 	vk.destroy(surface);
 
-	frameCommandBuffers.clear();
+	framesInFlight.clear();
 
 	vk.destroy(oneTimeCommandPool);
 	vk.destroy(commandPool);
@@ -723,8 +764,9 @@ void RenderWindowPrivate::recreateSwapchain(int width, int height)
 
 	VkSurfaceFormatKHR surfaceFormat =
 	    chooseSwapSurfaceFormat(swapChainSupport.formats);
-	VkPresentModeKHR presentMode =
-	    chooseSwapPresentMode(swapChainSupport.presentModes);
+	presentMode = chooseSwapPresentMode(swapChainSupport.presentModes,
+	                                    requestedPresentMode);
+	presentModeChanged = false;
 	VkExtent2D extent =
 	    chooseSwapExtent(swapChainSupport.capabilities.surfaceCapabilities,
 	                     uint32_t(width), uint32_t(height));
@@ -912,6 +954,22 @@ void RenderWindowPrivate::recreateSwapchain(int width, int height)
 	swapchainCreationTime = glfwGetTime();
 }
 
+void RenderWindowPrivate::waitForFrame(FrameInFlight& frame)
+{
+	auto& vk = vulkanDevice;
+
+	for (size_t i = 0; i < frame.usedCommandBuffers; i++)
+	{
+		auto& commandBuffer = frame.commandBuffers[i];
+		if (commandBuffer.submitted)
+			vk.wait(commandBuffer.fence);
+		commandBuffer.reset();
+	}
+	frame.usedCommandBuffers = 0;
+
+	frame.descriptorAllocator.reset();
+}
+
 void RenderWindowPrivate::keyCallback(GLFWwindow* window, int key,
                                       int scancode, int action, int mods)
 {
@@ -994,8 +1052,10 @@ void RenderWindowPrivate::maximizeCallback(bool maximized) {}
 
 // ========================================================================
 
-RenderWindow::RenderWindow(int width, int height, bool layers)
-    : p(std::make_unique<RenderWindowPrivate>(width, height, layers))
+RenderWindow::RenderWindow(int width, int height, bool layers,
+                           uint32_t framesInFlight)
+    : p(std::make_unique<RenderWindowPrivate>(width, height, layers,
+                                              framesInFlight))
 {
 }
 
@@ -1017,6 +1077,8 @@ void RenderWindow::pollEvents()
 // `semaphore` will be signaled
 uint32_t RenderWindow::acquireNextImage(VkSemaphore semaphore, VkFence fence)
 {
+	CpuProfiler::Zone zone("acquire");
+
 	const auto& vk = device();
 
 	VkResult result =
@@ -1051,27 +1113,16 @@ void RenderWindow::present(bool& outSwapchainRecreated)
 	outSwapchainRecreated = false;
 	const auto& vk = device();
 
-	/* m_imageIndex = */ acquireNextImage(p->acquireToCopySemaphore);
-	// p->imageAvailableSemaphores[m_currentFrame]);
+	auto& frameInFlight = p->framesInFlight[m_currentFrame];
 
-	VkResult result = vk.queuePresent(vk.presentQueue(), swapchain(),
-	                                  m_imageIndex, p->acquireToCopySemaphore);
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
-	{
-		int width, height;
-		glfwGetFramebufferSize(p->window, &width, &height);
+	acquireNextImage(frameInFlight.imageAcquiredSemaphore);
 
-		p->recreateSwapchain(width, height);
-
-		outSwapchainRecreated = true;
-		return;
-	}
-	else if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("error: failed to present");
-	}
+	VkResult result =
+	    vk.queuePresent(vk.presentQueue(), swapchain(), m_imageIndex,
+	                    frameInFlight.imageAcquiredSemaphore);
+	outSwapchainRecreated = recreateSwapchainIfNeeded(result);
 
-	m_currentFrame = (m_currentFrame + 1) % p->swapchainImages.size();
+	endFrame();
 }
 
 // `image` will be copied to the swapchain. It must be in
@@ -1091,17 +1142,25 @@ void RenderWindow::present(const Texture2D& image, VkImageLayout currentLayout,
                            VkSemaphore additionalSemaphore,
                            bool& outSwapchainRecreated)
 {
+	CpuProfiler::Zone zone("present");
+
 	{
 		int width, height;
 		glfwGetFramebufferSize(p->window, &width, &height);
 
+		// nothing is presented but the frame still waits for its slot
 		if (width == 0 || height == 0)
+		{
+			endFrame();
 			return;
+		}
 	}
 
 	outSwapchainRecreated = false;
 	const auto& vk = device();
 
+	auto& frameInFlight = p->framesInFlight[m_currentFrame];
+
 	auto& frame = getAvailableCommandBuffer();
 	frame.reset();
 
@@ -1109,14 +1168,7 @@ void RenderWindow::present(const Texture2D& image, VkImageLayout currentLayout,
 	// frame.commandBuffer.reset();
 	frame.commandBuffer.begin();
 
-	// vk.wait(p->imageAcquisitionFences[m_imageIndex]);
-	// vk.resetFence(p->imageAcquisitionFences[m_imageIndex]);
-
-	// waitForAllCommandBuffers();
-
-	// acquireNextImage(p->imageAcquisitionFences[m_imageIndex]);
-	size_t semaphoreIndex = m_imageIndex;
-	acquireNextImage(p->imageAcquisitionSemaphores[semaphoreIndex]);
+	acquireNextImage(frameInFlight.imageAcquiredSemaphore);
 
 #pragma region transition and blit
 	if (currentLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL &&
@@ -1218,11 +1270,11 @@ void RenderWindow::present(const Texture2D& image, VkImageLayout currentLayout,
 	submit.pCommandBuffers = &frame.commandBuffer.get();
 	stack_vector<VkSemaphore, 3> waitSemaphores;
 	stack_vector<VkPipelineStageFlags, 3> waitStages;
-	waitSemaphores.push_back(p->imageAcquisitionSemaphores[semaphoreIndex]);
+	waitSemaphores.push_back(frameInFlight.imageAcquiredSemaphore);
 	waitStages.push_back(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
 	submit.signalSemaphoreCount = 1;
-	submit.pSignalSemaphores = &p->copyToPresentSemaphore.get();
+	submit.pSignalSemaphores = &frameInFlight.renderFinishedSemaphore.get();
 
 	if (additionalSemaphore != nullptr)
 	{
@@ -1237,29 +1289,95 @@ void RenderWindow::present(const Texture2D& image, VkImageLayout currentLayout,
 
 	frame.submitted = true;
 
+	VkResult result =
+	    vk.queuePresent(vk.presentQueue(), swapchain(), m_imageIndex,
+	                    frameInFlight.renderFinishedSemaphore);
+	outSwapchainRecreated = recreateSwapchainIfNeeded(result);
+
+	endFrame();
+}
+
+uint32_t RenderWindow::acquireFrameImage()
+{
+	return acquireNextImage(imageAcquiredSemaphore());
+}
+
+VkSemaphore RenderWindow::imageAcquiredSemaphore() const
+{
+	return p->framesInFlight[m_currentFrame].imageAcquiredSemaphore;
+}
+
+void RenderWindow::presentFrameImage(VkSemaphore renderFinishedSemaphore)
+{
+	bool _;
+	presentFrameImage(renderFinishedSemaphore, _);
+}
+
+void RenderWindow::presentFrameImage(VkSemaphore renderFinishedSemaphore,
+                                     bool& outSwapchainRecreated)
+{
+	CpuProfiler::Zone zone("present");
+
+	const auto& vk = device();
+
 	VkResult result = vk.queuePresent(vk.presentQueue(), swapchain(),
-	                                  m_imageIndex, p->copyToPresentSemaphore);
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+	                                  m_imageIndex, renderFinishedSemaphore);
+	outSwapchainRecreated = recreateSwapchainIfNeeded(result);
+
+	endFrame();
+}
+
+bool RenderWindow::canRenderToSwapchain(VkFormat format,
+                                        VkExtent2D extent) const
+{
+	return format == p->swapchainImageFormat &&
+	       extent.width == p->swapchainExtent.width &&
+	       extent.height == p->swapchainExtent.height;
+}
+
+bool RenderWindow::recreateSwapchainIfNeeded(VkResult presentResult)
+{
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR ||
+	    presentResult == VK_SUBOPTIMAL_KHR || p->presentModeChanged)
 	{
 		int width, height;
 		glfwGetFramebufferSize(p->window, &width, &height);
 
 		p->recreateSwapchain(width, height);
 
-		outSwapchainRecreated = true;
-		return;
+		return true;
 	}
-	else if (result != VK_SUCCESS)
+	else if (presentResult != VK_SUCCESS)
 	{
 		throw std::runtime_error("error: failed to present");
 	}
 
-	m_currentFrame = (m_currentFrame + 1) % p->swapchainImages.size();
+	return false;
+}
+
+void RenderWindow::endFrame()
+{
+	using namespace std::chrono;
+
+	if (p->targetFrameTime > 0.0)
+	{
+		CpuProfiler::Zone zone("frame pacing");
 
-	// vk.wait(frame.fence);
-	// std::cout << "present: after wait " << uint32_t(frame.fence.get()) <<
-	// "\t" << vk::to_string(vk.getStatus(frame.fence)) << std::endl;
-	// frame.reset();
+		auto deadline = p->lastFrameEnd +
+		                duration_cast<steady_clock::duration>(
+		                    duration<double>(p->targetFrameTime));
+
+		// sleeps are coarse on some platforms, the last millisecond is spun
+		std::this_thread::sleep_until(deadline - milliseconds(1));
+		while (steady_clock::now() < deadline)
+			std::this_thread::yield();
+	}
+	p->lastFrameEnd = steady_clock::now();
+
+	m_currentFrame = (m_currentFrame + 1) % p->framesInFlight.size();
+
+	CpuProfiler::Zone zone("wait for frame");
+	p->waitForFrame(p->framesInFlight[m_currentFrame]);
 }
 
 uint32_t RenderWindow::imageIndex() const { return m_imageIndex; }
@@ -1438,78 +1556,74 @@ ResettableFrameCommandBuffer& RenderWindow::getAvailableCommandBuffer()
 {
 	const auto& vk = device();
 
-	// std::cout << "\ngetAvailableCommandBuffer" << std::endl;
-	// for (auto& frame : p->frameCommandBuffers)
-	//{
-	//	VkResult res = vk.getStatus(frame.fence);
-	//	std::cout << "    fence " << uint32_t(frame.fence.get())
-	//	          << ": \t" << (res == VK_SUCCESS ? "signaled" : "unsignaled")
-	//<< " and " << (frame.submitted ? "submitted" : "unsubmitted")
-	//	          << std::endl;
-	//}
-	// std::cout << std::endl;
+	auto& frameInFlight = p->framesInFlight[m_currentFrame];
 
-	int outCommandBufferIndex = 0;
-	for (auto& frame : p->frameCommandBuffers)
+	if (frameInFlight.usedCommandBuffers == frameInFlight.commandBuffers.size())
 	{
-		// VkResult res = vk.getStatus(frame.fence);
-		// if (res == VK_SUCCESS)
-		if (frame.isAvailable())
-		{
-			// std::cout << "    fence "
-			//          << uint32_t(frame.fence.get()) << " is available!"
-			//          << std::endl;
-			return frame;
-		}
-
-		/// AAAAAAAAAAAAH
-		outCommandBufferIndex++;
-		if (outCommandBufferIndex >= 256)
-			abort();
-	}
-
-	p->frameCommandBuffers.emplace_front(ResettableFrameCommandBuffer{
-	    CommandBuffer(vk, commandPool()),
-	    vk.createFence(VK_FENCE_CREATE_SIGNALED_BIT), vk.createSemaphore() });
+		// the frame was created unsignaled: callers reset then submit it
+		frameInFlight.commandBuffers.push_back(ResettableFrameCommandBuffer{
+		    CommandBuffer(vk, commandPool()), vk.createFence(),
+		    vk.createSemaphore() });
 
 #pragma region marker names
-	vk.debugMarkerSetObjectName(
-	    p->frameCommandBuffers.front().commandBuffer.get(),
-	    "RenderWindow::frameCommandBuffers[" +
-	        std::to_string(outCommandBufferIndex) + "].commandBuffer");
-	vk.debugMarkerSetObjectName(p->frameCommandBuffers.front().fence.get(),
-	                            "RenderWindow::frameCommandBuffers[" +
-	                                std::to_string(outCommandBufferIndex) +
-	                                "].fence");
-	vk.debugMarkerSetObjectName(p->frameCommandBuffers.front().semaphore.get(),
-	                            "RenderWindow::frameCommandBuffers[" +
-	                                std::to_string(outCommandBufferIndex) +
-	                                "].semaphore");
+		const std::string name =
+		    "RenderWindow::framesInFlight[" + std::to_string(m_currentFrame) +
+		    "].commandBuffers[" +
+		    std::to_string(frameInFlight.usedCommandBuffers) + "]";
+		auto& frame = frameInFlight.commandBuffers.back();
+		vk.debugMarkerSetObjectName(frame.commandBuffer.get(),
+		                            name + ".commandBuffer");
+		vk.debugMarkerSetObjectName(frame.fence.get(), name + ".fence");
+		vk.debugMarkerSetObjectName(frame.semaphore.get(), name + ".semaphore");
 #pragma endregion
+	}
 
-	// std::cout << "    fence "
-	//          << uint32_t(p->frameCommandBuffers.front().fence.get())
-	//          << " has been created..." << std::endl;
-
-	// std::cout << outCommandBufferIndex << std::endl;
-
-	return p->frameCommandBuffers.front();
+	return frameInFlight.commandBuffers[frameInFlight.usedCommandBuffers++];
 }
 
 void RenderWindow::waitForAllCommandBuffers()
 {
 	const auto& vk = device();
 
-	for (auto& frame : p->frameCommandBuffers)
+	// the frames keep their command buffers, some may still be recording
+	for (auto& frameInFlight : p->framesInFlight)
 	{
-		if (frame.submitted)
+		for (auto& frame : frameInFlight.commandBuffers)
 		{
-			vk.wait(frame.fence);
-			frame.reset();
+			if (frame.submitted)
+			{
+				vk.wait(frame.fence);
+				frame.reset();
+			}
 		}
 	}
 }
 
+uint32_t RenderWindow::framesInFlight() const
+{
+	return uint32_t(p->framesInFlight.size());
+}
+
+DescriptorAllocator& RenderWindow::frameDescriptorAllocator()
+{
+	return p->framesInFlight[m_currentFrame].descriptorAllocator;
+}
+
+void RenderWindow::setPresentMode(VkPresentModeKHR presentMode)
+{
+	p->requestedPresentMode = presentMode;
+	p->presentModeChanged = presentMode != p->presentMode;
+}
+
+VkPresentModeKHR RenderWindow::presentMode() const { return p->presentMode; }
+
+void RenderWindow::setTargetFrameTime(double seconds)
+{
+	p->targetFrameTime = seconds;
+}
+
+double RenderWindow::targetFrameTime() const { return p->targetFrameTime; }
+
 VkCommandPool RenderWindow::oneTimeCommandPool() const
 {
 	return p->oneTimeCommandPool;
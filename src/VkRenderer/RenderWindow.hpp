@@ -4,8 +4,7 @@
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 
-#define VK_NO_PROTOTYPES
-#include "cdm_vulkan.hpp"
+#include "RenderContext.hpp"
 
 #include <functional>
 #include <memory>
@@ -15,6 +14,7 @@ namespace cdm
 {
 class VulkanDevice;
 class CommandBuffer;
+class DescriptorAllocator;
 class ImageView;
 class Texture2D;
 
@@ -183,27 +183,38 @@ using PFN_keyCallback = std::function<void(Key, int, Action, int)>;
 using PFN_mouseButtonCallback = std::function<void(MouseButton, Action, int)>;
 using PFN_mousePosCallback = std::function<void(double, double)>;
 
-class RenderWindow
+class RenderWindow : public RenderContext
 {
 	std::unique_ptr<RenderWindowPrivate> p;
 
 	uint32_t m_imageIndex = 0;
 	size_t m_currentFrame = 0;
 
+	/// true if the swapchain had to be recreated
+	bool recreateSwapchainIfNeeded(VkResult presentResult);
+	/// Paces the frame then moves to the next frame in flight, waiting for
+	/// the GPU to be done with it
+	void endFrame();
+
 public:
-	RenderWindow(int width, int height, bool layers = false);
+	static constexpr uint32_t MaxFramesInFlight = 3;
+
+	/// `framesInFlight` is clamped between 1 and `MaxFramesInFlight`, and to
+	/// the swapchain image count
+	RenderWindow(int width, int height, bool layers = false,
+	             uint32_t framesInFlight = 2);
 	RenderWindow(const RenderWindow&) = delete;
 	RenderWindow(RenderWindow&&) = delete;
-	~RenderWindow();
+	~RenderWindow() override;
 
 	RenderWindow& operator=(const RenderWindow&) = delete;
 	RenderWindow& operator=(RenderWindow&&) = delete;
 
 	void pollEvents();
-	uint32_t acquireNextImage(VkSemaphore semaphore, VkFence fence);
+	uint32_t acquireNextImage(VkSemaphore semaphore, VkFence fence) override;
 	uint32_t acquireNextImage(VkSemaphore semaphore);
 	uint32_t acquireNextImage(VkFence fence);
-	void present();
+	void present() override;
 	void present(bool& outSwapchainRecreated);
 	void present(const Texture2D& image, VkImageLayout currentLayout,
 	             VkImageLayout outputLayout, VkSemaphore additionalSemaphore);
@@ -211,13 +222,30 @@ public:
 	             VkImageLayout outputLayout, VkSemaphore additionalSemaphore,
 	             bool& outSwapchainRecreated);
 
-	uint32_t imageIndex() const;
-	size_t currentFrame() const;
+	/// Acquires the swapchain image of the current frame so that the last
+	/// pass renders straight into `swapchainImageViews()[index]` instead of
+	/// going through the blit of `present(image, ...)`. The image is in
+	/// `VK_IMAGE_LAYOUT_PRESENT_SRC_KHR` and must be back in it when
+	/// presented. The submission writing it waits for
+	/// `imageAcquiredSemaphore()` and signals `renderFinishedSemaphore`
+	uint32_t acquireFrameImage();
+	VkSemaphore imageAcquiredSemaphore() const;
+	void presentFrameImage(VkSemaphore renderFinishedSemaphore);
+	void presentFrameImage(VkSemaphore renderFinishedSemaphore,
+	                       bool& outSwapchainRecreated);
+	/// true if an image of `format` and `extent` can be replaced by the
+	/// swapchain images, otherwise it has to be blitted by `present`
+	bool canRenderToSwapchain(VkFormat format, VkExtent2D extent) const;
+
+	uint32_t imageIndex() const override;
+	/// Index of the frame in flight being recorded, below `framesInFlight()`
+	size_t currentFrame() const override;
+	uint32_t framesInFlight() const override;
 
 	const VkSemaphore& currentImageAvailableSemaphore() const;
 	const VkFence& currentInFlightFences() const;
 
-	void pushPresentWaitSemaphore(VkSemaphore semaphore);
+	void pushPresentWaitSemaphore(VkSemaphore semaphore) override;
 
 	void show();
 	void hide();
@@ -250,26 +278,45 @@ public:
 	void registerMousePosCallback(PFN_mousePosCallback mousePosCallback);
 	void unregisterMousePosCallback(PFN_mousePosCallback mousePosCallback);
 
-	const VulkanDevice& device() const;
+	const VulkanDevice& device() const override;
 
 	VkSwapchainKHR swapchain() const;
-	VkExtent2D swapchainExtent();
-	VkFormat swapchainImageFormat();
-	VkFormat depthImageFormat();
-	std::vector<VkImage> swapchainImages() const;
-	std::vector<std::reference_wrapper<ImageView>> swapchainImageViews() const;
-
-	VkCommandPool commandPool() const;
-	VkCommandPool oneTimeCommandPool() const;
-
-	ResettableFrameCommandBuffer& getAvailableCommandBuffer();
-	void waitForAllCommandBuffers();
+	VkExtent2D swapchainExtent() override;
+	VkFormat swapchainImageFormat() override;
+	VkFormat depthImageFormat() override;
+	std::vector<VkImage> swapchainImages() const override;
+	std::vector<std::reference_wrapper<ImageView>> swapchainImageViews()
+	    const override;
+	VkImageLayout swapchainImageLayout() const override
+	{
+		return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	}
+
+	VkCommandPool commandPool() const override;
+	VkCommandPool oneTimeCommandPool() const override;
+
+	/// A command buffer of the current frame in flight, each call returns a
+	/// different one. They are recycled once the frame comes around again
+	ResettableFrameCommandBuffer& getAvailableCommandBuffer() override;
+	void waitForAllCommandBuffers() override;
+	/// Reset along with the command buffers of the current frame in flight
+	DescriptorAllocator& frameDescriptorAllocator();
+
+	/// Applied by the next `present`, falls back to FIFO if the surface
+	/// does not support `presentMode`
+	void setPresentMode(VkPresentModeKHR presentMode);
+	VkPresentModeKHR presentMode() const;
+
+	/// `present` does not return before `seconds` have passed since the
+	/// previous one. 0 disables the pacing
+	void setTargetFrameTime(double seconds);
+	double targetFrameTime() const;
 
 	VkRenderPass imguiRenderPass() const;
 
 	double swapchainCreationTime() const;
 
-	double getTime() const;
+	double getTime() const override;
 
 	ButtonState mouseState(MouseButton button) const;
 	bool mouseState(MouseButton button, ButtonState state) const;
@@ -254,7 +254,7 @@ void Renderer::render()
 
 	vk.ResetFences(vk.vkDevice(), 1, &inFlightFence);
 
-	if (vk.QueueSubmit(vk.graphicsQueue(), 1, &submitInfo, inFlightFence) !=
+	if (vk.queueSubmit(vk.graphicsQueue(), 1, &submitInfo, inFlightFence) !=
 	    VK_SUCCESS)
 	{
 		throw std::runtime_error(
@@ -300,4 +300,4 @@ RenderPass& Renderer::defaultRenderPass() { return m_defaultRenderPass; }
 
 Material& Renderer::defaultMaterial() { return m_defaultMaterial; }
 }  // namespace cdm
-//*/
\ No newline at end of file
+//*/
\ No newline at end of file
@@ -2,40 +2,117 @@
 
 #include "MyShaderWriter.hpp"
 #include "CommandBuffer.hpp"
-#include "RenderWindow.hpp"
+#include "CpuProfiler.hpp"
+#include "DepthPyramid.hpp"
+#include "Material.hpp"
+#include "RenderContext.hpp"
 #include "SceneObject.hpp"
+#include "StandardMesh.hpp"
 #include "TextureFactory.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 namespace cdm
 {
-Scene::Scene(RenderWindow& renderWindow) : rw(renderWindow)
+static void worldBounds(const SceneObject& sceneObject, vector3& outMin,
+                        vector3& outMax)
 {
-	auto& vk = renderWindow.device();
+	const vector3& bMin = sceneObject.mesh()->boundsMin();
+	const vector3& bMax = sceneObject.mesh()->boundsMax();
+	const matrix4 model = matrix4(sceneObject.transform);
 
-	m_sceneUniformBuffer =
-	    Buffer(vk, sizeof(SceneUboStruct), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	           VMA_MEMORY_USAGE_CPU_ONLY,
-	           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-	               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	m_sceneUniformBuffer.setName("Scene UBO");
+	for (uint32_t c = 0; c < 8; c++)
+	{
+		vector3 corner{ (c & 1) ? bMax.x : bMin.x, (c & 2) ? bMax.y : bMin.y,
+			            (c & 4) ? bMax.z : bMin.z };
+		vector3 wsCorner = (model * vector4(corner, 1.0f)).xyz();
+
+		if (c == 0)
+		{
+			outMin = outMax = wsCorner;
+			continue;
+		}
+
+		outMin.x = std::min(outMin.x, wsCorner.x);
+		outMin.y = std::min(outMin.y, wsCorner.y);
+		outMin.z = std::min(outMin.z, wsCorner.z);
+		outMax.x = std::max(outMax.x, wsCorner.x);
+		outMax.y = std::max(outMax.y, wsCorner.y);
+		outMax.z = std::max(outMax.z, wsCorner.z);
+	}
+}
+
+Scene::Scene(RenderContext& renderContext, uint32_t shadowmapResolution,
+             uint32_t shadowCascadeCount)
+    : rw(renderContext),
+      m_shadowmapResolution{ shadowmapResolution, shadowmapResolution },
+      m_shadowCascadeCount(shadowCascadeCount)
+{
+	auto& vk = renderContext.device();
 
-	m_modelUniformBuffer =
-	    Buffer(vk, sizeof(ModelUboStruct), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	           VMA_MEMORY_USAGE_CPU_ONLY,
-	           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-	               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	m_modelUniformBuffer.setName("Models UBO");
+	if (m_shadowCascadeCount == 0 ||
+	    m_shadowCascadeCount > MaxShadowCascadeCount)
+		throw std::runtime_error("invalid shadow cascade count");
+
+	// rewritten every frame while the previous ones may still read them
+	const uint32_t framesInFlight = std::max(rw.get().framesInFlight(), 1u);
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		m_sceneUniformBuffers.emplace_back(
+		    vk, sizeof(SceneUboStruct), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		    VMA_MEMORY_USAGE_CPU_ONLY,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_sceneUniformBuffers.back().setName("Scene UBO " +
+		                                     std::to_string(i));
+
+		m_modelUniformBuffers.emplace_back(
+		    vk, sizeof(ModelUboStruct), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		    VMA_MEMORY_USAGE_CPU_ONLY,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_modelUniformBuffers.back().setName("Models UBO " +
+		                                     std::to_string(i));
+
+		m_occlusionBoundsBuffers.emplace_back(
+		    vk,
+		    sizeof(DepthPyramid::BoundsStruct) * MaxSceneObjectCountPerPool,
+		    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_ONLY,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_occlusionBoundsBuffers.back().setName("Occlusion bounds SSBO " +
+		                                        std::to_string(i));
+
+		m_drawCommandsBuffers.emplace_back(
+		    vk,
+		    sizeof(VkDrawIndexedIndirectCommand) *
+		        MaxSceneObjectCountPerPool,
+		    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+		        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		    VMA_MEMORY_USAGE_CPU_TO_GPU,
+		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_drawCommandsBuffers.back().setName("Draw commands SSBO " +
+		                                     std::to_string(i));
+	}
 
 #pragma region shadowmap
 	TextureFactory f(vk);
 
 	f.setExtent(m_shadowmapResolution);
+	f.setArrayLayers(m_shadowCascadeCount);
+	f.setViewType(VK_IMAGE_VIEW_TYPE_2D_ARRAY);
 	f.setFormat(VK_FORMAT_D32_SFLOAT);
 	f.setAspectMask(VK_IMAGE_ASPECT_DEPTH_BIT);
 	f.setUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-	           VK_IMAGE_USAGE_SAMPLED_BIT);
+	           VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
 	f.setSamplerCompareEnable(true);
 	f.setSamplerCompareOp(VK_COMPARE_OP_LESS);
 
@@ -48,6 +125,34 @@ Scene::Scene(RenderWindow& renderWindow) : rw(renderWindow)
 	vk.debugMarkerSetObjectName(m_shadowmap.sampler(),
 	                            "Scene shadowmap sampler");
 
+	// the camera can move a quarter of a cascade before the static depth
+	// has to be rendered again
+	shadowmapCachePadding = m_shadowmapResolution.width / 4;
+
+	for (uint32_t i = 0; i < m_shadowCascadeCount; i++)
+	{
+		vk::ImageViewCreateInfo viewInfo;
+		viewInfo.image = m_shadowmap.image();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_D32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = i;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		m_shadowmapCascadeViews.push_back(vk.create(viewInfo));
+		if (!m_shadowmapCascadeViews.back())
+		{
+			std::cerr << "error: failed to create shadowmap cascade view"
+			          << std::endl;
+			abort();
+		}
+		vk.debugMarkerSetObjectName(
+		    m_shadowmapCascadeViews.back().get(),
+		    "Scene shadowmap cascade " + std::to_string(i) + " imageView");
+	}
+
 	VkDescriptorImageInfo shadowmapImageInfo{};
 	shadowmapImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	shadowmapImageInfo.imageView = m_shadowmap.view();
@@ -56,12 +161,14 @@ Scene::Scene(RenderWindow& renderWindow) : rw(renderWindow)
 
 #pragma region descriptor pool
 	std::array poolSizes{
-		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
-		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		                      2 * framesInFlight },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		                      framesInFlight },
 	};
 
 	vk::DescriptorPoolCreateInfo poolInfo;
-	poolInfo.maxSets = 1;
+	poolInfo.maxSets = framesInFlight;
 	poolInfo.poolSizeCount = uint32_t(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
 
@@ -114,52 +221,57 @@ Scene::Scene(RenderWindow& renderWindow) : rw(renderWindow)
 	}
 #pragma endregion
 
-#pragma region descriptor set
-	m_descriptorSet = vk.allocate(m_descriptorPool, m_descriptorSetLayout);
-
-	if (!m_descriptorSet)
+#pragma region descriptor sets
+	for (uint32_t i = 0; i < framesInFlight; i++)
 	{
-		std::cerr << "error: failed to allocate descriptor set" << std::endl;
-		abort();
-	}
-#pragma endregion
+		m_descriptorSets.push_back(
+		    vk.allocate(m_descriptorPool, m_descriptorSetLayout));
+
+		if (!m_descriptorSets.back())
+		{
+			std::cerr << "error: failed to allocate descriptor set"
+			          << std::endl;
+			abort();
+		}
+
+		VkDescriptorBufferInfo sceneSetBufferInfo{};
+		sceneSetBufferInfo.buffer = m_sceneUniformBuffers[i];
+		sceneSetBufferInfo.range = sizeof(SceneUboStruct);
+		sceneSetBufferInfo.offset = 0;
+
+		VkDescriptorBufferInfo modelSetBufferInfo{};
+		modelSetBufferInfo.buffer = m_modelUniformBuffers[i];
+		modelSetBufferInfo.range = sizeof(ModelUboStruct);
+		modelSetBufferInfo.offset = 0;
+
+		vk::WriteDescriptorSet sceneUboWrite;
+		sceneUboWrite.descriptorCount = 1;
+		sceneUboWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		sceneUboWrite.dstArrayElement = 0;
+		sceneUboWrite.dstBinding = 0;
+		sceneUboWrite.dstSet = m_descriptorSets.back();
+		sceneUboWrite.pBufferInfo = &sceneSetBufferInfo;
+
+		vk::WriteDescriptorSet modelUboWrite;
+		modelUboWrite.descriptorCount = 1;
+		modelUboWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		modelUboWrite.dstArrayElement = 0;
+		modelUboWrite.dstBinding = 1;
+		modelUboWrite.dstSet = m_descriptorSets.back();
+		modelUboWrite.pBufferInfo = &modelSetBufferInfo;
 
-#pragma region update descriptor set
-	VkDescriptorBufferInfo sceneSetBufferInfo{};
-	sceneSetBufferInfo.buffer = m_sceneUniformBuffer;
-	sceneSetBufferInfo.range = sizeof(SceneUboStruct);
-	sceneSetBufferInfo.offset = 0;
-
-	VkDescriptorBufferInfo modelSetBufferInfo{};
-	modelSetBufferInfo.buffer = m_modelUniformBuffer;
-	modelSetBufferInfo.range = sizeof(ModelUboStruct);
-	modelSetBufferInfo.offset = 0;
-
-	vk::WriteDescriptorSet sceneUboWrite;
-	sceneUboWrite.descriptorCount = 1;
-	sceneUboWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	sceneUboWrite.dstArrayElement = 0;
-	sceneUboWrite.dstBinding = 0;
-	sceneUboWrite.dstSet = m_descriptorSet;
-	sceneUboWrite.pBufferInfo = &sceneSetBufferInfo;
-
-	vk::WriteDescriptorSet modelUboWrite;
-	modelUboWrite.descriptorCount = 1;
-	modelUboWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	modelUboWrite.dstArrayElement = 0;
-	modelUboWrite.dstBinding = 1;
-	modelUboWrite.dstSet = m_descriptorSet;
-	modelUboWrite.pBufferInfo = &modelSetBufferInfo;
-
-	vk::WriteDescriptorSet shadowmapWrite;
-	shadowmapWrite.descriptorCount = 1;
-	shadowmapWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	shadowmapWrite.dstArrayElement = 0;
-	shadowmapWrite.dstBinding = 2;
-	shadowmapWrite.dstSet = m_descriptorSet;
-	shadowmapWrite.pImageInfo = &shadowmapImageInfo;
-
-	vk.updateDescriptorSets({ sceneUboWrite, modelUboWrite, shadowmapWrite });
+		vk::WriteDescriptorSet shadowmapWrite;
+		shadowmapWrite.descriptorCount = 1;
+		shadowmapWrite.descriptorType =
+		    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		shadowmapWrite.dstArrayElement = 0;
+		shadowmapWrite.dstBinding = 2;
+		shadowmapWrite.dstSet = m_descriptorSets.back();
+		shadowmapWrite.pImageInfo = &shadowmapImageInfo;
+
+		vk.updateDescriptorSets(
+		    { sceneUboWrite, modelUboWrite, shadowmapWrite });
+	}
 #pragma endregion
 
 #pragma region render pass
@@ -188,21 +300,136 @@ Scene::Scene(RenderWindow& renderWindow) : rw(renderWindow)
 	rpInfo.pSubpasses = &subpass;
 
 	m_shadowmapRenderPass = vk.create(rpInfo);
+
+	attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	m_staticShadowmapRenderPass = vk.create(rpInfo);
+
+	attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	m_cachedShadowmapRenderPass = vk.create(rpInfo);
 #pragma endregion
 
-#pragma region framebuffer
-	vk::FramebufferCreateInfo fbInfo;
-	fbInfo.attachmentCount = 1;
-	fbInfo.pAttachments = &m_shadowmap.view();
-	fbInfo.width = m_shadowmap.width();
-	fbInfo.height = m_shadowmap.height();
-	fbInfo.renderPass = m_shadowmapRenderPass;
-	fbInfo.layers = 1;
+#pragma region framebuffers
+	for (auto& cascadeView : m_shadowmapCascadeViews)
+	{
+		vk::FramebufferCreateInfo fbInfo;
+		fbInfo.attachmentCount = 1;
+		fbInfo.pAttachments = &cascadeView.get();
+		fbInfo.width = m_shadowmap.width();
+		fbInfo.height = m_shadowmap.height();
+		fbInfo.renderPass = m_shadowmapRenderPass;
+		fbInfo.layers = 1;
+
+		m_shadowmapFramebuffers.push_back(vk.create(fbInfo));
 
-	m_shadowmapFramebuffer = vk.create(fbInfo);
+		fbInfo.renderPass = m_cachedShadowmapRenderPass;
+		m_cachedShadowmapFramebuffers.push_back(vk.create(fbInfo));
+	}
 #pragma endregion
 }
 
+size_t Scene::frameIndex() const
+{
+	return rw.get().currentFrame() % m_descriptorSets.size();
+}
+
+const VkDescriptorSet& Scene::descriptorSet() const
+{
+	return m_descriptorSets[frameIndex()];
+}
+
+Buffer& Scene::sceneUniformBuffer()
+{
+	return m_sceneUniformBuffers[frameIndex()];
+}
+
+Buffer& Scene::modelUniformBuffer()
+{
+	return m_modelUniformBuffers[frameIndex()];
+}
+
+void Scene::updateStaticShadowmap()
+{
+	const bool allocated = !m_staticShadowmapFramebuffers.empty();
+	if (allocated == shadowmapCaching &&
+	    (!allocated || m_staticShadowmapPadding == shadowmapCachePadding))
+		return;
+
+	auto& vk = rw.get().device();
+
+	if (allocated)
+	{
+		// toggled rarely, the frames in flight may still copy from it
+		vk.wait();
+		m_staticShadowmapFramebuffers.clear();
+		m_staticShadowmapCascadeViews.clear();
+		m_staticShadowmap = Texture2D();
+	}
+
+	// the regions depend on the padding
+	m_staticShadowRegions = {};
+	invalidateShadowmapCache();
+
+	if (!shadowmapCaching)
+		return;
+
+	m_staticShadowmapPadding = shadowmapCachePadding;
+
+	TextureFactory f(vk);
+
+	f.setExtent({ m_shadowmapResolution.width + 2 * m_staticShadowmapPadding,
+	              m_shadowmapResolution.height +
+	                  2 * m_staticShadowmapPadding });
+	f.setArrayLayers(m_shadowCascadeCount);
+	f.setViewType(VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+	f.setFormat(VK_FORMAT_D32_SFLOAT);
+	f.setAspectMask(VK_IMAGE_ASPECT_DEPTH_BIT);
+	f.setUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+	           VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+	m_staticShadowmap = f.createTexture2D();
+	m_staticShadowmap.transitionLayoutImmediate(
+	    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	vk.debugMarkerSetObjectName(m_staticShadowmap.image(),
+	                            "Scene static shadowmap image");
+
+	for (uint32_t i = 0; i < m_shadowCascadeCount; i++)
+	{
+		vk::ImageViewCreateInfo viewInfo;
+		viewInfo.image = m_staticShadowmap.image();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_D32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = i;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		m_staticShadowmapCascadeViews.push_back(vk.create(viewInfo));
+		if (!m_staticShadowmapCascadeViews.back())
+		{
+			std::cerr << "error: failed to create static shadowmap cascade "
+			             "view"
+			          << std::endl;
+			abort();
+		}
+		vk.debugMarkerSetObjectName(
+		    m_staticShadowmapCascadeViews.back().get(),
+		    "Scene static shadowmap cascade " + std::to_string(i) +
+		        " imageView");
+
+		vk::FramebufferCreateInfo fbInfo;
+		fbInfo.attachmentCount = 1;
+		fbInfo.pAttachments = &m_staticShadowmapCascadeViews.back().get();
+		fbInfo.width = m_staticShadowmap.width();
+		fbInfo.height = m_staticShadowmap.height();
+		fbInfo.renderPass = m_staticShadowmapRenderPass;
+		fbInfo.layers = 1;
+
+		m_staticShadowmapFramebuffers.push_back(vk.create(fbInfo));
+	}
+}
+
 SceneObject& Scene::instantiateSceneObject()
 {
 	if (m_sceneObjects.size() >= MaxSceneObjectCountPerPool)
@@ -215,12 +442,39 @@ SceneObject& Scene::instantiateSceneObject()
 
 void Scene::removeSceneObject(SceneObject& sceneObject)
 {
+	if (sceneObject.mobility == SceneObject::Mobility::Static)
+		invalidateShadowmapCache();
+
 	std::remove_if(m_sceneObjects.begin(), m_sceneObjects.end(),
 	               [&](const std::unique_ptr<SceneObject>& soptr) {
 		               return &sceneObject == soptr.get();
 	               });
 }
 
+void Scene::invalidateShadowmapCache() { m_staticShadowmapValid.fill(false); }
+
+static vk::ImageMemoryBarrier shadowmapLayerBarrier(
+    VkImage image, uint32_t layer, VkImageLayout oldLayout,
+    VkImageLayout newLayout, VkAccessFlags srcAccessMask,
+    VkAccessFlags dstAccessMask)
+{
+	vk::ImageMemoryBarrier barrier;
+	barrier.image = image;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = layer;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = srcAccessMask;
+	barrier.dstAccessMask = dstAccessMask;
+
+	return barrier;
+}
+
 void Scene::drawShadowmapPass(CommandBuffer& cb)
 {
 	VkClearValue clearDepth{};
@@ -228,67 +482,341 @@ void Scene::drawShadowmapPass(CommandBuffer& cb)
 
 	std::array clearValues = { clearDepth };
 
-	vk::RenderPassBeginInfo rpInfo;
-	rpInfo.framebuffer = m_shadowmapFramebuffer;
-	rpInfo.renderPass = m_shadowmapRenderPass;
-	rpInfo.renderArea.extent = m_shadowmap.extent2D();
-	rpInfo.clearValueCount = uint32_t(clearValues.size());
-	rpInfo.pClearValues = clearValues.data();
-
 	vk::SubpassBeginInfo subpassBeginInfo;
 	subpassBeginInfo.contents = VK_SUBPASS_CONTENTS_INLINE;
 
 	vk::SubpassEndInfo subpassEndInfo;
 
-	cb.beginRenderPass2(rpInfo, subpassBeginInfo);
+	// `viewProjIndex` selects the cascade or its static region
+	auto drawCasters = [&](VkRenderPass renderPass,
+	                       VkFramebuffer framebuffer, VkExtent2D extent,
+	                       uint32_t viewProjIndex,
+	                       const std::vector<uint32_t>& casters) {
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = float(extent.width);
+		viewport.height = float(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = extent;
+
+		vk::RenderPassBeginInfo rpInfo;
+		rpInfo.framebuffer = framebuffer;
+		rpInfo.renderPass = renderPass;
+		rpInfo.renderArea.extent = extent;
+		rpInfo.clearValueCount = uint32_t(clearValues.size());
+		rpInfo.pClearValues = clearValues.data();
+
+		cb.beginRenderPass2(rpInfo, subpassBeginInfo);
+
+		cb.setViewport(viewport);
+		cb.setScissor(scissor);
+
+		for (uint32_t index : casters)
+		{
+			m_sceneObjects[index]->drawShadowmapPass(
+			    cb, renderPass, viewProjIndex, viewport, scissor);
+		}
 
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = float(m_shadowmap.width());
-	viewport.height = float(m_shadowmap.height());
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	cb.setViewport(viewport);
+		cb.endRenderPass2(subpassEndInfo);
+	};
+
+	for (uint32_t cascade = 0; cascade < m_shadowCascadeCount; cascade++)
+	{
+		// the static shadowmap is allocated by `uploadTransformMatrices`
+		if (!shadowmapCaching || m_staticShadowmapFramebuffers.empty() ||
+		    m_staticShadowCasters[cascade].empty())
+		{
+			drawCasters(m_shadowmapRenderPass,
+			            m_shadowmapFramebuffers[cascade],
+			            m_shadowmap.extent2D(), cascade,
+			            m_shadowCasters[cascade]);
+			continue;
+		}
+
+#pragma region static casters
+		if (!m_staticShadowmapValid[cascade])
+		{
+			cb.pipelineBarrier(
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, 0,
+			    shadowmapLayerBarrier(
+			        m_staticShadowmap.image(), cascade,
+			        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 0,
+			        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT));
+
+			drawCasters(m_staticShadowmapRenderPass,
+			            m_staticShadowmapFramebuffers[cascade],
+			            m_staticShadowmap.extent2D(),
+			            MaxShadowCascadeCount + cascade,
+			            m_staticShadowCasters[cascade]);
+
+			cb.pipelineBarrier(
+			    VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			    shadowmapLayerBarrier(
+			        m_staticShadowmap.image(), cascade,
+			        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			        VK_ACCESS_TRANSFER_READ_BIT));
+
+			m_staticShadowmapValid[cascade] = true;
+		}
+#pragma endregion
+
+#pragma region copy
+		cb.pipelineBarrier(
+		    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		    VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		    shadowmapLayerBarrier(m_shadowmap.image(), cascade,
+		                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                          VK_ACCESS_SHADER_READ_BIT,
+		                          VK_ACCESS_TRANSFER_WRITE_BIT));
+
+		VkImageCopy region{};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		region.srcSubresource.mipLevel = 0;
+		region.srcSubresource.baseArrayLayer = cascade;
+		region.srcSubresource.layerCount = 1;
+		region.srcOffset = { m_staticShadowmapOffsets[cascade].x,
+			                 m_staticShadowmapOffsets[cascade].y, 0 };
+		region.dstSubresource = region.srcSubresource;
+		region.extent = m_shadowmap.extent3D();
+
+		cb.copyImage(m_staticShadowmap.image(),
+		             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_shadowmap.image(),
+		             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region);
+
+		cb.pipelineBarrier(
+		    VK_PIPELINE_STAGE_TRANSFER_BIT,
+		    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, 0,
+		    shadowmapLayerBarrier(
+		        m_shadowmap.image(), cascade,
+		        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		        VK_ACCESS_TRANSFER_WRITE_BIT,
+		        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+		            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT));
+#pragma endregion
+
+#pragma region dynamic casters
+		std::vector<uint32_t> dynamicCasters;
+		for (uint32_t index : m_shadowCasters[cascade])
+		{
+			if (m_sceneObjects[index]->mobility !=
+			    SceneObject::Mobility::Static)
+				dynamicCasters.push_back(index);
+		}
 
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent.width = m_shadowmap.width();
-	scissor.extent.height = m_shadowmap.height();
-	cb.setScissor(scissor);
+		drawCasters(m_cachedShadowmapRenderPass,
+		            m_cachedShadowmapFramebuffers[cascade],
+		            m_shadowmap.extent2D(), cascade, dynamicCasters);
 
+		cb.pipelineBarrier(
+		    VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+		    shadowmapLayerBarrier(
+		        m_shadowmap.image(), cascade,
+		        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		        VK_ACCESS_SHADER_READ_BIT));
+#pragma endregion
+	}
+}
+
+void Scene::setDepthPyramid(DepthPyramid* depthPyramid)
+{
+	if (depthPyramid &&
+	    depthPyramid->framesInFlight() != m_drawCommandsBuffers.size())
+		throw std::runtime_error(
+		    "the depth pyramid and the scene have a different number of "
+		    "frames in flight");
+
+	m_depthPyramid = depthPyramid;
+	if (depthPyramid)
+	{
+		for (uint32_t i = 0; i < m_drawCommandsBuffers.size(); i++)
+			depthPyramid->setCullingBuffers(i, m_occlusionBoundsBuffers[i],
+			                                m_drawCommandsBuffers[i]);
+	}
+}
+
+void Scene::applyShaderReloads()
+{
+	// a rebuilt caster would otherwise stay baked with its previous shader
+	bool shadowmapPipelinesChanged = false;
 	for (auto& sceneObject : m_sceneObjects)
+		shadowmapPipelinesChanged |= sceneObject->applyShaderReloads();
+
+	if (shadowmapPipelinesChanged)
+		invalidateShadowmapCache();
+}
+
+void Scene::cullOcclusion(CommandBuffer& cb)
+{
+	CpuProfiler::Zone zone("occlusion culling");
+
+	m_indirectDrawCount = 0;
+
+	if (occlusionCulling != OcclusionCulling::Gpu || !m_depthPyramid)
+		return;
+
+	const uint32_t objectCount = std::min(uint32_t(m_sceneObjects.size()),
+	                                      MaxSceneObjectCountPerPool);
+
+	// the GPU is done with the previous use of the current frame's buffers
+	const size_t frame = frameIndex();
+	Buffer& boundsBuffer = m_occlusionBoundsBuffers[frame];
+	Buffer& commandsBuffer = m_drawCommandsBuffers[frame];
+
+	auto* bounds = boundsBuffer.map<DepthPyramid::BoundsStruct>();
+	auto* commands = commandsBuffer.map<VkDrawIndexedIndirectCommand>();
+
+	for (uint32_t i = 0; i < objectCount; i++)
 	{
-		sceneObject->drawShadowmapPass(cb, m_shadowmapRenderPass, viewport,
-		                               scissor);
+		const auto& sceneObject = m_sceneObjects[i];
+		commands[i] = VkDrawIndexedIndirectCommand{};
+
+		if (sceneObject->mesh() == nullptr)
+		{
+			bounds[i] = DepthPyramid::BoundsStruct{};
+			continue;
+		}
+
+		vector3 bMin;
+		vector3 bMax;
+		worldBounds(*sceneObject, bMin, bMax);
+		bounds[i].min = vector4(bMin, 1.0f);
+		bounds[i].max = vector4(bMax, 1.0f);
+
+		// meshes without indices read the command as a
+		// `VkDrawIndirectCommand` whose first two members are the same
+		const StandardMesh& mesh = *sceneObject->mesh();
+		commands[i].indexCount = mesh.indicesCount() != 0
+		                             ? mesh.indicesCount()
+		                             : mesh.verticesCount();
+		commands[i].instanceCount = 1;
 	}
 
-	cb.endRenderPass2(subpassEndInfo);
+	commandsBuffer.unmap();
+	boundsBuffer.unmap();
+
+	m_depthPyramid.get()->cull(cb, objectCount);
+	m_indirectDrawCount = objectCount;
+}
+
+void Scene::buildDepthPyramid(CommandBuffer& cb)
+{
+	if (!m_depthPyramid)
+		return;
+
+	if (occlusionCulling == OcclusionCulling::Disabled)
+		m_depthPyramid.get()->invalidate();
+	else
+		m_depthPyramid.get()->build(cb, m_viewProj);
 }
 
 void Scene::draw(CommandBuffer& cb, VkRenderPass renderPass,
                  std::optional<VkViewport> viewport,
                  std::optional<VkRect2D> scissor)
 {
-	for (auto& sceneObject : m_sceneObjects)
+	const bool cpuCulling =
+	    occlusionCulling == OcclusionCulling::Cpu && m_depthPyramid;
+
+#pragma region front-to-back sorting
+	{
+		CpuProfiler::Zone zone("culling");
+
+		std::vector<float> distances(m_sceneObjects.size(),
+		                             std::numeric_limits<float>::max());
+		m_drawOrder.clear();
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			const auto& sceneObject = m_sceneObjects[i];
+			if (sceneObject->mesh() == nullptr)
+			{
+				m_drawOrder.push_back(uint32_t(i));
+				continue;
+			}
+
+			if (cpuCulling)
+			{
+				vector3 bMin;
+				vector3 bMax;
+				worldBounds(*sceneObject, bMin, bMax);
+				if (m_depthPyramid.get()->isOccluded(bMin, bMax))
+					continue;
+			}
+
+			vector3 center = (sceneObject->mesh()->boundsMin() +
+			                  sceneObject->mesh()->boundsMax()) /
+			                 2.0f;
+			vector3 wsCenter =
+			    (matrix4(sceneObject->transform) * vector4(center, 1.0f)).xyz();
+			distances[i] = (wsCenter - m_viewPosition).norm_squared();
+			m_drawOrder.push_back(uint32_t(i));
+		}
+
+		std::sort(m_drawOrder.begin(), m_drawOrder.end(),
+		          [&](uint32_t a, uint32_t b) {
+			          return distances[a] < distances[b];
+		          });
+	}
+#pragma endregion
+
+	const Buffer& drawCommandsBuffer = m_drawCommandsBuffers[frameIndex()];
+
+	auto indirectDraw =
+	    [&](uint32_t index) -> std::optional<SceneObject::IndirectDraw> {
+		if (index >= m_indirectDrawCount)
+			return std::nullopt;
+
+		return SceneObject::IndirectDraw{
+			drawCommandsBuffer,
+			VkDeviceSize(index) * sizeof(VkDrawIndexedIndirectCommand)
+		};
+	};
+
+	if (depthPrepass)
 	{
-		sceneObject->draw(cb, renderPass, viewport, scissor);
+		for (uint32_t index : m_drawOrder)
+		{
+			m_sceneObjects[index]->drawDepthPrepass(
+			    cb, renderPass, viewport, scissor, indirectDraw(index));
+		}
 	}
+
+	for (uint32_t index : m_drawOrder)
+	{
+		m_sceneObjects[index]->draw(cb, renderPass, viewport, scissor,
+		                            indirectDraw(index));
+	}
+
+	m_indirectDrawCount = 0;
 }
 
 void Scene::uploadTransformMatrices(const transform3d& cameraTr,
                                     const matrix4& proj,
                                     const transform3d& lightTr)
 {
+	CpuProfiler::Zone zone("scene update");
+
 	SceneUboStruct* sceneUBOPtr = sceneUniformBuffer().map<SceneUboStruct>();
 	sceneUBOPtr->lightPos = { 0, 0, 0 };
 	sceneUBOPtr->view = matrix4(cameraTr).get_transposed().get_inversed();
 	sceneUBOPtr->proj = proj;
 	sceneUBOPtr->viewPos = cameraTr.position;
-	sceneUBOPtr->shadowView = matrix4(lightTr).get_transposed().get_inversed();
-	sceneUBOPtr->shadowProj =
-	    matrix4::orthographic(-150, 150, 150, -150, 0.01f, 1000.0f)
-	        .get_transposed();
+	m_viewPosition = cameraTr.position;
+	m_viewProj = proj.get_transposed() * matrix4(cameraTr).get_inversed();
+	updateShadowCascades(cameraTr, proj, lightTr, *sceneUBOPtr);
 	sceneUBOPtr->shadowBias = shadowBias;
 	sceneUBOPtr->R = R;
 	sceneUBOPtr->sigma = sigma;
@@ -303,13 +831,257 @@ void Scene::uploadTransformMatrices(const transform3d& cameraTr,
 
 	ModelUboStruct* modelUBOPtr = modelUniformBuffer().map<ModelUboStruct>();
 
+	m_previousModels.resize(m_sceneObjects.size());
+	m_previousStatic.resize(m_sceneObjects.size(), false);
+
 	for (size_t i = 0; i < m_sceneObjects.size(); i++)
 	{
 		modelUBOPtr->model[i] =
 		    matrix4(m_sceneObjects[i]->transform).get_transposed();
+
+		bool isStatic =
+		    m_sceneObjects[i]->mobility == SceneObject::Mobility::Static;
+		if ((isStatic || m_previousStatic[i]) &&
+		    (isStatic != m_previousStatic[i] ||
+		     std::memcmp(&m_previousModels[i], &modelUBOPtr->model[i],
+		                 sizeof(matrix4)) != 0))
+			invalidateShadowmapCache();
+
+		m_previousModels[i] = modelUBOPtr->model[i];
+		m_previousStatic[i] = isStatic;
 	}
 
 	modelUniformBuffer().unmap();
+
+	for (const auto& sceneObject : m_sceneObjects)
+	{
+		if (sceneObject->material())
+			sceneObject->material()->material().flushParameters();
+	}
+}
+
+void Scene::updateShadowCascades(const transform3d& cameraTr,
+                                 const matrix4& proj,
+                                 const transform3d& lightTr,
+                                 SceneUboStruct& sceneUbo)
+{
+	updateStaticShadowmap();
+
+	// `proj` is given in its uniform buffer layout
+	const matrix4 cameraView = matrix4(cameraTr).get_inversed();
+	const matrix4 invViewProj =
+	    (proj.get_transposed() * cameraView).get_inversed();
+
+#pragma region camera frustum
+	const std::array ndcCorners{
+		vector2(-1.0f, -1.0f),
+		vector2(1.0f, -1.0f),
+		vector2(1.0f, 1.0f),
+		vector2(-1.0f, 1.0f),
+	};
+
+	std::array<vector3, 4> nearCorners;
+	std::array<vector3, 4> farCorners;
+	for (size_t i = 0; i < ndcCorners.size(); i++)
+	{
+		vector4 n = invViewProj * vector4(ndcCorners[i], 0.0f, 1.0f);
+		vector4 f = invViewProj * vector4(ndcCorners[i], 1.0f, 1.0f);
+		nearCorners[i] = n.xyz() / n.w;
+		farCorners[i] = f.xyz() / f.w;
+	}
+
+	const float nearDepth =
+	    -(cameraView * vector4(nearCorners[0], 1.0f)).z;
+	const float farDepth = -(cameraView * vector4(farCorners[0], 1.0f)).z;
+	const float maxDepth = std::clamp(shadowDistance, nearDepth, farDepth);
+#pragma endregion
+
+#pragma region splits
+	std::array<float, MaxShadowCascadeCount + 1> splits;
+	splits[0] = nearDepth;
+	for (uint32_t i = 1; i <= m_shadowCascadeCount; i++)
+	{
+		float p = float(i) / float(m_shadowCascadeCount);
+		float logSplit = nearDepth * std::pow(maxDepth / nearDepth, p);
+		float uniformSplit = nearDepth + (maxDepth - nearDepth) * p;
+		splits[i] = lerp(uniformSplit, logSplit, cascadeSplitLambda);
+	}
+
+	sceneUbo.cascadeSplits.x = std::numeric_limits<float>::max();
+	sceneUbo.cascadeSplits.y = std::numeric_limits<float>::max();
+	sceneUbo.cascadeSplits.z = std::numeric_limits<float>::max();
+	if (m_shadowCascadeCount > 1)
+		sceneUbo.cascadeSplits.x = splits[1];
+	if (m_shadowCascadeCount > 2)
+		sceneUbo.cascadeSplits.y = splits[2];
+	if (m_shadowCascadeCount > 3)
+		sceneUbo.cascadeSplits.z = splits[3];
+	sceneUbo.cascadeSplits.w = splits[m_shadowCascadeCount];
+#pragma endregion
+
+	const matrix4 lightView = matrix4(lightTr).get_inversed();
+
+	struct LightSpaceBox
+	{
+		vector3 min;
+		vector3 max;
+	};
+
+	std::array<LightSpaceBox, MaxShadowCascadeCount> cascadeBoxes;
+	std::array<LightSpaceBox, MaxShadowCascadeCount> staticBoxes;
+
+#pragma region cascades
+	for (uint32_t i = 0; i < m_shadowCascadeCount; i++)
+	{
+		float t0 = (splits[i] - nearDepth) / (farDepth - nearDepth);
+		float t1 = (splits[i + 1] - nearDepth) / (farDepth - nearDepth);
+
+		std::array<vector3, 8> corners;
+		vector3 center;
+		for (size_t c = 0; c < 4; c++)
+		{
+			corners[c] = vector3::lerp(nearCorners[c], farCorners[c], t0);
+			corners[c + 4] = vector3::lerp(nearCorners[c], farCorners[c], t1);
+			center += corners[c] + corners[c + 4];
+		}
+		center /= 8.0f;
+
+		// a bounding sphere keeps the cascade size constant when the
+		// camera rotates
+		float radius = 0.0f;
+		for (const auto& corner : corners)
+			radius = std::max(radius, center.distance_from(corner));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		vector3 lsCenter = (lightView * vector4(center, 1.0f)).xyz();
+
+		// snap to shadowmap texels to avoid shimmering when the camera moves
+		const float texelSize = 2.0f * radius / float(m_shadowmap.width());
+		const auto texelX = int64_t(std::floor(lsCenter.x / texelSize));
+		const auto texelY = int64_t(std::floor(lsCenter.y / texelSize));
+		lsCenter.x = float(texelX) * texelSize;
+		lsCenter.y = float(texelY) * texelSize;
+
+#pragma region static region
+		// The static depth is rendered for a padded region that stays put
+		// while the cascade moves inside it. The cascade uses the depth
+		// range of the region so that the depth can be copied as is
+		StaticShadowRegion& region = m_staticShadowRegions[i];
+		const auto padding = int64_t(m_staticShadowmapPadding);
+		const float margin = float(padding) * texelSize;
+		const float nearPlane = -lsCenter.z - radius - shadowCasterDistance;
+		const float farPlane = -lsCenter.z + radius;
+
+		const bool lightChanged =
+		    std::memcmp(&region.lightView, &lightView, sizeof(matrix4)) != 0;
+		if (region.radius != radius || lightChanged ||
+		    std::abs(texelX - region.x) > padding ||
+		    std::abs(texelY - region.y) > padding ||
+		    nearPlane < region.nearPlane || farPlane > region.farPlane)
+		{
+			region.lightView = lightView;
+			region.radius = radius;
+			region.x = texelX;
+			region.y = texelY;
+			region.nearPlane = nearPlane - margin;
+			region.farPlane = farPlane + margin;
+			m_staticShadowmapValid[i] = false;
+		}
+
+		// the rows go down in light space
+		m_staticShadowmapOffsets[i] = {
+			int32_t(texelX - region.x + padding),
+			int32_t(region.y - texelY + padding),
+		};
+
+		const float regionX = float(region.x) * texelSize;
+		const float regionY = float(region.y) * texelSize;
+		const float regionRadius = radius + margin;
+
+		matrix4 regionProj = matrix4::orthographic(
+		    regionX - regionRadius, regionX + regionRadius,
+		    regionY + regionRadius, regionY - regionRadius, region.nearPlane,
+		    region.farPlane);
+
+		sceneUbo.shadowViewProj[MaxShadowCascadeCount + i] =
+		    (regionProj * lightView).get_transposed();
+
+		staticBoxes[i].min = { regionX - regionRadius, regionY - regionRadius,
+			                   -region.farPlane };
+		staticBoxes[i].max = { regionX + regionRadius, regionY + regionRadius,
+			                   -region.nearPlane };
+#pragma endregion
+
+		matrix4 cascadeProj = matrix4::orthographic(
+		    lsCenter.x - radius, lsCenter.x + radius, lsCenter.y + radius,
+		    lsCenter.y - radius, region.nearPlane, region.farPlane);
+
+		sceneUbo.shadowViewProj[i] = (cascadeProj * lightView).get_transposed();
+
+		cascadeBoxes[i].min = { lsCenter.x - radius, lsCenter.y - radius,
+			                    -farPlane };
+		cascadeBoxes[i].max = { lsCenter.x + radius, lsCenter.y + radius,
+			                    -nearPlane };
+	}
+#pragma endregion
+
+#pragma region culling
+	for (auto& casters : m_shadowCasters)
+		casters.clear();
+	for (auto& casters : m_staticShadowCasters)
+		casters.clear();
+
+	for (uint32_t index = 0; index < uint32_t(m_sceneObjects.size());
+	     index++)
+	{
+		const auto& sceneObject = m_sceneObjects[index];
+		if (sceneObject->mesh() == nullptr)
+			continue;
+
+		const vector3& bMin = sceneObject->mesh()->boundsMin();
+		const vector3& bMax = sceneObject->mesh()->boundsMax();
+		const matrix4 lightModel = lightView * matrix4(sceneObject->transform);
+
+		LightSpaceBox box;
+		for (uint32_t c = 0; c < 8; c++)
+		{
+			vector3 corner{ (c & 1) ? bMax.x : bMin.x,
+				            (c & 2) ? bMax.y : bMin.y,
+				            (c & 4) ? bMax.z : bMin.z };
+			vector3 lsCorner = (lightModel * vector4(corner, 1.0f)).xyz();
+
+			if (c == 0)
+			{
+				box.min = box.max = lsCorner;
+				continue;
+			}
+
+			box.min.x = std::min(box.min.x, lsCorner.x);
+			box.min.y = std::min(box.min.y, lsCorner.y);
+			box.min.z = std::min(box.min.z, lsCorner.z);
+			box.max.x = std::max(box.max.x, lsCorner.x);
+			box.max.y = std::max(box.max.y, lsCorner.y);
+			box.max.z = std::max(box.max.z, lsCorner.z);
+		}
+
+		auto overlaps = [&box](const LightSpaceBox& other) {
+			return box.max.x >= other.min.x && box.min.x <= other.max.x &&
+			       box.max.y >= other.min.y && box.min.y <= other.max.y &&
+			       box.max.z >= other.min.z && box.min.z <= other.max.z;
+		};
+
+		for (uint32_t i = 0; i < m_shadowCascadeCount; i++)
+		{
+			if (overlaps(cascadeBoxes[i]))
+				m_shadowCasters[i].push_back(index);
+
+			// the static region holds the casters of the whole region
+			if (sceneObject->mobility == SceneObject::Mobility::Static &&
+			    overlaps(staticBoxes[i]))
+				m_staticShadowCasters[i].push_back(index);
+		}
+	}
+#pragma endregion
 }
 
 Scene::SceneUbo::SceneUbo(sdw::ShaderWriter& writer)
@@ -319,8 +1091,8 @@ Scene::SceneUbo::SceneUbo(sdw::ShaderWriter& writer)
 	declMember<sdw::Mat4>("proj");
 	declMember<sdw::Vec3>("viewPos");
 	declMember<sdw::Vec3>("lightPos");
-	declMember<sdw::Mat4>("shadowView");
-	declMember<sdw::Mat4>("shadowProj");
+	declMember<sdw::Mat4>("shadowViewProj", 2 * MaxShadowCascadeCount);
+	declMember<sdw::Vec4>("cascadeSplits");
 	declMember<sdw::Float>("shadowBias");
 	declMember<sdw::Float>("R");
 	declMember<sdw::Float>("sigma");
@@ -334,14 +1106,14 @@ Scene::SceneUbo::SceneUbo(sdw::ShaderWriter& writer)
 }
 
 sdw::Mat4 Scene::SceneUbo::getView() { return getMember<sdw::Mat4>("view"); }
-sdw::Mat4 Scene::SceneUbo::getShadowView()
+sdw::Mat4 Scene::SceneUbo::getProj() { return getMember<sdw::Mat4>("proj"); }
+sdw::Array<sdw::Mat4> Scene::SceneUbo::getShadowViewProj()
 {
-	return getMember<sdw::Mat4>("shadowView");
+	return getMemberArray<sdw::Mat4>("shadowViewProj");
 }
-sdw::Mat4 Scene::SceneUbo::getProj() { return getMember<sdw::Mat4>("proj"); }
-sdw::Mat4 Scene::SceneUbo::getShadowProj()
+sdw::Vec4 Scene::SceneUbo::getCascadeSplits()
 {
-	return getMember<sdw::Mat4>("shadowProj");
+	return getMember<sdw::Vec4>("cascadeSplits");
 }
 sdw::Vec3 Scene::SceneUbo::getViewPos()
 {
@@ -411,4 +1183,22 @@ sdw::UInt Scene::ModelPcb::getMaterialInstanceId()
 {
 	return getMember<sdw::UInt>("materialInstanceId");
 }
+
+Scene::ShadowmapPcb::ShadowmapPcb(sdw::ShaderWriter& writer)
+    : sdw::Pcb(writer, "ShadowmapPCB")
+{
+	declMember<sdw::UInt>("modelId");
+	declMember<sdw::UInt>("cascadeIndex");
+	end();
+}
+
+sdw::UInt Scene::ShadowmapPcb::getModelId()
+{
+	return getMember<sdw::UInt>("modelId");
+}
+
+sdw::UInt Scene::ShadowmapPcb::getCascadeIndex()
+{
+	return getMember<sdw::UInt>("cascadeIndex");
+}
 }  // namespace cdm
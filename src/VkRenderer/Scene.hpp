@@ -6,21 +6,25 @@
 #include "cdm_maths.hpp"
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 namespace cdm
 {
 class CommandBuffer;
+class DepthPyramid;
+class PipelineCompiler;
 class SceneObject;
 
 class Scene final
 {
 public:
 	static constexpr uint32_t MaxSceneObjectCountPerPool = 256;
+	static constexpr uint32_t MaxShadowCascadeCount = 4;
 
 private:
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	std::vector<std::unique_ptr<SceneObject>> m_sceneObjects;
 
@@ -36,9 +40,12 @@ private:
 		vector3 lightPos;
 		float _1 = 0xcccc;
 
-		matrix4 shadowView;
+		/// the cascades, then the regions of their cached static depth
+		std::array<matrix4, 2 * MaxShadowCascadeCount> shadowViewProj;
 
-		matrix4 shadowProj;
+		/// xyz: far view depth of the first three cascades (FLT_MAX when
+		/// unused), w: shadow distance
+		vector4 cascadeSplits;
 
 		float shadowBias;
 		float R;
@@ -64,22 +71,91 @@ private:
 	SceneUboStruct m_sceneUbo;
 	std::vector<ModelUboStruct> m_modelUbo;
 
-	Buffer m_sceneUniformBuffer;
-	Buffer m_modelUniformBuffer;
+	/// one copy per frame in flight, `uploadTransformMatrices` rewrites the
+	/// current frame's while the previous frames may still read theirs
+	std::vector<Buffer> m_sceneUniformBuffers;
+	std::vector<Buffer> m_modelUniformBuffers;
 
 	UniqueDescriptorPool m_descriptorPool;
 	UniqueDescriptorSetLayout m_descriptorSetLayout;
-	Movable<VkDescriptorSet> m_descriptorSet;
+	/// one per frame in flight, see `frameIndex`
+	std::vector<VkDescriptorSet> m_descriptorSets;
 
 	UniqueRenderPass m_shadowmapRenderPass;
-	UniqueFramebuffer m_shadowmapFramebuffer;
-	VkExtent2D m_shadowmapResolution{ 4096, 4096 };
+	VkExtent2D m_shadowmapResolution{ 2048, 2048 };
+	uint32_t m_shadowCascadeCount = 4;
 	Texture2D m_shadowmap;
+	std::vector<UniqueImageView> m_shadowmapCascadeViews;
+	std::vector<UniqueFramebuffer> m_shadowmapFramebuffers;
+
+	/// indices in `m_sceneObjects` of the shadow casters of each cascade
+	std::array<std::vector<uint32_t>, MaxShadowCascadeCount> m_shadowCasters;
+	std::array<std::vector<uint32_t>, MaxShadowCascadeCount>
+	    m_staticShadowCasters;
+
+	/// depth of the static casters only, copied in the shadowmap before
+	/// the dynamic casters are rendered
+	UniqueRenderPass m_staticShadowmapRenderPass;
+	UniqueRenderPass m_cachedShadowmapRenderPass;
+	Texture2D m_staticShadowmap;
+	std::vector<UniqueImageView> m_staticShadowmapCascadeViews;
+	std::vector<UniqueFramebuffer> m_staticShadowmapFramebuffers;
+	std::vector<UniqueFramebuffer> m_cachedShadowmapFramebuffers;
+	std::array<bool, MaxShadowCascadeCount> m_staticShadowmapValid{};
+
+	/// Light-space region the static depth of a cascade covers, larger than
+	/// the cascade and on the same texel grid so that the cascade can be
+	/// copied out of it while the camera moves
+	struct StaticShadowRegion
+	{
+		matrix4 lightView = matrix4::identity();
+		/// radius of the cascade, 0 before the first frame
+		float radius = 0.0f;
+		/// center, in texels of the cascade
+		int64_t x = 0;
+		int64_t y = 0;
+		float nearPlane = 0.0f;
+		float farPlane = 0.0f;
+	};
+	std::array<StaticShadowRegion, MaxShadowCascadeCount>
+	    m_staticShadowRegions;
+	/// texels around the cascades in the allocated static shadowmap
+	uint32_t m_staticShadowmapPadding = 0;
+	/// where each cascade is copied from in its static region
+	std::array<VkOffset2D, MaxShadowCascadeCount> m_staticShadowmapOffsets{};
+	std::vector<matrix4> m_previousModels;
+	std::vector<bool> m_previousStatic;
+
+	vector3 m_viewPosition;
+	/// indices in `m_sceneObjects` sorted front-to-back
+	std::vector<uint32_t> m_drawOrder;
+
+	Movable<DepthPyramid*> m_depthPyramid;
+	Movable<PipelineCompiler*> m_pipelineCompiler;
+	uint64_t m_shaderGeneration = 0;
+	matrix4 m_viewProj = matrix4::identity();
+	/// world-space bounds and indirect draw command of each object, indexed
+	/// like `m_sceneObjects`, one buffer per frame in flight
+	std::vector<Buffer> m_occlusionBoundsBuffers;
+	std::vector<Buffer> m_drawCommandsBuffers;
+	/// number of draw commands written by `cullOcclusion` for the next
+	/// `draw`
+	uint32_t m_indirectDrawCount = 0;
 
 	/// TODO: `RenderQueue`s
 
+	void updateShadowCascades(const transform3d& cameraTr,
+	                          const matrix4& proj, const transform3d& lightTr,
+	                          SceneUboStruct& sceneUbo);
+	/// Index of the per-frame resources of the frame being recorded
+	size_t frameIndex() const;
+	/// Allocates the static shadowmap while `shadowmapCaching` is set, with
+	/// `shadowmapCachePadding`, and releases it otherwise
+	void updateStaticShadowmap();
+
 public:
-	Scene(RenderWindow& renderWindow);
+	Scene(RenderContext& renderContext, uint32_t shadowmapResolution = 2048,
+	      uint32_t shadowCascadeCount = 4);
 	Scene(const Scene&) = delete;
 	Scene(Scene&&) = default;
 	~Scene() = default;
@@ -88,6 +164,12 @@ public:
 	Scene& operator=(Scene&&) = default;
 
 	float shadowBias = -0.4096f;
+	/// view depth covered by the shadow cascades
+	float shadowDistance = 150.0f;
+	/// blend between uniform (0) and logarithmic (1) cascade splits
+	float cascadeSplitLambda = 0.75f;
+	/// how far behind a cascade (towards the light) casters are rendered
+	float shadowCasterDistance = 500.0f;
 	float R = 2.0f;
 	float sigma = 0.0f;
 	float roughness = 0.1f;
@@ -101,14 +183,84 @@ public:
 	{
 		return m_descriptorSetLayout;
 	}
-	const VkDescriptorSet& descriptorSet() const { return m_descriptorSet; }
+	/// Set of the frame being recorded
+	const VkDescriptorSet& descriptorSet() const;
 
 	SceneObject& instantiateSceneObject();
 
 	void removeSceneObject(SceneObject& sceneObject);
 
+	/// Static casters are rendered once in a cached depth layer that is
+	/// copied in the shadowmap each frame, only dynamic casters are
+	/// re-rendered on top of it. The layer covers `shadowmapCachePadding`
+	/// more texels on each side: it is only re-rendered when a cascade
+	/// moves past it, when the light or the cascade sizes change, or when
+	/// a static object changes. It is allocated on the first frame drawn
+	/// with caching and released when caching is disabled
+	bool shadowmapCaching = true;
+	/// A quarter of the shadowmap resolution by default, the layer is
+	/// reallocated when it changes
+	uint32_t shadowmapCachePadding = 0;
+
+	void invalidateShadowmapCache();
+
 	void drawShadowmapPass(CommandBuffer& cb);
 
+	/// Fill the depth buffer with a depth-only pass before shading, the
+	/// main pass then uses an `EQUAL` depth test so that every pixel is
+	/// shaded once
+	bool depthPrepass = false;
+
+	enum class OcclusionCulling
+	{
+		Disabled,
+		/// objects are tested against a coarse level of the depth pyramid
+		/// read back to host memory and are not recorded when occluded
+		Cpu,
+		/// a compute pass sets the instance count of the indirect draw of
+		/// occluded objects to 0
+		Gpu,
+	};
+
+	/// Occlusion culling against the depth pyramid of the previous frame,
+	/// requires a `DepthPyramid` to be set
+	OcclusionCulling occlusionCulling = OcclusionCulling::Disabled;
+
+	/// `depthPyramid` must be built from the depth buffer `draw` renders
+	/// to, nullptr disables occlusion culling
+	void setDepthPyramid(DepthPyramid* depthPyramid);
+
+	/// Pipelines of new objects and materials are then compiled on the
+	/// worker threads of `pipelineCompiler`, objects are not drawn until
+	/// their pipeline is ready. nullptr compiles them on first draw
+	void setPipelineCompiler(PipelineCompiler* pipelineCompiler) noexcept
+	{
+		m_pipelineCompiler = pipelineCompiler;
+	}
+	PipelineCompiler* pipelineCompiler() const noexcept
+	{
+		return m_pipelineCompiler;
+	}
+
+	/// Incremented by `invalidateShaders`, every object pipeline embeds the
+	/// scene, model and push constant blocks so all of them are rebuilt
+	uint64_t shaderGeneration() const noexcept { return m_shaderGeneration; }
+	void invalidateShaders() noexcept { m_shaderGeneration++; }
+
+	/// Frame boundary of the shader reloads: swaps in the pipelines rebuilt
+	/// since the last call for invalidated shaders, must be called before
+	/// recording a frame. Replaced pipelines are kept alive while the
+	/// frames in flight may still use them
+	void applyShaderReloads();
+
+	/// Records the GPU occlusion culling pass, must be called outside of a
+	/// render pass before `draw`
+	void cullOcclusion(CommandBuffer& cb);
+
+	/// Records the depth pyramid build, must be called after the render
+	/// pass `draw` was recorded in
+	void buildDepthPyramid(CommandBuffer& cb);
+
 	void draw(CommandBuffer& cb, VkRenderPass renderPass,
 	          std::optional<VkViewport> viewport = std::nullopt,
 	          std::optional<VkRect2D> scissor = std::nullopt);
@@ -119,9 +271,9 @@ public:
 		SceneUbo(sdw::ShaderWriter& writer);
 
 		sdw::Mat4 getView();
-		sdw::Mat4 getShadowView();
 		sdw::Mat4 getProj();
-		sdw::Mat4 getShadowProj();
+		sdw::Array<sdw::Mat4> getShadowViewProj();
+		sdw::Vec4 getCascadeSplits();
 		sdw::Float getShadowBias();
 		sdw::Vec3 getViewPos();
 		sdw::Vec3 getLightPos();
@@ -152,6 +304,15 @@ public:
 		sdw::UInt getMaterialInstanceId();
 	};
 
+	class ShadowmapPcb : private sdw::Pcb
+	{
+	public:
+		ShadowmapPcb(sdw::ShaderWriter& writer);
+
+		sdw::UInt getModelId();
+		sdw::UInt getCascadeIndex();
+	};
+
 	// static sdw::Ubo buildSceneUbo(sdw::ShaderWriter& writer, uint32_t
 	// binding,
 	//        uint32_t set);
@@ -163,9 +324,14 @@ public:
 	                             const matrix4& proj,
 	                             const transform3d& lightTr);
 
-	Buffer& sceneUniformBuffer() noexcept { return m_sceneUniformBuffer; }
-	Buffer& modelUniformBuffer() noexcept { return m_modelUniformBuffer; }
+	/// Buffers of the frame being recorded
+	Buffer& sceneUniformBuffer();
+	Buffer& modelUniformBuffer();
 
 	Texture2D& shadowmap() { return m_shadowmap; }
+	uint32_t shadowCascadeCount() const noexcept
+	{
+		return m_shadowCascadeCount;
+	}
 };
 }  // namespace cdm
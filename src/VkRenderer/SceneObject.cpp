@@ -1,98 +1,374 @@
 #include "SceneObject.hpp"
 
 #include "CommandBuffer.hpp"
+#include "CpuProfiler.hpp"
 #include "Material.hpp"
-#include "RenderWindow.hpp"
+#include "PipelineCompiler.hpp"
+#include "RenderContext.hpp"
 #include "Scene.hpp"
+#include "SpirvOptimizer.hpp"
 #include "StandardMesh.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 namespace cdm
 {
-SceneObject::Pipeline::Pipeline(Scene& s, StandardMesh& mesh,
-                                MaterialInterface& material,
-                                VkRenderPass renderPass)
-    : scene(&s),
-      mesh(&mesh),
-      material(&material),
-      renderPass(renderPass)
+namespace
 {
-	auto& rw = material.material().renderWindow();
-	auto& vk = rw.device();
+/// Returns the pipeline of `key`, created by `create` on the first call.
+/// With a `compiler` the creation runs on its workers and nullptr is
+/// returned until it completes.
+/// A pipeline built before `shaderGeneration` is still returned while its
+/// rebuild compiles, `SceneObject::applyShaderReloads` swaps it in. Without
+/// a compiler it is rebuilt right away and the old one goes to `retire`
+template <typename Key, typename P, typename Hash, typename Create,
+          typename Retire>
+P* findOrCompilePipeline(
+    std::unordered_map<Key, P, Hash>& pipelines,
+    std::unordered_map<Key, std::future<P>, Hash>& pendingPipelines,
+    const Key& key, uint64_t shaderGeneration, PipelineCompiler* compiler,
+    Create&& create, Retire&& retire)
+{
+	auto foundPipeline = pipelines.find(key);
+	if (foundPipeline != pipelines.end())
+	{
+		P& pipeline = foundPipeline->second;
+		if (pipeline.shaderGeneration == shaderGeneration)
+			return &pipeline;
 
-#pragma region vertexShader
+		if (compiler == nullptr)
+		{
+			retire(pipeline);
+			pipeline = create();
+		}
+		else if (pendingPipelines.count(key) == 0)
+		{
+			pendingPipelines.emplace(
+			    key, compiler->submit(std::forward<Create>(create)));
+		}
+		return &pipeline;
+	}
+
+	if (compiler == nullptr)
+		return &pipelines.emplace(key, create()).first->second;
+
+	auto foundPending = pendingPipelines.find(key);
+	if (foundPending == pendingPipelines.end())
 	{
-		using namespace sdw;
-		VertexWriter writer;
+		pendingPipelines.emplace(key,
+		                         compiler->submit(std::forward<Create>(create)));
+		return nullptr;
+	}
 
-		Scene::SceneUbo sceneUbo(writer);
-		Scene::ModelUbo modelUbo(writer);
-		Scene::ModelPcb modelPcb(writer);
+	if (!PipelineCompiler::ready(foundPending->second))
+		return nullptr;
 
-		auto shaderVertexInput = mesh.shaderVertexInput(writer);
+	auto it = pipelines.emplace(key, foundPending->second.get()).first;
+	pendingPipelines.erase(foundPending);
+	return &it->second;
+}
 
-		auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
-		auto fragUV = writer.declOutput<Vec2>("fragUV", 1);
-		auto fragNormal = writer.declOutput<Vec3>("fragNormal", 2);
-		auto fragTangent = writer.declOutput<Vec3>("fragTangent", 3);
-		auto fragDistance = writer.declOutput<sdw::Float>("fragDistance", 4);
+/// Fixed-function state of the pipelines drawing into the main render pass.
+/// They only differ by their shaders, vertex input, color writes and depth
+/// test. Holds pointers to itself, so it is neither copied nor moved
+struct MainPassPipelineState
+{
+	vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+	VkViewport viewport{};
+	VkRect2D scissor{};
+	vk::PipelineViewportStateCreateInfo viewportState;
+	vk::PipelineRasterizationStateCreateInfo rasterizer;
+	vk::PipelineMultisampleStateCreateInfo multisampling;
+	std::array<VkPipelineColorBlendAttachmentState, 4> colorBlendAttachments{};
+	vk::PipelineColorBlendStateCreateInfo colorBlending;
+	vk::PipelineDepthStencilStateCreateInfo depthStencil;
+	std::array<VkDynamicState, 2> dynamicStates{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR,
+	};
+	vk::PipelineDynamicStateCreateInfo dynamicState;
 
-		auto out = writer.getOut();
+	/// `colorWriteMask` applies to the color, object ID, normal-depth and
+	/// position attachments alike
+	explicit MainPassPipelineState(VkColorComponentFlags colorWriteMask)
+	{
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		// inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+		inputAssembly.primitiveRestartEnable = false;
+
+		/// TODO get from render pass
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = float(1280);
+		viewport.height = float(720);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		scissor.offset = { 0, 0 };
+		scissor.extent.width = 1280;
+		scissor.extent.height = 720;
+
+		viewportState.viewportCount = 1;
+		viewportState.pViewports = &viewport;
+		viewportState.scissorCount = 1;
+		viewportState.pScissors = &scissor;
+
+		rasterizer.depthClampEnable = false;
+		rasterizer.rasterizerDiscardEnable = false;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		// rasterizer.polygonMode = VK_POLYGON_MODE_LINE;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizer.depthBiasEnable = false;
+		rasterizer.depthBiasConstantFactor = 0.0f;
+		rasterizer.depthBiasClamp = 0.0f;
+		rasterizer.depthBiasSlopeFactor = 0.0f;
+
+		/// TODO get from render pass
+		multisampling.sampleShadingEnable = false;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_4_BIT;
+		multisampling.minSampleShading = 1.0f;
+		multisampling.pSampleMask = nullptr;
+		multisampling.alphaToCoverageEnable = false;
+		multisampling.alphaToOneEnable = false;
+
+		/// TODO get from render pass and material
+		for (VkPipelineColorBlendAttachmentState& attachment :
+		     colorBlendAttachments)
+		{
+			attachment.colorWriteMask = colorWriteMask;
+			attachment.blendEnable = false;
+			attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+			attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+			attachment.colorBlendOp = VK_BLEND_OP_ADD;
+			attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+			attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		}
 
-		auto materialVertexShaderBuildData =
-		    material.material().instantiateVertexShaderBuildData();
-		auto materialVertexFunction = material.material().vertexFunction(
-		    writer, materialVertexShaderBuildData.get());
+		// colorBlendAttachment.blendEnable = true;
+		// colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		// colorBlendAttachment.dstColorBlendFactor =
+		//    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		// colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		// colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		// colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		// colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		colorBlending.logicOpEnable = false;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = uint32_t(colorBlendAttachments.size());
+		colorBlending.pAttachments = colorBlendAttachments.data();
+		colorBlending.blendConstants[0] = 0.0f;
+		colorBlending.blendConstants[1] = 0.0f;
+		colorBlending.blendConstants[2] = 0.0f;
+		colorBlending.blendConstants[3] = 0.0f;
+
+		depthStencil.depthTestEnable = true;
+		depthStencil.depthWriteEnable = true;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStencil.depthBoundsTestEnable = false;
+		depthStencil.minDepthBounds = 0.0f;  // Optional
+		depthStencil.maxDepthBounds = 1.0f;  // Optional
+		depthStencil.stencilTestEnable = false;
+		// depthStencil.front; // Optional
+		// depthStencil.back; // Optional
+
+		dynamicState.dynamicStateCount = uint32_t(dynamicStates.size());
+		dynamicState.pDynamicStates = dynamicStates.data();
+	}
 
-		writer.implementMain([&]() {
-			auto model = modelUbo.getModel()[modelPcb.getModelId()];
-			auto view = sceneUbo.getView();
-			auto proj = sceneUbo.getProj();
+	MainPassPipelineState(const MainPassPipelineState&) = delete;
+	MainPassPipelineState& operator=(const MainPassPipelineState&) = delete;
 
-			fragPosition =
-			    (model * vec4(shaderVertexInput.inPosition, 1.0_f)).xyz();
-			fragUV = shaderVertexInput.inUV;
+	/// Points the fixed-function state of `info` at this one
+	void apply(vk::GraphicsPipelineCreateInfo& info) const
+	{
+		info.pInputAssemblyState = &inputAssembly;
+		info.pViewportState = &viewportState;
+		info.pRasterizationState = &rasterizer;
+		info.pMultisampleState = &multisampling;
+		info.pDepthStencilState = &depthStencil;
+		info.pColorBlendState = &colorBlending;
+		info.pDynamicState = &dynamicState;
+		info.subpass = 0;
+		info.basePipelineHandle = nullptr;
+		info.basePipelineIndex = -1;
+	}
+};
+}  // namespace
 
-			Locale(model3, mat3(vec3(model[0][0], model[0][1], model[0][2]),
-			                    vec3(model[1][0], model[1][1], model[1][2]),
-			                    vec3(model[2][0], model[2][1], model[2][2])));
+void SceneObject::writeVertexShader(sdw::VertexWriter& writer,
+                                    Material& material)
+{
+	using namespace sdw;
 
-			Locale(normalMatrix, transpose(inverse(model3)));
-			// Locale(normalMatrix, transpose((model3)));
+	Scene::SceneUbo sceneUbo(writer);
+	Scene::ModelUbo modelUbo(writer);
+	Scene::ModelPcb modelPcb(writer);
 
-			fragNormal = shaderVertexInput.inNormal;
+	auto shaderVertexInput = StandardMesh::shaderVertexInput(writer);
 
-			materialVertexFunction(fragPosition, fragNormal);
+	auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
+	auto fragUV = writer.declOutput<Vec2>("fragUV", 1);
+	auto fragNormal = writer.declOutput<Vec3>("fragNormal", 2);
+	auto fragTangent = writer.declOutput<Vec3>("fragTangent", 3);
+	auto fragDistance = writer.declOutput<sdw::Float>("fragDistance", 4);
 
-			fragNormal = normalize(normalMatrix * fragNormal);
-			fragTangent =
-			    normalize(normalMatrix * shaderVertexInput.inTangent);
+	auto out = writer.getOut();
 
-			// fragNormal = normalize((model * vec4(fragNormal, 0.0_f)).xyz());
-			// fragTangent = normalize(
-			//    (model * vec4(shaderVertexInput.inTangent, 0.0_f)).xyz());
+	auto materialVertexShaderBuildData =
+	    material.instantiateVertexShaderBuildData();
+	auto materialVertexFunction = material.vertexFunction(
+	    writer, materialVertexShaderBuildData.get());
 
-			fragTangent = normalize(fragTangent -
-			                        dot(fragTangent, fragNormal) * fragNormal);
+	writer.implementMain([&]() {
+		auto model = modelUbo.getModel()[modelPcb.getModelId()];
+		auto view = sceneUbo.getView();
+		auto proj = sceneUbo.getProj();
 
-			// Locale(B, cross(fragNormal, fragTangent));
+		fragPosition =
+		    (model * vec4(shaderVertexInput.inPosition, 1.0_f)).xyz();
+		fragUV = shaderVertexInput.inUV;
 
-			// Locale(TBN, transpose(mat3(fragTangent, B, fragNormal)));
+		Locale(model3, mat3(vec3(model[0][0], model[0][1], model[0][2]),
+		                    vec3(model[1][0], model[1][1], model[1][2]),
+		                    vec3(model[2][0], model[2][1], model[2][2])));
 
-			// fragTanLightPos = TBN * sceneUbo.getLightPos();
-			// fragTanViewPos = TBN * sceneUbo.getViewPos();
-			// fragTanFragPos = TBN * fragPosition;
+		Locale(normalMatrix, transpose(inverse(model3)));
+		// Locale(normalMatrix, transpose((model3)));
 
-			fragDistance =
-			    (view * model * vec4(shaderVertexInput.inPosition, 1.0_f)).z();
+		fragNormal = shaderVertexInput.inNormal;
 
-			out.vtx.position = proj * view * model *
-			                   vec4(shaderVertexInput.inPosition, 1.0_f);
-		});
+		materialVertexFunction(fragPosition, fragNormal);
 
-		std::vector<uint32_t> bytecode =
-		    spirv::serialiseSpirv(writer.getShader());
+		fragNormal = normalize(normalMatrix * fragNormal);
+		fragTangent =
+		    normalize(normalMatrix * shaderVertexInput.inTangent);
+
+		// fragNormal = normalize((model * vec4(fragNormal, 0.0_f)).xyz());
+		// fragTangent = normalize(
+		//    (model * vec4(shaderVertexInput.inTangent, 0.0_f)).xyz());
+
+		fragTangent = normalize(fragTangent -
+		                        dot(fragTangent, fragNormal) * fragNormal);
+
+		// Locale(B, cross(fragNormal, fragTangent));
+
+		// Locale(TBN, transpose(mat3(fragTangent, B, fragNormal)));
+
+		// fragTanLightPos = TBN * sceneUbo.getLightPos();
+		// fragTanViewPos = TBN * sceneUbo.getViewPos();
+		// fragTanFragPos = TBN * fragPosition;
+
+		fragDistance =
+		    (view * model * vec4(shaderVertexInput.inPosition, 1.0_f)).z();
+
+		out.vtx.position = proj * view * model *
+		                   vec4(shaderVertexInput.inPosition, 1.0_f);
+	});
+}
+
+void SceneObject::writeFragmentShader(sdw::FragmentWriter& writer,
+                                      Material& material,
+                                      PbrShadingModel& shadingModel,
+                                      uint32_t shadingFeatures)
+{
+	using namespace sdw;
+
+	Scene::SceneUbo sceneUbo(writer);
+	Scene::ModelPcb modelPcb(writer);
+
+	auto fragPosition = writer.declInput<sdw::Vec3>("fragPosition", 0);
+	auto fragUV = writer.declInput<sdw::Vec2>("fragUV", 1);
+	auto fragNormal = writer.declInput<sdw::Vec3>("fragNormal", 2);
+	auto fragTangent = writer.declInput<sdw::Vec3>("fragTangent", 3);
+	auto fragDistance = writer.declInput<sdw::Float>("fragDistance", 4);
+
+	auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
+	auto fragID = writer.declOutput<UInt>("fragID", 1);
+	auto fragNormalDepth = writer.declOutput<Vec4>("fragNormalDepth", 2);
+	auto fragPos = writer.declOutput<Vec3>("fragPos", 3);
+
+	auto fragmentShaderBuildData =
+	    material.instantiateFragmentShaderBuildData();
+	auto materialFragmentFunction =
+	    material.fragmentFunction(writer, fragmentShaderBuildData.get());
+
+	auto shadingModelFragmentShaderBuildData =
+	    shadingModel.instantiateFragmentShaderBuildData();
+	auto combinedMaterialFragmentFunction =
+	    shadingModel.combinedMaterialFragmentFunction(
+	        writer, materialFragmentFunction,
+	        shadingModelFragmentShaderBuildData.get(), sceneUbo,
+	        shadingFeatures);
+
+	writer.implementMain([&]() {
+		Locale(materialInstanceId, modelPcb.getMaterialInstanceId() + 1_u);
+		materialInstanceId -= 1_u;
+		Locale(normal, normalize(fragNormal));
+		Locale(tangent, normalize(fragTangent));
+		fragColor = combinedMaterialFragmentFunction(
+		    materialInstanceId, fragPosition, fragUV, normal, tangent);
+		fragID = modelPcb.getModelId();
+		fragNormalDepth.xyz() = fragNormal;
+		fragNormalDepth.w() = fragDistance;
+		fragPos = fragPosition;
+	});
+}
+
+VkPipelineLayout SceneObject::sharedPipelineLayout(Scene& scene,
+                                                  MaterialInterface& material)
+{
+	auto& vk = material.material().renderContext().device();
+
+	VkPushConstantRange pcRange{};
+	pcRange.size =
+	    uint32_t(std::max(sizeof(PcbStruct), sizeof(ShadowmapPcbStruct)));
+	pcRange.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+	std::array descriptorSetLayouts{
+		scene.descriptorSetLayout(),
+		material.material().shadingModel().m_descriptorSetLayout.get(),
+		material.material().descriptorSetLayout(),
+		material.material().shadingModel().textureTable().descriptorSetLayout(),
+	};
+
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+	pipelineLayoutInfo.setLayoutCount = uint32_t(descriptorSetLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pcRange;
+
+	return vk.layoutCache().pipelineLayout(pipelineLayoutInfo);
+}
+
+SceneObject::Pipeline::Pipeline(Scene& s, StandardMesh& mesh,
+                                MaterialInterface& material,
+                                VkRenderPass renderPass,
+                                uint32_t shadingFeatures,
+                                uint64_t shaderGeneration, bool depthEqual)
+    : scene(&s),
+      mesh(&mesh),
+      material(&material),
+      renderPass(renderPass),
+      shadingFeatures(shadingFeatures),
+      shaderGeneration(shaderGeneration)
+{
+	CpuProfiler::Zone zone("build pipeline");
+
+	auto& rw = material.material().renderContext();
+	auto& vk = rw.device();
+
+#pragma region vertexShader
+	{
+		sdw::VertexWriter writer;
+		writeVertexShader(writer, material.material());
+
+		std::vector<uint32_t> bytecode = optimizeSpirv(
+		    makePositionInvariant(spirv::serialiseSpirv(writer.getShader())));
 
 		vk::ShaderModuleCreateInfo createInfo;
 		createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -110,54 +386,24 @@ SceneObject::Pipeline::Pipeline(Scene& s, StandardMesh& mesh,
 
 #pragma region fragmentShader
 	{
-		using namespace sdw;
-		FragmentWriter writer;
+		// features toggled by specialization constants share their SPIR-V
+		uint32_t variant =
+		    shadingFeatures & ~PbrShadingModel::SpecializedShadingFeatures;
+		std::shared_ptr<const std::vector<uint32_t>> cachedBytecode =
+		    material.material().fragmentShader(variant, shaderGeneration);
 
-		Scene::SceneUbo sceneUbo(writer);
-		Scene::ModelPcb modelPcb(writer);
-
-		auto fragPosition = writer.declInput<sdw::Vec3>("fragPosition", 0);
-		auto fragUV = writer.declInput<sdw::Vec2>("fragUV", 1);
-		auto fragNormal = writer.declInput<sdw::Vec3>("fragNormal", 2);
-		auto fragTangent = writer.declInput<sdw::Vec3>("fragTangent", 3);
-		auto fragDistance = writer.declInput<sdw::Float>("fragDistance", 4);
-
-		auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
-		auto fragID = writer.declOutput<UInt>("fragID", 1);
-		auto fragNormalDepth = writer.declOutput<Vec4>("fragNormalDepth", 2);
-		auto fragPos = writer.declOutput<Vec3>("fragPos", 3);
-
-		auto fragmentShaderBuildData =
-		    material.material().instantiateFragmentShaderBuildData();
-		auto materialFragmentFunction = material.material().fragmentFunction(
-		    writer, fragmentShaderBuildData.get());
-
-		auto shadingModelFragmentShaderBuildData =
-		    material.material()
-		        .shadingModel()
-		        .instantiateFragmentShaderBuildData();
-		auto combinedMaterialFragmentFunction =
-		    material.material()
-		        .shadingModel()
-		        .combinedMaterialFragmentFunction(
-		            writer, materialFragmentFunction,
-		            shadingModelFragmentShaderBuildData.get(), sceneUbo);
-
-		writer.implementMain([&]() {
-			Locale(materialInstanceId, modelPcb.getMaterialInstanceId() + 1_u);
-			materialInstanceId -= 1_u;
-			Locale(normal, normalize(fragNormal));
-			Locale(tangent, normalize(fragTangent));
-			fragColor = combinedMaterialFragmentFunction(
-			    materialInstanceId, fragPosition, fragUV, normal, tangent);
-			fragID = modelPcb.getModelId();
-			fragNormalDepth.xyz() = fragNormal;
-			fragNormalDepth.w() = fragDistance;
-			fragPos = fragPosition;
-		});
-
-		std::vector<uint32_t> bytecode =
-		    spirv::serialiseSpirv(writer.getShader());
+		if (cachedBytecode == nullptr)
+		{
+			sdw::FragmentWriter writer;
+			writeFragmentShader(writer, material.material(),
+			                    material.material().shadingModel(),
+			                    shadingFeatures);
+
+			cachedBytecode = material.material().setFragmentShader(
+			    variant, shaderGeneration,
+			    optimizeSpirv(spirv::serialiseSpirv(writer.getShader())));
+		}
+		const std::vector<uint32_t>& bytecode = *cachedBytecode;
 
 		vk::ShaderModuleCreateInfo createInfo;
 		createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -174,33 +420,7 @@ SceneObject::Pipeline::Pipeline(Scene& s, StandardMesh& mesh,
 #pragma endregion
 
 #pragma region pipeline layout
-	VkPushConstantRange pcRange{};
-	pcRange.size = sizeof(PcbStruct);
-	pcRange.stageFlags =
-	    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	std::array descriptorSetLayouts{
-		scene.get()->descriptorSetLayout(),
-		material.material().shadingModel().m_descriptorSetLayout.get(),
-		material.material().descriptorSetLayout(),
-	};
-
-	vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
-	pipelineLayoutInfo.setLayoutCount = uint32_t(descriptorSetLayouts.size());
-	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-	// pipelineLayoutInfo.setLayoutCount = 0;
-	// pipelineLayoutInfo.pSetLayouts = nullptr;
-	pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges = &pcRange;
-	// pipelineLayoutInfo.pushConstantRangeCount = 0;
-	// pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-	pipelineLayout = vk.create(pipelineLayoutInfo);
-	if (!pipelineLayout)
-	{
-		std::cerr << "error: failed to create pipeline layout" << std::endl;
-		abort();
-	}
+	pipelineLayout = sharedPipelineLayout(*scene.get(), material);
 #pragma endregion
 
 #pragma region pipeline
@@ -209,183 +429,195 @@ SceneObject::Pipeline::Pipeline(Scene& s, StandardMesh& mesh,
 	vertShaderStageInfo.module = vertexModule;
 	vertShaderStageInfo.pName = "main";
 
+	auto specializationData =
+	    PbrShadingModel::specializationData(shadingFeatures);
+	std::array specializationEntries{
+		VkSpecializationMapEntry{ PbrShadingModel::ReceiveShadowsConstantId,
+		                          0, sizeof(uint32_t) },
+		VkSpecializationMapEntry{
+		    PbrShadingModel::ImageBasedLightingConstantId,
+		    uint32_t(sizeof(uint32_t)), sizeof(uint32_t) },
+	};
+
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = uint32_t(specializationEntries.size());
+	specializationInfo.pMapEntries = specializationEntries.data();
+	specializationInfo.dataSize =
+	    specializationData.size() * sizeof(*specializationData.data());
+	specializationInfo.pData = specializationData.data();
+
 	vk::PipelineShaderStageCreateInfo fragShaderStageInfo;
 	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragShaderStageInfo.module = fragmentModule;
 	fragShaderStageInfo.pName = "main";
+	fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
 	std::array shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
 
 	auto vertexInputState = mesh.vertexInputState();
 
-	vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	// inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
-	inputAssembly.primitiveRestartEnable = false;
+	MainPassPipelineState state(
+	    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+	    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+	// both positions are invariant, the pre-pass depth is matched exactly
+	state.depthStencil.depthWriteEnable = !depthEqual;
+	state.depthStencil.depthCompareOp =
+	    depthEqual ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
 
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	/// TODO get from render pass
-	viewport.width = float(1280);
-	viewport.height = float(720);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
+	vk::GraphicsPipelineCreateInfo pipelineInfo;
+	pipelineInfo.stageCount = uint32_t(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pVertexInputState = &vertexInputState.vertexInputInfo;
+	state.apply(pipelineInfo);
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
 
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	/// TODO get from render pass
-	scissor.extent.width = 1280;
-	scissor.extent.height = 720;
+	pipeline = vk.create(pipelineInfo);
+	if (!pipeline)
+	{
+		std::cerr << "error: failed to create graphics pipeline" << std::endl;
+		abort();
+	}
+#pragma endregion
+}
 
-	vk::PipelineViewportStateCreateInfo viewportState;
-	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
-	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+void SceneObject::Pipeline::bindPipeline(CommandBuffer& cb)
+{
+	cb.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+}
 
-	vk::PipelineRasterizationStateCreateInfo rasterizer;
-	rasterizer.depthClampEnable = false;
-	rasterizer.rasterizerDiscardEnable = false;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-	// rasterizer.polygonMode = VK_POLYGON_MODE_LINE;
-	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-	rasterizer.depthBiasEnable = false;
-	rasterizer.depthBiasConstantFactor = 0.0f;
-	rasterizer.depthBiasClamp = 0.0f;
-	rasterizer.depthBiasSlopeFactor = 0.0f;
+void SceneObject::Pipeline::bindDescriptorSet(CommandBuffer& cb)
+{
+	std::array<VkDescriptorSet, 4> descriptorSets{
+		scene.get()->descriptorSet(),
+		material.get()->material().shadingModel().m_descriptorSet,
+		material.get()->material().descriptorSet(),
+		material.get()->material().shadingModel().textureTable().descriptorSet(),
+	};
+	cb.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
+	                      uint32_t(descriptorSets.size()),
+	                      descriptorSets.data());
+}
 
-	/// TODO get from render pass
-	vk::PipelineMultisampleStateCreateInfo multisampling;
-	multisampling.sampleShadingEnable = false;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_4_BIT;
-	multisampling.minSampleShading = 1.0f;
-	multisampling.pSampleMask = nullptr;
-	multisampling.alphaToCoverageEnable = false;
-	multisampling.alphaToOneEnable = false;
+void SceneObject::Pipeline::draw(CommandBuffer& cb,
+                                 std::optional<IndirectDraw> indirect)
+{
+	if (indirect.has_value())
+		mesh.get()->drawIndirect(cb, indirect->buffer, indirect->offset);
+	else
+		mesh.get()->draw(cb);
+}
 
-	/// TODO get from render pass and material
-	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-	colorBlendAttachment.colorWriteMask =
-	    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-	    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = false;
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+SceneObject::DepthPrepassPipeline::DepthPrepassPipeline(
+    Scene& s, StandardMesh& mesh, MaterialInterface& material,
+    VkRenderPass renderPass, uint64_t shaderGeneration)
+    : scene(&s),
+      mesh(&mesh),
+      material(&material),
+      renderPass(renderPass),
+      shaderGeneration(shaderGeneration)
+{
+	CpuProfiler::Zone zone("build depth prepass pipeline");
 
-	// colorBlendAttachment.blendEnable = true;
-	// colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-	// colorBlendAttachment.dstColorBlendFactor =
-	//    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	// colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	// colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	// colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	// colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	auto& rw = material.material().renderContext();
+	auto& vk = rw.device();
 
-	/// TODO get from render pass and material
-	VkPipelineColorBlendAttachmentState objectIDBlendAttachment = {};
-	objectIDBlendAttachment.colorWriteMask =
-	    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-	    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	objectIDBlendAttachment.blendEnable = false;
-	objectIDBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	objectIDBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-	objectIDBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	objectIDBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	objectIDBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	objectIDBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+#pragma region vertexShader
+	{
+		using namespace sdw;
+		VertexWriter writer;
 
-	VkPipelineColorBlendAttachmentState normalDepthBlendAttachment = {};
-	normalDepthBlendAttachment.colorWriteMask =
-	    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-	    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	normalDepthBlendAttachment.blendEnable = false;
-	normalDepthBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	normalDepthBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-	normalDepthBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	normalDepthBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	normalDepthBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	normalDepthBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-	VkPipelineColorBlendAttachmentState positionhBlendAttachment = {};
-	positionhBlendAttachment.colorWriteMask =
-	    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-	    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	positionhBlendAttachment.blendEnable = false;
-	positionhBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	positionhBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-	positionhBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	positionhBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	positionhBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	positionhBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		Scene::SceneUbo sceneUbo(writer);
+		Scene::ModelUbo modelUbo(writer);
+		Scene::ModelPcb modelPcb(writer);
 
-	// colorHDRBlendAttachment.blendEnable = true;
-	// colorHDRBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-	// colorHDRBlendAttachment.dstColorBlendFactor =
-	//    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	// colorHDRBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	// colorHDRBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	// colorHDRBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	// colorHDRBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		auto inPosition = writer.declInput<Vec4>("inPosition", 0);
 
-	std::array colorBlendAttachments{ colorBlendAttachment,
-		                              objectIDBlendAttachment,
-		                              normalDepthBlendAttachment,
-		                              positionhBlendAttachment };
+		auto out = writer.getOut();
 
-	/// TODO get from render pass
-	vk::PipelineColorBlendStateCreateInfo colorBlending;
-	colorBlending.logicOpEnable = false;
-	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = uint32_t(colorBlendAttachments.size());
-	colorBlending.pAttachments = colorBlendAttachments.data();
-	colorBlending.blendConstants[0] = 0.0f;
-	colorBlending.blendConstants[1] = 0.0f;
-	colorBlending.blendConstants[2] = 0.0f;
-	colorBlending.blendConstants[3] = 0.0f;
+		writer.implementMain([&]() {
+			auto model = modelUbo.getModel()[modelPcb.getModelId()];
+			auto view = sceneUbo.getView();
+			auto proj = sceneUbo.getProj();
 
-	vk::PipelineDepthStencilStateCreateInfo depthStencil;
-	depthStencil.depthTestEnable = true;
-	depthStencil.depthWriteEnable = true;
-	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-	depthStencil.depthBoundsTestEnable = false;
-	depthStencil.minDepthBounds = 0.0f;  // Optional
-	depthStencil.maxDepthBounds = 1.0f;  // Optional
-	depthStencil.stencilTestEnable = false;
-	// depthStencil.front; // Optional
-	// depthStencil.back; // Optional
+			// same expression as the main pass, both positions are made
+			// invariant for its EQUAL depth test
+			out.vtx.position =
+			    proj * view * model * vec4(inPosition.xyz(), 1.0_f);
+		});
 
-	std::array dynamicStates = {
-		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR,
-	};
+		std::vector<uint32_t> bytecode = optimizeSpirv(
+		    makePositionInvariant(spirv::serialiseSpirv(writer.getShader())));
 
-	vk::PipelineDynamicStateCreateInfo dynamicState;
-	dynamicState.dynamicStateCount = uint32_t(dynamicStates.size());
-	dynamicState.pDynamicStates = dynamicStates.data();
+		vk::ShaderModuleCreateInfo createInfo;
+		createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
+		createInfo.pCode = bytecode.data();
+
+		vertexModule = vk.create(createInfo);
+		if (!vertexModule)
+		{
+			std::cerr << "error: failed to create vertex shader module"
+			          << std::endl;
+			abort();
+		}
+	}
+#pragma endregion
+
+#pragma region fragmentShader
+	{
+		using namespace sdw;
+		FragmentWriter writer;
+
+		writer.implementMain([&]() {
+
+		});
+
+		std::vector<uint32_t> bytecode =
+		    optimizeSpirv(spirv::serialiseSpirv(writer.getShader()));
+
+		vk::ShaderModuleCreateInfo createInfo;
+		createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
+		createInfo.pCode = bytecode.data();
+
+		fragmentModule = vk.create(createInfo);
+		if (!fragmentModule)
+		{
+			std::cerr << "error: failed to create fragment shader module"
+			          << std::endl;
+			abort();
+		}
+	}
+#pragma endregion
+
+#pragma region pipeline layout
+	pipelineLayout = sharedPipelineLayout(*scene.get(), material);
+#pragma endregion
+
+#pragma region pipeline
+	vk::PipelineShaderStageCreateInfo vertShaderStageInfo;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = vertexModule;
+	vertShaderStageInfo.pName = "main";
+
+	vk::PipelineShaderStageCreateInfo fragShaderStageInfo;
+	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragShaderStageInfo.module = fragmentModule;
+	fragShaderStageInfo.pName = "main";
+
+	std::array shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
+
+	VertexInputState vertexInputState = mesh.positionOnlyVertexInputState();
+
+	// only the depth is written
+	MainPassPipelineState state(0);
 
 	vk::GraphicsPipelineCreateInfo pipelineInfo;
 	pipelineInfo.stageCount = uint32_t(shaderStages.size());
 	pipelineInfo.pStages = shaderStages.data();
 	pipelineInfo.pVertexInputState = &vertexInputState.vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssembly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizer;
-	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = &depthStencil;
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = &dynamicState;
+	state.apply(pipelineInfo);
 	pipelineInfo.layout = pipelineLayout;
 	pipelineInfo.renderPass = renderPass;
-	pipelineInfo.subpass = 0;
-	pipelineInfo.basePipelineHandle = nullptr;
-	pipelineInfo.basePipelineIndex = -1;
 
 	pipeline = vk.create(pipelineInfo);
 	if (!pipeline)
@@ -396,34 +628,47 @@ SceneObject::Pipeline::Pipeline(Scene& s, StandardMesh& mesh,
 #pragma endregion
 }
 
-void SceneObject::Pipeline::bindPipeline(CommandBuffer& cb)
+void SceneObject::DepthPrepassPipeline::bindPipeline(CommandBuffer& cb)
 {
 	cb.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 }
 
-void SceneObject::Pipeline::bindDescriptorSet(CommandBuffer& cb)
+void SceneObject::DepthPrepassPipeline::bindDescriptorSet(CommandBuffer& cb)
 {
-	std::array<VkDescriptorSet, 3> descriptorSets{
+	std::array<VkDescriptorSet, 4> descriptorSets{
 		scene.get()->descriptorSet(),
 		material.get()->material().shadingModel().m_descriptorSet,
 		material.get()->material().descriptorSet(),
+		material.get()->material().shadingModel().textureTable().descriptorSet(),
 	};
 	cb.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
 	                      uint32_t(descriptorSets.size()),
 	                      descriptorSets.data());
 }
 
-void SceneObject::Pipeline::draw(CommandBuffer& cb) { mesh.get()->draw(cb); }
+void SceneObject::DepthPrepassPipeline::draw(
+    CommandBuffer& cb, std::optional<IndirectDraw> indirect)
+{
+	if (indirect.has_value())
+		mesh.get()->drawPositionsIndirect(cb, indirect->buffer,
+		                                  indirect->offset);
+	else
+		mesh.get()->drawPositions(cb);
+}
 
 SceneObject::ShadowmapPipeline::ShadowmapPipeline(Scene& s, StandardMesh& mesh,
                                                   MaterialInterface& material,
-                                                  VkRenderPass renderPass)
+                                                  VkRenderPass renderPass,
+                                                  uint64_t shaderGeneration)
     : scene(&s),
       mesh(&mesh),
       material(&material),
-      renderPass(renderPass)
+      renderPass(renderPass),
+      shaderGeneration(shaderGeneration)
 {
-	auto& rw = material.material().renderWindow();
+	CpuProfiler::Zone zone("build shadowmap pipeline");
+
+	auto& rw = material.material().renderContext();
 	auto& vk = rw.device();
 
 #pragma region vertexShader
@@ -433,7 +678,7 @@ SceneObject::ShadowmapPipeline::ShadowmapPipeline(Scene& s, StandardMesh& mesh,
 
 		Scene::SceneUbo sceneUbo(writer);
 		Scene::ModelUbo modelUbo(writer);
-		Scene::ModelPcb modelPcb(writer);
+		Scene::ShadowmapPcb shadowmapPcb(writer);
 
 		auto inPosition = writer.declInput<Vec4>("fragPosition", 0);
 
@@ -445,15 +690,15 @@ SceneObject::ShadowmapPipeline::ShadowmapPipeline(Scene& s, StandardMesh& mesh,
 		    writer, materialVertexShaderBuildData.get());
 
 		writer.implementMain([&]() {
-			auto model = modelUbo.getModel()[modelPcb.getModelId()];
-			auto view = sceneUbo.getShadowView();
-			auto proj = sceneUbo.getShadowProj();
+			auto model = modelUbo.getModel()[shadowmapPcb.getModelId()];
+			auto viewProj =
+			    sceneUbo.getShadowViewProj()[shadowmapPcb.getCascadeIndex()];
 
-			out.vtx.position = proj * view * model * inPosition;
+			out.vtx.position = viewProj * model * inPosition;
 		});
 
 		std::vector<uint32_t> bytecode =
-		    spirv::serialiseSpirv(writer.getShader());
+		    optimizeSpirv(spirv::serialiseSpirv(writer.getShader()));
 
 		vk::ShaderModuleCreateInfo createInfo;
 		createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -479,7 +724,7 @@ SceneObject::ShadowmapPipeline::ShadowmapPipeline(Scene& s, StandardMesh& mesh,
 		});
 
 		std::vector<uint32_t> bytecode =
-		    spirv::serialiseSpirv(writer.getShader());
+		    optimizeSpirv(spirv::serialiseSpirv(writer.getShader()));
 
 		vk::ShaderModuleCreateInfo createInfo;
 		createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
@@ -496,32 +741,7 @@ SceneObject::ShadowmapPipeline::ShadowmapPipeline(Scene& s, StandardMesh& mesh,
 #pragma endregion
 
 #pragma region pipeline layout
-	VkPushConstantRange pcRange{};
-	pcRange.size = sizeof(PcbStruct);
-	pcRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-	std::array descriptorSetLayouts{
-		scene.get()->descriptorSetLayout(),
-		material.material().shadingModel().m_descriptorSetLayout.get(),
-		material.material().descriptorSetLayout(),
-	};
-
-	vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
-	pipelineLayoutInfo.setLayoutCount = uint32_t(descriptorSetLayouts.size());
-	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-	// pipelineLayoutInfo.setLayoutCount = 0;
-	// pipelineLayoutInfo.pSetLayouts = nullptr;
-	pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges = &pcRange;
-	// pipelineLayoutInfo.pushConstantRangeCount = 0;
-	// pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-	pipelineLayout = vk.create(pipelineLayoutInfo);
-	if (!pipelineLayout)
-	{
-		std::cerr << "error: failed to create pipeline layout" << std::endl;
-		abort();
-	}
+	pipelineLayout = sharedPipelineLayout(*scene.get(), material);
 #pragma endregion
 
 #pragma region pipeline
@@ -702,10 +922,11 @@ void SceneObject::ShadowmapPipeline::bindPipeline(CommandBuffer& cb)
 
 void SceneObject::ShadowmapPipeline::bindDescriptorSet(CommandBuffer& cb)
 {
-	std::array<VkDescriptorSet, 3> descriptorSets{
+	std::array<VkDescriptorSet, 4> descriptorSets{
 		scene.get()->descriptorSet(),
 		material.get()->material().shadingModel().m_descriptorSet,
 		material.get()->material().descriptorSet(),
+		material.get()->material().shadingModel().textureTable().descriptorSet(),
 	};
 	cb.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
 	                      uint32_t(descriptorSets.size()),
@@ -719,27 +940,90 @@ void SceneObject::ShadowmapPipeline::draw(CommandBuffer& cb)
 
 SceneObject::SceneObject(Scene& s) : m_scene(&s) {}
 
+uint64_t SceneObject::shaderGeneration() const
+{
+	Material& material = m_material.get()->material();
+	return m_scene.get()->shaderGeneration() + material.shaderGeneration() +
+	       material.shadingModel().shaderGeneration();
+}
+
+template <typename P>
+void SceneObject::retirePipeline(P& pipeline)
+{
+	RetiredPipeline retired;
+	retired.pipeline = std::move(pipeline.pipeline);
+	retired.framesLeft = std::max(
+	    m_material.get()->material().renderContext().framesInFlight(), 1u);
+	m_retiredPipelines.push_back(std::move(retired));
+}
+
+SceneObject::~SceneObject()
+{
+	// the jobs still reference the mesh and material
+	auto wait = [](auto& pendingPipelines) {
+		for (auto& [key, pending] : pendingPipelines)
+			if (pending.valid())
+				pending.wait();
+	};
+	wait(m_pendingPipelines);
+	wait(m_pendingDepthEqualPipelines);
+	wait(m_pendingDepthPrepassPipelines);
+}
+
+SceneObject::Pipeline* SceneObject::findPipeline(VkRenderPass renderPass,
+                                                 bool depthEqual)
+{
+	auto& pipelines = depthEqual ? m_depthEqualPipelines : m_pipelines;
+	auto& pendingPipelines =
+	    depthEqual ? m_pendingDepthEqualPipelines : m_pendingPipelines;
+
+	PipelineKey key;
+	key.renderPass = renderPass;
+	key.shadingFeatures = m_material.get()->material().shadingFeatures();
+
+	uint64_t generation = shaderGeneration();
+	return findOrCompilePipeline(
+	    pipelines, pendingPipelines, key, generation,
+	    m_scene.get()->pipelineCompiler(),
+	    [scene = m_scene.get(), mesh = m_mesh.get(),
+	     material = m_material.get(), key, generation, depthEqual]() {
+		    return Pipeline(*scene, *mesh, *material, key.renderPass,
+		                    key.shadingFeatures, generation, depthEqual);
+	    },
+	    [this](Pipeline& old) { retirePipeline(old); });
+}
+
+SceneObject::DepthPrepassPipeline* SceneObject::findDepthPrepassPipeline(
+    VkRenderPass renderPass)
+{
+	uint64_t generation = shaderGeneration();
+	return findOrCompilePipeline(
+	    m_depthPrepassPipelines, m_pendingDepthPrepassPipelines, renderPass,
+	    generation, m_scene.get()->pipelineCompiler(),
+	    [scene = m_scene.get(), mesh = m_mesh.get(),
+	     material = m_material.get(), renderPass, generation]() {
+		    return DepthPrepassPipeline(*scene, *mesh, *material, renderPass,
+		                                generation);
+	    },
+	    [this](DepthPrepassPipeline& old) { retirePipeline(old); });
+}
+
 void SceneObject::draw(CommandBuffer& cb, VkRenderPass renderPass,
                        std::optional<VkViewport> viewport,
-                       std::optional<VkRect2D> scissor)
+                       std::optional<VkRect2D> scissor,
+                       std::optional<IndirectDraw> indirect)
 {
 	if (m_scene && m_mesh && m_material)
 	{
-		Pipeline* pipeline;
-		auto foundPipeline = m_pipelines.find(renderPass);
-		if (foundPipeline == m_pipelines.end())
-		{
-			auto it = m_pipelines
-			              .insert(std::make_pair(
-			                  renderPass, Pipeline(*m_scene, *m_mesh,
-			                                       *m_material, renderPass)))
-			              .first;
-			pipeline = &it->second;
-		}
-		else
-		{
-			pipeline = &foundPipeline->second;
-		}
+		bool depthEqual = m_scene.get()->depthPrepass;
+
+		Pipeline* pipeline = findPipeline(renderPass, depthEqual);
+		if (pipeline == nullptr)
+			return;
+
+		// not drawn by the pre-pass yet, nothing passes the EQUAL test
+		if (depthEqual && findDepthPrepassPipeline(renderPass) == nullptr)
+			return;
 
 		pipeline->bindPipeline(cb);
 
@@ -756,29 +1040,122 @@ void SceneObject::draw(CommandBuffer& cb, VkRenderPass renderPass,
 		pcbStruct.materialInstanceIndex = m_material.get()->index();
 
 		cb.pushConstants(
-		    pipeline->pipelineLayout,
-		    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+		    pipeline->pipelineLayout, VK_SHADER_STAGE_ALL_GRAPHICS, 0,
 		    &pcbStruct);
 
-		pipeline->draw(cb);
+		pipeline->draw(cb, indirect);
+	}
+}
+
+void SceneObject::drawDepthPrepass(CommandBuffer& cb, VkRenderPass renderPass,
+                                   std::optional<VkViewport> viewport,
+                                   std::optional<VkRect2D> scissor,
+                                   std::optional<IndirectDraw> indirect)
+{
+	if (m_scene && m_mesh && m_material)
+	{
+		DepthPrepassPipeline* pipeline = findDepthPrepassPipeline(renderPass);
+		if (pipeline == nullptr)
+			return;
+
+		// the main pass would not draw the color over this depth yet
+		if (findPipeline(renderPass, true) == nullptr)
+			return;
+
+		pipeline->bindPipeline(cb);
+
+		if (viewport.has_value())
+			cb.setViewport(viewport.value());
+
+		if (scissor.has_value())
+			cb.setScissor(scissor.value());
+
+		pipeline->bindDescriptorSet(cb);
+
+		PcbStruct pcbStruct;
+		pcbStruct.modelIndex = id;
+		pcbStruct.materialInstanceIndex = m_material.get()->index();
+
+		cb.pushConstants(pipeline->pipelineLayout, VK_SHADER_STAGE_ALL_GRAPHICS,
+		                 0, &pcbStruct);
+
+		pipeline->draw(cb, indirect);
 	}
 }
 
+bool SceneObject::applyShaderReloads()
+{
+	for (RetiredPipeline& retired : m_retiredPipelines)
+		retired.framesLeft--;
+	m_retiredPipelines.erase(
+	    std::remove_if(m_retiredPipelines.begin(), m_retiredPipelines.end(),
+	                   [](const RetiredPipeline& retired) {
+		                   return retired.framesLeft == 0;
+	                   }),
+	    m_retiredPipelines.end());
+
+	// first compilations are picked up by the draws themselves
+	auto swapRebuilt = [this](auto& pipelines, auto& pendingPipelines) {
+		for (auto it = pendingPipelines.begin(); it != pendingPipelines.end();)
+		{
+			auto foundPipeline = pipelines.find(it->first);
+			if (foundPipeline == pipelines.end() ||
+			    !PipelineCompiler::ready(it->second))
+			{
+				++it;
+				continue;
+			}
+
+			retirePipeline(foundPipeline->second);
+			foundPipeline->second = it->second.get();
+			it = pendingPipelines.erase(it);
+		}
+	};
+	swapRebuilt(m_pipelines, m_pendingPipelines);
+	swapRebuilt(m_depthEqualPipelines, m_pendingDepthEqualPipelines);
+	swapRebuilt(m_depthPrepassPipelines, m_pendingDepthPrepassPipelines);
+
+	if (!m_scene || !m_mesh || !m_material)
+		return false;
+
+	// rebuilt here rather than in the pass so that the scene can re-render
+	// its cached static shadowmap with them
+	bool shadowmapPipelinesChanged = false;
+	uint64_t generation = shaderGeneration();
+	for (auto& [renderPass, pipeline] : m_shadowmapPipelines)
+	{
+		if (pipeline.shaderGeneration == generation)
+			continue;
+
+		retirePipeline(pipeline);
+		pipeline = ShadowmapPipeline(*m_scene, *m_mesh, *m_material,
+		                             renderPass, generation);
+		shadowmapPipelinesChanged = true;
+	}
+
+	return shadowmapPipelinesChanged;
+}
+
 void SceneObject::drawShadowmapPass(CommandBuffer& cb, VkRenderPass renderPass,
+                                    uint32_t cascadeIndex,
                                     std::optional<VkViewport> viewport,
                                     std::optional<VkRect2D> scissor)
 {
-	if (m_scene && m_mesh && m_material)
+	if (m_scene && m_mesh && m_material &&
+	    (m_material.get()->material().shadingFeatures() &
+	     PbrShadingModel::CastShadows))
 	{
+		// compiled right away: the shader is trivial and a caster missing
+		// from the cached static shadowmap would never be added back
 		ShadowmapPipeline* pipeline;
 		auto foundPipeline = m_shadowmapPipelines.find(renderPass);
 		if (foundPipeline == m_shadowmapPipelines.end())
 		{
 			auto it = m_shadowmapPipelines
 			              .insert(std::make_pair(
-			                  renderPass,
-			                  ShadowmapPipeline(*m_scene, *m_mesh, *m_material,
-			                                    renderPass)))
+			                  renderPass, ShadowmapPipeline(
+			                                  *m_scene, *m_mesh, *m_material,
+			                                  renderPass, shaderGeneration())))
 			              .first;
 			pipeline = &it->second;
 		}
@@ -797,11 +1174,11 @@ void SceneObject::drawShadowmapPass(CommandBuffer& cb, VkRenderPass renderPass,
 
 		pipeline->bindDescriptorSet(cb);
 
-		PcbStruct pcbStruct;
+		ShadowmapPcbStruct pcbStruct;
 		pcbStruct.modelIndex = id;
-		pcbStruct.materialInstanceIndex = m_material.get()->index();
+		pcbStruct.cascadeIndex = cascadeIndex;
 
-		cb.pushConstants(pipeline->pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+		cb.pushConstants(pipeline->pipelineLayout, VK_SHADER_STAGE_ALL_GRAPHICS,
 		                 0, &pcbStruct);
 
 		pipeline->draw(cb);
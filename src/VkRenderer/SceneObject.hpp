@@ -1,28 +1,53 @@
 #pragma once
 
+#include "PbrShadingModel.hpp"
 #include "VulkanDevice.hpp"
 #include "VulkanHelperStructs.hpp"
 
 #include "cdm_maths.hpp"
 
+#include <future>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace cdm
 {
 class CommandBuffer;
 class Scene;
 class StandardMesh;
+class Material;
 class MaterialInterface;
 
 class SceneObject
 {
+public:
+	/// Draw command read from a buffer, see `StandardMesh::drawIndirect`
+	struct IndirectDraw
+	{
+		VkBuffer buffer = nullptr;
+		VkDeviceSize offset = 0;
+	};
+
+	/// Main pass shaders of the objects drawn with `material`, only declared
+	/// in `writer`: generating them does not need a device
+	static void writeVertexShader(sdw::VertexWriter& writer,
+	                              Material& material);
+	static void writeFragmentShader(sdw::FragmentWriter& writer,
+	                                Material& material,
+	                                PbrShadingModel& shadingModel,
+	                                uint32_t shadingFeatures);
+
+private:
 	struct Pipeline
 	{
 		Movable<Scene*> scene;
 		Movable<StandardMesh*> mesh;
 		Movable<MaterialInterface*> material;
 		Movable<VkRenderPass> renderPass;
+		uint32_t shadingFeatures = PbrShadingModel::AllShadingFeatures;
+		/// `SceneObject::shaderGeneration` the shaders were built from
+		uint64_t shaderGeneration = 0;
 
 		// UniqueDescriptorPool descriptorPool;
 
@@ -32,12 +57,14 @@ class SceneObject
 		UniqueShaderModule vertexModule;
 		UniqueShaderModule fragmentModule;
 
-		UniquePipelineLayout pipelineLayout;
+		/// owned by the device's `LayoutCache`
+		Movable<VkPipelineLayout> pipelineLayout;
 		UniquePipeline pipeline;
 
 		Pipeline() = default;
 		Pipeline(Scene& s, StandardMesh& mesh, MaterialInterface& material,
-		         VkRenderPass renderPass);
+		         VkRenderPass renderPass, uint32_t shadingFeatures,
+		         uint64_t shaderGeneration, bool depthEqual = false);
 		Pipeline(const Pipeline&) = delete;
 		Pipeline(Pipeline&&) = default;
 		~Pipeline() = default;
@@ -47,7 +74,8 @@ class SceneObject
 
 		void bindPipeline(CommandBuffer& cb);
 		void bindDescriptorSet(CommandBuffer& cb);
-		void draw(CommandBuffer& cb);
+		void draw(CommandBuffer& cb,
+		          std::optional<IndirectDraw> indirect = std::nullopt);
 	};
 
 	struct ShadowmapPipeline
@@ -56,17 +84,19 @@ class SceneObject
 		Movable<StandardMesh*> mesh;
 		Movable<MaterialInterface*> material;
 		Movable<VkRenderPass> renderPass;
+		uint64_t shaderGeneration = 0;
 
 		UniqueShaderModule vertexModule;
 		UniqueShaderModule fragmentModule;
 
-		UniquePipelineLayout pipelineLayout;
+		/// owned by the device's `LayoutCache`
+		Movable<VkPipelineLayout> pipelineLayout;
 		UniquePipeline pipeline;
 
 		ShadowmapPipeline() = default;
 		ShadowmapPipeline(Scene& s, StandardMesh& mesh,
-		                  MaterialInterface& material,
-		                  VkRenderPass renderPass);
+		                  MaterialInterface& material, VkRenderPass renderPass,
+		                  uint64_t shaderGeneration);
 		ShadowmapPipeline(const ShadowmapPipeline&) = delete;
 		ShadowmapPipeline(ShadowmapPipeline&&) = default;
 		~ShadowmapPipeline() = default;
@@ -79,28 +109,136 @@ class SceneObject
 		void draw(CommandBuffer& cb);
 	};
 
+	/// Depth-only pipeline for the main render pass, color writes are
+	/// disabled so that only the depth attachment is filled
+	struct DepthPrepassPipeline
+	{
+		Movable<Scene*> scene;
+		Movable<StandardMesh*> mesh;
+		Movable<MaterialInterface*> material;
+		Movable<VkRenderPass> renderPass;
+		uint64_t shaderGeneration = 0;
+
+		UniqueShaderModule vertexModule;
+		UniqueShaderModule fragmentModule;
+
+		/// owned by the device's `LayoutCache`
+		Movable<VkPipelineLayout> pipelineLayout;
+		UniquePipeline pipeline;
+
+		DepthPrepassPipeline() = default;
+		DepthPrepassPipeline(Scene& s, StandardMesh& mesh,
+		                     MaterialInterface& material,
+		                     VkRenderPass renderPass,
+		                     uint64_t shaderGeneration);
+		DepthPrepassPipeline(const DepthPrepassPipeline&) = delete;
+		DepthPrepassPipeline(DepthPrepassPipeline&&) = default;
+		~DepthPrepassPipeline() = default;
+
+		DepthPrepassPipeline& operator=(const DepthPrepassPipeline&) = delete;
+		DepthPrepassPipeline& operator=(DepthPrepassPipeline&&) = default;
+
+		void bindPipeline(CommandBuffer& cb);
+		void bindDescriptorSet(CommandBuffer& cb);
+		void draw(CommandBuffer& cb,
+		          std::optional<IndirectDraw> indirect = std::nullopt);
+	};
+
+	/// Pipelines are built lazily for each render pass and shading
+	/// variant an object is drawn with
+	struct PipelineKey
+	{
+		VkRenderPass renderPass = nullptr;
+		uint32_t shadingFeatures = 0;
+
+		bool operator==(const PipelineKey& o) const noexcept
+		{
+			return renderPass == o.renderPass &&
+			       shadingFeatures == o.shadingFeatures;
+		}
+	};
+	struct PipelineKeyHash
+	{
+		size_t operator()(const PipelineKey& k) const noexcept
+		{
+			return std::hash<VkRenderPass>()(k.renderPass) ^
+			       (size_t(k.shadingFeatures) << 1);
+		}
+	};
+
 	struct PcbStruct
 	{
 		uint32_t modelIndex;
 		uint32_t materialInstanceIndex;
 	};
 
+	struct ShadowmapPcbStruct
+	{
+		uint32_t modelIndex;
+		uint32_t cascadeIndex;
+	};
+
+	/// Layout of every pipeline of the object, one push constant range
+	/// visible to all the graphics stages like `Material::pushOffset`
+	static VkPipelineLayout sharedPipelineLayout(Scene& scene,
+	                                             MaterialInterface& material);
+
+	/// Replaced pipelines may still be used by the frames in flight
+	struct RetiredPipeline
+	{
+		UniquePipeline pipeline;
+		uint32_t framesLeft = 0;
+	};
+
 protected:
 	Movable<Scene*> m_scene;
 	Movable<StandardMesh*> m_mesh;
 	Movable<MaterialInterface*> m_material;
-	std::unordered_map<VkRenderPass, Pipeline> m_pipelines;
+	std::unordered_map<PipelineKey, Pipeline, PipelineKeyHash> m_pipelines;
+	/// same as `m_pipelines` but with an `EQUAL` depth test and no depth
+	/// write, used after a depth pre-pass
+	std::unordered_map<PipelineKey, Pipeline, PipelineKeyHash>
+	    m_depthEqualPipelines;
+	std::unordered_map<VkRenderPass, DepthPrepassPipeline>
+	    m_depthPrepassPipelines;
+	/// pipelines being compiled by the scene's `PipelineCompiler`
+	std::unordered_map<PipelineKey, std::future<Pipeline>, PipelineKeyHash>
+	    m_pendingPipelines;
+	std::unordered_map<PipelineKey, std::future<Pipeline>, PipelineKeyHash>
+	    m_pendingDepthEqualPipelines;
+	std::unordered_map<VkRenderPass, std::future<DepthPrepassPipeline>>
+	    m_pendingDepthPrepassPipelines;
 	std::unordered_map<VkRenderPass, ShadowmapPipeline> m_shadowmapPipelines;
+	std::vector<RetiredPipeline> m_retiredPipelines;
+
+	/// Changes whenever the scene, shading model or material shaders are
+	/// invalidated, every counter only grows
+	uint64_t shaderGeneration() const;
+	template <typename P>
+	void retirePipeline(P& pipeline);
+
+	/// null while the pipeline compiles
+	Pipeline* findPipeline(VkRenderPass renderPass, bool depthEqual);
+	DepthPrepassPipeline* findDepthPrepassPipeline(VkRenderPass renderPass);
 
 public:
+	enum class Mobility
+	{
+		Dynamic,
+		/// does not move, its shadow is cached by the `Scene`
+		Static,
+	};
+
 	transform3d transform;
 	uint32_t id = -1;
+	Mobility mobility = Mobility::Dynamic;
 
 	SceneObject() = default;
 	SceneObject(Scene& s);
 	SceneObject(const SceneObject&) = delete;
 	SceneObject(SceneObject&&) = default;
-	~SceneObject() = default;
+	/// Waits for the pipelines still being compiled
+	~SceneObject();
 
 	SceneObject& operator=(const SceneObject&) = delete;
 	SceneObject& operator=(SceneObject&&) = default;
@@ -110,13 +248,28 @@ public:
 	void setMaterial(MaterialInterface& m) noexcept { m_material = &m; }
 	MaterialInterface* material() const noexcept { return m_material; }
 
+	/// With `Scene::depthPrepass`, the object is only drawn in either pass
+	/// once both its pre-pass and main pass pipelines are compiled, a depth
+	/// written without its color would leave a hole
 	virtual void draw(CommandBuffer& cb, VkRenderPass renderPass,
 	                  std::optional<VkViewport> viewport = std::nullopt,
-	                  std::optional<VkRect2D> scissor = std::nullopt);
+	                  std::optional<VkRect2D> scissor = std::nullopt,
+	                  std::optional<IndirectDraw> indirect = std::nullopt);
 
-	virtual void drawShadowmapPass(
+	virtual void drawDepthPrepass(
 	    CommandBuffer& cb, VkRenderPass renderPass,
 	    std::optional<VkViewport> viewport = std::nullopt,
+	    std::optional<VkRect2D> scissor = std::nullopt,
+	    std::optional<IndirectDraw> indirect = std::nullopt);
+
+	/// Swaps in the pipelines rebuilt after a shader invalidation and
+	/// releases the retired ones, see `Scene::applyShaderReloads`. Returns
+	/// true if a shadowmap pipeline was replaced
+	bool applyShaderReloads();
+
+	virtual void drawShadowmapPass(
+	    CommandBuffer& cb, VkRenderPass renderPass, uint32_t cascadeIndex,
+	    std::optional<VkViewport> viewport = std::nullopt,
 	    std::optional<VkRect2D> scissor = std::nullopt);
 };
 }  // namespace cdm
@@ -0,0 +1,239 @@
+#include "ShaderArchive.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cdm
+{
+namespace
+{
+/// Maps the whole file read-only, the mapping outlives the file handles
+const uint8_t* mapFile(const std::filesystem::path& path, size_t& size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+	                          nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+	                          nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	HANDLE mapping =
+	    CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return nullptr;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == nullptr)
+		return nullptr;
+
+	size = size_t(fileSize.QuadPart);
+	return static_cast<const uint8_t*>(data);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return nullptr;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		::close(file);
+		return nullptr;
+	}
+
+	void* data =
+	    mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	size = size_t(fileStat.st_size);
+	return static_cast<const uint8_t*>(data);
+#endif
+}
+
+void unmapFile(const uint8_t* data, size_t size)
+{
+#ifdef _WIN32
+	(void)size;
+	UnmapViewOfFile(data);
+#else
+	munmap(const_cast<uint8_t*>(data), size);
+#endif
+}
+}  // namespace
+
+ShaderArchive::ShaderArchive(const std::filesystem::path& path)
+{
+	size_t size = 0;
+	const uint8_t* data = mapFile(path, size);
+	if (data == nullptr)
+		return;
+
+	m_data = data;
+	m_size = size;
+
+	// every offset is validated once so that lookups need no check
+	bool valid = size >= sizeof(Header) && header().magic == Magic &&
+	             header().version == Version &&
+	             size >= sizeof(Header) +
+	                         size_t(header().entryCount) * sizeof(IndexEntry);
+	for (uint32_t i = 0; valid && i < header().entryCount; i++)
+	{
+		const IndexEntry& entry = index()[i];
+		valid = size_t(entry.keyOffset) + entry.keySize <= size &&
+		        entry.codeOffset % sizeof(uint32_t) == 0 &&
+		        size_t(entry.codeOffset) +
+		                size_t(entry.codeWordCount) * sizeof(uint32_t) <=
+		            size;
+	}
+
+	if (!valid)
+	{
+		std::cerr << "warning: " << path << " is not a valid shader archive"
+		          << std::endl;
+		close();
+	}
+}
+
+ShaderArchive::~ShaderArchive() { close(); }
+
+void ShaderArchive::close()
+{
+	if (m_data.get() != nullptr)
+		unmapFile(m_data.get(), m_size.get());
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+const ShaderArchive::Header& ShaderArchive::header() const
+{
+	return *reinterpret_cast<const Header*>(m_data.get());
+}
+
+const ShaderArchive::IndexEntry* ShaderArchive::index() const
+{
+	return reinterpret_cast<const IndexEntry*>(m_data.get() + sizeof(Header));
+}
+
+std::string_view ShaderArchive::key(const IndexEntry& entry) const
+{
+	return std::string_view(
+	    reinterpret_cast<const char*>(m_data.get() + entry.keyOffset),
+	    entry.keySize);
+}
+
+uint32_t ShaderArchive::entryCount() const
+{
+	return isOpen() ? header().entryCount : 0;
+}
+
+ShaderArchive::Bytecode ShaderArchive::find(std::string_view key) const
+{
+	if (!isOpen())
+		return {};
+
+	const IndexEntry* begin = index();
+	const IndexEntry* end = begin + header().entryCount;
+
+	auto found = std::lower_bound(
+	    begin, end, key, [this](const IndexEntry& entry, std::string_view k) {
+		    return this->key(entry) < k;
+	    });
+
+	if (found == end || this->key(*found) != key)
+		return {};
+
+	Bytecode res;
+	res.code =
+	    reinterpret_cast<const uint32_t*>(m_data.get() + found->codeOffset);
+	res.wordCount = found->codeWordCount;
+
+	return res;
+}
+
+void ShaderArchiveWriter::add(std::string key, std::vector<uint32_t> bytecode)
+{
+	m_shaders.insert_or_assign(std::move(key), std::move(bytecode));
+}
+
+bool ShaderArchiveWriter::write(const std::filesystem::path& path) const
+{
+	ShaderArchive::Header header{};
+	header.magic = ShaderArchive::Magic;
+	header.version = ShaderArchive::Version;
+	header.entryCount = uint32_t(m_shaders.size());
+
+	// std::map iterates in key order, as the lookup expects
+	std::vector<ShaderArchive::IndexEntry> index;
+	index.reserve(m_shaders.size());
+
+	size_t offset = sizeof(header) + m_shaders.size() * sizeof(index[0]);
+	for (const auto& [key, bytecode] : m_shaders)
+	{
+		ShaderArchive::IndexEntry entry{};
+		entry.keyOffset = uint32_t(offset);
+		entry.keySize = uint32_t(key.size());
+		offset += key.size();
+		index.push_back(entry);
+	}
+
+	offset = (offset + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+	const size_t keysEnd = offset;
+	auto entry = index.begin();
+	for (const auto& [key, bytecode] : m_shaders)
+	{
+		entry->codeOffset = uint32_t(offset);
+		entry->codeWordCount = uint32_t(bytecode.size());
+		offset += bytecode.size() * sizeof(uint32_t);
+		++entry;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "error: could not open " << path << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(index.data()),
+	           std::streamsize(index.size() * sizeof(index[0])));
+	size_t written = sizeof(header) + index.size() * sizeof(index[0]);
+	for (const auto& [key, bytecode] : m_shaders)
+	{
+		file.write(key.data(), std::streamsize(key.size()));
+		written += key.size();
+	}
+
+	const char padding[sizeof(uint32_t)]{};
+	file.write(padding, std::streamsize(keysEnd - written));
+
+	for (const auto& [key, bytecode] : m_shaders)
+		file.write(reinterpret_cast<const char*>(bytecode.data()),
+		           std::streamsize(bytecode.size() * sizeof(uint32_t)));
+
+	return bool(file);
+}
+}  // namespace cdm
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "SpirvOptimizer.hpp"
+#include "VulkanDevice.hpp"
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cdm
+{
+/// Read-only view of a packed SPIR-V archive written by
+/// `ShaderArchiveWriter`. The file is memory-mapped and looked up by key
+/// with a binary search over its index, nothing is copied.
+///
+/// Layout: a `Header`, `entryCount` `IndexEntry` sorted by key, the keys,
+/// then the 4-byte aligned bytecodes. Offsets are relative to the file start
+class ShaderArchive final
+{
+public:
+	static constexpr uint32_t Magic = 0x52415653;  // "SVAR"
+	static constexpr uint32_t Version = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+	};
+
+	struct IndexEntry
+	{
+		uint32_t keyOffset;
+		uint32_t keySize;
+		uint32_t codeOffset;
+		uint32_t codeWordCount;
+	};
+
+	struct Bytecode
+	{
+		const uint32_t* code = nullptr;
+		size_t wordCount = 0;
+
+		explicit operator bool() const noexcept { return code != nullptr; }
+	};
+
+private:
+	Movable<const uint8_t*> m_data;
+	Movable<size_t, size_t(0)> m_size;
+
+	const Header& header() const;
+	const IndexEntry* index() const;
+	std::string_view key(const IndexEntry& entry) const;
+
+	void close();
+
+public:
+	ShaderArchive() = default;
+	/// Maps `path`, the archive stays closed if the file is missing or
+	/// malformed
+	ShaderArchive(const std::filesystem::path& path);
+	ShaderArchive(const ShaderArchive&) = delete;
+	ShaderArchive(ShaderArchive&&) = default;
+	~ShaderArchive();
+
+	ShaderArchive& operator=(const ShaderArchive&) = delete;
+	ShaderArchive& operator=(ShaderArchive&&) = default;
+
+	bool isOpen() const noexcept { return m_data.get() != nullptr; }
+	uint32_t entryCount() const;
+
+	/// Empty if `key` is not in the archive. The bytecode lives as long as
+	/// the archive
+	Bytecode find(std::string_view key) const;
+};
+
+/// Collects bytecodes by key and writes them as a `ShaderArchive`
+class ShaderArchiveWriter final
+{
+	std::map<std::string, std::vector<uint32_t>, std::less<>> m_shaders;
+
+public:
+	/// Replaces a previous entry with the same key, `bytecode` is stored as
+	/// is
+	void add(std::string key, std::vector<uint32_t> bytecode);
+	size_t size() const noexcept { return m_shaders.size(); }
+
+	bool write(const std::filesystem::path& path) const;
+};
+
+/// Shader module of `key` from `vk.shaderArchive()`, or of the optimized
+/// bytecode returned by `build` when the archive is missing or lacks the key
+template <typename Build>
+UniqueShaderModule createShaderModule(const VulkanDevice& vk,
+                                      std::string_view key, Build&& build)
+{
+	ShaderArchive::Bytecode bytecode;
+	if (const ShaderArchive* archive = vk.shaderArchive())
+		bytecode = archive->find(key);
+
+	std::vector<uint32_t> builtBytecode;
+	if (!bytecode)
+	{
+		builtBytecode = optimizeSpirv(build());
+		bytecode.code = builtBytecode.data();
+		bytecode.wordCount = builtBytecode.size();
+	}
+
+	vk::ShaderModuleCreateInfo createInfo;
+	createInfo.codeSize = bytecode.wordCount * sizeof(*bytecode.code);
+	createInfo.pCode = bytecode.code;
+
+	return vk.create(createInfo);
+}
+}  // namespace cdm
@@ -4,6 +4,7 @@
 #include "EquirectangularToCubemap.hpp"
 #include "EquirectangularToIrradianceMap.hpp"
 #include "PrefilterCubemap.hpp"
+#include "ShaderArchive.hpp"
 #include "StagingBuffer.hpp"
 
 #include "CompilerSpirV/compileSpirV.hpp"
@@ -23,9 +24,9 @@ void Skybox::Config::copyTo(void* ptr)
     std::memcpy(ptr, this, sizeof(*this));
 }
 
-Skybox::Skybox(RenderWindow& renderWindow, VkRenderPass renderPass,
+Skybox::Skybox(RenderContext& renderContext, VkRenderPass renderPass,
                VkViewport viewport, Cubemap& cubemap)
-    : rw(renderWindow),
+    : rw(renderContext),
       m_renderPass(renderPass),
       m_viewport(viewport),
       m_cubemap(cubemap)
@@ -42,104 +43,25 @@ Skybox::Skybox(RenderWindow& renderWindow, VkRenderPass renderPass,
 
 #pragma region vertexShader
     std::cout << "vertexShader" << std::endl;
+    m_vertexModule = createShaderModule(vk, "Skybox.vert",
+                                        &vertexShaderBytecode);
+    if (!m_vertexModule)
     {
-        using namespace sdw;
-        VertexWriter writer;
-
-        auto inPosition = writer.declInput<Vec3>("inPosition", 0);
-
-        auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
-
-        auto out = writer.getOut();
-
-        Ubo ubo(writer, "ubo", 0, 0);
-        ubo.declMember<Mat4>("view");
-        ubo.declMember<Mat4>("proj");
-        ubo.end();
-
-        writer.implementMain([&]() {
-            auto view = ubo.getMember<Mat4>("view");
-            auto proj = ubo.getMember<Mat4>("proj");
-
-            fragPosition = inPosition;
-
-            Locale(rotView,
-                   mat4(vec4(view[0][0], view[0][1], view[0][2], 0.0_f),
-                        vec4(view[1][0], view[1][1], view[1][2], 0.0_f),
-                        vec4(view[2][0], view[2][1], view[2][2], 0.0_f),
-                        vec4(0.0_f, 0.0_f, 0.0_f, 1.0_f)));
-
-            Locale(clipPos, proj * rotView * vec4(inPosition, 1.0_f));
-
-            out.vtx.position = clipPos.xyww();
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_vertexModule = vk.create(createInfo);
-        if (!m_vertexModule)
-        {
-            std::cerr << "error: failed to create vertex shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create vertex shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
 #pragma region fragmentShader
     std::cout << "fragmentShader" << std::endl;
+    m_fragmentModule = createShaderModule(vk, "Skybox.frag",
+                                          &fragmentShaderBytecode);
+    if (!m_fragmentModule)
     {
-        using namespace sdw;
-        FragmentWriter writer;
-
-        auto in = writer.getIn();
-
-        auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
-
-        auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
-        auto fragID = writer.declOutput<UInt>("fragID", 1);
-        auto fragNormalDepth = writer.declOutput<Vec4>("fragNormalDepth", 2);
-        auto fragPos = writer.declOutput<Vec3>("fragPos", 3);
-
-        auto environmentMap =
-            writer.declSampledImage<FImgCubeRgba32>("environmentMap", 1, 0);
-
-        Ubo ubo(writer, "ubo", 0, 0);
-        ubo.declMember<Mat4>("view");
-        ubo.declMember<Mat4>("proj");
-        ubo.end();
-
-        writer.implementMain([&]() {
-            Locale(envColor, environmentMap.lod(fragPosition, 0.0_f));
-
-            envColor = envColor / (envColor + vec4(1.0_f));
-            envColor = pow(envColor, vec4(1.0_f / 2.2_f));
-
-            fragColor = envColor;
-            fragID = -1_u;
-            fragNormalDepth = vec4(0.0_f);
-            fragPos = fragPosition;
-        });
-
-        std::vector<uint32_t> bytecode =
-            spirv::serialiseSpirv(writer.getShader());
-
-        vk::ShaderModuleCreateInfo createInfo;
-        createInfo.codeSize = bytecode.size() * sizeof(*bytecode.data());
-        createInfo.pCode = bytecode.data();
-
-        m_fragmentModule = vk.create(createInfo);
-        if (!m_fragmentModule)
-        {
-            std::cerr << "error: failed to create fragment shader module"
-                      << std::endl;
-            abort();
-        }
+        std::cerr << "error: failed to create fragment shader module"
+                  << std::endl;
+        abort();
     }
 #pragma endregion
 
@@ -569,6 +491,79 @@ Skybox::Skybox(RenderWindow& renderWindow, VkRenderPass renderPass,
 #pragma endregion
 }
 
+std::vector<uint32_t> Skybox::vertexShaderBytecode()
+{
+    using namespace sdw;
+    VertexWriter writer;
+
+    auto inPosition = writer.declInput<Vec3>("inPosition", 0);
+
+    auto fragPosition = writer.declOutput<Vec3>("fragPosition", 0);
+
+    auto out = writer.getOut();
+
+    Ubo ubo(writer, "ubo", 0, 0);
+    ubo.declMember<Mat4>("view");
+    ubo.declMember<Mat4>("proj");
+    ubo.end();
+
+    writer.implementMain([&]() {
+        auto view = ubo.getMember<Mat4>("view");
+        auto proj = ubo.getMember<Mat4>("proj");
+
+        fragPosition = inPosition;
+
+        Locale(rotView,
+               mat4(vec4(view[0][0], view[0][1], view[0][2], 0.0_f),
+                    vec4(view[1][0], view[1][1], view[1][2], 0.0_f),
+                    vec4(view[2][0], view[2][1], view[2][2], 0.0_f),
+                    vec4(0.0_f, 0.0_f, 0.0_f, 1.0_f)));
+
+        Locale(clipPos, proj * rotView * vec4(inPosition, 1.0_f));
+
+        out.vtx.position = clipPos.xyww();
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
+std::vector<uint32_t> Skybox::fragmentShaderBytecode()
+{
+    using namespace sdw;
+    FragmentWriter writer;
+
+    auto in = writer.getIn();
+
+    auto fragPosition = writer.declInput<Vec3>("fragPosition", 0);
+
+    auto fragColor = writer.declOutput<Vec4>("fragColor", 0);
+    auto fragID = writer.declOutput<UInt>("fragID", 1);
+    auto fragNormalDepth = writer.declOutput<Vec4>("fragNormalDepth", 2);
+    auto fragPos = writer.declOutput<Vec3>("fragPos", 3);
+
+    auto environmentMap =
+        writer.declSampledImage<FImgCubeRgba32>("environmentMap", 1, 0);
+
+    Ubo ubo(writer, "ubo", 0, 0);
+    ubo.declMember<Mat4>("view");
+    ubo.declMember<Mat4>("proj");
+    ubo.end();
+
+    writer.implementMain([&]() {
+        Locale(envColor, environmentMap.lod(fragPosition, 0.0_f));
+
+        envColor = envColor / (envColor + vec4(1.0_f));
+        envColor = pow(envColor, vec4(1.0_f / 2.2_f));
+
+        fragColor = envColor;
+        fragID = -1_u;
+        fragNormalDepth = vec4(0.0_f);
+        fragPos = fragPosition;
+    });
+
+    return spirv::serialiseSpirv(writer.getShader());
+}
+
 Skybox::~Skybox() {}
 
 void Skybox::setMatrices(matrix4 projection, matrix4 view)
@@ -6,7 +6,7 @@
 #include "CommandBuffer.hpp"
 #include "Cubemap.hpp"
 #include "DepthTexture.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 #include "Texture2D.hpp"
 
 #include "cdm_maths.hpp"
@@ -18,7 +18,7 @@ namespace cdm
 {
 class Skybox final
 {
-	std::reference_wrapper<RenderWindow> rw;
+	std::reference_wrapper<RenderContext> rw;
 
 	VkRenderPass m_renderPass;
 	VkViewport m_viewport;
@@ -56,10 +56,14 @@ private:
 	// CommandBuffer cb;// (vk, rw.oneTimeCommandPool());
 
 public:
-	Skybox(RenderWindow& renderWindow, VkRenderPass renderPass,
+	Skybox(RenderContext& renderContext, VkRenderPass renderPass,
 	       VkViewport viewport, Cubemap& m_cubemap);
 	~Skybox();
 
+	/// Shaders of the `Skybox.vert`/`Skybox.frag` keys of a `ShaderArchive`
+	static std::vector<uint32_t> vertexShaderBytecode();
+	static std::vector<uint32_t> fragmentShaderBytecode();
+
 	void setMatrices(matrix4 projection, matrix4 view);
 
 	void render(CommandBuffer& cb);
@@ -0,0 +1,162 @@
+#include "SpirvOptimizer.hpp"
+
+#include <cstddef>
+
+#ifdef VKRENDERER_OPTIMIZE_SPIRV
+#include <spirv-tools/optimizer.hpp>
+
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#endif
+
+namespace cdm
+{
+#ifdef VKRENDERER_OPTIMIZE_SPIRV
+namespace
+{
+/// every hot reload adds new shaders, the least recently used ones are
+/// dropped past this count
+constexpr size_t CacheCapacity = 256;
+
+struct CacheEntry
+{
+	std::vector<uint32_t> bytecode;
+	std::vector<uint32_t> optimized;
+};
+
+/// keys point to the `bytecode` of the entries
+struct BytecodeHash
+{
+	size_t operator()(const std::vector<uint32_t>* bytecode) const noexcept
+	{
+		size_t hash = bytecode->size();
+		for (uint32_t word : *bytecode)
+			hash ^= word + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+};
+struct BytecodeEqual
+{
+	bool operator()(const std::vector<uint32_t>* a,
+	                const std::vector<uint32_t>* b) const noexcept
+	{
+		return *a == *b;
+	}
+};
+
+/// shared by the pipeline compiler workers
+std::mutex cacheMutex;
+/// most recently used first
+std::list<CacheEntry> cacheEntries;
+std::unordered_map<const std::vector<uint32_t>*,
+                   std::list<CacheEntry>::iterator, BytecodeHash,
+                   BytecodeEqual>
+    cache;
+}  // namespace
+
+std::vector<uint32_t> optimizeSpirv(std::vector<uint32_t> bytecode)
+{
+	{
+		std::lock_guard lock(cacheMutex);
+		auto found = cache.find(&bytecode);
+		if (found != cache.end())
+		{
+			cacheEntries.splice(cacheEntries.begin(), cacheEntries,
+			                    found->second);
+			return found->second->optimized;
+		}
+	}
+
+	spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_1);
+	optimizer.SetMessageConsumer([](spv_message_level_t level, const char*,
+	                                const spv_position_t& position,
+	                                const char* message) {
+		if (level <= SPV_MSG_ERROR)
+			std::cerr << "spirv-opt: " << position.index << ": " << message
+			          << std::endl;
+	});
+	optimizer.RegisterPerformancePasses();
+
+	std::vector<uint32_t> optimized;
+	if (!optimizer.Run(bytecode.data(), bytecode.size(), &optimized))
+	{
+		std::cerr << "warning: SPIR-V optimization failed, using the "
+		             "unoptimized shader"
+		          << std::endl;
+		optimized = bytecode;
+	}
+
+	std::lock_guard lock(cacheMutex);
+	// another worker may have optimized the same shader meanwhile
+	if (cache.find(&bytecode) != cache.end())
+		return optimized;
+
+	cacheEntries.push_front({ std::move(bytecode), optimized });
+	cache.emplace(&cacheEntries.front().bytecode, cacheEntries.begin());
+	if (cacheEntries.size() > CacheCapacity)
+	{
+		cache.erase(&cacheEntries.back().bytecode);
+		cacheEntries.pop_back();
+	}
+
+	return optimized;
+}
+#else
+std::vector<uint32_t> optimizeSpirv(std::vector<uint32_t> bytecode)
+{
+	return bytecode;
+}
+#endif
+
+std::vector<uint32_t> makePositionInvariant(std::vector<uint32_t> bytecode)
+{
+	constexpr uint32_t OpDecorate = 71;
+	constexpr uint32_t OpMemberDecorate = 72;
+	constexpr uint32_t DecorationBuiltIn = 11;
+	constexpr uint32_t DecorationInvariant = 18;
+	constexpr uint32_t BuiltInPosition = 0;
+	constexpr size_t HeaderSize = 5;
+
+	if (bytecode.size() < HeaderSize)
+		return bytecode;
+
+	// the decoration is added right after the `BuiltIn Position` one,
+	// either on the output variable or on the member of `gl_PerVertex`
+	std::vector<uint32_t> res(bytecode.begin(),
+	                          bytecode.begin() + HeaderSize);
+	res.reserve(bytecode.size() + 4);
+
+	for (size_t i = HeaderSize; i < bytecode.size();)
+	{
+		uint32_t wordCount = bytecode[i] >> 16;
+		uint32_t opcode = bytecode[i] & 0xffff;
+		if (wordCount == 0 || i + wordCount > bytecode.size())
+			return bytecode;
+
+		auto begin = bytecode.begin() + ptrdiff_t(i);
+		res.insert(res.end(), begin, begin + wordCount);
+
+		if (opcode == OpDecorate && wordCount == 4 &&
+		    bytecode[i + 2] == DecorationBuiltIn &&
+		    bytecode[i + 3] == BuiltInPosition)
+		{
+			res.insert(res.end(), { (3u << 16) | OpDecorate, bytecode[i + 1],
+			                        DecorationInvariant });
+		}
+		else if (opcode == OpMemberDecorate && wordCount == 5 &&
+		         bytecode[i + 3] == DecorationBuiltIn &&
+		         bytecode[i + 4] == BuiltInPosition)
+		{
+			res.insert(res.end(),
+			           { (4u << 16) | OpMemberDecorate, bytecode[i + 1],
+			             bytecode[i + 2], DecorationInvariant });
+		}
+
+		i += wordCount;
+	}
+
+	return res;
+}
+}  // namespace cdm
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace cdm
+{
+/// Runs the SPIRV-Tools performance passes (dead code elimination, constant
+/// folding, load/store forwarding, inlining, ...) on the output of
+/// `spirv::serialiseSpirv`. The results of the most recently used inputs are
+/// cached so that rebuilding an identical shader costs a lookup.
+///
+/// Returns `bytecode` untouched if the optimizer fails or if VkRenderer is
+/// built without the `optimizeSpirV` option
+std::vector<uint32_t> optimizeSpirv(std::vector<uint32_t> bytecode);
+
+/// Decorates the `Position` built-in output of a vertex shader as invariant,
+/// so that shaders computing it with the same expression from the same
+/// inputs produce the same depth whatever else they compute, as the depth
+/// pre-pass and the `EQUAL` depth test of the main pass require. To be
+/// applied before `optimizeSpirv`
+std::vector<uint32_t> makePositionInvariant(std::vector<uint32_t> bytecode);
+}  // namespace cdm
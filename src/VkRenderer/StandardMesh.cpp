@@ -1,24 +1,22 @@
 #include "StandardMesh.hpp"
 
 #include "CommandBuffer.hpp"
-#include "RenderWindow.hpp"
+#include "RenderContext.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace cdm
 {
-StandardMesh::StandardMesh(RenderWindow& renderWindow,
+StandardMesh::StandardMesh(RenderContext& renderContext,
                            const std::vector<Vertex>& vertices,
                            const std::vector<uint32_t>& indices)
-    : rw(&renderWindow)
+    : rw(&renderContext)
 {
 	auto& vk = rw.get()->device();
 
-	std::vector<vector4> positions;
-
-	positions.reserve(vertices.size());
-	for (const auto& vertex : vertices)
-		positions.push_back(vector4(vertex.position, 1.0f));
+	std::vector<vector4> positions =
+	    packPositions(vertices, m_boundsMin, m_boundsMax);
 
 	CommandBuffer copyCB(vk, rw.get()->oneTimeCommandPool());
 
@@ -106,6 +104,31 @@ StandardMesh::StandardMesh(RenderWindow& renderWindow,
 #pragma endregion
 }
 
+std::vector<vector4> StandardMesh::packPositions(
+    const std::vector<Vertex>& vertices, vector3& boundsMin,
+    vector3& boundsMax)
+{
+	std::vector<vector4> positions;
+
+	if (!vertices.empty())
+		boundsMin = boundsMax = vertices.front().position;
+
+	positions.reserve(vertices.size());
+	for (const auto& vertex : vertices)
+	{
+		positions.push_back(vector4(vertex.position, 1.0f));
+
+		boundsMin.x = std::min(boundsMin.x, vertex.position.x);
+		boundsMin.y = std::min(boundsMin.y, vertex.position.y);
+		boundsMin.z = std::min(boundsMin.z, vertex.position.z);
+		boundsMax.x = std::max(boundsMax.x, vertex.position.x);
+		boundsMax.y = std::max(boundsMax.y, vertex.position.y);
+		boundsMax.z = std::max(boundsMax.z, vertex.position.z);
+	}
+
+	return positions;
+}
+
 void StandardMesh::draw(CommandBuffer& cb)
 {
 	cb.bindVertexBuffer(m_vertexBuffer.get());
@@ -134,6 +157,40 @@ void StandardMesh::drawPositions(CommandBuffer& cb)
 	}
 }
 
+void StandardMesh::drawIndirect(CommandBuffer& cb, VkBuffer buffer,
+                                VkDeviceSize offset)
+{
+	cb.bindVertexBuffer(m_vertexBuffer.get());
+	if (m_indicesCount != 0)
+	{
+		cb.bindIndexBuffer(m_indexBuffer.get(), 0, VK_INDEX_TYPE_UINT32);
+		cb.drawIndexedIndirect(buffer, offset, 1,
+		                       sizeof(VkDrawIndexedIndirectCommand));
+	}
+	else
+	{
+		cb.drawIndirect(buffer, offset, 1,
+		                sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
+
+void StandardMesh::drawPositionsIndirect(CommandBuffer& cb, VkBuffer buffer,
+                                         VkDeviceSize offset)
+{
+	cb.bindVertexBuffer(m_positionBuffer.get());
+	if (m_indicesCount != 0)
+	{
+		cb.bindIndexBuffer(m_indexBuffer.get(), 0, VK_INDEX_TYPE_UINT32);
+		cb.drawIndexedIndirect(buffer, offset, 1,
+		                       sizeof(VkDrawIndexedIndirectCommand));
+	}
+	else
+	{
+		cb.drawIndirect(buffer, offset, 1,
+		                sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
+
 VertexInputState StandardMesh::vertexInputState()
 {
 	VertexInputState res;
@@ -12,7 +12,7 @@
 namespace cdm
 {
 class CommandBuffer;
-class RenderWindow;
+class RenderContext;
 
 class StandardMesh final
 {
@@ -34,18 +34,21 @@ public:
 	};
 
 private:
-	Movable<RenderWindow*> rw;
+	Movable<RenderContext*> rw;
 
 	uint32_t m_verticesCount = 0;
 	uint32_t m_indicesCount = 0;
 
+	vector3 m_boundsMin;
+	vector3 m_boundsMax;
+
 	Buffer m_vertexBuffer;
 	Buffer m_positionBuffer;
 	Buffer m_indexBuffer;
 
 public:
 	StandardMesh() = default;
-	StandardMesh(RenderWindow& rw, const std::vector<Vertex>& vertices,
+	StandardMesh(RenderContext& rw, const std::vector<Vertex>& vertices,
 	             const std::vector<uint32_t>& indices);
 	StandardMesh(const StandardMesh&) = delete;
 	StandardMesh(StandardMesh&&) = default;
@@ -56,6 +59,15 @@ public:
 
 	void draw(CommandBuffer& cb);
 	void drawPositions(CommandBuffer& cb);
+	/// Draws with the `VkDrawIndexedIndirectCommand` at `offset` in
+	/// `buffer`, meshes without indices read it as a `VkDrawIndirectCommand`
+	void drawIndirect(CommandBuffer& cb, VkBuffer buffer, VkDeviceSize offset);
+	void drawPositionsIndirect(CommandBuffer& cb, VkBuffer buffer,
+	                           VkDeviceSize offset);
+
+	/// Object-space axis-aligned bounding box
+	const vector3& boundsMin() const noexcept { return m_boundsMin; }
+	const vector3& boundsMax() const noexcept { return m_boundsMax; }
 
 	//const std::vector<Vertex>& vertices() const noexcept { return m_vertices; }
 	//const std::vector<vector4>& positions() const noexcept
@@ -64,13 +76,19 @@ public:
 	//}
 	//const std::vector<uint32_t>& indices() const noexcept { return m_indices; }
 
-	//uint32_t verticesCount() const noexcept { return m_verticesCount; }
-	//uint32_t indicesCount() const noexcept { return m_indicesCount; }
+	uint32_t verticesCount() const noexcept { return m_verticesCount; }
+	uint32_t indicesCount() const noexcept { return m_indicesCount; }
 
 	//const Buffer& vertexBuffer() const noexcept { return m_vertexBuffer; }
 	//const Buffer& positionBuffer() const noexcept { return m_positionBuffer; }
 	//const Buffer& indexBuffer() const noexcept { return m_indexBuffer; }
 
+	/// Positions read by the position-only passes and the bounds of
+	/// `vertices`, done on the CPU before the upload
+	static std::vector<vector4> packPositions(
+	    const std::vector<Vertex>& vertices, vector3& boundsMin,
+	    vector3& boundsMax);
+
 	static VertexInputState vertexInputState();
 	static VertexInputState positionOnlyVertexInputState();
 	static ShaderVertexInput shaderVertexInput(sdw::VertexWriter& writer);
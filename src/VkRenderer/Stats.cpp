@@ -0,0 +1,234 @@
+#include "Stats.hpp"
+
+#include "CommandBuffer.hpp"
+
+#include <imgui.h>
+
+#include <iostream>
+#include <string>
+
+namespace cdm
+{
+RecordingStats& RecordingStats::operator+=(const RecordingStats& stats)
+{
+	draws += stats.draws;
+	indirectDraws += stats.indirectDraws;
+	dispatches += stats.dispatches;
+	pipelineBinds += stats.pipelineBinds;
+	descriptorSetBinds += stats.descriptorSetBinds;
+	pushConstants += stats.pushConstants;
+	barriers += stats.barriers;
+	triangles += stats.triangles;
+
+	return *this;
+}
+
+const char* memoryCategoryName(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::Texture: return "textures";
+	case MemoryCategory::Mesh: return "meshes";
+	case MemoryCategory::Staging: return "staging";
+	case MemoryCategory::Uniform: return "uniforms";
+	case MemoryCategory::Other: return "other";
+	default: return "unknown";
+	}
+}
+
+void MemoryStats::allocated(MemoryCategory category, VkDeviceSize size)
+{
+	m_allocationCounts[size_t(category)].fetch_add(1,
+	                                               std::memory_order_relaxed);
+	m_bytes[size_t(category)].fetch_add(size, std::memory_order_relaxed);
+}
+
+void MemoryStats::freed(MemoryCategory category, VkDeviceSize size)
+{
+	m_allocationCounts[size_t(category)].fetch_sub(1,
+	                                               std::memory_order_relaxed);
+	m_bytes[size_t(category)].fetch_sub(size, std::memory_order_relaxed);
+}
+
+uint64_t MemoryStats::allocationCount(MemoryCategory category) const
+{
+	return m_allocationCounts[size_t(category)].load(
+	    std::memory_order_relaxed);
+}
+
+uint64_t MemoryStats::bytes(MemoryCategory category) const
+{
+	return m_bytes[size_t(category)].load(std::memory_order_relaxed);
+}
+
+std::vector<HeapStats> heapStats(const VulkanDevice& vulkanDevice)
+{
+	const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+	vmaGetMemoryProperties(vulkanDevice.allocator(), &memoryProperties);
+
+	std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+	vmaGetBudget(vulkanDevice.allocator(), budgets.data());
+
+	std::vector<HeapStats> res(memoryProperties->memoryHeapCount);
+	for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+	{
+		res[i].flags = memoryProperties->memoryHeaps[i].flags;
+		res[i].size = memoryProperties->memoryHeaps[i].size;
+		res[i].blockBytes = budgets[i].blockBytes;
+		res[i].allocationBytes = budgets[i].allocationBytes;
+		res[i].usage = budgets[i].usage;
+		res[i].budget = budgets[i].budget;
+	}
+
+	return res;
+}
+
+FrameStats::FrameStats(const VulkanDevice& vulkanDevice, uint32_t frameCount)
+    : m_vulkanDevice(&vulkanDevice)
+{
+	auto& vk = vulkanDevice;
+
+	if (!vk.pipelineStatisticsSupported())
+		return;
+
+	vk::QueryPoolCreateInfo queryPoolInfo;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	queryPoolInfo.queryCount = 1;
+	// in the order of `PipelineStatistics`
+	queryPoolInfo.pipelineStatistics =
+	    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+	    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+	m_frames.resize(frameCount);
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		m_frames[i].queryPool = vk.create(queryPoolInfo);
+		if (!m_frames[i].queryPool)
+		{
+			std::cerr << "error: failed to create pipeline statistics "
+			             "query pool"
+			          << std::endl;
+			abort();
+		}
+		vk.debugMarkerSetObjectName(
+		    m_frames[i].queryPool.get(),
+		    "FrameStats::frames[" + std::to_string(i) + "].queryPool");
+	}
+
+	m_currentFrame = frameCount - 1;
+}
+
+void FrameStats::beginFrame(CommandBuffer& cb)
+{
+	m_lastRecording = m_recording;
+	m_recording = RecordingStats{};
+
+	if (!pipelineStatisticsEnabled())
+		return;
+
+	m_currentFrame = (m_currentFrame + 1) % uint32_t(m_frames.size());
+	Frame& frame = m_frames[m_currentFrame];
+
+	if (frame.pending)
+		resolve(frame);
+
+	cb.resetQueryPool(frame.queryPool, 0, 1);
+	cb.beginQuery(frame.queryPool, 0, 0);
+	frame.pending = true;
+}
+
+void FrameStats::endFrame(CommandBuffer& cb)
+{
+	if (pipelineStatisticsEnabled())
+		cb.endQuery(m_frames[m_currentFrame].queryPool, 0);
+}
+
+void FrameStats::add(const CommandBuffer& cb) { m_recording += cb.stats(); }
+
+void FrameStats::resolve(Frame& frame)
+{
+	const auto& vk = *m_vulkanDevice.get();
+
+	std::array<uint64_t, 5> values{};
+	VkResult res = vk.GetQueryPoolResults(
+	    vk.vkDevice(), frame.queryPool, 0, 1,
+	    values.size() * sizeof(uint64_t), values.data(),
+	    values.size() * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (res != VK_SUCCESS)
+		return;
+
+	m_pipelineStatistics.inputAssemblyPrimitives = values[0];
+	m_pipelineStatistics.vertexShaderInvocations = values[1];
+	m_pipelineStatistics.clippingPrimitives = values[2];
+	m_pipelineStatistics.fragmentShaderInvocations = values[3];
+	m_pipelineStatistics.computeShaderInvocations = values[4];
+}
+
+void FrameStats::imgui(const char* windowName) const
+{
+	constexpr double MiB = 1024.0 * 1024.0;
+
+	ImGui::Begin(windowName);
+
+	const RecordingStats& r = m_lastRecording;
+	ImGui::Text("draws: %u (%u indirect)", r.draws + r.indirectDraws,
+	            r.indirectDraws);
+	ImGui::Text("dispatches: %u", r.dispatches);
+	ImGui::Text("pipeline binds: %u", r.pipelineBinds);
+	ImGui::Text("descriptor set binds: %u", r.descriptorSetBinds);
+	ImGui::Text("push constants: %u", r.pushConstants);
+	ImGui::Text("barriers: %u", r.barriers);
+	ImGui::Text("direct triangles: %llu", (unsigned long long)r.triangles);
+
+	if (pipelineStatisticsEnabled())
+	{
+		const PipelineStatistics& p = m_pipelineStatistics;
+		ImGui::Separator();
+		ImGui::Text("input primitives: %llu",
+		            (unsigned long long)p.inputAssemblyPrimitives);
+		ImGui::Text("vertex invocations: %llu",
+		            (unsigned long long)p.vertexShaderInvocations);
+		ImGui::Text("clipping primitives: %llu",
+		            (unsigned long long)p.clippingPrimitives);
+		ImGui::Text("fragment invocations: %llu",
+		            (unsigned long long)p.fragmentShaderInvocations);
+		ImGui::Text("compute invocations: %llu",
+		            (unsigned long long)p.computeShaderInvocations);
+	}
+
+	if (m_vulkanDevice)
+	{
+		const auto& vk = *m_vulkanDevice.get();
+		const MemoryStats& memory = vk.memoryStats();
+
+		ImGui::Separator();
+		for (uint32_t i = 0; i < uint32_t(MemoryCategory::Count); i++)
+		{
+			MemoryCategory category = MemoryCategory(i);
+			ImGui::Text("%s: %llu allocations, %.2f MiB",
+			            memoryCategoryName(category),
+			            (unsigned long long)memory.allocationCount(category),
+			            double(memory.bytes(category)) / MiB);
+		}
+
+		ImGui::Separator();
+		std::vector<HeapStats> heaps = heapStats(vk);
+		for (size_t i = 0; i < heaps.size(); i++)
+		{
+			const HeapStats& heap = heaps[i];
+			ImGui::Text("heap %zu%s: %.1f / %.1f MiB (%.1f MiB in blocks)",
+			            i,
+			            (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			                ? " (device)"
+			                : "",
+			            double(heap.usage) / MiB, double(heap.budget) / MiB,
+			            double(heap.blockBytes) / MiB);
+		}
+	}
+
+	ImGui::End();
+}
+}  // namespace cdm
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace cdm
+{
+class CommandBuffer;
+
+/// Commands recorded by a `CommandBuffer` since its last `begin`
+struct RecordingStats
+{
+	uint32_t draws = 0;
+	uint32_t indirectDraws = 0;
+	uint32_t dispatches = 0;
+	uint32_t pipelineBinds = 0;
+	uint32_t descriptorSetBinds = 0;
+	uint32_t pushConstants = 0;
+	uint32_t barriers = 0;
+	/// of the direct draws only, assuming triangle lists
+	uint64_t triangles = 0;
+
+	RecordingStats& operator+=(const RecordingStats& stats);
+};
+
+enum class MemoryCategory : uint32_t
+{
+	Texture,
+	Mesh,
+	Staging,
+	Uniform,
+	Other,
+
+	Count,
+};
+
+const char* memoryCategoryName(MemoryCategory category);
+
+/// Live allocations made through `Buffer` and the texture classes, per
+/// category. Owned by the `VulkanDevice`, updated from any thread
+class MemoryStats final
+{
+	std::array<std::atomic<uint64_t>, size_t(MemoryCategory::Count)>
+	    m_allocationCounts{};
+	std::array<std::atomic<uint64_t>, size_t(MemoryCategory::Count)>
+	    m_bytes{};
+
+public:
+	void allocated(MemoryCategory category, VkDeviceSize size);
+	void freed(MemoryCategory category, VkDeviceSize size);
+
+	uint64_t allocationCount(MemoryCategory category) const;
+	uint64_t bytes(MemoryCategory category) const;
+};
+
+/// Usage and budget of a memory heap, as estimated by VMA
+struct HeapStats
+{
+	VkMemoryHeapFlags flags = 0;
+	VkDeviceSize size = 0;
+	/// allocated by VMA, used by allocations or not
+	VkDeviceSize blockBytes = 0;
+	VkDeviceSize allocationBytes = 0;
+	/// by this process and others
+	VkDeviceSize usage = 0;
+	VkDeviceSize budget = 0;
+};
+
+std::vector<HeapStats> heapStats(const VulkanDevice& vulkanDevice);
+
+/// Counters of a frame: the commands of its command buffers and, if the
+/// device supports `pipelineStatisticsQuery`, what the GPU executed.
+/// Pipeline statistics are read back with the same ring as `GpuProfiler`,
+/// a few frames late and without waiting
+class FrameStats final
+{
+public:
+	struct PipelineStatistics
+	{
+		uint64_t inputAssemblyPrimitives = 0;
+		uint64_t vertexShaderInvocations = 0;
+		uint64_t clippingPrimitives = 0;
+		uint64_t fragmentShaderInvocations = 0;
+		uint64_t computeShaderInvocations = 0;
+	};
+
+private:
+	struct Frame
+	{
+		UniqueQueryPool queryPool;
+		bool pending = false;
+	};
+
+	Movable<const VulkanDevice*> m_vulkanDevice;
+
+	std::vector<Frame> m_frames;
+	uint32_t m_currentFrame = 0;
+
+	RecordingStats m_recording;
+	RecordingStats m_lastRecording;
+	PipelineStatistics m_pipelineStatistics;
+
+	void resolve(Frame& frame);
+
+public:
+	FrameStats() = default;
+	/// `frameCount` must be greater than the number of frames in flight
+	FrameStats(const VulkanDevice& vulkanDevice, uint32_t frameCount = 3);
+	FrameStats(const FrameStats&) = delete;
+	FrameStats(FrameStats&&) = default;
+	~FrameStats() = default;
+
+	FrameStats& operator=(const FrameStats&) = delete;
+	FrameStats& operator=(FrameStats&&) = default;
+
+	bool pipelineStatisticsEnabled() const noexcept
+	{
+		return !m_frames.empty();
+	}
+
+	/// Starts the frame statistics query, `cb` must not be in a render pass
+	void beginFrame(CommandBuffer& cb);
+	/// Ends the query, to be recorded in the same command buffer as
+	/// `beginFrame`, outside of a render pass
+	void endFrame(CommandBuffer& cb);
+
+	/// Adds the commands of a recorded command buffer to the current frame
+	void add(const CommandBuffer& cb);
+
+	/// Commands of the previous frame
+	const RecordingStats& recording() const noexcept
+	{
+		return m_lastRecording;
+	}
+	/// Latest resolved frame
+	const PipelineStatistics& pipelineStatistics() const noexcept
+	{
+		return m_pipelineStatistics;
+	}
+
+	/// Draws the counters, the memory categories and the heap budgets in an
+	/// ImGui window
+	void imgui(const char* windowName = "Stats") const;
+};
+}  // namespace cdm
@@ -1,8 +1,10 @@
 #include "Texture1D.hpp"
 
 #include "CommandBuffer.hpp"
-#include "RenderWindow.hpp"
+#include "FrameRecorder.hpp"
+#include "RenderContext.hpp"
 #include "StagingBuffer.hpp"
+#include "Stats.hpp"
 
 #include <stdexcept>
 
@@ -10,13 +12,13 @@
 
 namespace cdm
 {
-Texture1D::Texture1D(RenderWindow& renderWindow, uint32_t imageWidth,
+Texture1D::Texture1D(RenderContext& renderContext, uint32_t imageWidth,
                       VkFormat imageFormat,
                      VkImageTiling imageTiling, VkImageUsageFlags usage,
                      VmaMemoryUsage memoryUsage,
                      VkMemoryPropertyFlags requiredFlags, uint32_t mipLevels,
                      VkFilter filter, VkSampleCountFlagBits samples)
-    : rw(&renderWindow)
+    : rw(&renderContext)
 {
 	auto& vk = rw.get()->device();
 
@@ -52,6 +54,8 @@ Texture1D::Texture1D(RenderWindow& renderWindow, uint32_t imageWidth,
 
 	if (m_image == false)
 		throw std::runtime_error("could not create image");
+	vk.memoryStats().allocated(MemoryCategory::Texture, allocInfo.size);
+	vk.frameRecorder().recordImage(m_image.get(), info, imageAllocCreateInfo);
 #pragma endregion
 
 	m_width = imageWidth;
@@ -110,7 +114,12 @@ Texture1D::~Texture1D()
 		if (m_imageView)
 			m_imageView.reset();
 		if (m_image)
+		{
+			vk.memoryStats().freed(MemoryCategory::Texture, m_size);
+			vk.frameRecorder().recordDestruction(
+			    capture::handleId(m_image.get()));
 			vmaDestroyImage(vk.allocator(), m_image.get(), m_allocation.get());
+		}
 	}
 }
 
@@ -7,11 +7,11 @@
 
 namespace cdm
 {
-class RenderWindow;
+class RenderContext;
 
 class Texture1D final : public TextureInterface
 {
-	Movable<RenderWindow*> rw;
+	Movable<RenderContext*> rw;
 
 	Movable<VmaAllocation> m_allocation;
 	Movable<VkImage> m_image;
@@ -30,7 +30,7 @@ class Texture1D final : public TextureInterface
 
 public:
 	Texture1D() = default;
-	Texture1D(RenderWindow& renderWindow, uint32_t imageWidth,
+	Texture1D(RenderContext& renderContext, uint32_t imageWidth,
 	           VkFormat imageFormat,
 	          VkImageTiling imageTiling, VkImageUsageFlags usage,
 	          VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags requiredFlags,
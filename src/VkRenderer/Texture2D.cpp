@@ -2,8 +2,11 @@
 
 #include "CommandBuffer.hpp"
 #include "CommandBufferPool.hpp"
-#include "RenderWindow.hpp"
+#include "CpuProfiler.hpp"
+#include "FrameRecorder.hpp"
+#include "RenderContext.hpp"
 #include "StagingBuffer.hpp"
+#include "Stats.hpp"
 
 #include <stdexcept>
 
@@ -22,7 +25,7 @@ Texture2D::Texture2D(const VulkanDevice& vulkanDevice,
 
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
 	imageInfo.extent.depth = 1;
-	imageInfo.arrayLayers = 1;
+	imageInfo.arrayLayers = std::max(imageInfo.arrayLayers, 1u);
 
 	imageInfo.mipLevels =
 	    std::min(imageInfo.mipLevels,
@@ -37,6 +40,8 @@ Texture2D::Texture2D(const VulkanDevice& vulkanDevice,
 
 	if (m_image == false)
 		throw std::runtime_error("could not create image");
+	vk.memoryStats().allocated(MemoryCategory::Texture, allocInfo.size);
+	vk.frameRecorder().recordImage(m_image.get(), imageInfo, alloceInfo);
 
 	m_width = imageInfo.extent.width;
 	m_height = imageInfo.extent.height;
@@ -44,14 +49,18 @@ Texture2D::Texture2D(const VulkanDevice& vulkanDevice,
 	m_offset = allocInfo.offset;
 	m_size = allocInfo.size;
 	m_mipLevels = imageInfo.mipLevels;
+	m_arrayLayers = imageInfo.arrayLayers;
 	m_samples = imageInfo.samples;
 	m_format = imageInfo.format;
 	m_aspectMask = viewInfo.subresourceRange.aspectMask;
 
 	viewInfo.image = m_image.get();
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	if (m_arrayLayers > 1)
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	else if (viewInfo.viewType != VK_IMAGE_VIEW_TYPE_2D_ARRAY)
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
-	viewInfo.subresourceRange.layerCount = 1;
+	viewInfo.subresourceRange.layerCount = m_arrayLayers;
 	viewInfo.subresourceRange.levelCount = m_mipLevels;
 
 	m_imageView = vk.create(viewInfo);
@@ -72,7 +81,12 @@ Texture2D::~Texture2D()
 		if (m_imageView)
 			m_imageView.reset();
 		if (m_image)
+		{
+			vk.memoryStats().freed(MemoryCategory::Texture, m_size);
+			vk.frameRecorder().recordDestruction(
+			    capture::handleId(m_image.get()));
 			vmaDestroyImage(vk.allocator(), m_image.get(), m_allocation.get());
+		}
 	}
 }
 
@@ -96,7 +110,7 @@ void Texture2D::transitionLayoutImmediate(VkImageLayout oldLayout,
 	barrier.subresourceRange.baseMipLevel = 0;
 	barrier.subresourceRange.levelCount = m_mipLevels;
 	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
+	barrier.subresourceRange.layerCount = m_arrayLayers;
 	barrier.srcAccessMask = 0;
 	barrier.dstAccessMask = 0;
 	transitionCB.pipelineBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
@@ -224,6 +238,7 @@ void Texture2D::uploadDataImmediate(const void* texels, size_t size,
 
 	uploadData(texels, size, region, initialLayout, finalLayout, pool);
 
+	CpuProfiler::Zone zone("texture upload wait");
 	pool.waitForAllCommandBuffers();
 
 	/*
@@ -287,6 +302,8 @@ void Texture2D::uploadData(const void* texels, size_t size,
                            VkImageLayout initialLayout,
                            VkImageLayout finalLayout, CommandBufferPool& pool)
 {
+	CpuProfiler::Zone zone("texture upload");
+
 	auto& vk = *m_vulkanDevice.get();
 
 	StagingBuffer stagingBuffer(vk, texels, size);
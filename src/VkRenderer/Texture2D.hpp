@@ -26,6 +26,7 @@ class Texture2D final : public TextureInterface
 	uint32_t m_height = 0;
 	VkFormat m_format = VK_FORMAT_UNDEFINED;
 	uint32_t m_mipLevels = 0;
+	uint32_t m_arrayLayers = 1;
 	VkSampleCountFlagBits m_samples = VK_SAMPLE_COUNT_1_BIT;
 	VkImageAspectFlags m_aspectMask = 0;
 
@@ -57,6 +58,7 @@ public:
 	VkDeviceSize offset() const override { return m_offset; }
 	VkFormat format() const override { return m_format; }
 	uint32_t mipLevels() const override { return m_mipLevels; }
+	uint32_t arrayLayers() const { return m_arrayLayers; }
 	VkSampleCountFlagBits samples() const override { return m_samples; }
 	VkDeviceMemory deviceMemory() const override
 	{
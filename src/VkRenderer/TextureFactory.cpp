@@ -111,6 +111,12 @@ void TextureFactory::setMipLevels(uint32_t mipLevels)
 	m_imageInfo.mipLevels = mipLevels;
 }
 
+void TextureFactory::setArrayLayers(uint32_t arrayLayers)
+{
+	m_imageInfo.arrayLayers = arrayLayers;
+	m_viewInfo.subresourceRange.layerCount = arrayLayers;
+}
+
 void TextureFactory::setSamples(VkSampleCountFlagBits samples)
 {
 	m_imageInfo.samples = samples;
@@ -126,6 +132,11 @@ void TextureFactory::setAspectMask(VkImageAspectFlags aspectMask)
 	m_viewInfo.subresourceRange.aspectMask = aspectMask;
 }
 
+void TextureFactory::setViewType(VkImageViewType viewType)
+{
+	m_viewInfo.viewType = viewType;
+}
+
 void TextureFactory::setViewComponents(const VkComponentMapping& components)
 {
 	m_viewInfo.components = components;
@@ -40,10 +40,12 @@ public:
 	void setMemoryUsage(VmaMemoryUsage memoryUsage);
 	void setRequieredMemoryProperties(VkMemoryPropertyFlags requiredFlags);
 	void setMipLevels(uint32_t mipLevels);
+	void setArrayLayers(uint32_t arrayLayers);
 	void setSamples(VkSampleCountFlagBits samples);
 	void setSharingMode(VkSharingMode sharingMode);
 	void setAspectMask(VkImageAspectFlags aspectMask);
 
+	void setViewType(VkImageViewType viewType);
 	void setViewComponents(const VkComponentMapping& components);
 	void setViewSubresourceRange(const VkImageSubresourceRange& range);
 
@@ -0,0 +1,162 @@
+#include "TextureTable.hpp"
+
+#include "TextureInterface.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+
+namespace cdm
+{
+TextureTable::TextureTable(const VulkanDevice& vulkanDevice,
+                           uint32_t framesInFlight)
+    : m_vulkanDevice(&vulkanDevice),
+      m_framesInFlight(std::max(framesInFlight, 1u))
+{
+	auto& vk = *m_vulkanDevice.get();
+
+#pragma region descriptor pool
+	std::array poolSizes{
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		                      MaxTextureCount },
+	};
+
+	vk::DescriptorPoolCreateInfo poolInfo;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = uint32_t(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	m_descriptorPool = vk.create(poolInfo);
+	if (!m_descriptorPool)
+	{
+		std::cerr << "error: failed to create descriptor pool" << std::endl;
+		abort();
+	}
+#pragma endregion
+
+#pragma region descriptor set layout
+	VkDescriptorSetLayoutBinding layoutBindingTextures{};
+	layoutBindingTextures.binding = 0;
+	layoutBindingTextures.descriptorCount = MaxTextureCount;
+	layoutBindingTextures.descriptorType =
+	    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	layoutBindingTextures.stageFlags =
+	    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorBindingFlagsEXT bindingFlags =
+	    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+	    VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+	    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+	vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo;
+	bindingFlagsInfo.bindingCount = 1;
+	bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+	vk::DescriptorSetLayoutCreateInfo setLayoutInfo;
+	setLayoutInfo.pNext = &bindingFlagsInfo;
+	setLayoutInfo.flags =
+	    VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	setLayoutInfo.bindingCount = 1;
+	setLayoutInfo.pBindings = &layoutBindingTextures;
+
+	m_descriptorSetLayout = vk.create(setLayoutInfo);
+	if (!m_descriptorSetLayout)
+	{
+		std::cerr << "error: failed to create descriptor set layout"
+		          << std::endl;
+		abort();
+	}
+#pragma endregion
+
+#pragma region descriptor set
+	m_descriptorSet = vk.allocate(m_descriptorPool, m_descriptorSetLayout);
+
+	if (!m_descriptorSet)
+	{
+		std::cerr << "error: failed to allocate descriptor set" << std::endl;
+		abort();
+	}
+#pragma endregion
+
+	m_slots.resize(MaxTextureCount);
+
+	// lowest slots are handed out first
+	m_freeSlots.reserve(MaxTextureCount);
+	for (uint32_t i = MaxTextureCount; i > 0; i--)
+		m_freeSlots.push_back(i - 1);
+
+	m_slotsByView.reserve(MaxTextureCount);
+}
+
+uint32_t TextureTable::registerTexture(const TextureInterface& texture)
+{
+	auto found = m_slotsByView.find(texture.view());
+	if (found != m_slotsByView.end())
+	{
+		m_slots[found->second].refCount++;
+		return found->second;
+	}
+
+	if (m_freeSlots.empty())
+		throw std::runtime_error("texture table is full");
+
+	uint32_t slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+
+	m_slots[slot].view = texture.view();
+	m_slots[slot].refCount = 1;
+	m_slotsByView[texture.view()] = slot;
+
+	VkDescriptorImageInfo imageInfo =
+	    texture.makeDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	vk::WriteDescriptorSet textureWrite;
+	textureWrite.descriptorCount = 1;
+	textureWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureWrite.dstArrayElement = slot;
+	textureWrite.dstBinding = 0;
+	textureWrite.dstSet = m_descriptorSet;
+	textureWrite.pImageInfo = &imageInfo;
+
+	m_vulkanDevice.get()->updateDescriptorSets(textureWrite);
+
+	return slot;
+}
+
+void TextureTable::unregisterTexture(uint32_t slot)
+{
+	if (slot >= MaxTextureCount || m_slots[slot].refCount == 0)
+		throw std::runtime_error("texture slot is not registered");
+
+	Slot& s = m_slots[slot];
+	s.refCount--;
+	if (s.refCount > 0)
+		return;
+
+	m_slotsByView.erase(s.view);
+	s.view = nullptr;
+
+	// the descriptor may still be read by the frames in flight, rewriting
+	// it now would change their texture
+	m_quarantinedSlots.push_back({ slot, m_framesInFlight });
+}
+
+void TextureTable::beginFrame()
+{
+	for (QuarantinedSlot& quarantined : m_quarantinedSlots)
+	{
+		quarantined.framesLeft--;
+		if (quarantined.framesLeft == 0)
+			m_freeSlots.push_back(quarantined.slot);
+	}
+
+	m_quarantinedSlots.erase(
+	    std::remove_if(m_quarantinedSlots.begin(), m_quarantinedSlots.end(),
+	                   [](const QuarantinedSlot& quarantined) {
+		                   return quarantined.framesLeft == 0;
+	                   }),
+	    m_quarantinedSlots.end());
+}
+}  // namespace cdm
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "VulkanDevice.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace cdm
+{
+class TextureInterface;
+
+/// Bindless array of combined image samplers shared by every material.
+/// Textures are registered once and referenced in shaders by their slot,
+/// unused slots are left unbound (`VK_EXT_descriptor_indexing`).
+class TextureTable final
+{
+public:
+	static constexpr uint32_t MaxTextureCount = 1024;
+	static constexpr uint32_t InvalidSlot = ~0u;
+
+private:
+	Movable<const VulkanDevice*> m_vulkanDevice;
+
+	UniqueDescriptorPool m_descriptorPool;
+	UniqueDescriptorSetLayout m_descriptorSetLayout;
+	Movable<VkDescriptorSet> m_descriptorSet;
+
+	struct Slot
+	{
+		VkImageView view = nullptr;
+		uint32_t refCount = 0;
+	};
+
+	/// Released slot the frames in flight may still sample
+	struct QuarantinedSlot
+	{
+		uint32_t slot = 0;
+		uint32_t framesLeft = 0;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<QuarantinedSlot> m_quarantinedSlots;
+	std::unordered_map<VkImageView, uint32_t> m_slotsByView;
+	uint32_t m_framesInFlight = 1;
+
+public:
+	TextureTable() = default;
+	TextureTable(const VulkanDevice& vulkanDevice, uint32_t framesInFlight);
+	TextureTable(const TextureTable&) = delete;
+	TextureTable(TextureTable&&) = default;
+	~TextureTable() = default;
+
+	TextureTable& operator=(const TextureTable&) = delete;
+	TextureTable& operator=(TextureTable&&) = default;
+
+	/// Returns the slot of `texture`, writing its descriptor if it was not
+	/// registered yet. Each call must be matched by an `unregisterTexture`
+	uint32_t registerTexture(const TextureInterface& texture);
+	/// Releases a reference to `slot`. Once no reference is left the slot
+	/// is reused after `framesInFlight` calls to `beginFrame`, the texture
+	/// must be kept alive until then
+	void unregisterTexture(uint32_t slot);
+
+	/// Frame boundary of the slot releases, must be called once per frame
+	/// before recording it
+	void beginFrame();
+
+	uint32_t textureCount() const noexcept
+	{
+		return uint32_t(m_slotsByView.size());
+	}
+
+	const VkDescriptorSetLayout& descriptorSetLayout() const noexcept
+	{
+		return m_descriptorSetLayout;
+	}
+	const VkDescriptorSet& descriptorSet() const noexcept
+	{
+		return m_descriptorSet;
+	}
+};
+}  // namespace cdm
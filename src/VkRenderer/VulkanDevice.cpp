@@ -1,10 +1,20 @@
 #define VMA_IMPLEMENTATION
 #include "VulkanDevice.hpp"
 
+#include "FrameRecorder.hpp"
+#include "LayoutCache.hpp"
+#include "Stats.hpp"
+
 //#define VK_NO_PROTOTYPES
 //#define VK_USE_PLATFORM_WIN32_KHR
 //#include "cdm_vulkan.hpp"
 
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <optional>
@@ -47,7 +57,11 @@ VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDeviceBase::DebugUtilsMessengerCallback(
 
 VulkanDeviceBase::VulkanDeviceBase(bool layers) noexcept : m_layers(layers)
 {
+#ifdef _WIN32
 	VulkanLibrary = LoadLibraryW(L"vulkan-1.dll");
+#else
+	VulkanLibrary = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+#endif
 
 	if (VulkanLibrary == nullptr)
 	{
@@ -55,8 +69,13 @@ VulkanDeviceBase::VulkanDeviceBase(bool layers) noexcept : m_layers(layers)
 		exit(1);
 	}
 
+#ifdef _WIN32
 	GetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)GetProcAddress(
 	    VulkanLibrary, "vkGetInstanceProcAddr");
+#else
+	GetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)dlsym(
+	    VulkanLibrary, "vkGetInstanceProcAddr");
+#endif
 	if (!GetInstanceProcAddr)
 	{
 		std::cerr << "error: could not load vkGetInstanceProcAddr"
@@ -120,15 +139,58 @@ VulkanDeviceBase::VulkanDeviceBase(bool layers) noexcept : m_layers(layers)
 		}
 	}
 
+	uint32_t extensionCount;
+	std::vector<VkExtensionProperties> availableExtensions;
+
+	EnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+	availableExtensions.resize(extensionCount);
+	EnumerateInstanceExtensionProperties(nullptr, &extensionCount,
+	                                     availableExtensions.data());
+
+	bool khrSurfaceFound = false;
+	bool khrWin32SurfaceFound = false;
+	bool khrGetSurfaceCapabilities2Found = false;
+	bool khrGetPhysicalDeviceProperties2Found = false;
+	bool extDebugReportFound = false;
+	bool extDebugUtilsFound = false;
+	for (const auto& ext : availableExtensions)
+	{
+		std::string_view name(ext.extensionName);
+		if (name == VK_KHR_SURFACE_EXTENSION_NAME)
+			khrSurfaceFound = true;
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+		else if (name == VK_KHR_WIN32_SURFACE_EXTENSION_NAME)
+			khrWin32SurfaceFound = true;
+#endif
+		else if (name == VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME)
+			khrGetSurfaceCapabilities2Found = true;
+		else if (name ==
+		         VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
+			khrGetPhysicalDeviceProperties2Found = true;
+		else if (name == VK_EXT_DEBUG_REPORT_EXTENSION_NAME)
+			extDebugReportFound = true;
+		else if (name == VK_EXT_DEBUG_UTILS_EXTENSION_NAME)
+			extDebugUtilsFound = true;
+	}
+
+	// surface extensions are missing from headless drivers and servers
 	std::vector<const char*> instanceExtensions;
-	instanceExtensions.push_back(
-	    VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME);
-	instanceExtensions.push_back(
-	    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
-	instanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-	instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
-	instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
-	instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	if (khrGetSurfaceCapabilities2Found)
+		instanceExtensions.push_back(
+		    VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME);
+	if (khrGetPhysicalDeviceProperties2Found)
+		instanceExtensions.push_back(
+		    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	if (khrSurfaceFound)
+		instanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	if (khrWin32SurfaceFound)
+		instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#endif
+	if (extDebugReportFound)
+		instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+	if (extDebugUtilsFound)
+		instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
 	vk::InstanceCreateInfo instanceInfo = {};
 	instanceInfo.pApplicationInfo = &appInfo;
@@ -178,38 +240,6 @@ VulkanDeviceBase::VulkanDeviceBase(bool layers) noexcept : m_layers(layers)
 	LOAD(GetPhysicalDeviceSparseImageFormatProperties);
 	LOAD(GetPhysicalDeviceSparseImageFormatProperties2);
 
-	uint32_t extensionCount;
-	std::vector<VkExtensionProperties> availableExtensions;
-
-	EnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
-	availableExtensions.resize(extensionCount);
-	EnumerateInstanceExtensionProperties(nullptr, &extensionCount,
-	                                     availableExtensions.data());
-
-	bool khrSurfaceFound = false;
-	bool khrWin32SurfaceFound = false;
-	bool khrGetSurfaceCapabilities2Found = false;
-	bool khrGetPhysicalDeviceProperties2Found = false;
-	bool extDebugReportFound = false;
-	bool extDebugUtilsFound = false;
-	for (const auto& ext : availableExtensions)
-	{
-		std::string_view name(ext.extensionName);
-		if (name == VK_KHR_SURFACE_EXTENSION_NAME)
-			khrSurfaceFound = true;
-		else if (name == VK_KHR_WIN32_SURFACE_EXTENSION_NAME)
-			khrWin32SurfaceFound = true;
-		else if (name == VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME)
-			khrGetSurfaceCapabilities2Found = true;
-		else if (name ==
-		         VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
-			khrGetPhysicalDeviceProperties2Found = true;
-		else if (name == VK_EXT_DEBUG_REPORT_EXTENSION_NAME)
-			extDebugReportFound = true;
-		else if (name == VK_EXT_DEBUG_UTILS_EXTENSION_NAME)
-			extDebugUtilsFound = true;
-	}
-
 	if (khrSurfaceFound)
 	{
 		LOAD(DestroySurfaceKHR);
@@ -218,11 +248,13 @@ VulkanDeviceBase::VulkanDeviceBase(bool layers) noexcept : m_layers(layers)
 		LOAD(GetPhysicalDeviceSurfaceFormatsKHR);
 		LOAD(GetPhysicalDeviceSurfacePresentModesKHR);
 	}
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 	if (khrWin32SurfaceFound)
 	{
 		LOAD(CreateWin32SurfaceKHR);
 		LOAD(GetPhysicalDeviceWin32PresentationSupportKHR);
 	}
+#endif
 	if (khrGetSurfaceCapabilities2Found)
 	{
 		LOAD(GetPhysicalDeviceSurfaceCapabilities2KHR);
@@ -347,6 +379,7 @@ void VulkanDeviceBase::destroy(VkSurfaceKHR surface) const
 	destroySurface(surface);
 }
 
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 VkResult VulkanDeviceBase::createSurface(
     const cdm::vk::Win32SurfaceCreateInfoKHR& createInfo,
     VkSurfaceKHR& outSurface) const
@@ -361,6 +394,7 @@ VkResult VulkanDeviceBase::create(
 {
 	return createSurface(createInfo, outSurface);
 }
+#endif
 
 // ================================================================
 
@@ -373,7 +407,9 @@ static int rateDeviceSuitability(VkPhysicalDevice physicalDevice,
 	VkPhysicalDeviceFeatures deviceFeatures;
 	vk.GetPhysicalDeviceFeatures(physicalDevice, &deviceFeatures);
 
-	int score = 0;
+	// any device can run the renderer, CPU implementations such as lavapipe
+	// included
+	int score = 1;
 
 	// Discrete GPUs have a significant performance advantage
 	if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
@@ -479,7 +515,10 @@ void VulkanDeviceDestroyer::createDevice(VkSurfaceKHR surface,
 		VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
 		VK_KHR_BIND_MEMORY_2_EXTENSION_NAME,
 		VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+		VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+		VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
 		VK_EXT_DEBUG_MARKER_EXTENSION_NAME,
+		VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME,
 	};
 
 	std::vector<const char*> optionalDeviceExtensions = {
@@ -530,11 +569,58 @@ void VulkanDeviceDestroyer::createDevice(VkSurfaceKHR surface,
 		exit(1);
 	}
 
+	m_pushDescriptorSupported =
+	    std::find_if(requiredDeviceExtensions.begin(),
+	                 requiredDeviceExtensions.end(), [](const char* ext) {
+		                 return std::string_view(ext) ==
+		                        VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME;
+	                 }) != requiredDeviceExtensions.end();
+
+	VkPhysicalDeviceFeatures supportedFeatures;
+	GetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+	m_pipelineStatisticsSupported = supportedFeatures.pipelineStatisticsQuery;
+
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.shaderFloat64 = true;
 	deviceFeatures.fillModeNonSolid = true;
+	deviceFeatures.pipelineStatisticsQuery = m_pipelineStatisticsSupported;
+
+	// bindless material textures
+	vk::PhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexingFeatures;
+	vk::PhysicalDeviceFeatures2 supportedFeatures2;
+	supportedFeatures2.pNext = &supportedIndexingFeatures;
+	GetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures2);
+
+	if (!supportedIndexingFeatures.descriptorBindingPartiallyBound ||
+	    !supportedIndexingFeatures
+	         .descriptorBindingSampledImageUpdateAfterBind ||
+	    !supportedIndexingFeatures.descriptorBindingUpdateUnusedWhilePending)
+	{
+		std::cerr << "error: required descriptor indexing feature(s) not "
+		             "supported"
+		          << std::endl;
+		if (!supportedIndexingFeatures.descriptorBindingPartiallyBound)
+			std::cerr << "    descriptorBindingPartiallyBound" << std::endl;
+		if (!supportedIndexingFeatures
+		         .descriptorBindingSampledImageUpdateAfterBind)
+			std::cerr << "    descriptorBindingSampledImageUpdateAfterBind"
+			          << std::endl;
+		if (!supportedIndexingFeatures
+		         .descriptorBindingUpdateUnusedWhilePending)
+			std::cerr << "    descriptorBindingUpdateUnusedWhilePending"
+			          << std::endl;
+		exit(1);
+	}
+
+	vk::PhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures;
+	descriptorIndexingFeatures.descriptorBindingPartiallyBound = true;
+	descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind =
+	    true;
+	descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending =
+	    true;
 
 	vk::DeviceCreateInfo createInfo;
+	createInfo.pNext = &descriptorIndexingFeatures;
 	createInfo.queueCreateInfoCount = uint32_t(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.pEnabledFeatures = &deviceFeatures;
@@ -596,28 +682,49 @@ void VulkanDeviceDestroyer::createDevice(VkSurfaceKHR surface,
 	LOAD(GetPhysicalDeviceQueueFamilyProperties2);
 	LOAD(GetPhysicalDeviceSparseImageFormatProperties);
 	LOAD(GetPhysicalDeviceSparseImageFormatProperties2);
-	LOAD(DestroySurfaceKHR);
-	LOAD(GetPhysicalDeviceSurfaceSupportKHR);
-	LOAD(GetPhysicalDeviceSurfaceCapabilitiesKHR);
-	LOAD(GetPhysicalDeviceSurfaceFormatsKHR);
-	LOAD(GetPhysicalDeviceSurfacePresentModesKHR);
-	LOAD(CreateWin32SurfaceKHR);
-	LOAD(GetPhysicalDeviceWin32PresentationSupportKHR);
-	LOAD(GetPhysicalDeviceSurfaceCapabilities2KHR);
-	LOAD(GetPhysicalDeviceSurfaceFormats2KHR);
-	LOAD(GetPhysicalDeviceFeatures2KHR);
-	LOAD(GetPhysicalDeviceFormatProperties2KHR);
-	LOAD(GetPhysicalDeviceImageFormatProperties2KHR);
-	LOAD(GetPhysicalDeviceMemoryProperties2KHR);
-	LOAD(GetPhysicalDeviceProperties2KHR);
-	LOAD(GetPhysicalDeviceQueueFamilyProperties2KHR);
-	LOAD(GetPhysicalDeviceSparseImageFormatProperties2KHR);
-	LOAD(CreateDebugReportCallbackEXT);
-	LOAD(DebugReportMessageEXT);
-	LOAD(DestroyDebugReportCallbackEXT);
-	LOAD(CreateDebugUtilsMessengerEXT);
-	LOAD(DestroyDebugUtilsMessengerEXT);
-	LOAD(SubmitDebugUtilsMessageEXT);
+	// extension functions stay null if the instance did not enable them
+	if (DestroySurfaceKHR)
+	{
+		LOAD(DestroySurfaceKHR);
+		LOAD(GetPhysicalDeviceSurfaceSupportKHR);
+		LOAD(GetPhysicalDeviceSurfaceCapabilitiesKHR);
+		LOAD(GetPhysicalDeviceSurfaceFormatsKHR);
+		LOAD(GetPhysicalDeviceSurfacePresentModesKHR);
+	}
+#ifdef VK_USE_PLATFORM_WIN32_KHR
+	if (CreateWin32SurfaceKHR)
+	{
+		LOAD(CreateWin32SurfaceKHR);
+		LOAD(GetPhysicalDeviceWin32PresentationSupportKHR);
+	}
+#endif
+	if (GetPhysicalDeviceSurfaceCapabilities2KHR)
+	{
+		LOAD(GetPhysicalDeviceSurfaceCapabilities2KHR);
+		LOAD(GetPhysicalDeviceSurfaceFormats2KHR);
+	}
+	if (GetPhysicalDeviceFeatures2KHR)
+	{
+		LOAD(GetPhysicalDeviceFeatures2KHR);
+		LOAD(GetPhysicalDeviceFormatProperties2KHR);
+		LOAD(GetPhysicalDeviceImageFormatProperties2KHR);
+		LOAD(GetPhysicalDeviceMemoryProperties2KHR);
+		LOAD(GetPhysicalDeviceProperties2KHR);
+		LOAD(GetPhysicalDeviceQueueFamilyProperties2KHR);
+		LOAD(GetPhysicalDeviceSparseImageFormatProperties2KHR);
+	}
+	if (CreateDebugReportCallbackEXT)
+	{
+		LOAD(CreateDebugReportCallbackEXT);
+		LOAD(DebugReportMessageEXT);
+		LOAD(DestroyDebugReportCallbackEXT);
+	}
+	if (CreateDebugUtilsMessengerEXT)
+	{
+		LOAD(CreateDebugUtilsMessengerEXT);
+		LOAD(DestroyDebugUtilsMessengerEXT);
+		LOAD(SubmitDebugUtilsMessageEXT);
+	}
 
 #undef LOAD
 #define LOAD(func)                                                            \
@@ -811,6 +918,12 @@ void VulkanDeviceDestroyer::createDevice(VkSurfaceKHR surface,
 	LOAD(WaitForFences);
 	// LOAD(WaitSemaphores);
 
+	if (m_pushDescriptorSupported)
+	{
+		LOAD(CmdPushDescriptorSetKHR);
+		LOAD(CmdPushDescriptorSetWithTemplateKHR);
+	}
+
 	LOAD_OPTIONAL(CmdDebugMarkerBeginEXT);
 	LOAD_OPTIONAL(CmdDebugMarkerEndEXT);
 	LOAD_OPTIONAL(CmdDebugMarkerInsertEXT);
@@ -922,7 +1035,14 @@ VkResult VulkanDeviceDestroyer::allocateDescriptorSets(
     const cdm::vk::DescriptorSetAllocateInfo& allocateInfo,
     VkDescriptorSet* pDescriptorSets) const
 {
-	return AllocateDescriptorSets(vkDevice(), &allocateInfo, pDescriptorSets);
+	VkResult res =
+	    AllocateDescriptorSets(vkDevice(), &allocateInfo, pDescriptorSets);
+	if (res == VK_SUCCESS)
+	{
+		if (FrameRecorder* frameRecorder = recorder())
+			frameRecorder->recordDescriptorSets(allocateInfo, pDescriptorSets);
+	}
+	return res;
 }
 
 VkResult VulkanDeviceDestroyer::allocate(
@@ -964,8 +1084,18 @@ VkResult VulkanDeviceDestroyer::createComputePipelines(
     uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos,
     VkPipeline* pPipelines, VkPipelineCache pipelineCache) const
 {
-	return CreateComputePipelines(vkDevice(), pipelineCache, createInfoCount,
-	                              pCreateInfos, nullptr, pPipelines);
+	VkResult res =
+	    CreateComputePipelines(vkDevice(), pipelineCache, createInfoCount,
+	                           pCreateInfos, nullptr, pPipelines);
+	if (res == VK_SUCCESS)
+	{
+		if (FrameRecorder* frameRecorder = recorder())
+		{
+			frameRecorder->recordComputePipelines(createInfoCount, pCreateInfos,
+			                                      pPipelines);
+		}
+	}
+	return res;
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -981,8 +1111,10 @@ VkResult VulkanDeviceDestroyer::createComputePipelines(
     const cdm::vk::ComputePipelineCreateInfo* pCreateInfos,
     VkPipeline* pPipelines, VkPipelineCache pipelineCache) const
 {
-	return CreateComputePipelines(vkDevice(), pipelineCache, createInfoCount,
-	                              pCreateInfos, nullptr, pPipelines);
+	return createComputePipelines(
+	    createInfoCount,
+	    static_cast<const VkComputePipelineCreateInfo*>(pCreateInfos),
+	    pPipelines, pipelineCache);
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -998,8 +1130,9 @@ VkResult VulkanDeviceDestroyer::createComputePipeline(
     const cdm::vk::ComputePipelineCreateInfo& createInfo,
     VkPipeline& outPipeline, VkPipelineCache pipelineCache) const
 {
-	return CreateComputePipelines(vkDevice(), pipelineCache, 1, &createInfo,
-	                              nullptr, &outPipeline);
+	return createComputePipelines(
+	    1, static_cast<const VkComputePipelineCreateInfo*>(&createInfo),
+	    &outPipeline, pipelineCache);
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -1022,8 +1155,18 @@ VkResult VulkanDeviceDestroyer::createGraphicsPipelines(
     uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos,
     VkPipeline* pPipelines, VkPipelineCache pipelineCache) const
 {
-	return CreateGraphicsPipelines(vkDevice(), pipelineCache, createInfoCount,
-	                               pCreateInfos, nullptr, pPipelines);
+	VkResult res =
+	    CreateGraphicsPipelines(vkDevice(), pipelineCache, createInfoCount,
+	                            pCreateInfos, nullptr, pPipelines);
+	if (res == VK_SUCCESS)
+	{
+		if (FrameRecorder* frameRecorder = recorder())
+		{
+			frameRecorder->recordGraphicsPipelines(
+			    createInfoCount, pCreateInfos, pPipelines);
+		}
+	}
+	return res;
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -1039,8 +1182,10 @@ VkResult VulkanDeviceDestroyer::createGraphicsPipelines(
     const cdm::vk::GraphicsPipelineCreateInfo* pCreateInfos,
     VkPipeline* pPipelines, VkPipelineCache pipelineCache) const
 {
-	return CreateGraphicsPipelines(vkDevice(), pipelineCache, createInfoCount,
-	                               pCreateInfos, nullptr, pPipelines);
+	return createGraphicsPipelines(
+	    createInfoCount,
+	    static_cast<const VkGraphicsPipelineCreateInfo*>(pCreateInfos),
+	    pPipelines, pipelineCache);
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -1056,8 +1201,9 @@ VkResult VulkanDeviceDestroyer::createGraphicsPipeline(
     const cdm::vk::GraphicsPipelineCreateInfo& createInfo,
     VkPipeline& outPipeline, VkPipelineCache pipelineCache) const
 {
-	return CreateGraphicsPipelines(vkDevice(), pipelineCache, 1, &createInfo,
-	                               nullptr, &outPipeline);
+	return createGraphicsPipelines(
+	    1, static_cast<const VkGraphicsPipelineCreateInfo*>(&createInfo),
+	    &outPipeline, pipelineCache);
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -1080,8 +1226,11 @@ VkResult VulkanDeviceDestroyer::createRenderPass2(
     const cdm::vk::RenderPassCreateInfo2& createInfo,
     VkRenderPass& outRenderPass) const
 {
-	return CreateRenderPass2KHR(vkDevice(), &createInfo, nullptr,
-	                            &outRenderPass);
+	VkResult res =
+	    CreateRenderPass2KHR(vkDevice(), &createInfo, nullptr, &outRenderPass);
+	if (res == VK_SUCCESS)
+		traceCreation(&createInfo, (uint64_t)(outRenderPass));
+	return res;
 }
 
 VkResult VulkanDeviceDestroyer::create(
@@ -1266,6 +1415,34 @@ UniqueShaderModule VulkanDevice::createShaderModule(
 	return UniqueShaderModule(res, *this);
 }
 
+std::shared_ptr<FrameRecorder> VulkanDevice::createFrameRecorder() const
+{
+	return std::make_shared<FrameRecorder>(*this);
+}
+
+std::shared_ptr<LayoutCache> VulkanDevice::createLayoutCache() const
+{
+	return std::make_shared<LayoutCache>(*this);
+}
+
+std::shared_ptr<MemoryStats> VulkanDevice::createMemoryStats() const
+{
+	return std::make_shared<MemoryStats>();
+}
+
+void VulkanDeviceDestroyer::traceCreation(const void* createInfo,
+                                          uint64_t handle) const
+{
+	if (FrameRecorder* frameRecorder = recorder())
+		frameRecorder->recordCreation(createInfo, handle);
+}
+
+void VulkanDeviceDestroyer::traceDestruction(uint64_t handle) const
+{
+	if (FrameRecorder* frameRecorder = recorder())
+		frameRecorder->recordDestruction(handle);
+}
+
 void VulkanDeviceDestroyer::destroyDevice() const
 {
 	DestroyDevice(vkDevice(), nullptr);
@@ -1310,6 +1487,9 @@ VkResult VulkanDeviceDestroyer::freeDescriptorSets(
     VkDescriptorPool descriptorPool, uint32_t descriptorSetCount,
     const VkDescriptorSet* pDescriptorSets) const
 {
+	for (uint32_t i = 0; i < descriptorSetCount; i++)
+		traceDestruction((uint64_t)(pDescriptorSets[i]));
+
 	return FreeDescriptorSets(vkDevice(), descriptorPool, descriptorSetCount,
 	                          pDescriptorSets);
 }
@@ -1324,7 +1504,7 @@ VkResult VulkanDeviceDestroyer::free(
 VkResult VulkanDeviceDestroyer::freeDescriptorSets(
     VkDescriptorPool descriptorPool, VkDescriptorSet DescriptorSet) const
 {
-	return FreeDescriptorSets(vkDevice(), descriptorPool, 1, &DescriptorSet);
+	return freeDescriptorSets(descriptorPool, 1, &DescriptorSet);
 }
 
 VkResult VulkanDeviceDestroyer::free(VkDescriptorPool descriptorPool,
@@ -1358,6 +1538,9 @@ VkResult VulkanDeviceDestroyer::queueSubmit(VkQueue queue,
                                             const VkSubmitInfo* submits,
                                             VkFence fence) const
 {
+	if (FrameRecorder* frameRecorder = recorder())
+		frameRecorder->recordSubmission(submitCount, submits);
+
 	return QueueSubmit(queue, submitCount, submits, fence);
 }
 
@@ -1453,6 +1636,15 @@ VkResult VulkanDeviceDestroyer::resetCommandPool(
 	return ResetCommandPool(vkDevice(), pool, flags);
 }
 
+VkResult VulkanDeviceDestroyer::resetDescriptorPool(
+    VkDescriptorPool pool) const
+{
+	if (FrameRecorder* frameRecorder = recorder())
+		frameRecorder->recordDescriptorPoolReset(pool);
+
+	return ResetDescriptorPool(vkDevice(), pool, 0);
+}
+
 VkResult VulkanDeviceDestroyer::resetFences(uint32_t fenceCount,
                                             const VkFence* fences) const
 {
@@ -1476,6 +1668,14 @@ void VulkanDeviceDestroyer::updateDescriptorSets(
     uint32_t descriptorCopyCount,
     const vk::CopyDescriptorSet* descriptorCopies) const
 {
+	if (FrameRecorder* frameRecorder = recorder())
+	{
+		frameRecorder->recordDescriptorUpdates(descriptorWriteCount,
+		                                       descriptorWrites,
+		                                       descriptorCopyCount,
+		                                       descriptorCopies);
+	}
+
 	UpdateDescriptorSets(vkDevice(), descriptorWriteCount, descriptorWrites,
 	                     descriptorCopyCount, descriptorCopies);
 }
@@ -1520,6 +1720,21 @@ void VulkanDeviceDestroyer::updateDescriptorSets(
 	                     descriptorCopies.begin());
 }
 
+void VulkanDeviceDestroyer::updateDescriptorSetWithTemplate(
+    VkDescriptorSet descriptorSet,
+    VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+    const void* pData) const
+{
+	if (FrameRecorder* frameRecorder = recorder())
+	{
+		frameRecorder->recordDescriptorUpdate(descriptorSet,
+		                                      descriptorUpdateTemplate, pData);
+	}
+
+	UpdateDescriptorSetWithTemplate(vkDevice(), descriptorSet,
+	                                descriptorUpdateTemplate, pData);
+}
+
 VkResult VulkanDeviceDestroyer::wait(uint32_t fenceCount,
                                      const VkFence* pFences, bool waitAll,
                                      uint64_t timeout) const
@@ -1631,4 +1846,12 @@ LogRRID::LogRRID(const VulkanDevice& vulkanDevice) : m_device(vulkanDevice)
 }
 
 LogRRID::~LogRRID() { m_device.get().setLogInactive(); }
+
+void VulkanDeviceObject::setCreationTime()
+{
+	// only compared between objects, the clock origin does not matter
+	m_creationTime = std::chrono::duration<double>(
+	                     std::chrono::steady_clock::now().time_since_epoch())
+	                     .count();
+}
 }  // namespace cdm
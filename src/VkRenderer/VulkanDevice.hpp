@@ -7,12 +7,15 @@
 // #include <libloaderapi.h>
 
 #define VK_NO_PROTOTYPES
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define VMA_DYNAMIC_VULKAN_FUNCTIONS 0
 #include "cdm_vulkan.hpp"
 #include "vk_mem_alloc.h"
 
 #include <initializer_list>
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <utility>
@@ -22,6 +25,11 @@
 
 namespace cdm
 {
+class FrameRecorder;
+class LayoutCache;
+class MemoryStats;
+class ShaderArchive;
+
 struct QueueFamilyIndices
 {
 	std::optional<uint32_t> graphicsFamily;
@@ -58,7 +66,11 @@ public:
 
 	VkInstance instance() const { return m_instance; }
 
+#ifdef _WIN32
 	HMODULE VulkanLibrary;
+#else
+	void* VulkanLibrary;
+#endif
 
 	// clang-format off
 	PFN_vkGetInstanceProcAddr GetInstanceProcAddr;
@@ -95,7 +107,7 @@ public:
 	PFN_vkGetPhysicalDeviceSparseImageFormatProperties2 GetPhysicalDeviceSparseImageFormatProperties2;
 
 	// VK_KHR_SURFACE_EXTENSION
-	PFN_vkDestroySurfaceKHR DestroySurfaceKHR;
+	PFN_vkDestroySurfaceKHR DestroySurfaceKHR = nullptr;
 public:
 	void destroySurface(VkSurfaceKHR surface) const;
 	void destroy(VkSurfaceKHR surface) const;
@@ -105,20 +117,22 @@ public:
 	PFN_vkGetPhysicalDeviceSurfacePresentModesKHR GetPhysicalDeviceSurfacePresentModesKHR;
 	PFN_vkGetPhysicalDeviceSurfaceSupportKHR GetPhysicalDeviceSurfaceSupportKHR;
 
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 	// VK_KHR_WIN32_SURFACE_EXTENSION_NAME
-	PFN_vkCreateWin32SurfaceKHR CreateWin32SurfaceKHR;
+	PFN_vkCreateWin32SurfaceKHR CreateWin32SurfaceKHR = nullptr;
 public:
 	VkResult createSurface(const vk::Win32SurfaceCreateInfoKHR& createInfo, VkSurfaceKHR& outSurface) const;
 	VkResult create(const vk::Win32SurfaceCreateInfoKHR& createInfo, VkSurfaceKHR& outSurface) const;
 
 	PFN_vkGetPhysicalDeviceWin32PresentationSupportKHR GetPhysicalDeviceWin32PresentationSupportKHR;
+#endif
 
 	// VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME
-	PFN_vkGetPhysicalDeviceSurfaceCapabilities2KHR GetPhysicalDeviceSurfaceCapabilities2KHR;
+	PFN_vkGetPhysicalDeviceSurfaceCapabilities2KHR GetPhysicalDeviceSurfaceCapabilities2KHR = nullptr;
 	PFN_vkGetPhysicalDeviceSurfaceFormats2KHR GetPhysicalDeviceSurfaceFormats2KHR;
 
 	// VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME
-	PFN_vkGetPhysicalDeviceFeatures2KHR GetPhysicalDeviceFeatures2KHR;
+	PFN_vkGetPhysicalDeviceFeatures2KHR GetPhysicalDeviceFeatures2KHR = nullptr;
 	PFN_vkGetPhysicalDeviceFormatProperties2KHR GetPhysicalDeviceFormatProperties2KHR;
 	PFN_vkGetPhysicalDeviceImageFormatProperties2KHR GetPhysicalDeviceImageFormatProperties2KHR;
 	PFN_vkGetPhysicalDeviceMemoryProperties2KHR GetPhysicalDeviceMemoryProperties2KHR;
@@ -127,13 +141,13 @@ public:
 	PFN_vkGetPhysicalDeviceSparseImageFormatProperties2KHR GetPhysicalDeviceSparseImageFormatProperties2KHR;
 
 	// VK_EXT_DEBUG_REPORT_EXTENSION_NAME
-	PFN_vkCreateDebugReportCallbackEXT CreateDebugReportCallbackEXT;
+	PFN_vkCreateDebugReportCallbackEXT CreateDebugReportCallbackEXT = nullptr;
 	PFN_vkDebugReportMessageEXT DebugReportMessageEXT;
-	PFN_vkDestroyDebugReportCallbackEXT DestroyDebugReportCallbackEXT;
+	PFN_vkDestroyDebugReportCallbackEXT DestroyDebugReportCallbackEXT = nullptr;
 
 	// VK_EXT_DEBUG_UTILS_EXTENSION_NAME
-	PFN_vkCreateDebugUtilsMessengerEXT CreateDebugUtilsMessengerEXT;
-	PFN_vkDestroyDebugUtilsMessengerEXT DestroyDebugUtilsMessengerEXT;
+	PFN_vkCreateDebugUtilsMessengerEXT CreateDebugUtilsMessengerEXT = nullptr;
+	PFN_vkDestroyDebugUtilsMessengerEXT DestroyDebugUtilsMessengerEXT = nullptr;
 	PFN_vkSubmitDebugUtilsMessageEXT SubmitDebugUtilsMessageEXT;
 	// clang-format on
 
@@ -161,6 +175,14 @@ protected:
 
 	Movable<VmaAllocator> m_allocator = nullptr;
 
+	bool m_pushDescriptorSupported = false;
+	bool m_pipelineStatisticsSupported = false;
+
+	/// Null until the `VulkanDevice` is constructed
+	virtual FrameRecorder* recorder() const { return nullptr; }
+	void traceCreation(const void* createInfo, uint64_t handle) const;
+	void traceDestruction(uint64_t handle) const;
+
 public:
 	VulkanDeviceDestroyer(bool layers = false) noexcept;
 	~VulkanDeviceDestroyer() override;
@@ -177,6 +199,13 @@ public:
 		return m_queueFamilyIndices;
 	}
 	VmaAllocator allocator() const { return m_allocator.get(); }
+	/// `VK_KHR_push_descriptor` is enabled
+	bool pushDescriptorSupported() const { return m_pushDescriptorSupported; }
+	/// `pipelineStatisticsQuery` is enabled
+	bool pipelineStatisticsSupported() const
+	{
+		return m_pipelineStatisticsSupported;
+	}
 
 	using VulkanDeviceBase::create;
 	using VulkanDeviceBase::createSurface;
@@ -313,6 +342,7 @@ public:
 public:                                                          \
 	void destroy##ObjectName(Vk##ObjectName a##ObjectName) const \
 	{                                                            \
+		traceDestruction((uint64_t)(a##ObjectName));             \
 		Destroy##ObjectName(vkDevice(), a##ObjectName, nullptr); \
 	}                                                            \
 	void destroy(Vk##ObjectName a##ObjectName) const             \
@@ -413,7 +443,10 @@ public:
 public:                                                                                                                     \
 	VkResult create##ObjectName(const vk:: ObjectName##CreateInfo& createInfo, Vk##ObjectName& out##ObjectName) const      \
 	{                                                                                                                       \
-		return Create##ObjectName(vkDevice(), &createInfo, nullptr, &out##ObjectName);                                      \
+		VkResult res = Create##ObjectName(vkDevice(), &createInfo, nullptr, &out##ObjectName);                              \
+		if (res == VK_SUCCESS)                                                                                              \
+			traceCreation(&createInfo, (uint64_t)(out##ObjectName));                                                        \
+		return res;                                                                                                         \
 	}                                                                                                                       \
 	VkResult create(const vk:: ObjectName##CreateInfo& createInfo, Vk##ObjectName& out##ObjectName) const                  \
 	{                                                                                                                       \
@@ -557,6 +590,7 @@ public:
 	PFN_vkResetCommandPool ResetCommandPool;
 	VkResult resetCommandPool(VkCommandPool pool, VkCommandPoolResetFlags flags) const;
 	PFN_vkResetDescriptorPool ResetDescriptorPool;
+	VkResult resetDescriptorPool(VkDescriptorPool pool) const;
 	PFN_vkResetEvent ResetEvent;
 
 	PFN_vkResetFences ResetFences;
@@ -580,6 +614,7 @@ public:
 	void updateDescriptorSets(std::initializer_list<vk::CopyDescriptorSet> descriptorCopies) const;
 
 	PFN_vkUpdateDescriptorSetWithTemplate UpdateDescriptorSetWithTemplate;
+	void updateDescriptorSetWithTemplate(VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplate descriptorUpdateTemplate, const void* pData) const;
 
 
 	PFN_vkWaitForFences WaitForFences;
@@ -924,6 +959,7 @@ public:
 
 	PFN_vkResetQueryPoolEXT ResetQueryPoolEXT = nullptr;
 
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 	PFN_vkGetMemoryWin32HandleKHR GetMemoryWin32HandleKHR = nullptr;
 	PFN_vkGetMemoryWin32HandlePropertiesKHR GetMemoryWin32HandlePropertiesKHR = nullptr;
 
@@ -938,6 +974,7 @@ public:
 	PFN_vkAcquireFullScreenExclusiveModeEXT AcquireFullScreenExclusiveModeEXT = nullptr;
 	PFN_vkGetDeviceGroupSurfacePresentModes2EXT GetDeviceGroupSurfacePresentModes2EXT = nullptr;
 	PFN_vkGetPhysicalDeviceSurfacePresentModes2EXT GetPhysicalDeviceSurfacePresentModes2EXT = nullptr;
+#endif
 	PFN_vkReleaseFullScreenExclusiveModeEXT ReleaseFullScreenExclusiveModeEXT = nullptr;
 	// clang-format on
 };
@@ -1056,6 +1093,38 @@ public:
 	UniqueSemaphore                create                         (const vk::SemaphoreCreateInfo& createInfo)                const { return createSemaphore(createInfo); }
 	UniqueShaderModule             createShaderModule             (const vk::ShaderModuleCreateInfo& createInfo)             const;
 	UniqueShaderModule             create                         (const vk::ShaderModuleCreateInfo& createInfo)             const { return createShaderModule(createInfo); }
+
+	/// Layouts shared by the pipeline factories, destroyed with the device
+	LayoutCache& layoutCache() const { return *m_layoutCache; }
+
+	/// Prebuilt shaders looked up by `createShaderModule`, to be set before
+	/// creating the objects that use them
+	const ShaderArchive* shaderArchive() const { return m_shaderArchive.get(); }
+	void setShaderArchive(std::shared_ptr<const ShaderArchive> archive) const
+	{
+		m_shaderArchive = std::move(archive);
+	}
+
+	/// Allocations of the `Buffer` and texture objects of this device
+	MemoryStats& memoryStats() const { return *m_memoryStats; }
+
+	/// Frame capture for `FrameReplayer`, see `FrameRecorder::setTracking`
+	FrameRecorder& frameRecorder() const { return *m_frameRecorder; }
+
+protected:
+	FrameRecorder* recorder() const override { return m_frameRecorder.get(); }
+
+private:
+	std::shared_ptr<FrameRecorder> createFrameRecorder() const;
+	std::shared_ptr<LayoutCache> createLayoutCache() const;
+	std::shared_ptr<MemoryStats> createMemoryStats() const;
+
+	/// destroyed last, the other members report their destructions to it
+	std::shared_ptr<FrameRecorder> m_frameRecorder = createFrameRecorder();
+	/// destroyed before the device
+	std::shared_ptr<LayoutCache> m_layoutCache = createLayoutCache();
+	mutable std::shared_ptr<const ShaderArchive> m_shaderArchive;
+	std::shared_ptr<MemoryStats> m_memoryStats = createMemoryStats();
 };
 
 class VulkanDeviceObject
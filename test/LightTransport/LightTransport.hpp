@@ -85,19 +85,19 @@ class LightTransport final
 
 	UniqueDescriptorPool m_descriptorPool;
 
-	std::vector<UniqueDescriptorSetLayout> m_setLayouts;
+	std::vector<VkDescriptorSetLayout> m_setLayouts;
 	Movable<VkDescriptorSet> m_descriptorSet;
-	UniquePipelineLayout m_pipelineLayout;
+	VkPipelineLayout m_pipelineLayout = nullptr;
 	UniqueGraphicsPipeline m_pipeline;
 
-	std::vector<UniqueDescriptorSetLayout> m_blitSetLayouts;
+	std::vector<VkDescriptorSetLayout> m_blitSetLayouts;
 	Movable<VkDescriptorSet> m_blitDescriptorSet;
-	UniquePipelineLayout m_blitPipelineLayout;
+	VkPipelineLayout m_blitPipelineLayout = nullptr;
 	UniqueGraphicsPipeline m_blitPipeline;
 
-	std::vector<UniqueDescriptorSetLayout> m_traceSetLayouts;
+	std::vector<VkDescriptorSetLayout> m_traceSetLayouts;
 	Movable<VkDescriptorSet> m_traceDescriptorSet;
-	UniquePipelineLayout m_tracePipelineLayout;
+	VkPipelineLayout m_tracePipelineLayout = nullptr;
 	UniqueComputePipeline m_tracePipeline;
 
 	Buffer m_raysBuffer;
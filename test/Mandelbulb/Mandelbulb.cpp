@@ -1682,15 +1682,3 @@ void Mandelbulb::setSampleAndRandomize(float s)
 	m_computeUbo.unmap();
 }
 }  // namespace cdm
-
-#include <chrono>
-
-int main()
-{
-	using namespace cdm;
-
-	RenderWindow rw(1280, 720, true);
-	Mandelbulb mandelbulb(rw);
-
-	return mandelbulb.run();
-}
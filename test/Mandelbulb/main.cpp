@@ -0,0 +1,11 @@
+#include "Mandelbulb.hpp"
+
+int main()
+{
+	using namespace cdm;
+
+	RenderWindow rw(1280, 720, true);
+	Mandelbulb mandelbulb(rw);
+
+	return mandelbulb.run();
+}
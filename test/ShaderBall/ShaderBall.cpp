@@ -2,6 +2,7 @@
 
 #include "CommandBufferPool.hpp"
 #include "EquirectangularToCubemap.hpp"
+#include "ShaderArchive.hpp"
 #include "TextureFactory.hpp"
 
 #include <CompilerSpirV/compileSpirV.hpp>
@@ -25,7 +26,9 @@
 //#include "load_dds.hpp"
 //#include "stb_image.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 #include <string_view>
@@ -430,19 +433,32 @@ static void processNode(RenderWindow& rw, aiNode* node, const aiScene* scene,
 	}
 }
 
-ShaderBall::ShaderBall(RenderWindow& renderWindow)
+ShaderBall::ShaderBall(RenderWindow& renderWindow,
+                       const StressScene& stressScene)
     : rw(renderWindow),
-      m_shadingModel(rw.get().device(), 1, 1),
-      m_defaultMaterial(rw, m_shadingModel, 1000),
+      m_shadingModel(rw.get().device(), std::max(stressScene.pointLights, 1u),
+                     1, rw.get().framesInFlight()),
+      m_defaultMaterial(rw, m_shadingModel, 1000 + stressScene.materials),
       m_scene(renderWindow),
+      m_stressScene(stressScene),
       imguiCB(CommandBuffer(rw.get().device(), rw.get().oneTimeCommandPool())),
       copyHDRCB(
-          CommandBuffer(rw.get().device(), rw.get().oneTimeCommandPool()))
+          CommandBuffer(rw.get().device(), rw.get().oneTimeCommandPool())),
+      // one more slot than frames in flight, the oldest one is done
+      m_gpuProfiler(rw.get().device(), rw.get().framesInFlight() + 1),
+      m_frameStats(rw.get().device(), rw.get().framesInFlight() + 1)
 {
 	auto& vk = rw.get().device();
 
 	LogRRID log(vk);
 
+	// built by the ShaderArchiver target, shaders missing from it are
+	// generated at runtime
+	vk.setShaderArchive(
+	    std::make_shared<ShaderArchive>("../runtime_cache/shaders.spva"));
+
+	m_scene.setPipelineCompiler(&m_pipelineCompiler);
+
 	Assimp::Importer importer;
 
 #pragma region bunny mesh
@@ -567,6 +583,11 @@ ShaderBall::ShaderBall(RenderWindow& renderWindow)
 
 	CommandBufferPool sponzaPool(vk, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
 
+	const auto roughnessHandle =
+	    m_defaultMaterial.parameterHandle<float>("roughness");
+	const auto metalnessHandle =
+	    m_defaultMaterial.parameterHandle<float>("metalness");
+
 	m_sponzaMaterialInstances.resize(sponzaScene->mNumMaterials);
 	for (size_t i = 0; i < sponzaScene->mNumMaterials; i++)
 	{
@@ -750,8 +771,8 @@ ShaderBall::ShaderBall(RenderWindow& renderWindow)
 
 		m_sponzaMaterialInstances[i]->setTextureParameter(
 		    "", *m_sponzaTextures[path]);
-		m_sponzaMaterialInstances[i]->setFloatParameter("roughness", 0.9f);
-		m_sponzaMaterialInstances[i]->setFloatParameter("metalness", 0.0f);
+		m_sponzaMaterialInstances[i]->setParameter(roughnessHandle, 0.9f);
+		m_sponzaMaterialInstances[i]->setParameter(metalnessHandle, 0.0f);
 
 		if (i % 16 == 15)
 			sponzaPool.waitForAllCommandBuffers();
@@ -876,6 +897,7 @@ ShaderBall::ShaderBall(RenderWindow& renderWindow)
 		if (m_sponzaMaterialInstances[mesh->mMaterialIndex])
 			sponzaSceneObject->setMaterial(
 			    *m_sponzaMaterialInstances[mesh->mMaterialIndex]);
+		sponzaSceneObject->mobility = SceneObject::Mobility::Static;
 		m_sponzaSceneObjects.push_back(sponzaSceneObject);
 	}
 #pragma endregion
@@ -1047,7 +1069,8 @@ ShaderBall::ShaderBall(RenderWindow& renderWindow)
 	depthAttachment.format = rw.get().depthImageFormat();
 	depthAttachment.samples = VK_SAMPLE_COUNT_4_BIT;
 	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	// kept for the depth pyramid
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachment.initialLayout =
@@ -2154,16 +2177,70 @@ ShaderBall::ShaderBall(RenderWindow& renderWindow)
 	m_sphereSceneObject->setMesh(m_sphereMesh);
 	m_sphereSceneObject->setMaterial(*m_materialInstance3);
 #pragma endregion
+
+	if (stressed())
+		buildStressScene();
 }
 
 ShaderBall::~ShaderBall() = default;
 
+void ShaderBall::buildStressScene()
+{
+	for (SceneObject* sceneObject : m_sponzaSceneObjects)
+		m_scene.removeSceneObject(*sceneObject);
+	m_sponzaSceneObjects.clear();
+
+	uint32_t materialCount = std::max(m_stressScene.materials, 1u);
+	m_stressMaterialInstances.resize(materialCount);
+	for (uint32_t i = 0; i < materialCount; i++)
+	{
+		float t = (float(i) + 0.5f) / float(materialCount);
+
+		auto* materialInstance = m_defaultMaterial.instanciate();
+		materialInstance->setFloatParameter("roughness", t);
+		materialInstance->setFloatParameter("metalness", float(i % 2));
+		materialInstance->setVec4Parameter("color",
+		                                   vector4(t, 1.0f - t, 0.5f, 1.0f));
+		m_stressMaterialInstances[i] = materialInstance;
+	}
+
+	uint32_t side =
+	    uint32_t(std::ceil(std::sqrt(float(m_stressScene.objects))));
+	float offset = float(side - 1) * m_stressScene.spacing / 2.0f;
+
+	m_stressSceneObjects.resize(m_stressScene.objects);
+	for (uint32_t i = 0; i < m_stressScene.objects; i++)
+	{
+		auto* sceneObject = &m_scene.instantiateSceneObject();
+		sceneObject->setMesh(m_sphereMesh);
+		sceneObject->setMaterial(
+		    *m_stressMaterialInstances[i % materialCount]);
+		sceneObject->transform.position = {
+			float(i % side) * m_stressScene.spacing - offset, 1.0f,
+			float(i / side) * m_stressScene.spacing - offset
+		};
+		sceneObject->transform.scale = { 0.5f, 0.5f, 0.5f };
+		sceneObject->mobility = SceneObject::Mobility::Static;
+		m_stressSceneObjects[i] = sceneObject;
+	}
+}
+
+float ShaderBall::stressSceneRadius() const
+{
+	float side = std::ceil(std::sqrt(float(m_stressScene.objects)));
+	return side * m_stressScene.spacing / 2.0f;
+}
+
 void ShaderBall::renderOpaque(CommandBuffer& cb)
 {
 	{
-		cb.debugMarkerBegin("shadows", 0.2f, 0.2f, 0.4f);
-		m_scene.drawShadowmapPass(cb);
-		cb.debugMarkerEnd();
+		{
+			auto scope =
+			    m_gpuProfiler.scope(cb, "shadows", { 0.2f, 0.2f, 0.4f, 1.0f });
+			m_scene.drawShadowmapPass(cb);
+		}
+
+		m_scene.cullOcclusion(cb);
 
 		VkClearValue clearColor{};
 		clearColor.color.float32[0] = 0X27 / 255.0f;
@@ -2206,9 +2283,11 @@ void ShaderBall::renderOpaque(CommandBuffer& cb)
 
 		cb.beginRenderPass2(rpInfo, subpassBeginInfo);
 
-		cb.debugMarkerBegin("skybox", 0.8f, 0.8f, 1.0f);
-		m_skybox->render(cb);
-		cb.debugMarkerEnd();
+		{
+			auto scope =
+			    m_gpuProfiler.scope(cb, "skybox", { 0.8f, 0.8f, 1.0f, 1.0f });
+			m_skybox->render(cb);
+		}
 
 		// cb.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
 		// cb.bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -2233,16 +2312,24 @@ void ShaderBall::renderOpaque(CommandBuffer& cb)
 		// m_bunnyPipeline.bindDescriptorSet(cb);
 		// m_bunnyPipeline.draw(cb);
 
-		cb.debugMarkerBegin("main", 0.3f, 0.8f, 0.4f);
-		m_scene.draw(cb, m_renderPass, std::make_optional(viewport),
-		             std::make_optional(scissor));
-		cb.debugMarkerEnd();
+		{
+			auto scope =
+			    m_gpuProfiler.scope(cb, "main", { 0.3f, 0.8f, 0.4f, 1.0f });
+			m_scene.draw(cb, m_renderPass, std::make_optional(viewport),
+			             std::make_optional(scissor));
+		}
 
 		// m_bunnySceneObject->draw(cb, m_renderPass, viewport, scissor);
 		// m_bunnySceneObject2->draw(cb, m_renderPass, viewport, scissor);
 		// m_bunnySceneObject3->draw(cb, m_renderPass, viewport, scissor);
 
 		cb.endRenderPass2(subpassEndInfo);
+
+		{
+			auto scope = m_gpuProfiler.scope(cb, "depth pyramid",
+			                                 { 0.5f, 0.5f, 0.5f, 1.0f });
+			m_scene.buildDepthPyramid(cb);
+		}
 	}
 	{
 		vk::ImageMemoryBarrier barrier;
@@ -2290,7 +2377,7 @@ void ShaderBall::renderOpaque(CommandBuffer& cb)
 		std::array clearValues = { clearColor, /*clearID,*/ clearDepth };
 
 		vk::RenderPassBeginInfo rpInfo;
-		rpInfo.framebuffer = m_highlightFramebuffer;
+		rpInfo.framebuffer = outputFramebuffer();
 		rpInfo.renderPass = m_highlightRenderPass;
 		rpInfo.renderArea.extent.width = rw.get().swapchainExtent().width;
 		rpInfo.renderArea.extent.height = rw.get().swapchainExtent().height;
@@ -2302,7 +2389,30 @@ void ShaderBall::renderOpaque(CommandBuffer& cb)
 
 		vk::SubpassEndInfo subpassEndInfo;
 
-		cb.debugMarkerBegin("post process", 8.0f, 0.3f, 0.4f);
+		if (renderToSwapchain())
+		{
+			// fully overwritten, the previous content is discarded
+			vk::ImageMemoryBarrier outputBarrier;
+			outputBarrier.image = outputImage();
+			outputBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			outputBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			outputBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			outputBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			outputBarrier.subresourceRange.aspectMask =
+			    VK_IMAGE_ASPECT_COLOR_BIT;
+			outputBarrier.subresourceRange.baseMipLevel = 0;
+			outputBarrier.subresourceRange.levelCount = 1;
+			outputBarrier.subresourceRange.baseArrayLayer = 0;
+			outputBarrier.subresourceRange.layerCount = 1;
+			outputBarrier.srcAccessMask = 0;
+			outputBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			cb.pipelineBarrier(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			                   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+			                   outputBarrier);
+		}
+
+		auto scope = m_gpuProfiler.scope(cb, "post process",
+		                                 { 8.0f, 0.3f, 0.4f, 1.0f });
 		cb.beginRenderPass2(rpInfo, subpassBeginInfo);
 
 		cb.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_highlightPipeline);
@@ -2336,8 +2446,6 @@ void ShaderBall::renderOpaque(CommandBuffer& cb)
 		barrier.image = m_positionResolveTexture;
 		cb.pipelineBarrier(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 		                   VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, barrier);
-
-		cb.debugMarkerEnd();
 	}
 }
 
@@ -2365,6 +2473,50 @@ void ShaderBall::imgui(CommandBuffer& cb)
 		ImGui::Begin("Lights");
 
 		ImGui::DragFloat("shadow bias", &m_scene.shadowBias, 0.0001f);
+		ImGui::DragFloat("shadow distance", &m_scene.shadowDistance, 1.0f,
+		                 1.0f, 1000.0f);
+		ImGui::SliderFloat("cascade split lambda", &m_scene.cascadeSplitLambda,
+		                   0.0f, 1.0f);
+		ImGui::Checkbox("shadowmap caching", &m_scene.shadowmapCaching);
+		ImGui::Checkbox("depth pre-pass", &m_scene.depthPrepass);
+		ImGui::Text("pipelines compiling: %u",
+		            m_pipelineCompiler.pendingJobCount());
+		if (ImGui::Button("reload shaders"))
+			m_shadingModel.invalidateShaders();
+		int presentMode = int(rw.get().presentMode());
+		if (ImGui::Combo("present mode", &presentMode,
+		                 "immediate\0mailbox\0FIFO\0FIFO relaxed\0"))
+			rw.get().setPresentMode(VkPresentModeKHR(presentMode));
+		// in frames per second, 0 for no limit
+		float frameRateLimit =
+		    rw.get().targetFrameTime() > 0.0
+		        ? float(1.0 / rw.get().targetFrameTime())
+		        : 0.0f;
+		if (ImGui::DragFloat("frame rate limit", &frameRateLimit, 1.0f, 0.0f,
+		                     500.0f))
+			rw.get().setTargetFrameTime(
+			    frameRateLimit > 0.0f ? 1.0 / frameRateLimit : 0.0);
+		if (!CpuProfiler::capturing())
+		{
+			if (ImGui::Button("start trace capture"))
+			{
+				m_gpuProfiler.calibrate();
+				m_gpuProfiler.startCapture();
+				CpuProfiler::startCapture();
+			}
+		}
+		else if (ImGui::Button("stop trace capture"))
+		{
+			CpuProfiler::stopCapture();
+			m_gpuProfiler.stopCapture();
+			CpuProfiler::writeChromeTrace("trace.json",
+			                              m_gpuProfiler.capturedResults());
+		}
+		int occlusionCulling = int(m_scene.occlusionCulling);
+		if (ImGui::Combo("occlusion culling", &occlusionCulling,
+		                 "disabled\0CPU\0GPU\0"))
+			m_scene.occlusionCulling =
+			    Scene::OcclusionCulling(occlusionCulling);
 		ImGui::DragFloat("R", &m_scene.R, 0.01f);
 		ImGui::SliderFloat("sigma", &m_scene.sigma, -Pi / 2.0f, Pi / 2.0f);
 		ImGui::SliderFloat("roughness", &m_scene.roughness, 0.0f, 0.7f);
@@ -2504,10 +2656,13 @@ void ShaderBall::imgui(CommandBuffer& cb)
 		//*/
 	}
 
+	m_gpuProfiler.imgui();
+	m_frameStats.imgui();
+
 	ImGui::Render();
 
 	vk::ImageMemoryBarrier barrier;
-	barrier.image = m_highlightColorAttachmentTexture;
+	barrier.image = outputImage();
 	barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
 	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -2529,7 +2684,7 @@ void ShaderBall::imgui(CommandBuffer& cb)
 		std::array clearValues = { VkClearValue{}, VkClearValue{} };
 
 		vk::RenderPassBeginInfo rpInfo;
-		rpInfo.framebuffer = m_highlightFramebuffer.get();
+		rpInfo.framebuffer = outputFramebuffer();
 		rpInfo.renderPass = rw.get().imguiRenderPass();
 		rpInfo.renderArea.extent.width = rw.get().swapchainExtent().width;
 		rpInfo.renderArea.extent.height = rw.get().swapchainExtent().height;
@@ -2548,7 +2703,9 @@ void ShaderBall::imgui(CommandBuffer& cb)
 	cb.endRenderPass2(subpassEndInfo2);
 
 	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.newLayout = renderToSwapchain()
+	                        ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+	                        : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	barrier.srcAccessMask = 0;
 	barrier.dstAccessMask = 0;
 	cb.pipelineBarrier(
@@ -2557,6 +2714,22 @@ void ShaderBall::imgui(CommandBuffer& cb)
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, barrier);
 }
 
+VkImage ShaderBall::outputImage()
+{
+	if (renderToSwapchain())
+		return rw.get().swapchainImages()[rw.get().imageIndex()];
+
+	return m_highlightColorAttachmentTexture;
+}
+
+VkFramebuffer ShaderBall::outputFramebuffer()
+{
+	if (renderToSwapchain())
+		return m_swapchainHighlightFramebuffers[rw.get().imageIndex()];
+
+	return m_highlightFramebuffer;
+}
+
 void ShaderBall::standaloneDraw()
 {
 	auto& vk = rw.get().device();
@@ -2641,19 +2814,38 @@ void ShaderBall::standaloneDraw()
 	auto* shadingModelData =
 	    m_shadingModel.m_shadingModelStaging
 	        .map<PbrShadingModel::ShadingModelUboStruct>();
-	shadingModelData->pointLightsCount = pointEnabled;
+	shadingModelData->pointLightsCount =
+	    stressed() ? m_stressScene.pointLights : uint32_t(pointEnabled);
 	shadingModelData->directionalLightsCount = directionalEnabled;
 	m_shadingModel.m_shadingModelStaging.unmap();
 	m_shadingModel.uploadShadingModelDataStaging();
 
 	auto* pointLights = m_shadingModel.m_pointLightsStaging
 	                        .map<PbrShadingModel::PointLightUboStruct>();
-	pointLights->color = vector4(1.0f, 1.0f, 1.0f, 1.0f) * 80.f;
-	pointLights->intensity = 1.0f;
-	if (pointAtCameraEnabled)
-		lightPos = cameraTr.position;
+	if (stressed())
+	{
+		// the total power does not depend on the light count
+		uint32_t count = m_stressScene.pointLights;
+		float radius = stressSceneRadius();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float angle = 2.0f * Pi * float(i) / float(count);
+			pointLights[i].position = vector3(std::cos(angle) * radius, 10.0f,
+			                                  std::sin(angle) * radius);
+			pointLights[i].color =
+			    vector4(1.0f, 1.0f, 1.0f, 1.0f) * (80.0f / float(count));
+			pointLights[i].intensity = 1.0f;
+		}
+	}
+	else
+	{
+		pointLights->color = vector4(1.0f, 1.0f, 1.0f, 1.0f) * 80.f;
+		pointLights->intensity = 1.0f;
+		if (pointAtCameraEnabled)
+			lightPos = cameraTr.position;
 
-	pointLights->position = lightPos;
+		pointLights->position = lightPos;
+	}
 	m_shadingModel.m_pointLightsStaging.unmap();
 	m_shadingModel.uploadPointLightsStaging();
 
@@ -2685,18 +2877,36 @@ void ShaderBall::standaloneDraw()
 
 	m_skybox->setMatrices(m_config.proj, m_config.view);
 
+	m_scene.applyShaderReloads();
+	m_shadingModel.textureTable().beginFrame();
+	m_defaultMaterial.beginFrame();
+
+	// the output image must be known before recording
+	if (renderToSwapchain())
+		rw.get().acquireFrameImage();
+
 	auto& frame = rw.get().getAvailableCommandBuffer();
 	frame.reset();
 	// vk.resetFence(frame.fence);
 	auto& cb = frame.commandBuffer;
 
 	// cb.reset();
-	cb.begin();
-	renderOpaque(cb);
-	cb.debugMarkerBegin("imgui", 0.2f, 0.2f, 1.0f);
-	imgui(cb);
-	cb.debugMarkerEnd();
-	cb.end();
+	{
+		CpuProfiler::Zone zone("record");
+
+		cb.begin();
+		m_gpuProfiler.beginFrame(cb);
+		m_frameStats.beginFrame(cb);
+		renderOpaque(cb);
+		{
+			auto scope =
+			    m_gpuProfiler.scope(cb, "imgui", { 0.2f, 0.2f, 1.0f, 1.0f });
+			imgui(cb);
+		}
+		m_frameStats.endFrame(cb);
+		cb.end();
+		m_frameStats.add(cb);
+	}
 
 	// vk::SubmitInfo drawSubmit;
 	// drawSubmit.commandBufferCount = 1;
@@ -2708,23 +2918,39 @@ void ShaderBall::standaloneDraw()
 	////if (vk.queueSubmit(vk.graphicsQueue(), imguiCB) != VK_SUCCESS)
 	// if (vk.queueSubmit(vk.graphicsQueue(), drawSubmit) != VK_SUCCESS)
 
-	if (vk.queueSubmit(vk.graphicsQueue(), cb, VkSemaphore(frame.semaphore),
-	                   VkFence(frame.fence)) != VK_SUCCESS)
 	{
-		std::cerr << "error: failed to submit ShaderBall command buffer"
-		          << std::endl;
-		abort();
+		CpuProfiler::Zone zone("submit");
+
+		VkResult submitResult;
+		if (renderToSwapchain())
+			submitResult = vk.queueSubmit(
+			    vk.graphicsQueue(), cb, rw.get().imageAcquiredSemaphore(),
+			    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			    VkSemaphore(frame.semaphore), VkFence(frame.fence));
+		else
+			submitResult = vk.queueSubmit(vk.graphicsQueue(), cb,
+			                              VkSemaphore(frame.semaphore),
+			                              VkFence(frame.fence));
+		if (submitResult != VK_SUCCESS)
+		{
+			std::cerr << "error: failed to submit ShaderBall command buffer"
+			          << std::endl;
+			abort();
+		}
+		frame.submitted = true;
 	}
-	frame.submitted = true;
 
 	// vk.wait(vk.graphicsQueue());
 
 	// vk.wait();
 
-	rw.get().present(m_highlightColorAttachmentTexture,
-	                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-	                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-	                 frame.semaphore);
+	if (renderToSwapchain())
+		rw.get().presentFrameImage(frame.semaphore);
+	else
+		rw.get().present(m_highlightColorAttachmentTexture,
+		                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		                 frame.semaphore);
 }
 
 bool ShaderBall::mustRebuild() const
@@ -2875,7 +3101,7 @@ void ShaderBall::rebuild()
 	    rw.get().swapchainExtent().height, rw.get().depthImageFormat(),
 	    VK_IMAGE_TILING_OPTIMAL,
 	    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-	        VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+	        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 	    VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1,
 	    VK_SAMPLE_COUNT_4_BIT);
 
@@ -2885,6 +3111,10 @@ void ShaderBall::rebuild()
 	    VK_IMAGE_LAYOUT_UNDEFINED,
 	    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 
+	m_scene.setDepthPyramid(nullptr);
+	m_depthPyramid = std::make_unique<DepthPyramid>(rw, m_depthTexture);
+	m_scene.setDepthPyramid(m_depthPyramid.get());
+
 #pragma endregion
 
 #pragma region normalDepth resolve texture
@@ -3129,6 +3359,32 @@ void ShaderBall::rebuild()
 			          << std::endl;
 			abort();
 		}
+
+		// skips the blit of RenderWindow::present when the swapchain
+		// matches the highlight attachment
+		m_swapchainHighlightFramebuffers.clear();
+		if (rw.get().canRenderToSwapchain(
+		        m_highlightColorAttachmentTexture.format(),
+		        m_highlightColorAttachmentTexture.extent2D()))
+		{
+			for (ImageView& view : rw.get().swapchainImageViews())
+			{
+				VkImageView attachment = view;
+				framebufferInfo.attachmentCount = 1;
+				framebufferInfo.pAttachments = &attachment;
+
+				auto& framebuffer =
+				    m_swapchainHighlightFramebuffers.emplace_back(
+				        vk.create(framebufferInfo));
+				if (!framebuffer)
+				{
+					std::cerr << "error: failed to create swapchain "
+					             "highlight framebuffer"
+					          << std::endl;
+					abort();
+				}
+			}
+		}
 	}
 #pragma endregion
 
@@ -5,18 +5,23 @@
 #include "BrdfLut.hpp"
 #include "Buffer.hpp"
 #include "CommandBuffer.hpp"
+#include "CpuProfiler.hpp"
 #include "Cubemap.hpp"
+#include "DepthPyramid.hpp"
 #include "DepthTexture.hpp"
+#include "GpuProfiler.hpp"
 #include "IrradianceMap.hpp"
 #include "Materials/DefaultMaterial.hpp"
 #include "Model.hpp"
 #include "PbrShadingModel.hpp"
+#include "PipelineCompiler.hpp"
 #include "PrefilteredCubemap.hpp"
 #include "RenderWindow.hpp"
 #include "Skybox.hpp"
 #include "Scene.hpp"
 #include "SceneObject.hpp"
 #include "StandardMesh.hpp"
+#include "Stats.hpp"
 #include "Texture2D.hpp"
 
 #include "cdm_maths.hpp"
@@ -83,6 +88,10 @@ class ShaderBall final
 
 	UniqueFramebuffer m_framebuffer;
 	UniqueFramebuffer m_highlightFramebuffer;
+	/// one per swapchain image when the highlight and imgui passes render
+	/// straight into them, empty when they go through
+	/// `m_highlightColorAttachmentTexture`
+	std::vector<UniqueFramebuffer> m_swapchainHighlightFramebuffers;
 
 	UniqueDescriptorPool m_descriptorPool;
 
@@ -115,6 +124,7 @@ class ShaderBall final
 	std::unordered_map<std::string, std::unique_ptr<Texture2D>> m_sponzaTextures;
 	StandardMesh m_sphereMesh;
 
+	PipelineCompiler m_pipelineCompiler;
 	Scene m_scene;
 	SceneObject* m_bunnySceneObject;
 	SceneObject* m_bunnySceneObject2;
@@ -150,6 +160,7 @@ class ShaderBall final
 	Texture2D m_colorAttachmentTexture;
 	Texture2D m_objectIDAttachmentTexture;
 	DepthTexture m_depthTexture;
+	std::unique_ptr<DepthPyramid> m_depthPyramid;
 	Texture2D m_colorResolveTexture;
 	Texture2D m_objectIDResolveTexture;
 
@@ -185,17 +196,37 @@ public:
 		void copyTo(void* ptr);
 	};
 
+	/// Procedural scene replacing sponza, to measure how the renderer
+	/// scales: `objects` spheres on a grid sharing `materials` instances of
+	/// the default material, lit by `pointLights` lights on a ring above
+	/// them. Disabled when `objects` is 0
+	struct StressScene
+	{
+		uint32_t objects = 0;
+		uint32_t materials = 1;
+		uint32_t pointLights = 1;
+		float spacing = 3.0f;
+	};
+
 	transform3d cameraTr;
 	transform3d modelTr;
 
 private:
 	Config m_config;
 
+	StressScene m_stressScene;
+	std::vector<MaterialInstance*> m_stressMaterialInstances;
+	std::vector<SceneObject*> m_stressSceneObjects;
+
 	CommandBuffer imguiCB;
 	CommandBuffer copyHDRCB;
 
+	GpuProfiler m_gpuProfiler;
+	FrameStats m_frameStats;
+
 public:
-	ShaderBall(RenderWindow& renderWindow);
+	ShaderBall(RenderWindow& renderWindow,
+	           const StressScene& stressScene = {});
 	ShaderBall(const ShaderBall&) = delete;
 	ShaderBall(ShaderBall&&) = default;
 	~ShaderBall();
@@ -208,7 +239,24 @@ public:
 
 	void standaloneDraw();
 
+	const GpuProfiler& gpuProfiler() const noexcept { return m_gpuProfiler; }
+	const FrameStats& frameStats() const noexcept { return m_frameStats; }
+
+	/// Half the side of the stress scene grid, centered on the origin
+	float stressSceneRadius() const;
+
 private:
+	bool stressed() const { return m_stressScene.objects > 0; }
+	void buildStressScene();
+
+	bool renderToSwapchain() const
+	{
+		return !m_swapchainHighlightFramebuffers.empty();
+	}
+	/// image and framebuffer written by the highlight and imgui passes
+	VkImage outputImage();
+	VkFramebuffer outputFramebuffer();
+
 	bool mustRebuild() const;
 	void rebuild();
 };
@@ -25,7 +25,7 @@ Written by Charles Seizilles de Mazancourt
 #ifndef CDM_VULKAN_HPP
 #define CDM_VULKAN_HPP
 
-#ifndef VK_USE_PLATFORM_WIN32_KHR
+#if defined(_WIN32) && !defined(VK_USE_PLATFORM_WIN32_KHR)
 #define VK_USE_PLATFORM_WIN32_KHR
 #endif
 #include <vulkan/vulkan.h>
@@ -86,6 +86,7 @@ using DebugUtilsMessengerCreateInfoEXT     = CreateInfo<VkDebugUtilsMessengerCre
 using DescriptorPoolCreateInfo             = CreateInfo<VkDescriptorPoolCreateInfo,             VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO>;
 using DescriptorSetAllocateInfo            = CreateInfo<VkDescriptorSetAllocateInfo,            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO>;
 using DescriptorSetLayoutCreateInfo        = CreateInfo<VkDescriptorSetLayoutCreateInfo,        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO>;
+using DescriptorSetLayoutBindingFlagsCreateInfoEXT = CreateInfo<VkDescriptorSetLayoutBindingFlagsCreateInfoEXT, VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT>;
 using DescriptorUpdateTemplateCreateInfo   = CreateInfo<VkDescriptorUpdateTemplateCreateInfo,   VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO>;
 using DeviceCreateInfo                     = CreateInfo<VkDeviceCreateInfo,                     VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO>;
 using DeviceQueueCreateInfo                = CreateInfo<VkDeviceQueueCreateInfo,                VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO>;
@@ -100,6 +101,7 @@ using ImageViewCreateInfo                  = CreateInfo<VkImageViewCreateInfo,
 using InstanceCreateInfo                   = CreateInfo<VkInstanceCreateInfo,                   VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO>;
 using MemoryAllocateInfo                   = CreateInfo<VkMemoryAllocateInfo,                   VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO>;
 using PhysicalDeviceFeatures2              = CreateInfo<VkPhysicalDeviceFeatures2,              VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2>;
+using PhysicalDeviceDescriptorIndexingFeaturesEXT = CreateInfo<VkPhysicalDeviceDescriptorIndexingFeaturesEXT, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT>;
 using PhysicalDeviceProperties2            = CreateInfo<VkPhysicalDeviceProperties2,            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2>;
 using PhysicalDeviceSurfaceInfo2KHR        = CreateInfo<VkPhysicalDeviceSurfaceInfo2KHR,        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SURFACE_INFO_2_KHR>;
 using PipelineCacheCreateInfo              = CreateInfo<VkPipelineCacheCreateInfo,              VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO>;
@@ -126,7 +128,9 @@ using ShaderModuleCreateInfo               = CreateInfo<VkShaderModuleCreateInfo
 using SubmitInfo                           = CreateInfo<VkSubmitInfo,                           VK_STRUCTURE_TYPE_SUBMIT_INFO>;
 using SurfaceCapabilities2KHR              = CreateInfo<VkSurfaceCapabilities2KHR,              VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_KHR>;
 using SwapchainCreateInfoKHR               = CreateInfo<VkSwapchainCreateInfoKHR,               VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR>;
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 using Win32SurfaceCreateInfoKHR            = CreateInfo<VkWin32SurfaceCreateInfoKHR,            VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR>;
+#endif
 using SubpassBeginInfo                     = CreateInfo<VkSubpassBeginInfo,                     VK_STRUCTURE_TYPE_SUBPASS_BEGIN_INFO>;
 using SubpassEndInfo                       = CreateInfo<VkSubpassEndInfo,                       VK_STRUCTURE_TYPE_SUBPASS_END_INFO>;
 using DebugMarkerObjectTagInfoEXT          = CreateInfo<VkDebugMarkerObjectTagInfoEXT,          VK_STRUCTURE_TYPE_DEBUG_MARKER_OBJECT_TAG_INFO_EXT>;
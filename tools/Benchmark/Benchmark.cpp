@@ -0,0 +1,436 @@
+#include "FrameRecorder.hpp"
+#include "HeadlessRenderContext.hpp"
+#include "LightTransport.hpp"
+#include "Mandelbulb.hpp"
+#include "ReferenceScene.hpp"
+#include "ShaderBall.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cdm
+{
+namespace
+{
+constexpr float Pi{ 3.14159265359f };
+
+struct Options
+{
+	std::string scene;
+	uint32_t frames = 1000;
+	/// not measured, fills the frames in flight and the pipeline caches
+	uint32_t warmupFrames = 100;
+	ReferenceScene::StressParameters stressScene;
+	std::string output = "benchmark.json";
+	/// frame written for `FrameReplay` when not empty, counted after the
+	/// warmup
+	std::string capture;
+	uint32_t captureFrame = 0;
+};
+
+/// What the runner needs from a scene
+struct BenchmarkScene
+{
+	/// `frame` is the index on the camera path, 0 during the warmup
+	std::function<void(uint32_t frame)> draw;
+	/// called before each frame, outside of the measured time, empty
+	/// without a window
+	std::function<void()> pollEvents;
+	/// called after each frame, outside of the measured time, to wait for
+	/// scenes whose frames are not overlapped
+	std::function<void()> finishFrame;
+	const GpuProfiler* gpuProfiler = nullptr;
+	const FrameStats* frameStats = nullptr;
+};
+
+struct Measurements
+{
+	std::vector<double> cpuMilliseconds;
+	/// frames resolved by the scene's `GpuProfiler`, empty without one
+	std::vector<double> gpuMilliseconds;
+	RecordingStats recording;
+	uint32_t recordedFrames = 0;
+};
+
+struct Summary
+{
+	double mean = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+};
+
+Summary summarize(std::vector<double> samples)
+{
+	Summary res;
+	if (samples.empty())
+		return res;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+
+	// nearest rank, always one of the samples
+	auto percentile = [&samples](double p) {
+		size_t rank = size_t(std::ceil(p / 100.0 * double(samples.size())));
+		return samples[std::clamp(rank, size_t(1), samples.size()) - 1];
+	};
+
+	res.mean = sum / double(samples.size());
+	res.min = samples.front();
+	res.max = samples.back();
+	res.p50 = percentile(50.0);
+	res.p90 = percentile(90.0);
+	res.p95 = percentile(95.0);
+	res.p99 = percentile(99.0);
+
+	return res;
+}
+
+/// One revolution around `center` over `frameCount` frames, looking down
+/// at it from `height`
+transform3d orbitCamera(uint32_t frame, uint32_t frameCount, vector3 center,
+                        float radius, float height)
+{
+	float yaw = 2.0f * Pi * float(frame) / float(std::max(frameCount, 1u));
+	float pitch = std::atan2(height, radius);
+
+	transform3d res;
+	res.position = center + vector3(std::sin(yaw) * radius, height,
+	                                std::cos(yaw) * radius);
+	res.rotation = quaternion(vector3(0, 1, 0), radian(yaw)) *
+	               quaternion(vector3(1, 0, 0), radian(-pitch));
+	res.scale = { 1, 1, 1 };
+
+	return res;
+}
+
+Measurements measure(RenderContext& rc, const Options& options,
+                     const BenchmarkScene& scene)
+{
+	Measurements res;
+	res.cpuMilliseconds.reserve(options.frames);
+
+	uint64_t resolvedFrameCount =
+	    scene.gpuProfiler ? scene.gpuProfiler->resolvedFrameCount() : 0;
+
+	for (uint32_t i = 0; i < options.warmupFrames + options.frames; i++)
+	{
+		bool warmup = i < options.warmupFrames;
+
+		if (scene.pollEvents)
+			scene.pollEvents();
+
+		bool capture = !warmup && !options.capture.empty() &&
+		               i - options.warmupFrames == options.captureFrame;
+		if (capture)
+			rc.device().frameRecorder().beginCapture();
+
+		auto begin = std::chrono::steady_clock::now();
+		scene.draw(warmup ? 0 : i - options.warmupFrames);
+		auto end = std::chrono::steady_clock::now();
+
+		if (scene.finishFrame)
+			scene.finishFrame();
+
+		if (capture)
+			rc.device().frameRecorder().endCapture(options.capture);
+
+		// results lag behind by the profiler ring, read them even during
+		// the warmup to only keep the ones resolved afterwards
+		bool gpuResolved =
+		    scene.gpuProfiler &&
+		    scene.gpuProfiler->resolvedFrameCount() != resolvedFrameCount;
+		if (scene.gpuProfiler)
+			resolvedFrameCount = scene.gpuProfiler->resolvedFrameCount();
+
+		if (warmup)
+			continue;
+
+		res.cpuMilliseconds.push_back(
+		    std::chrono::duration<double, std::milli>(end - begin).count());
+
+		if (gpuResolved)
+			res.gpuMilliseconds.push_back(
+			    scene.gpuProfiler->frameMilliseconds());
+
+		if (scene.frameStats)
+		{
+			res.recording += scene.frameStats->recording();
+			res.recordedFrames++;
+		}
+	}
+
+	rc.device().wait();
+
+	return res;
+}
+
+/// The stress scene only needs the renderer, it is drawn offscreen so that
+/// neither the window system nor the presentation are timed. The CPU time
+/// covers the recording and the submission, the wait for the GPU is left
+/// out
+Measurements runStressScene(HeadlessRenderContext& rc, const Options& options)
+{
+	ReferenceEnvironment environment(rc);
+	ReferenceScene referenceScene(rc, environment,
+	                              ReferenceScene::Geometry::Stress,
+	                              options.stressScene);
+
+	float radius = referenceScene.stressRadius() * 1.5f + 5.0f;
+
+	BenchmarkScene scene;
+	scene.draw = [&](uint32_t frame) {
+		referenceScene.setCamera(orbitCamera(frame, options.frames,
+		                                     vector3(0, 0, 0), radius,
+		                                     radius / 2.0f));
+		referenceScene.submitFrame({});
+	};
+	scene.finishFrame = [&rc]() { rc.device().wait(); };
+	scene.gpuProfiler = &referenceScene.gpuProfiler();
+	scene.frameStats = &referenceScene.frameStats();
+
+	return measure(rc, options, scene);
+}
+
+std::optional<Measurements> runScene(RenderWindow& rw,
+                                     const Options& options)
+{
+	BenchmarkScene scene;
+	scene.pollEvents = [&rw]() { rw.pollEvents(); };
+
+	if (options.scene == "shaderball")
+	{
+		ShaderBall shaderBall(rw);
+
+		scene.draw = [&](uint32_t frame) {
+			shaderBall.cameraTr = orbitCamera(frame, options.frames,
+			                                  vector3(0, 5, -5), 25.0f, 12.5f);
+			shaderBall.standaloneDraw();
+		};
+		scene.gpuProfiler = &shaderBall.gpuProfiler();
+		scene.frameStats = &shaderBall.frameStats();
+
+		return measure(rw, options, scene);
+	}
+	if (options.scene == "mandelbulb")
+	{
+		Mandelbulb mandelbulb(rw);
+		scene.draw = [&](uint32_t) { mandelbulb.draw(); };
+
+		return measure(rw, options, scene);
+	}
+	if (options.scene == "lighttransport")
+	{
+		LightTransport lightTransport(rw);
+		scene.draw = [&](uint32_t) { lightTransport.standaloneDraw(); };
+
+		return measure(rw, options, scene);
+	}
+
+	std::cerr << "error: unknown scene " << options.scene << std::endl;
+	return std::nullopt;
+}
+
+void writeSummary(std::ostream& os, const std::vector<double>& samples)
+{
+	Summary s = summarize(samples);
+
+	os << "{\"mean\":" << s.mean << ",\"min\":" << s.min
+	   << ",\"max\":" << s.max << ",\"p50\":" << s.p50
+	   << ",\"p90\":" << s.p90 << ",\"p95\":" << s.p95
+	   << ",\"p99\":" << s.p99 << ",\"samples\":[";
+	for (size_t i = 0; i < samples.size(); i++)
+		os << (i == 0 ? "" : ",") << samples[i];
+	os << "]}";
+}
+
+bool writeResults(const std::string& path, const Options& options,
+                  const VulkanDevice& vk, const Measurements& measurements)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << "error: failed to open " << path << std::endl;
+		return false;
+	}
+
+	VkPhysicalDeviceProperties properties{};
+	vk.GetPhysicalDeviceProperties(vk.physicalDevice(), &properties);
+
+	file << std::fixed << std::setprecision(4);
+	file << "{\n\"scene\":\"" << options.scene << "\",\n";
+	file << "\"device\":\"" << properties.deviceName << "\",\n";
+	file << "\"frames\":" << options.frames << ",\n";
+	file << "\"warmupFrames\":" << options.warmupFrames << ",\n";
+	if (options.scene == "stress")
+	{
+		file << "\"stressScene\":{\"objects\":" << options.stressScene.objects
+		     << ",\"materials\":" << options.stressScene.materials
+		     << ",\"pointLights\":" << options.stressScene.pointLights
+		     << "},\n";
+	}
+
+	file << "\"cpuMilliseconds\":";
+	writeSummary(file, measurements.cpuMilliseconds);
+	file << ",\n\"gpuMilliseconds\":";
+	if (measurements.gpuMilliseconds.empty())
+		file << "null";
+	else
+		writeSummary(file, measurements.gpuMilliseconds);
+
+	// per frame averages
+	file << ",\n\"recording\":";
+	if (measurements.recordedFrames == 0)
+	{
+		file << "null";
+	}
+	else
+	{
+		const RecordingStats& r = measurements.recording;
+		double frames = double(measurements.recordedFrames);
+		file << "{\"draws\":" << double(r.draws) / frames
+		     << ",\"indirectDraws\":" << double(r.indirectDraws) / frames
+		     << ",\"dispatches\":" << double(r.dispatches) / frames
+		     << ",\"pipelineBinds\":" << double(r.pipelineBinds) / frames
+		     << ",\"descriptorSetBinds\":"
+		     << double(r.descriptorSetBinds) / frames
+		     << ",\"barriers\":" << double(r.barriers) / frames
+		     << ",\"triangles\":" << double(r.triangles) / frames << "}";
+	}
+	file << "\n}\n";
+
+	return file.good();
+}
+
+void printUsage()
+{
+	std::cerr << "usage: Benchmark <shaderball|stress|mandelbulb|"
+	             "lighttransport> [--frames N] [--warmup N] [--objects N] "
+	             "[--materials N] [--lights N] [--output path] "
+	             "[--capture path] [--capture-frame N]"
+	          << std::endl;
+}
+
+std::optional<Options> parseOptions(int argc, char** argv)
+{
+	if (argc < 2)
+		return std::nullopt;
+
+	Options res;
+	res.scene = argv[1];
+
+	for (int i = 2; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 == argc)
+			return std::nullopt;
+		std::string value = argv[++i];
+
+		try
+		{
+			if (option == "--output")
+				res.output = value;
+			else if (option == "--frames")
+				res.frames = uint32_t(std::stoul(value));
+			else if (option == "--warmup")
+				res.warmupFrames = uint32_t(std::stoul(value));
+			else if (option == "--objects")
+				res.stressScene.objects = uint32_t(std::stoul(value));
+			else if (option == "--materials")
+				res.stressScene.materials = uint32_t(std::stoul(value));
+			else if (option == "--lights")
+				res.stressScene.pointLights = uint32_t(std::stoul(value));
+			else if (option == "--capture")
+				res.capture = value;
+			else if (option == "--capture-frame")
+				res.captureFrame = uint32_t(std::stoul(value));
+			else
+				return std::nullopt;
+		}
+		catch (const std::logic_error&)
+		{
+			return std::nullopt;
+		}
+	}
+
+	if (res.frames == 0 || res.captureFrame >= res.frames ||
+	    (res.scene == "stress" && res.stressScene.objects == 0))
+		return std::nullopt;
+
+	return res;
+}
+}  // namespace
+}  // namespace cdm
+
+/// Renders a scene for a fixed number of frames along a scripted camera path
+/// and writes the CPU and GPU frame times to a JSON file, to compare builds
+/// on the same machine. The stress scene is rendered on a headless context
+/// and its frames are not overlapped, the others in a hidden window whose
+/// frames are not paced by vsync
+int main(int argc, char** argv)
+{
+	using namespace cdm;
+
+	std::optional<Options> options = parseOptions(argc, argv);
+	if (!options)
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::optional<Measurements> measurements;
+
+	// no validation layers, they would dominate the CPU times
+	if (options->scene == "stress")
+	{
+		HeadlessRenderContext rc({ 1280, 720 });
+
+		// the objects created before cannot be replayed
+		if (!options->capture.empty())
+			rc.device().frameRecorder().setTracking(true);
+
+		measurements = runStressScene(rc, *options);
+
+		if (!writeResults(options->output, *options, rc.device(),
+		                  *measurements))
+			return 1;
+	}
+	else
+	{
+		RenderWindow rw(1280, 720, false);
+		rw.setPresentMode(VK_PRESENT_MODE_IMMEDIATE_KHR);
+		rw.hide();
+
+		if (!options->capture.empty())
+			rw.device().frameRecorder().setTracking(true);
+
+		measurements = runScene(rw, *options);
+		if (!measurements)
+			return 1;
+
+		if (!writeResults(options->output, *options, rw.device(),
+		                  *measurements))
+			return 1;
+	}
+
+	Summary cpu = summarize(measurements->cpuMilliseconds);
+	std::cout << options->scene << ": " << cpu.mean << " ms mean, "
+	          << cpu.p99 << " ms p99 over " << options->frames
+	          << " frames, written to " << options->output << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,683 @@
+#include "ReferenceScene.hpp"
+
+#include "CommandBuffer.hpp"
+#include "CommandBufferPool.hpp"
+#include "EquirectangularToCubemap.hpp"
+#include "TextureFactory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace cdm
+{
+namespace
+{
+constexpr float Pi{ 3.14159265359f };
+constexpr VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_4_BIT;
+
+/// Formats of the `SceneObject` fragment shader outputs, in location order
+constexpr std::array AttachmentFormats{
+	VK_FORMAT_R8G8B8A8_UNORM,
+	VK_FORMAT_R32_UINT,
+	VK_FORMAT_R32G32B32A32_SFLOAT,
+	VK_FORMAT_R32G32B32A32_SFLOAT,
+};
+
+/// Features of the reference images, the LTC area light needs textures
+/// ShaderBall does not ship yet
+constexpr uint32_t ShadingFeatures = PbrShadingModel::ReceiveShadows |
+                                     PbrShadingModel::CastShadows |
+                                     PbrShadingModel::ImageBasedLighting;
+
+StandardMesh uvSphere(RenderContext& renderContext, uint32_t segments,
+                      uint32_t rings)
+{
+	std::vector<StandardMesh::Vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	for (uint32_t r = 0; r <= rings; r++)
+	{
+		float v = float(r) / float(rings);
+		float theta = v * Pi;
+		for (uint32_t s = 0; s <= segments; s++)
+		{
+			float u = float(s) / float(segments);
+			float phi = u * 2.0f * Pi;
+
+			StandardMesh::Vertex vertex;
+			vertex.normal = { std::sin(theta) * std::cos(phi),
+				              std::cos(theta),
+				              std::sin(theta) * std::sin(phi) };
+			vertex.position = vertex.normal;
+			vertex.uv = { u, v };
+			vertex.tangent = { -std::sin(phi), 0.0f, std::cos(phi) };
+			vertices.push_back(vertex);
+		}
+	}
+
+	for (uint32_t r = 0; r < rings; r++)
+	{
+		for (uint32_t s = 0; s < segments; s++)
+		{
+			uint32_t a = r * (segments + 1) + s;
+			uint32_t b = a + segments + 1;
+			indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+		}
+	}
+
+	return StandardMesh(renderContext, vertices, indices);
+}
+
+/// 2x2 quad on the XZ plane facing +Y
+StandardMesh plane(RenderContext& renderContext)
+{
+	std::vector<StandardMesh::Vertex> vertices(4);
+	const std::array<vector2, 4> corners{ vector2(-1, -1), vector2(1, -1),
+		                                  vector2(1, 1), vector2(-1, 1) };
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		vertices[i].position = { corners[i].x, 0.0f, corners[i].y };
+		vertices[i].normal = { 0.0f, 1.0f, 0.0f };
+		vertices[i].uv = { (corners[i].x + 1.0f) / 2.0f,
+			               (corners[i].y + 1.0f) / 2.0f };
+		vertices[i].tangent = { 1.0f, 0.0f, 0.0f };
+	}
+
+	return StandardMesh(renderContext, vertices, { 0, 2, 1, 0, 3, 2 });
+}
+
+/// Looking down -Z once rotated by `yaw` then `pitch`
+quaternion orientation(degree yaw, degree pitch)
+{
+	return quaternion(vector3(0, 1, 0), yaw) *
+	       quaternion(vector3(1, 0, 0), pitch);
+}
+}  // namespace
+
+ReferenceEnvironment::ReferenceEnvironment(RenderContext& renderContext)
+{
+	auto& vk = renderContext.device();
+
+#pragma region sky
+	// horizon to zenith gradient over a darker ground
+	constexpr uint32_t width = 64;
+	constexpr uint32_t height = 32;
+	std::vector<vector4> texels(size_t(width) * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		float t = (float(y) + 0.5f) / float(height);
+		vector4 color = t < 0.5f ? lerp(vector4(0.3f, 0.5f, 0.9f, 1.0f),
+		                                vector4(0.8f, 0.85f, 0.9f, 1.0f),
+		                                t * 2.0f)
+		                         : vector4(0.3f, 0.25f, 0.2f, 1.0f);
+		for (uint32_t x = 0; x < width; x++)
+			texels[size_t(y) * width + x] = color;
+	}
+
+	TextureFactory f(vk);
+	f.setWidth(width);
+	f.setHeight(height);
+	f.setFormat(VK_FORMAT_R32G32B32A32_SFLOAT);
+	f.setUsage(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+	m_equirectangularTexture = f.createTexture2D();
+
+	VkBufferImageCopy copy{};
+	copy.imageExtent = { width, height, 1 };
+	copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copy.imageSubresource.layerCount = 1;
+
+	m_equirectangularTexture.uploadDataImmediate(
+	    texels.data(), texels.size() * sizeof(vector4), copy,
+	    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+#pragma endregion
+
+#pragma region cubemaps
+	EquirectangularToCubemap e2c(renderContext, 128);
+	m_environmentMap = e2c.computeCubemap(m_equirectangularTexture);
+	if (m_environmentMap.get() == nullptr)
+		throw std::runtime_error("could not create environmentMap");
+
+	// cached under names of their own, the sky never changes
+	m_irradianceMap =
+	    IrradianceMap(renderContext, 32, m_equirectangularTexture,
+	                  "ReferenceScene_irradiance.hdr");
+	if (m_irradianceMap.get() == nullptr)
+		throw std::runtime_error("could not create irradianceMap");
+
+	m_prefilteredMap =
+	    PrefilteredCubemap(renderContext, 128, -1, m_environmentMap,
+	                       "ReferenceScene_prefiltered.hdr");
+	if (m_prefilteredMap.get().get() == nullptr)
+		throw std::runtime_error("could not create prefilteredMap");
+
+	m_brdfLut = BrdfLut(renderContext, 128, "ReferenceScene_brdfLut.hdr");
+	if (m_brdfLut.get() == nullptr)
+		throw std::runtime_error("could not create brdfLut");
+#pragma endregion
+}
+
+ReferenceScene::ReferenceScene(HeadlessRenderContext& renderContext,
+                               ReferenceEnvironment& environment,
+                               Geometry geometry,
+                               const StressParameters& stress)
+    : m_renderContext(renderContext),
+      m_geometry(geometry),
+      m_stress(stress),
+      m_shadingModel(renderContext.device(),
+                     geometry == Geometry::Stress
+                         ? std::max(stress.pointLights, 1u)
+                         : 1u,
+                     1, renderContext.framesInFlight()),
+      m_material(renderContext, m_shadingModel,
+                 geometry == Geometry::Stress
+                     ? std::max(stress.materials, 16u)
+                     : 16u),
+      m_scene(renderContext, 1024),
+      m_gpuProfiler(renderContext.device(),
+                    renderContext.framesInFlight() + 1),
+      m_frameStats(renderContext.device(),
+                   renderContext.framesInFlight() + 1)
+{
+	m_material.setShadingFeatures(ShadingFeatures);
+
+	m_sphereMesh = uvSphere(renderContext, 48, 24);
+	m_planeMesh = plane(renderContext);
+
+	createRenderPass();
+	createFramebuffer();
+	bindEnvironment(environment);
+
+	switch (geometry)
+	{
+	case Geometry::Materials: buildMaterials(); break;
+	case Geometry::Shadows: buildShadows(); break;
+	case Geometry::Stress: buildStress(); break;
+	}
+}
+
+ReferenceScene::~ReferenceScene()
+{
+	m_renderContext.get().device().wait();
+}
+
+void ReferenceScene::createRenderPass()
+{
+	auto& vk = m_renderContext.get().device();
+
+	// multisampled attachments, their resolves, then the depth
+	std::vector<VkAttachmentDescription> attachments;
+	std::vector<VkAttachmentReference> colorRefs;
+	std::vector<VkAttachmentReference> resolveRefs;
+
+	for (VkSampleCountFlagBits samples : { Samples, VK_SAMPLE_COUNT_1_BIT })
+	{
+		auto& refs = samples == Samples ? colorRefs : resolveRefs;
+		for (VkFormat format : AttachmentFormats)
+		{
+			// cleared rather than left undefined so that pixels without
+			// any object compare equal too
+			VkAttachmentDescription attachment = {};
+			attachment.format = format;
+			attachment.samples = samples;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = samples == Samples
+			                         ? VK_ATTACHMENT_STORE_OP_DONT_CARE
+			                         : VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout =
+			    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+			refs.push_back({ uint32_t(attachments.size()),
+			                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+			attachments.push_back(attachment);
+		}
+	}
+
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format = m_renderContext.get().depthImageFormat();
+	depthAttachment.samples = Samples;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	// kept for the depth pyramid
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout =
+	    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout =
+	    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthRef = {
+		uint32_t(attachments.size()),
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+	};
+	attachments.push_back(depthAttachment);
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = uint32_t(colorRefs.size());
+	subpass.pColorAttachments = colorRefs.data();
+	subpass.pResolveAttachments = resolveRefs.data();
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	VkSubpassDependency dependency = {};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+	                          VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependency.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+	                           VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	vk::RenderPassCreateInfo renderPassInfo;
+	renderPassInfo.attachmentCount = uint32_t(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	m_renderPass = vk.create(renderPassInfo);
+	if (!m_renderPass)
+	{
+		std::cerr << "error: failed to create render pass" << std::endl;
+		abort();
+	}
+
+	vk.debugMarkerSetObjectName(m_renderPass, "ReferenceScene render pass");
+}
+
+void ReferenceScene::createFramebuffer()
+{
+	auto& rc = m_renderContext.get();
+	auto& vk = rc.device();
+
+	TextureFactory f(vk);
+	f.setExtent(rc.swapchainExtent());
+	f.setUsage(VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+	           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+	f.setFilters(VK_FILTER_NEAREST, VK_FILTER_NEAREST);
+
+	std::vector<VkImageView> views;
+	for (VkSampleCountFlagBits samples : { Samples, VK_SAMPLE_COUNT_1_BIT })
+	{
+		auto& textures =
+		    samples == Samples ? m_attachments : m_resolveAttachments;
+		f.setSamples(samples);
+		for (VkFormat format : AttachmentFormats)
+		{
+			f.setFormat(format);
+			Texture2D& texture = textures.emplace_back(f.createTexture2D());
+			texture.transitionLayoutImmediate(
+			    VK_IMAGE_LAYOUT_UNDEFINED,
+			    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			views.push_back(texture.view());
+		}
+	}
+
+	m_depthTexture = DepthTexture(
+	    rc, rc.swapchainExtent().width, rc.swapchainExtent().height,
+	    rc.depthImageFormat(), VK_IMAGE_TILING_OPTIMAL,
+	    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+	        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	    VMA_MEMORY_USAGE_GPU_ONLY, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1,
+	    Samples);
+	m_depthTexture.transitionLayoutImmediate(
+	    VK_IMAGE_LAYOUT_UNDEFINED,
+	    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	views.push_back(m_depthTexture.view());
+
+	m_depthPyramid = std::make_unique<DepthPyramid>(rc, m_depthTexture);
+	m_scene.setDepthPyramid(m_depthPyramid.get());
+
+	vk::FramebufferCreateInfo framebufferInfo;
+	framebufferInfo.renderPass = m_renderPass;
+	framebufferInfo.attachmentCount = uint32_t(views.size());
+	framebufferInfo.pAttachments = views.data();
+	framebufferInfo.width = rc.swapchainExtent().width;
+	framebufferInfo.height = rc.swapchainExtent().height;
+	framebufferInfo.layers = 1;
+
+	m_framebuffer = vk.create(framebufferInfo);
+	if (!m_framebuffer)
+	{
+		std::cerr << "error: failed to create framebuffer" << std::endl;
+		abort();
+	}
+}
+
+void ReferenceScene::bindEnvironment(ReferenceEnvironment& environment)
+{
+	auto& vk = m_renderContext.get().device();
+
+	auto imageInfo = [](auto& texture) {
+		VkDescriptorImageInfo res{};
+		res.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		res.imageView = texture.view();
+		res.sampler = texture.sampler();
+		return res;
+	};
+
+	// the LTC tables are only read by the `AreaLight` variant, which is
+	// disabled, the BRDF LUT keeps the descriptors valid
+	std::array infos{ imageInfo(environment.irradianceMap()),
+		              imageInfo(environment.prefilteredMap()),
+		              imageInfo(environment.brdfLut()),
+		              imageInfo(environment.brdfLut()),
+		              imageInfo(environment.brdfLut()) };
+	constexpr std::array<uint32_t, 5> bindings{ 0, 1, 2, 6, 7 };
+
+	std::array<vk::WriteDescriptorSet, 5> writes;
+	for (size_t i = 0; i < writes.size(); i++)
+	{
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[i].dstArrayElement = 0;
+		writes[i].dstBinding = bindings[i];
+		writes[i].dstSet = m_shadingModel.m_descriptorSet;
+		writes[i].pImageInfo = &infos[i];
+	}
+
+	vk.updateDescriptorSets(uint32_t(writes.size()), writes.data());
+}
+
+void ReferenceScene::buildMaterials()
+{
+	constexpr uint32_t columns = 5;
+	constexpr uint32_t rows = 3;
+	constexpr float spacing = 2.2f;
+
+	for (uint32_t row = 0; row < rows; row++)
+	{
+		for (uint32_t column = 0; column < columns; column++)
+		{
+			float roughness = (float(column) + 0.5f) / float(columns);
+			float metalness = float(row) / float(rows - 1);
+
+			auto* materialInstance = m_material.instanciate();
+			materialInstance->setFloatParameter("roughness", roughness);
+			materialInstance->setFloatParameter("metalness", metalness);
+			materialInstance->setVec4Parameter(
+			    "color", vector4(0.9f, 0.5f + 0.2f * float(row), 0.25f, 1));
+			m_materialInstances.push_back(materialInstance);
+
+			auto& sphere = m_scene.instantiateSceneObject();
+			sphere.setMesh(m_sphereMesh);
+			sphere.setMaterial(*materialInstance);
+			sphere.transform.position = {
+				(float(column) - float(columns - 1) / 2.0f) * spacing,
+				1.0f + float(row) * spacing, 0.0f
+			};
+		}
+	}
+
+	auto& floor = m_scene.instantiateSceneObject();
+	floor.setMesh(m_planeMesh);
+	floor.setMaterial(m_material);
+	floor.transform.scale = { 20, 1, 20 };
+
+	m_cameraTr = transform3d(vector3(0.0f, 3.2f, 9.0f),
+	                         orientation(0.0_deg, -5.0_deg), { 1, 1, 1 });
+	m_lightTr = transform3d(vector3(0.0f, 20.0f, 10.0f),
+	                        orientation(0.0_deg, -60.0_deg), { 1, 1, 1 });
+	m_pointLightPosition = { 4.0f, 6.0f, 5.0f };
+}
+
+void ReferenceScene::buildShadows()
+{
+	auto* materialInstance = m_material.instanciate();
+	materialInstance->setFloatParameter("roughness", 0.6f);
+	materialInstance->setFloatParameter("metalness", 0.0f);
+	materialInstance->setVec4Parameter("color", vector4(0.8f, 0.8f, 0.8f, 1));
+	m_materialInstances.push_back(materialInstance);
+
+	const std::array<vector4, 6> spheres{
+		// position and scale
+		vector4(0.0f, 1.0f, 0.0f, 1.0f),   vector4(-4.0f, 2.5f, -2.0f, 1.5f),
+		vector4(4.0f, 0.5f, 2.0f, 0.5f),   vector4(3.0f, 4.0f, -6.0f, 1.0f),
+		vector4(-6.0f, 0.75f, 4.0f, 0.75f), vector4(0.0f, 6.0f, -12.0f, 2.0f),
+	};
+	for (const vector4& s : spheres)
+	{
+		auto& sphere = m_scene.instantiateSceneObject();
+		sphere.setMesh(m_sphereMesh);
+		sphere.setMaterial(*materialInstance);
+		sphere.transform.position = s.xyz();
+		sphere.transform.scale = { s.w, s.w, s.w };
+		sphere.mobility = SceneObject::Mobility::Static;
+	}
+
+	auto& floor = m_scene.instantiateSceneObject();
+	floor.setMesh(m_planeMesh);
+	floor.setMaterial(m_material);
+	floor.transform.scale = { 40, 1, 40 };
+	floor.mobility = SceneObject::Mobility::Static;
+
+	m_cameraTr = transform3d(vector3(0.0f, 8.0f, 14.0f),
+	                         orientation(0.0_deg, -30.0_deg), { 1, 1, 1 });
+	m_lightTr = transform3d(vector3(20.0f, 40.0f, 20.0f),
+	                        orientation(30.0_deg, -55.0_deg), { 1, 1, 1 });
+	// far enough to only add a little fill light
+	m_pointLightPosition = { 0.0f, 50.0f, 50.0f };
+}
+
+void ReferenceScene::buildStress()
+{
+	uint32_t materialCount = std::max(m_stress.materials, 1u);
+	for (uint32_t i = 0; i < materialCount; i++)
+	{
+		float t = (float(i) + 0.5f) / float(materialCount);
+
+		auto* materialInstance = m_material.instanciate();
+		materialInstance->setFloatParameter("roughness", t);
+		materialInstance->setFloatParameter("metalness", float(i % 2));
+		materialInstance->setVec4Parameter("color",
+		                                   vector4(t, 1.0f - t, 0.5f, 1.0f));
+		m_materialInstances.push_back(materialInstance);
+	}
+
+	uint32_t side = uint32_t(std::ceil(std::sqrt(float(m_stress.objects))));
+	float offset = float(std::max(side, 1u) - 1) * m_stress.spacing / 2.0f;
+
+	for (uint32_t i = 0; i < m_stress.objects; i++)
+	{
+		auto& sphere = m_scene.instantiateSceneObject();
+		sphere.setMesh(m_sphereMesh);
+		sphere.setMaterial(*m_materialInstances[i % materialCount]);
+		sphere.transform.position = {
+			float(i % side) * m_stress.spacing - offset, 1.0f,
+			float(i / side) * m_stress.spacing - offset
+		};
+		sphere.transform.scale = { 0.5f, 0.5f, 0.5f };
+		sphere.mobility = SceneObject::Mobility::Static;
+	}
+
+	float radius = stressRadius();
+	m_cameraTr = transform3d(vector3(0.0f, radius, radius * 1.5f + 5.0f),
+	                         orientation(0.0_deg, -30.0_deg), { 1, 1, 1 });
+	m_lightTr = transform3d(vector3(20.0f, 40.0f, 20.0f),
+	                        orientation(30.0_deg, -55.0_deg), { 1, 1, 1 });
+}
+
+float ReferenceScene::stressRadius() const
+{
+	float side = std::ceil(std::sqrt(float(m_stress.objects)));
+	return side * m_stress.spacing / 2.0f;
+}
+
+void ReferenceScene::uploadLights()
+{
+	bool stress = m_geometry == Geometry::Stress;
+	uint32_t pointLightCount = stress ? std::max(m_stress.pointLights, 1u) : 1;
+
+	auto* shadingModelData =
+	    m_shadingModel.m_shadingModelStaging
+	        .map<PbrShadingModel::ShadingModelUboStruct>();
+	shadingModelData->pointLightsCount = pointLightCount;
+	shadingModelData->directionalLightsCount = 1;
+	m_shadingModel.m_shadingModelStaging.unmap();
+	m_shadingModel.uploadShadingModelDataStaging();
+
+	auto* pointLights = m_shadingModel.m_pointLightsStaging
+	                        .map<PbrShadingModel::PointLightUboStruct>();
+	if (stress)
+	{
+		// the total power does not depend on the light count
+		float radius = stressRadius();
+		for (uint32_t i = 0; i < pointLightCount; i++)
+		{
+			float angle = 2.0f * Pi * float(i) / float(pointLightCount);
+			pointLights[i].position = vector3(std::cos(angle) * radius, 10.0f,
+			                                  std::sin(angle) * radius);
+			pointLights[i].color = vector4(1.0f, 1.0f, 1.0f, 1.0f) *
+			                       (80.0f / float(pointLightCount));
+			pointLights[i].intensity = 1.0f;
+		}
+	}
+	else
+	{
+		pointLights->position = m_pointLightPosition;
+		pointLights->color = vector4(1.0f, 1.0f, 1.0f, 1.0f) * 80.0f;
+		pointLights->intensity = 1.0f;
+	}
+	m_shadingModel.m_pointLightsStaging.unmap();
+	m_shadingModel.uploadPointLightsStaging();
+
+	// the shadows are cast along the forward axis of the light transform
+	auto* directionalLights =
+	    m_shadingModel.m_directionalLightsStaging
+	        .map<PbrShadingModel::DirectionalLightUboStruct>();
+	directionalLights->direction =
+	    (m_lightTr.rotation * vector3(0, 0, -1)).get_normalized();
+	directionalLights->color = vector4(1.0f, 1.0f, 1.0f, 1.0f) * 2.0f;
+	directionalLights->intensity = 1.0f;
+	m_shadingModel.m_directionalLightsStaging.unmap();
+	m_shadingModel.uploadDirectionalLightsStaging();
+}
+
+void ReferenceScene::submitFrame(const RenderOptions& options)
+{
+	m_scene.depthPrepass = options.depthPrepass;
+	m_scene.shadowmapCaching = options.shadowmapCaching;
+	m_scene.occlusionCulling = options.occlusionCulling;
+
+	auto& rc = m_renderContext.get();
+	auto& vk = rc.device();
+	VkExtent2D extent = rc.swapchainExtent();
+
+	matrix4 proj = matrix4::perspective(90_deg,
+	                                    float(extent.width) /
+	                                        float(extent.height),
+	                                    0.01f, 1000.0f)
+	                   .get_transposed();
+
+	uploadLights();
+	m_scene.uploadTransformMatrices(m_cameraTr, proj, m_lightTr);
+	m_scene.applyShaderReloads();
+	m_shadingModel.textureTable().beginFrame();
+	m_material.beginFrame();
+
+	auto& frame = rc.getAvailableCommandBuffer();
+	frame.reset();
+	auto& cb = frame.commandBuffer;
+
+	cb.begin();
+	m_gpuProfiler.beginFrame(cb);
+	m_frameStats.beginFrame(cb);
+
+	{
+		auto scope =
+		    m_gpuProfiler.scope(cb, "shadows", { 0.2f, 0.2f, 0.4f, 1.0f });
+		m_scene.drawShadowmapPass(cb);
+	}
+	m_scene.cullOcclusion(cb);
+
+	VkClearValue clearColor{};
+	clearColor.color.float32[0] = 0X27 / 255.0f;
+	clearColor.color.float32[1] = 0X28 / 255.0f;
+	clearColor.color.float32[2] = 0X22 / 255.0f;
+	clearColor.color.float32[3] = 1.0f;
+
+	VkClearValue clearID{};
+	clearID.color.uint32[0] = 0xffff;
+
+	VkClearValue clearZero{};
+
+	VkClearValue clearDepth{};
+	clearDepth.depthStencil.depth = 1.0f;
+
+	std::array clearValues{ clearColor, clearID, clearZero, clearZero,
+		                    clearColor, clearID, clearZero, clearZero,
+		                    clearDepth };
+
+	vk::RenderPassBeginInfo rpInfo;
+	rpInfo.framebuffer = m_framebuffer;
+	rpInfo.renderPass = m_renderPass;
+	rpInfo.renderArea.extent = extent;
+	rpInfo.clearValueCount = uint32_t(clearValues.size());
+	rpInfo.pClearValues = clearValues.data();
+
+	vk::SubpassBeginInfo subpassBeginInfo;
+	subpassBeginInfo.contents = VK_SUBPASS_CONTENTS_INLINE;
+
+	vk::SubpassEndInfo subpassEndInfo;
+
+	VkViewport viewport = {};
+	viewport.width = float(extent.width);
+	viewport.height = float(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor = {};
+	scissor.extent = extent;
+
+	{
+		auto scope =
+		    m_gpuProfiler.scope(cb, "main", { 0.3f, 0.8f, 0.4f, 1.0f });
+		cb.beginRenderPass2(rpInfo, subpassBeginInfo);
+		m_scene.draw(cb, m_renderPass, viewport, scissor);
+		cb.endRenderPass2(subpassEndInfo);
+	}
+	{
+		auto scope = m_gpuProfiler.scope(cb, "depth pyramid",
+		                                 { 0.5f, 0.5f, 0.5f, 1.0f });
+		m_scene.buildDepthPyramid(cb);
+	}
+
+	m_frameStats.endFrame(cb);
+	cb.end();
+	m_frameStats.add(cb);
+
+	if (frame.submit(vk.graphicsQueue()) != VK_SUCCESS)
+	{
+		std::cerr << "error: failed to submit ReferenceScene command buffer"
+		          << std::endl;
+		abort();
+	}
+}
+
+void ReferenceScene::drawFrame(const RenderOptions& options)
+{
+	submitFrame(options);
+
+	// frames are not overlapped, the CPU occlusion culling then always
+	// reads the depth of the previous one
+	m_renderContext.get().device().wait();
+}
+
+std::vector<uint8_t> ReferenceScene::render(const RenderOptions& options,
+                                            uint32_t frameCount)
+{
+	for (uint32_t i = 0; i < frameCount; i++)
+		drawFrame(options);
+
+	return m_resolveAttachments[0].downloadDataImmediate<uint8_t>(
+	    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+}
+}  // namespace cdm
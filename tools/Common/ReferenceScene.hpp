@@ -0,0 +1,159 @@
+#pragma once
+
+#include "BrdfLut.hpp"
+#include "Cubemap.hpp"
+#include "DepthPyramid.hpp"
+#include "DepthTexture.hpp"
+#include "GpuProfiler.hpp"
+#include "HeadlessRenderContext.hpp"
+#include "IrradianceMap.hpp"
+#include "Materials/DefaultMaterial.hpp"
+#include "PbrShadingModel.hpp"
+#include "PrefilteredCubemap.hpp"
+#include "Scene.hpp"
+#include "SceneObject.hpp"
+#include "StandardMesh.hpp"
+#include "Stats.hpp"
+#include "Texture2D.hpp"
+
+#include "cdm_maths.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace cdm
+{
+/// Image based lighting of the reference scenes, computed once from a
+/// procedural sky so that no asset is needed
+class ReferenceEnvironment final
+{
+	Texture2D m_equirectangularTexture;
+	Cubemap m_environmentMap;
+	IrradianceMap m_irradianceMap;
+	PrefilteredCubemap m_prefilteredMap;
+	BrdfLut m_brdfLut;
+
+public:
+	explicit ReferenceEnvironment(RenderContext& renderContext);
+	ReferenceEnvironment(const ReferenceEnvironment&) = delete;
+	ReferenceEnvironment(ReferenceEnvironment&&) = delete;
+	~ReferenceEnvironment() = default;
+
+	ReferenceEnvironment& operator=(const ReferenceEnvironment&) = delete;
+	ReferenceEnvironment& operator=(ReferenceEnvironment&&) = delete;
+
+	Cubemap& irradianceMap() noexcept { return m_irradianceMap.get(); }
+	Cubemap& prefilteredMap() noexcept { return m_prefilteredMap.get(); }
+	Texture2D& brdfLut() noexcept { return m_brdfLut.get(); }
+};
+
+/// A ShaderBall-like scene built from procedural meshes and rendered
+/// offscreen with the main pass layout of ShaderBall: 4x MSAA color, object
+/// ID, normal-depth and position attachments resolved at the end of the
+/// pass. `Geometry::Stress` is the scene `Benchmark stress` times
+class ReferenceScene final
+{
+public:
+	enum class Geometry
+	{
+		/// spheres of increasing roughness and metalness under IBL and a
+		/// point light
+		Materials,
+		/// static spheres on a plane with cascaded shadows from a
+		/// directional light
+		Shadows,
+		/// `StressParameters::objects` spheres on a grid, the same scene
+		/// as `ShaderBall::StressScene`
+		Stress,
+	};
+
+	/// Only read for `Geometry::Stress`
+	struct StressParameters
+	{
+		uint32_t objects = 1000;
+		uint32_t materials = 16;
+		/// on a ring above the grid
+		uint32_t pointLights = 8;
+		float spacing = 3.0f;
+	};
+
+	/// Paths that must render the same image as the default one
+	struct RenderOptions
+	{
+		bool depthPrepass = false;
+		bool shadowmapCaching = false;
+		Scene::OcclusionCulling occlusionCulling =
+		    Scene::OcclusionCulling::Disabled;
+	};
+
+private:
+	std::reference_wrapper<HeadlessRenderContext> m_renderContext;
+
+	Geometry m_geometry;
+	StressParameters m_stress;
+
+	PbrShadingModel m_shadingModel;
+	DefaultMaterial m_material;
+	std::vector<MaterialInstance*> m_materialInstances;
+	StandardMesh m_sphereMesh;
+	StandardMesh m_planeMesh;
+
+	Scene m_scene;
+
+	UniqueRenderPass m_renderPass;
+	UniqueFramebuffer m_framebuffer;
+
+	/// color, object ID, normal-depth and position
+	std::vector<Texture2D> m_attachments;
+	std::vector<Texture2D> m_resolveAttachments;
+	DepthTexture m_depthTexture;
+	std::unique_ptr<DepthPyramid> m_depthPyramid;
+
+	transform3d m_cameraTr;
+	transform3d m_lightTr;
+	vector3 m_pointLightPosition;
+
+	GpuProfiler m_gpuProfiler;
+	FrameStats m_frameStats;
+
+	void createRenderPass();
+	void createFramebuffer();
+	void bindEnvironment(ReferenceEnvironment& environment);
+
+	void buildMaterials();
+	void buildShadows();
+	void buildStress();
+
+	void uploadLights();
+
+public:
+	ReferenceScene(HeadlessRenderContext& renderContext,
+	               ReferenceEnvironment& environment, Geometry geometry,
+	               const StressParameters& stress = {});
+	ReferenceScene(const ReferenceScene&) = delete;
+	ReferenceScene(ReferenceScene&&) = delete;
+	~ReferenceScene();
+
+	ReferenceScene& operator=(const ReferenceScene&) = delete;
+	ReferenceScene& operator=(ReferenceScene&&) = delete;
+
+	/// Renders `frameCount` frames, the first ones fill the shadowmap cache
+	/// and the depth pyramid, and returns the resolved color of the last
+	/// one as tightly packed RGBA8 rows
+	std::vector<uint8_t> render(const RenderOptions& options,
+	                            uint32_t frameCount = 3);
+
+	/// Records and submits one frame. The previous one must be done, the
+	/// buffers it reads are rewritten
+	void submitFrame(const RenderOptions& options);
+	/// `submitFrame`, then waits for the device
+	void drawFrame(const RenderOptions& options);
+
+	void setCamera(const transform3d& cameraTr) { m_cameraTr = cameraTr; }
+	/// Half the side of the stress grid, centered on the origin
+	float stressRadius() const;
+
+	const GpuProfiler& gpuProfiler() const noexcept { return m_gpuProfiler; }
+	const FrameStats& frameStats() const noexcept { return m_frameStats; }
+};
+}  // namespace cdm
@@ -0,0 +1,215 @@
+#include "FrameReplayer.hpp"
+#include "HeadlessRenderContext.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cdm
+{
+namespace
+{
+struct Options
+{
+	std::string capture;
+	uint32_t iterations = 100;
+	/// not measured, warms up the driver and the clocks
+	uint32_t warmup = 10;
+	/// no results file when empty
+	std::string json;
+};
+
+struct Summary
+{
+	double mean = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+};
+
+Summary summarize(const std::vector<double>& samples)
+{
+	Summary res;
+	if (samples.empty())
+		return res;
+
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+
+	res.mean = sum / double(samples.size());
+	res.min = *std::min_element(samples.begin(), samples.end());
+	res.max = *std::max_element(samples.begin(), samples.end());
+
+	return res;
+}
+
+void writeSummary(std::ostream& os, const std::vector<double>& samples)
+{
+	Summary s = summarize(samples);
+
+	os << "{\"mean\":" << s.mean << ",\"min\":" << s.min
+	   << ",\"max\":" << s.max << ",\"samples\":[";
+	for (size_t i = 0; i < samples.size(); i++)
+		os << (i == 0 ? "" : ",") << samples[i];
+	os << "]}";
+}
+
+bool writeResults(const Options& options, const VulkanDevice& vk,
+                  const std::vector<double>& cpuMilliseconds,
+                  const std::vector<double>& gpuMilliseconds)
+{
+	std::ofstream file(options.json);
+	if (!file.is_open())
+	{
+		std::cerr << "error: failed to open " << options.json << std::endl;
+		return false;
+	}
+
+	VkPhysicalDeviceProperties properties{};
+	vk.GetPhysicalDeviceProperties(vk.physicalDevice(), &properties);
+
+	file << std::fixed << std::setprecision(4);
+	file << "{\n\"capture\":\"" << options.capture << "\",\n";
+	file << "\"device\":\"" << properties.deviceName << "\",\n";
+	file << "\"iterations\":" << options.iterations << ",\n";
+	file << "\"cpuMilliseconds\":";
+	writeSummary(file, cpuMilliseconds);
+	file << ",\n\"gpuMilliseconds\":";
+	if (gpuMilliseconds.empty())
+		file << "null";
+	else
+		writeSummary(file, gpuMilliseconds);
+	file << "\n}\n";
+
+	return file.good();
+}
+
+void printUsage()
+{
+	std::cerr << "usage: FrameReplay capture-file [--iterations N] "
+	             "[--warmup N] [--json path]"
+	          << std::endl;
+}
+
+std::optional<Options> parseOptions(int argc, char** argv)
+{
+	if (argc < 2)
+		return std::nullopt;
+
+	Options res;
+	res.capture = argv[1];
+
+	for (int i = 2; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 == argc)
+			return std::nullopt;
+		std::string value = argv[++i];
+
+		try
+		{
+			if (option == "--iterations")
+				res.iterations = uint32_t(std::stoul(value));
+			else if (option == "--warmup")
+				res.warmup = uint32_t(std::stoul(value));
+			else if (option == "--json")
+				res.json = value;
+			else
+				return std::nullopt;
+		}
+		catch (const std::logic_error&)
+		{
+			return std::nullopt;
+		}
+	}
+
+	if (res.iterations == 0)
+		return std::nullopt;
+
+	return res;
+}
+}  // namespace
+}  // namespace cdm
+
+/// Replays a frame captured with `Benchmark --capture` on a headless device,
+/// to time its command buffers without the application, the window or the
+/// presentation
+int main(int argc, char** argv)
+{
+	using namespace cdm;
+
+	std::optional<Options> options = parseOptions(argc, argv);
+	if (!options)
+	{
+		printUsage();
+		return 1;
+	}
+
+	HeadlessRenderContext renderContext({ 64, 64 });
+
+	std::optional<FrameReplayer> replayer;
+	try
+	{
+		replayer.emplace(renderContext.device(), options->capture);
+	}
+	catch (const std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	const FrameReplayer::Statistics& stats = replayer->statistics();
+	std::cout << options->capture << ": " << stats.objects << " objects ("
+	          << stats.skippedObjects << " skipped), " << stats.submits
+	          << " submits, " << stats.commandBuffers << " command buffers, "
+	          << stats.commands << " commands (" << stats.skippedCommands
+	          << " skipped), " << stats.skippedDescriptors
+	          << " descriptors skipped" << std::endl;
+
+	std::vector<double> cpuMilliseconds;
+	std::vector<double> gpuMilliseconds;
+	cpuMilliseconds.reserve(options->iterations);
+	gpuMilliseconds.reserve(options->iterations);
+
+	try
+	{
+		for (uint32_t i = 0; i < options->warmup; i++)
+			replayer->replay();
+
+		for (uint32_t i = 0; i < options->iterations; i++)
+		{
+			FrameReplayer::Timings timings = replayer->replay();
+			cpuMilliseconds.push_back(timings.cpuTime);
+			if (timings.gpuTime > 0.0)
+				gpuMilliseconds.push_back(timings.gpuTime);
+		}
+	}
+	catch (const std::runtime_error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	Summary cpu = summarize(cpuMilliseconds);
+	std::cout << std::fixed << std::setprecision(3) << "cpu: " << cpu.mean
+	          << " ms mean, " << cpu.min << " ms min, " << cpu.max
+	          << " ms max" << std::endl;
+	if (!gpuMilliseconds.empty())
+	{
+		Summary gpu = summarize(gpuMilliseconds);
+		std::cout << "gpu: " << gpu.mean << " ms mean, " << gpu.min
+		          << " ms min, " << gpu.max << " ms max" << std::endl;
+	}
+
+	if (!options->json.empty() &&
+	    !writeResults(*options, renderContext.device(), cpuMilliseconds,
+	                  gpuMilliseconds))
+		return 1;
+
+	return 0;
+}
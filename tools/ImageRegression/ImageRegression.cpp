@@ -0,0 +1,329 @@
+#include "ReferenceScene.hpp"
+
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cdm
+{
+namespace
+{
+constexpr uint32_t Width = 320;
+constexpr uint32_t Height = 240;
+
+struct Options
+{
+	std::string filter;
+	std::string goldenDir = "../tools/ImageRegression/golden";
+	std::string outputDir = ".";
+	bool update = false;
+	/// allowed mean CIE76 difference over the image
+	double maxMeanDeltaE = 0.5;
+	/// a pixel differing more than this counts as wrong
+	double badDeltaE = 5.0;
+	/// allowed share of wrong pixels
+	double maxBadPixels = 0.001;
+};
+
+struct TestCase
+{
+	std::string name;
+	/// the fast paths are compared to the image of the default path
+	std::string golden;
+	ReferenceScene::Geometry geometry;
+	ReferenceScene::RenderOptions options;
+};
+
+std::vector<TestCase> testCases()
+{
+	using Geometry = ReferenceScene::Geometry;
+	using Culling = Scene::OcclusionCulling;
+
+	return {
+		{ "materials", "materials", Geometry::Materials, {} },
+		{ "materials-depth-prepass", "materials", Geometry::Materials,
+		  { true, false, Culling::Disabled } },
+		{ "shadows", "shadows", Geometry::Shadows, {} },
+		{ "shadows-cached", "shadows", Geometry::Shadows,
+		  { false, true, Culling::Disabled } },
+		{ "shadows-depth-prepass", "shadows", Geometry::Shadows,
+		  { true, false, Culling::Disabled } },
+		{ "shadows-occlusion-cpu", "shadows", Geometry::Shadows,
+		  { false, false, Culling::Cpu } },
+		{ "shadows-occlusion-gpu", "shadows", Geometry::Shadows,
+		  { false, false, Culling::Gpu } },
+	};
+}
+
+struct Image
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	/// tightly packed RGBA8
+	std::vector<uint8_t> pixels;
+};
+
+std::optional<Image> loadPng(const std::string& path)
+{
+	int w, h, c;
+	uint8_t* data = stbi_load(path.c_str(), &w, &h, &c, 4);
+	if (data == nullptr)
+		return std::nullopt;
+
+	Image res;
+	res.width = uint32_t(w);
+	res.height = uint32_t(h);
+	res.pixels.assign(data, data + size_t(w) * size_t(h) * 4);
+	stbi_image_free(data);
+
+	return res;
+}
+
+bool writePng(const std::string& path, const Image& image)
+{
+	if (stbi_write_png(path.c_str(), int(image.width), int(image.height), 4,
+	                   image.pixels.data(), int(image.width * 4)) == 0)
+	{
+		std::cerr << "error: failed to write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/// CIE L*a*b* of an sRGB color, D65 white point
+vector3 srgbToLab(const uint8_t* rgb)
+{
+	auto toLinear = [](uint8_t c) {
+		float v = float(c) / 255.0f;
+		return v <= 0.04045f ? v / 12.92f
+		                     : std::pow((v + 0.055f) / 1.055f, 2.4f);
+	};
+	float r = toLinear(rgb[0]);
+	float g = toLinear(rgb[1]);
+	float b = toLinear(rgb[2]);
+
+	float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+	float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+	float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+	auto f = [](float t) {
+		return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+	};
+
+	return { 116.0f * f(y) - 16.0f, 500.0f * (f(x) - f(y)),
+		     200.0f * (f(y) - f(z)) };
+}
+
+struct Comparison
+{
+	double meanDeltaE = 0.0;
+	double maxDeltaE = 0.0;
+	/// share of the pixels above `Options::badDeltaE`
+	double badPixels = 0.0;
+	/// white where the images match, red where they differ the most
+	Image diff;
+};
+
+/// Perceptual difference, the rasterization and filtering of two devices or
+/// drivers never match bit for bit
+Comparison compare(const Image& actual, const Image& golden,
+                   const Options& options)
+{
+	Comparison res;
+	res.diff.width = actual.width;
+	res.diff.height = actual.height;
+	res.diff.pixels.resize(actual.pixels.size());
+
+	size_t pixelCount = size_t(actual.width) * actual.height;
+	size_t badPixels = 0;
+	double sum = 0.0;
+
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		double deltaE = double((srgbToLab(&actual.pixels[i * 4]) -
+		                        srgbToLab(&golden.pixels[i * 4]))
+		                           .norm());
+
+		sum += deltaE;
+		res.maxDeltaE = std::max(res.maxDeltaE, deltaE);
+		if (deltaE > options.badDeltaE)
+			badPixels++;
+
+		// saturates at twice the threshold
+		auto fade = uint8_t(
+		    255.0 * (1.0 - std::min(deltaE / (2.0 * options.badDeltaE), 1.0)));
+		res.diff.pixels[i * 4 + 0] = 255;
+		res.diff.pixels[i * 4 + 1] = fade;
+		res.diff.pixels[i * 4 + 2] = fade;
+		res.diff.pixels[i * 4 + 3] = 255;
+	}
+
+	res.meanDeltaE = sum / double(pixelCount);
+	res.badPixels = double(badPixels) / double(pixelCount);
+
+	return res;
+}
+
+void printUsage()
+{
+	std::cerr << "usage: ImageRegression [--filter substring] [--update] "
+	             "[--golden-dir path] [--output-dir path] "
+	             "[--max-mean-delta-e value] [--bad-delta-e value] "
+	             "[--max-bad-pixels ratio]"
+	          << std::endl;
+}
+
+std::optional<Options> parseOptions(int argc, char** argv)
+{
+	Options res;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (option == "--update")
+		{
+			res.update = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+			return std::nullopt;
+		std::string value = argv[++i];
+
+		try
+		{
+			if (option == "--filter")
+				res.filter = value;
+			else if (option == "--golden-dir")
+				res.goldenDir = value;
+			else if (option == "--output-dir")
+				res.outputDir = value;
+			else if (option == "--max-mean-delta-e")
+				res.maxMeanDeltaE = std::stod(value);
+			else if (option == "--bad-delta-e")
+				res.badDeltaE = std::stod(value);
+			else if (option == "--max-bad-pixels")
+				res.maxBadPixels = std::stod(value);
+			else
+				return std::nullopt;
+		}
+		catch (const std::logic_error&)
+		{
+			return std::nullopt;
+		}
+	}
+
+	return res;
+}
+
+/// Renders `testCase` and compares it to its golden image, or replaces the
+/// golden image when updating a default path
+bool run(HeadlessRenderContext& renderContext,
+         ReferenceEnvironment& environment, const TestCase& testCase,
+         const Options& options)
+{
+	Image actual;
+	actual.width = Width;
+	actual.height = Height;
+	{
+		ReferenceScene scene(renderContext, environment, testCase.geometry);
+		actual.pixels = scene.render(testCase.options);
+	}
+
+	// the clear alpha is not part of what is compared
+	for (size_t i = 3; i < actual.pixels.size(); i += 4)
+		actual.pixels[i] = 255;
+
+	std::string goldenPath = options.goldenDir + "/" + testCase.golden + ".png";
+
+	if (options.update && testCase.name == testCase.golden)
+	{
+		std::cout << std::left << std::setw(28) << testCase.name
+		          << "updated " << goldenPath << std::endl;
+		return writePng(goldenPath, actual);
+	}
+
+	std::optional<Image> golden = loadPng(goldenPath);
+	if (!golden)
+	{
+		std::cerr << "error: failed to load " << goldenPath
+		          << ", run with --update on the reference device first"
+		          << std::endl;
+		return false;
+	}
+	if (golden->width != actual.width || golden->height != actual.height)
+	{
+		std::cerr << "error: " << goldenPath << " is " << golden->width << "x"
+		          << golden->height << " instead of " << actual.width << "x"
+		          << actual.height << std::endl;
+		return false;
+	}
+
+	Comparison comparison = compare(actual, *golden, options);
+	bool passed = comparison.meanDeltaE <= options.maxMeanDeltaE &&
+	              comparison.badPixels <= options.maxBadPixels;
+
+	std::cout << std::left << std::setw(28) << testCase.name
+	          << (passed ? "passed" : "FAILED") << std::fixed
+	          << std::setprecision(3) << "  mean dE " << comparison.meanDeltaE
+	          << "  max dE " << comparison.maxDeltaE << "  bad pixels "
+	          << comparison.badPixels * 100.0 << "%" << std::endl;
+
+	if (!passed)
+	{
+		writePng(options.outputDir + "/" + testCase.name + "_actual.png",
+		         actual);
+		writePng(options.outputDir + "/" + testCase.name + "_diff.png",
+		         comparison.diff);
+	}
+
+	return passed;
+}
+}  // namespace
+}  // namespace cdm
+
+/// Renders the reference scenes through every path that must not change the
+/// image and compares them to golden images, meant to run on a software
+/// device such as lavapipe whose output is the same on every machine
+int main(int argc, char** argv)
+{
+	using namespace cdm;
+
+	std::optional<Options> options = parseOptions(argc, argv);
+	if (!options)
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(options->goldenDir, error);
+	std::filesystem::create_directories(options->outputDir, error);
+
+	HeadlessRenderContext renderContext({ Width, Height });
+	ReferenceEnvironment environment(renderContext);
+
+	uint32_t failures = 0;
+	uint32_t runs = 0;
+	for (const TestCase& testCase : testCases())
+	{
+		if (testCase.name.find(options->filter) == std::string::npos)
+			continue;
+
+		runs++;
+		if (!run(renderContext, environment, testCase, *options))
+			failures++;
+	}
+
+	std::cout << runs - failures << "/" << runs << " passed" << std::endl;
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#include "MicroBenchmark.hpp"
+
+#include "load_dds.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace cdm
+{
+namespace
+{
+/// The 128 bytes of the header followed by the 20 of the DX10 one, see
+/// load_dds.cpp for the layout
+std::array<std::byte, 148> ddsHeaders(const char (&fourCC)[5],
+                                      uint32_t dxgiFormat)
+{
+	std::array<std::byte, 148> res{};
+
+	auto write = [&res](size_t offset, uint32_t value) {
+		std::memcpy(res.data() + offset, &value, sizeof(value));
+	};
+
+	std::memcpy(res.data(), "DDS ", 4);
+	write(4, 124);
+	write(12, 2048);  // height
+	write(16, 2048);  // width
+	write(28, 12);    // mipmap count
+	write(76, 32);
+	write(80, 0x4);  // FourCC pixel format
+	std::memcpy(res.data() + 84, fourCC, 4);
+	write(128, dxgiFormat);
+
+	return res;
+}
+
+void DdsParseHeaderDXT5(bench::State& state)
+{
+	auto headers = ddsHeaders("DXT5", 0);
+
+	for (auto _ : state)
+	{
+		DDSInfo info;
+		bool parsed = dds_parseHeader(headers.data(), headers.size(), info);
+		bench::doNotOptimize(parsed);
+		bench::doNotOptimize(info);
+	}
+}
+CDM_BENCHMARK(DdsParseHeaderDXT5);
+
+void DdsParseHeaderDX10(bench::State& state)
+{
+	// DXGI_FORMAT_R32G32B32A32_FLOAT
+	auto headers = ddsHeaders("DX10", 2);
+
+	for (auto _ : state)
+	{
+		DDSInfo info;
+		bool parsed = dds_parseHeader(headers.data(), headers.size(), info);
+		bench::doNotOptimize(parsed);
+		bench::doNotOptimize(info);
+	}
+}
+CDM_BENCHMARK(DdsParseHeaderDX10);
+}  // namespace
+}  // namespace cdm
@@ -0,0 +1,100 @@
+#include "MicroBenchmark.hpp"
+
+#include "Materials/DefaultMaterialParameters.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace cdm
+{
+namespace
+{
+/// The setters and handles of `DefaultMaterial` without its device half:
+/// no render context, no shader, and the upload is the no-op of `Material`
+class ParameterMaterial final : public DefaultMaterialParameters
+{
+public:
+	MaterialVertexFunction vertexFunction(
+	    sdw::VertexWriter& writer,
+	    VertexShaderBuildDataBase* shaderBuildData) override
+	{
+		throw std::runtime_error("ParameterMaterial has no shader");
+	}
+	MaterialFragmentFunction fragmentFunction(
+	    sdw::FragmentWriter& writer,
+	    FragmentShaderBuildDataBase* shaderBuildData) override
+	{
+		throw std::runtime_error("ParameterMaterial has no shader");
+	}
+};
+
+std::vector<MaterialInstance*> instantiate(Material& material, size_t count)
+{
+	std::vector<MaterialInstance*> res(count);
+	for (auto& instance : res)
+		instance = material.instanciate();
+	return res;
+}
+
+/// `arg` is the instance count, each instance gets its color and roughness
+void MaterialSetParameterByName(bench::State& state)
+{
+	ParameterMaterial material;
+	std::vector<MaterialInstance*> instances =
+	    instantiate(material, size_t(state.arg()));
+
+	float value = 0.0f;
+	for (auto _ : state)
+	{
+		for (MaterialInstance* instance : instances)
+		{
+			instance->setVec4Parameter("color", { value, value, value, 1 });
+			instance->setFloatParameter("roughness", value);
+		}
+		value += 1.0f;
+		bench::clobberMemory();
+	}
+	state.setItemsProcessed(state.iterations() * instances.size() * 2);
+}
+CDM_BENCHMARK_ARG(MaterialSetParameterByName, 1000);
+
+/// Same writes as `MaterialSetParameterByName`, through `ParameterHandle`s
+void MaterialSetParameterByHandle(bench::State& state)
+{
+	ParameterMaterial material;
+	std::vector<MaterialInstance*> instances =
+	    instantiate(material, size_t(state.arg()));
+
+	auto color = material.parameterHandle<vector4>("color");
+	auto roughness = material.parameterHandle<float>("roughness");
+
+	float value = 0.0f;
+	for (auto _ : state)
+	{
+		for (MaterialInstance* instance : instances)
+		{
+			instance->setParameter(color, vector4{ value, value, value, 1 });
+			instance->setParameter(roughness, value);
+		}
+		value += 1.0f;
+		bench::clobberMemory();
+	}
+	state.setItemsProcessed(state.iterations() * instances.size() * 2);
+}
+CDM_BENCHMARK_ARG(MaterialSetParameterByHandle, 1000);
+
+/// Handle lookup by name, done once per parameter by the callers of
+/// `parameterHandle`
+void MaterialParameterHandle(bench::State& state)
+{
+	ParameterMaterial material;
+
+	for (auto _ : state)
+	{
+		auto roughness = material.parameterHandle<float>("roughness");
+		bench::doNotOptimize(roughness);
+	}
+}
+CDM_BENCHMARK(MaterialParameterHandle);
+}  // namespace
+}  // namespace cdm
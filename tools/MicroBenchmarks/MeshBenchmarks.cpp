@@ -0,0 +1,111 @@
+#include "MicroBenchmark.hpp"
+
+#include "StandardMesh.hpp"
+
+#include "cdm_maths.hpp"
+
+#include <random>
+#include <vector>
+
+namespace cdm
+{
+namespace
+{
+std::vector<StandardMesh::Vertex> randomVertices(size_t count)
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+
+	std::vector<StandardMesh::Vertex> res(count);
+	for (auto& v : res)
+	{
+		v.position = { dist(rng), dist(rng), dist(rng) };
+		v.normal = vector3(dist(rng), dist(rng), dist(rng)).get_normalized();
+		v.uv = { dist(rng), dist(rng) };
+		v.tangent = vector3(dist(rng), dist(rng), dist(rng)).get_normalized();
+	}
+
+	return res;
+}
+
+/// Same poses as the objects of a scene, scattered and rotated
+std::vector<transform3d> randomTransforms(size_t count)
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+
+	std::vector<transform3d> res(count);
+	for (auto& t : res)
+	{
+		t.position = { dist(rng), dist(rng), dist(rng) };
+		t.rotation = quaternion(
+		    vector3(dist(rng), dist(rng), dist(rng)).get_normalized(),
+		    radian(dist(rng)));
+		t.scale = { 1, 1, 1 };
+	}
+
+	return res;
+}
+
+/// `arg` is the vertex count
+void StandardMeshPackPositions(bench::State& state)
+{
+	std::vector<StandardMesh::Vertex> vertices =
+	    randomVertices(size_t(state.arg()));
+
+	for (auto _ : state)
+	{
+		vector3 boundsMin;
+		vector3 boundsMax;
+		std::vector<vector4> positions =
+		    StandardMesh::packPositions(vertices, boundsMin, boundsMax);
+		bench::doNotOptimize(positions.data());
+		bench::doNotOptimize(boundsMin);
+		bench::doNotOptimize(boundsMax);
+	}
+	state.setItemsProcessed(state.iterations() * vertices.size());
+}
+CDM_BENCHMARK_ARG(StandardMeshPackPositions, 1024);
+CDM_BENCHMARK_ARG(StandardMeshPackPositions, 1048576);
+
+/// Model matrices as written by `Scene::uploadTransformMatrices`, `arg` is
+/// the object count
+void ModelMatrices(bench::State& state)
+{
+	std::vector<transform3d> transforms =
+	    randomTransforms(size_t(state.arg()));
+	std::vector<matrix4> models(transforms.size());
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < transforms.size(); i++)
+			models[i] = matrix4(transforms[i]).get_transposed();
+		bench::doNotOptimize(models.data());
+		bench::clobberMemory();
+	}
+	state.setItemsProcessed(state.iterations() * transforms.size());
+}
+CDM_BENCHMARK_ARG(ModelMatrices, 1000);
+CDM_BENCHMARK_ARG(ModelMatrices, 100000);
+
+/// View and view projection matrices of `Scene::uploadTransformMatrices`
+void ViewMatrices(bench::State& state)
+{
+	std::vector<transform3d> cameras = randomTransforms(256);
+	matrix4 proj = matrix4::perspective(90_deg, 16.0f / 9.0f, 0.1f, 100.0f);
+
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const transform3d& cameraTr = cameras[i++ % cameras.size()];
+		matrix4 view = matrix4(cameraTr).get_transposed().get_inversed();
+		matrix4 viewProj =
+		    proj.get_transposed() * matrix4(cameraTr).get_inversed();
+		bench::doNotOptimize(view);
+		bench::doNotOptimize(viewProj);
+	}
+	state.setItemsProcessed(state.iterations());
+}
+CDM_BENCHMARK(ViewMatrices);
+}  // namespace
+}  // namespace cdm
@@ -0,0 +1,214 @@
+#include "MicroBenchmark.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cdm
+{
+namespace bench
+{
+namespace detail
+{
+const void* volatile escapedAddress = nullptr;
+}
+
+namespace
+{
+constexpr uint64_t MaxIterations = 1'000'000'000;
+
+struct Benchmark
+{
+	std::string name;
+	Function function = nullptr;
+	int64_t arg = 0;
+};
+
+std::vector<Benchmark>& registry()
+{
+	// function local, registrations happen during static initialization
+	static std::vector<Benchmark> res;
+	return res;
+}
+
+struct Result
+{
+	std::string name;
+	uint64_t iterations = 0;
+	double nanoseconds = 0.0;
+	/// 0 if the benchmark does not set its items
+	double itemsPerSecond = 0.0;
+};
+
+struct Options
+{
+	std::string filter;
+	double minSeconds = 0.5;
+	std::string json;
+};
+
+/// Runs the benchmark again with more iterations until its loop lasts
+/// `minSeconds`
+std::optional<Result> run(const Benchmark& benchmark, double minSeconds)
+{
+	uint64_t iterations = 1;
+	for (;;)
+	{
+		State state(iterations, benchmark.arg);
+		benchmark.function(state);
+
+		if (!state.finished())
+		{
+			std::cerr << "error: " << benchmark.name
+			          << " did not run its loop" << std::endl;
+			return std::nullopt;
+		}
+
+		double seconds = state.seconds();
+		if (seconds >= minSeconds || iterations >= MaxIterations)
+		{
+			Result res;
+			res.name = benchmark.name;
+			res.iterations = iterations;
+			res.nanoseconds = seconds * 1e9 / double(iterations);
+			if (state.itemsProcessed() != 0 && seconds > 0.0)
+				res.itemsPerSecond = double(state.itemsProcessed()) / seconds;
+			return res;
+		}
+
+		// aims a bit past the minimum, without trusting too short runs
+		double multiplier =
+		    seconds > 0.0 ? minSeconds * 1.4 / seconds : 10.0;
+		multiplier = std::clamp(multiplier, 2.0, 10.0);
+		iterations = std::min(uint64_t(double(iterations) * multiplier),
+		                      MaxIterations);
+	}
+}
+
+bool writeJson(const std::string& path, const std::vector<Result>& results)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << "error: failed to open " << path << std::endl;
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"benchmarks\":[";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		file << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << r.name
+		     << "\",\"iterations\":" << r.iterations
+		     << ",\"nsPerIteration\":" << r.nanoseconds
+		     << ",\"itemsPerSecond\":" << r.itemsPerSecond << "}";
+	}
+	file << "\n]}\n";
+
+	return file.good();
+}
+
+void printUsage()
+{
+	std::cerr << "usage: MicroBenchmarks [--filter substring] "
+	             "[--min-time seconds] [--json path]"
+	          << std::endl;
+}
+
+std::optional<Options> parseOptions(int argc, char** argv)
+{
+	Options res;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		if (i + 1 == argc)
+			return std::nullopt;
+		std::string value = argv[++i];
+
+		try
+		{
+			if (option == "--filter")
+				res.filter = value;
+			else if (option == "--min-time")
+				res.minSeconds = std::stod(value);
+			else if (option == "--json")
+				res.json = value;
+			else
+				return std::nullopt;
+		}
+		catch (const std::logic_error&)
+		{
+			return std::nullopt;
+		}
+	}
+
+	if (res.minSeconds <= 0.0)
+		return std::nullopt;
+
+	return res;
+}
+}  // namespace
+
+bool registerBenchmark(const char* name, Function function, int64_t arg)
+{
+	registry().push_back({ name, function, arg });
+	return true;
+}
+}  // namespace bench
+}  // namespace cdm
+
+/// Times the CPU side of the renderer without a device: shader generation,
+/// SPIR-V serialization, mesh packing, transform matrices, material
+/// parameters and DDS parsing
+int main(int argc, char** argv)
+{
+	using namespace cdm::bench;
+
+	std::optional<Options> options = parseOptions(argc, argv);
+	if (!options)
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::vector<Benchmark> benchmarks = registry();
+	std::sort(benchmarks.begin(), benchmarks.end(),
+	          [](const Benchmark& a, const Benchmark& b) {
+		          return a.name < b.name;
+	          });
+
+	std::cout << std::left << std::setw(40) << "benchmark" << std::right
+	          << std::setw(14) << "ns/iteration" << std::setw(14)
+	          << "iterations" << std::setw(16) << "items/s" << std::endl;
+
+	std::vector<Result> results;
+	for (const Benchmark& benchmark : benchmarks)
+	{
+		if (benchmark.name.find(options->filter) == std::string::npos)
+			continue;
+
+		std::optional<Result> result = run(benchmark, options->minSeconds);
+		if (!result)
+			return 1;
+
+		std::cout << std::left << std::setw(40) << result->name << std::right
+		          << std::fixed << std::setprecision(1) << std::setw(14)
+		          << result->nanoseconds << std::setw(14)
+		          << result->iterations << std::setw(16)
+		          << std::setprecision(0) << result->itemsPerSecond
+		          << std::endl;
+
+		results.push_back(std::move(*result));
+	}
+
+	if (!options->json.empty() && !writeJson(options->json, results))
+		return 1;
+
+	return 0;
+}
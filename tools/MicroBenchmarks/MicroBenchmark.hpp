@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace cdm
+{
+namespace bench
+{
+/// Handed to a benchmark, which times the body of a
+/// `for (auto _ : state)` loop as with Google Benchmark. What is done
+/// before the loop is setup and is not measured
+class State final
+{
+	uint64_t m_iterations = 0;
+	int64_t m_arg = 0;
+	uint64_t m_itemsProcessed = 0;
+
+	std::chrono::steady_clock::time_point m_begin;
+	std::chrono::steady_clock::time_point m_end;
+	bool m_finished = false;
+
+public:
+	struct Iteration
+	{
+	};
+
+	class Iterator final
+	{
+		State* m_state = nullptr;
+		uint64_t m_remaining = 0;
+
+	public:
+		Iterator(State* state, uint64_t remaining)
+		    : m_state(state),
+		      m_remaining(remaining)
+		{
+		}
+
+		Iteration operator*() const noexcept { return {}; }
+		Iterator& operator++() noexcept
+		{
+			m_remaining--;
+			return *this;
+		}
+		/// Stops the timer when the last iteration is done
+		bool operator!=(const Iterator&) noexcept
+		{
+			if (m_remaining != 0)
+				return true;
+			m_state->finish();
+			return false;
+		}
+	};
+
+	State(uint64_t iterations, int64_t arg)
+	    : m_iterations(iterations),
+	      m_arg(arg)
+	{
+	}
+
+	Iterator begin()
+	{
+		m_begin = std::chrono::steady_clock::now();
+		return Iterator(this, m_iterations);
+	}
+	Iterator end() { return Iterator(this, 0); }
+
+	uint64_t iterations() const noexcept { return m_iterations; }
+	/// of the registration, 0 if it has none
+	int64_t arg() const noexcept { return m_arg; }
+
+	/// Items handled by the whole loop, reported per second
+	void setItemsProcessed(uint64_t items) noexcept
+	{
+		m_itemsProcessed = items;
+	}
+	uint64_t itemsProcessed() const noexcept { return m_itemsProcessed; }
+
+	bool finished() const noexcept { return m_finished; }
+	double seconds() const noexcept
+	{
+		return std::chrono::duration<double>(m_end - m_begin).count();
+	}
+
+private:
+	void finish()
+	{
+		m_end = std::chrono::steady_clock::now();
+		m_finished = true;
+	}
+};
+
+using Function = void (*)(State& state);
+
+/// Called by `CDM_BENCHMARK` during static initialization
+bool registerBenchmark(const char* name, Function function, int64_t arg = 0);
+
+namespace detail
+{
+extern const void* volatile escapedAddress;
+}
+
+/// Keeps `value` from being optimized away: its address escapes and the
+/// compiler has to assume it is read
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+	detail::escapedAddress = &value;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+/// Forces the pending writes to memory to be done
+inline void clobberMemory()
+{
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+}  // namespace bench
+}  // namespace cdm
+
+#define CDM_BENCHMARK(function)                                               \
+	static const bool function##Registered =                                  \
+	    ::cdm::bench::registerBenchmark(#function, function)
+
+/// Registers `function` under `function/arg`, `arg` is an integer literal
+#define CDM_BENCHMARK_ARG(function, arg)                                      \
+	static const bool function##Registered##arg =                             \
+	    ::cdm::bench::registerBenchmark(#function "/" #arg, function, arg)
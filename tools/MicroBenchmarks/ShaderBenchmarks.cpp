@@ -0,0 +1,77 @@
+#include "MicroBenchmark.hpp"
+
+#include "Materials/DefaultMaterial.hpp"
+#include "PbrShadingModel.hpp"
+#include "SceneObject.hpp"
+
+namespace cdm
+{
+namespace
+{
+// default constructed, shader generation only reads their declarations
+DefaultMaterial material;
+PbrShadingModel shadingModel;
+
+void SceneObjectVertexShader(bench::State& state)
+{
+	for (auto _ : state)
+	{
+		sdw::VertexWriter writer;
+		SceneObject::writeVertexShader(writer, material);
+		bench::doNotOptimize(writer.getShader());
+	}
+}
+CDM_BENCHMARK(SceneObjectVertexShader);
+
+/// `arg` is the `PbrShadingModel::ShadingFeature` flags
+void SceneObjectFragmentShader(bench::State& state)
+{
+	uint32_t shadingFeatures = uint32_t(state.arg());
+
+	for (auto _ : state)
+	{
+		sdw::FragmentWriter writer;
+		SceneObject::writeFragmentShader(writer, material, shadingModel,
+		                                 shadingFeatures);
+		bench::doNotOptimize(writer.getShader());
+	}
+}
+CDM_BENCHMARK_ARG(SceneObjectFragmentShader, 0);
+CDM_BENCHMARK_ARG(SceneObjectFragmentShader, 15);
+
+void SerialiseVertexShader(bench::State& state)
+{
+	sdw::VertexWriter writer;
+	SceneObject::writeVertexShader(writer, material);
+
+	size_t words = 0;
+	for (auto _ : state)
+	{
+		std::vector<uint32_t> bytecode =
+		    spirv::serialiseSpirv(writer.getShader());
+		words = bytecode.size();
+		bench::doNotOptimize(bytecode.data());
+	}
+	state.setItemsProcessed(state.iterations() * words);
+}
+CDM_BENCHMARK(SerialiseVertexShader);
+
+void SerialiseFragmentShader(bench::State& state)
+{
+	sdw::FragmentWriter writer;
+	SceneObject::writeFragmentShader(writer, material, shadingModel,
+	                                 PbrShadingModel::AllShadingFeatures);
+
+	size_t words = 0;
+	for (auto _ : state)
+	{
+		std::vector<uint32_t> bytecode =
+		    spirv::serialiseSpirv(writer.getShader());
+		words = bytecode.size();
+		bench::doNotOptimize(bytecode.data());
+	}
+	state.setItemsProcessed(state.iterations() * words);
+}
+CDM_BENCHMARK(SerialiseFragmentShader);
+}  // namespace
+}  // namespace cdm
@@ -0,0 +1,61 @@
+#include "BrdfLutGenerator.hpp"
+#include "EquirectangularToCubemap.hpp"
+#include "EquirectangularToIrradianceMap.hpp"
+#include "PrefilterCubemap.hpp"
+#include "ShaderArchive.hpp"
+#include "Skybox.hpp"
+#include "SpirvOptimizer.hpp"
+
+#include <iostream>
+#include <string>
+
+/// Builds the shaders of every declared variant and packs them in the
+/// archive loaded by the applications through
+/// `VulkanDevice::setShaderArchive`. Keys must match the ones used by the
+/// `createShaderModule` calls
+int main(int argc, char** argv)
+{
+	using namespace cdm;
+
+	if (argc != 2)
+	{
+		std::cerr << "usage: ShaderArchiver <output archive>" << std::endl;
+		return 1;
+	}
+
+	ShaderArchiveWriter archive;
+	// stored optimized, as createShaderModule would have built them
+	auto add = [&archive](std::string key, std::vector<uint32_t> bytecode) {
+		archive.add(std::move(key), optimizeSpirv(std::move(bytecode)));
+	};
+
+	add("Skybox.vert", Skybox::vertexShaderBytecode());
+	add("Skybox.frag", Skybox::fragmentShaderBytecode());
+
+	add("BrdfLutGenerator.vert", BrdfLutGenerator::vertexShaderBytecode());
+	add("BrdfLutGenerator.frag", BrdfLutGenerator::fragmentShaderBytecode());
+
+	add("EquirectangularToCubemap.vert",
+	    EquirectangularToCubemap::vertexShaderBytecode());
+	add("EquirectangularToCubemap.frag",
+	    EquirectangularToCubemap::fragmentShaderBytecode());
+
+	add("EquirectangularToIrradianceMap.vert",
+	    EquirectangularToIrradianceMap::vertexShaderBytecode());
+	add("EquirectangularToIrradianceMap.frag",
+	    EquirectangularToIrradianceMap::fragmentShaderBytecode());
+
+	add("PrefilterCubemap.vert", PrefilterCubemap::vertexShaderBytecode());
+	// prefiltered environment resolutions used by the applications
+	for (uint32_t cubemapWidth : { 256u, 512u, 1024u })
+		add("PrefilterCubemap.frag/" + std::to_string(cubemapWidth),
+		    PrefilterCubemap::fragmentShaderBytecode(cubemapWidth));
+
+	if (!archive.write(argv[1]))
+		return 1;
+
+	std::cout << archive.size() << " shaders written to " << argv[1]
+	          << std::endl;
+
+	return 0;
+}
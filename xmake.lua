@@ -162,6 +162,11 @@ option("useLoadDDS")
 	set_description("Use LoadDDS as a backend for TextureLoaderFrontend")
 option_end()
 
+option("optimizeSpirV")
+	set_showmenu(true)
+	set_description("Optimize generated shaders with SPIRV-Tools from the Vulkan SDK")
+option_end()
+
 target("TextureLoaderFrontend")
 	set_default(false)
 	set_kind("static")
@@ -207,6 +212,12 @@ target("VkRenderer")
 	add_deps("sdwShaderAST", "sdwShaderWriter", "sdwCompilerSpirV")
 	-- add_deps("TextureLoaderFrontend", "imgui")
 	add_deps("imgui")
+
+	if has_config("optimizeSpirV") then
+		add_defines("VKRENDERER_OPTIMIZE_SPIRV")
+		add_linkdirs("$(env VULKAN_SDK)/Lib", { public = true })
+		add_links("SPIRV-Tools-opt", "SPIRV-Tools", { public = true })
+	end
 	add_includedirs(
 		"third_party/include",
 		"third_party/imgui/examples",
@@ -225,20 +236,31 @@ target("VkRenderer")
 		"src/VkRenderer/CommandBuffer.cpp",
 		"src/VkRenderer/CommandBufferPool.cpp",
 		"src/VkRenderer/CommandPool.cpp",
+		"src/VkRenderer/CpuProfiler.cpp",
 		"src/VkRenderer/Cubemap.cpp",
+		"src/VkRenderer/DepthPyramid.cpp",
 		"src/VkRenderer/DepthTexture.cpp",
+		"src/VkRenderer/DescriptorAllocator.cpp",
+		"src/VkRenderer/DescriptorUpdateTemplate.cpp",
 		"src/VkRenderer/EquirectangularToCubemap.cpp",
 		"src/VkRenderer/EquirectangularToIrradianceMap.cpp",
+		"src/VkRenderer/FrameRecorder.cpp",
+		"src/VkRenderer/FrameReplayer.cpp",
 		"src/VkRenderer/Framebuffer.cpp",
+		"src/VkRenderer/GpuProfiler.cpp",
+		"src/VkRenderer/HeadlessRenderContext.cpp",
 		"src/VkRenderer/Image.cpp",
 		"src/VkRenderer/ImageView.cpp",
 		"src/VkRenderer/IrradianceMap.cpp",
+		"src/VkRenderer/LayoutCache.cpp",
 		"src/VkRenderer/Material.cpp",
 		"src/VkRenderer/Materials/CustomMaterial.cpp",
 		"src/VkRenderer/Materials/DefaultMaterial.cpp",
+		"src/VkRenderer/Materials/DefaultMaterialParameters.cpp",
 		"src/VkRenderer/Model.cpp",
 		"src/VkRenderer/MyShaderWriter.cpp",
 		"src/VkRenderer/PbrShadingModel.cpp",
+		"src/VkRenderer/PipelineCompiler.cpp",
 		"src/VkRenderer/PipelineFactory.cpp",
 		"src/VkRenderer/PrefilterCubemap.cpp",
 		"src/VkRenderer/PrefilteredCubemap.cpp",
@@ -248,12 +270,16 @@ target("VkRenderer")
 		"src/VkRenderer/RenderWindow.cpp",
 		"src/VkRenderer/Scene.cpp",
 		"src/VkRenderer/SceneObject.cpp",
+		"src/VkRenderer/ShaderArchive.cpp",
 		"src/VkRenderer/Skybox.cpp",
+		"src/VkRenderer/SpirvOptimizer.cpp",
 		"src/VkRenderer/StagingBuffer.cpp",
 		"src/VkRenderer/StandardMesh.cpp",
+		"src/VkRenderer/Stats.cpp",
 		"src/VkRenderer/Texture1D.cpp",
 		"src/VkRenderer/Texture2D.cpp",
 		"src/VkRenderer/TextureFactory.cpp",
+		"src/VkRenderer/TextureTable.cpp",
 		"src/VkRenderer/UniformBuffer.cpp",
 		"src/VkRenderer/VertexInputHelper.cpp",
 		"src/VkRenderer/VulkanDevice.cpp"
@@ -266,36 +292,53 @@ target("VkRenderer")
 		"src/VkRenderer/CommandBuffer.inl",
 		"src/VkRenderer/CommandBufferPool.hpp",
 		"src/VkRenderer/CommandPool.hpp",
+		"src/VkRenderer/CpuProfiler.hpp",
 		"src/VkRenderer/Cubemap.hpp",
+		"src/VkRenderer/DepthPyramid.hpp",
 		"src/VkRenderer/DepthTexture.hpp",
+		"src/VkRenderer/DescriptorAllocator.hpp",
+		"src/VkRenderer/DescriptorUpdateTemplate.hpp",
 		"src/VkRenderer/EquirectangularToCubemap.hpp",
 		"src/VkRenderer/EquirectangularToIrradianceMap.hpp",
+		"src/VkRenderer/FrameCapture.hpp",
+		"src/VkRenderer/FrameRecorder.hpp",
+		"src/VkRenderer/FrameReplayer.hpp",
 		"src/VkRenderer/Framebuffer.hpp",
+		"src/VkRenderer/GpuProfiler.hpp",
+		"src/VkRenderer/HeadlessRenderContext.hpp",
 		"src/VkRenderer/Image.hpp",
 		"src/VkRenderer/ImageView.hpp",
 		"src/VkRenderer/IrradianceMap.hpp",
+		"src/VkRenderer/LayoutCache.hpp",
 		"src/VkRenderer/Material.hpp",
 		"src/VkRenderer/Materials/CustomMaterial.hpp",
 		"src/VkRenderer/Materials/DefaultMaterial.hpp",
+		"src/VkRenderer/Materials/DefaultMaterialParameters.hpp",
 		"src/VkRenderer/Model.hpp",
 		"src/VkRenderer/MyShaderWriter.hpp",
 		"src/VkRenderer/MyShaderWriter.inl",
 		"src/VkRenderer/PbrShadingModel.hpp",
+		"src/VkRenderer/PipelineCompiler.hpp",
 		"src/VkRenderer/PipelineFactory.hpp",
 		"src/VkRenderer/PrefilterCubemap.hpp",
 		"src/VkRenderer/PrefilteredCubemap.hpp",
 		"src/VkRenderer/RenderApplication.hpp",
+		"src/VkRenderer/RenderContext.hpp",
 		"src/VkRenderer/Renderer.hpp",
 		"src/VkRenderer/RenderPass.hpp",
 		"src/VkRenderer/RenderWindow.hpp",
 		"src/VkRenderer/Scene.hpp",
 		"src/VkRenderer/SceneObject.hpp",
+		"src/VkRenderer/ShaderArchive.hpp",
 		"src/VkRenderer/Skybox.hpp",
+		"src/VkRenderer/SpirvOptimizer.hpp",
 		"src/VkRenderer/StagingBuffer.hpp",
 		"src/VkRenderer/StandardMesh.hpp",
+		"src/VkRenderer/Stats.hpp",
 		"src/VkRenderer/Texture1D.hpp",
 		"src/VkRenderer/Texture2D.hpp",
 		"src/VkRenderer/TextureFactory.hpp",
+		"src/VkRenderer/TextureTable.hpp",
 		"src/VkRenderer/TextureInterface.hpp",
 		"src/VkRenderer/UniformBuffer.hpp",
 		"src/VkRenderer/VertexInputHelper.hpp",
@@ -319,6 +362,50 @@ target_end()
 
 
 
+target("Benchmark")
+	set_kind("binary")
+	set_languages("cxx17")
+	add_deps("VkRenderer", "ShaderArchiver")
+	add_packages("imgui", "assimp")
+	add_includedirs("test/LightTransport", "test/Mandelbulb", "test/ShaderBall",
+	                "tools/Common")
+	add_files("tools/Benchmark/*.cpp")
+	-- the demos, without the main of Mandelbulb
+	add_files("test/LightTransport/*.cpp", "test/Mandelbulb/Mandelbulb.cpp",
+	          "test/ShaderBall/*.cpp")
+	-- the headless stress scene
+	add_files("tools/Common/ReferenceScene.cpp")
+target_end()
+
+target("MicroBenchmarks")
+	set_kind("binary")
+	set_languages("cxx17")
+	add_deps("VkRenderer")
+	add_includedirs("src/TextureLoaderFrontend")
+	add_files("tools/MicroBenchmarks/*.cpp")
+	-- TextureLoaderFrontend is not built as a library
+	add_files("src/TextureLoaderFrontend/load_dds.cpp")
+target_end()
+
+target("ImageRegression")
+	-- built on request, `xmake build ImageRegression`, until the lavapipe
+	-- golden images are committed under tools/ImageRegression/golden
+	set_default(false)
+	set_kind("binary")
+	set_languages("cxx17")
+	add_deps("VkRenderer")
+	add_includedirs("tools/Common")
+	add_files("tools/ImageRegression/*.cpp", "tools/Common/ReferenceScene.cpp")
+	add_headerfiles("tools/Common/ReferenceScene.hpp")
+target_end()
+
+target("FrameReplay")
+	set_kind("binary")
+	set_languages("cxx17")
+	add_deps("VkRenderer")
+	add_files("tools/FrameReplay/*.cpp")
+target_end()
+
 target("LightTransport")
 	set_kind("binary")
 	set_languages("cxx17")
@@ -342,10 +429,22 @@ target("Mandelbulb")
 	end
 target_end()
 
-target("ShaderBall")
+target("ShaderArchiver")
 	set_kind("binary")
 	set_languages("cxx17")
 	add_deps("VkRenderer")
+	add_files("tools/ShaderArchiver/*.cpp")
+
+	-- packs the prebuilt shaders loaded by the applications at startup
+	after_build(function (target)
+		os.execv(target:targetfile(), {"runtime_cache/shaders.spva"})
+	end)
+target_end()
+
+target("ShaderBall")
+	set_kind("binary")
+	set_languages("cxx17")
+	add_deps("VkRenderer", "ShaderArchiver")
 	add_packages("imgui", "assimp")
 	add_files("test/ShaderBall/*.cpp")
 	add_headerfiles("test/ShaderBall/*.hpp")